@@ -0,0 +1,185 @@
+﻿#include "SyntheticRepo.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QStringList>
+
+#include "model/GraphModel.h"
+
+static const char* const kKinds[] = {"npm", "pypi", "maven", "gradle", "cmake"};
+static constexpr int kKindCount = 5;
+
+// Most packages are required at one version across the repo; about one in
+// ten requirements asks for the next major, so conflicts show up too.
+static int majorFor(int package, QRandomGenerator& rng)
+{
+    return package % 5 + 1 + (rng.bounded(10) == 0 ? 1 : 0);
+}
+
+static QString manifestText(const QString& kind, int index, const SyntheticRepoSpec& spec, QRandomGenerator& rng)
+{
+    QStringList lines;
+    const int pool = qMax(1, spec.packagePool);
+
+    if (kind == "npm") {
+        lines << "{" << QString("  \"name\": \"app-%1\",").arg(index) << "  \"version\": \"1.0.0\","
+              << "  \"dependencies\": {";
+        for (int d = 0; d < spec.depsPerManifest; d++) {
+            const int p = int(rng.bounded(pool));
+            lines << QString("    \"pkg-%1\": \"^%2.%3.0\"%4")
+                         .arg(p)
+                         .arg(majorFor(p, rng))
+                         .arg(p % 10)
+                         .arg(d + 1 < spec.depsPerManifest ? "," : "");
+        }
+        lines << "  }" << "}";
+    } else if (kind == "pypi") {
+        lines << "# generated";
+        for (int d = 0; d < spec.depsPerManifest; d++) {
+            const int p = int(rng.bounded(pool));
+            lines << QString("py-pkg-%1>=%2.%3").arg(p).arg(majorFor(p, rng)).arg(p % 10);
+        }
+    } else if (kind == "maven") {
+        lines << "<project>" << QString("  <artifactId>module-%1</artifactId>").arg(index) << "  <dependencies>";
+        for (int d = 0; d < spec.depsPerManifest; d++) {
+            const int p = int(rng.bounded(pool));
+            lines << "    <dependency>"
+                  << QString("      <groupId>org.synth.g%1</groupId>").arg(p % 50)
+                  << QString("      <artifactId>artifact-%1</artifactId>").arg(p)
+                  << QString("      <version>%1.%2.0</version>").arg(majorFor(p, rng)).arg(p % 10)
+                  << "    </dependency>";
+        }
+        lines << "  </dependencies>" << "</project>";
+    } else if (kind == "gradle") {
+        lines << "plugins { id 'java' }" << "dependencies {";
+        for (int d = 0; d < spec.depsPerManifest; d++) {
+            const int p = int(rng.bounded(pool));
+            lines << QString("    implementation 'com.synth:lib-%1:%2.%3.0'").arg(p).arg(majorFor(p, rng)).arg(p % 10);
+        }
+        lines << "}";
+    } else if (kind == "cmake") {
+        lines << "cmake_minimum_required(VERSION 3.20)" << QString("project(module_%1 CXX)").arg(index);
+        for (int d = 0; d < spec.depsPerManifest; d++) {
+            const int p = int(rng.bounded(pool));
+            if (d % 4 == 3) {
+                lines << QString("FetchContent_Declare(synthdep%1").arg(p)
+                      << QString("  GIT_REPOSITORY https://example.invalid/synthdep%1.git").arg(p)
+                      << QString("  GIT_TAG v%1.%2.0").arg(majorFor(p, rng)).arg(p % 10) << ")";
+            } else {
+                lines << QString("find_package(Synth%1 %2.%3 REQUIRED)").arg(p).arg(majorFor(p, rng)).arg(p % 10);
+            }
+        }
+    }
+
+    lines << QString();
+    return lines.join('\n');
+}
+
+static QString manifestFileName(const QString& kind)
+{
+    if (kind == "npm") return "package.json";
+    if (kind == "pypi") return "requirements.txt";
+    if (kind == "maven") return "pom.xml";
+    if (kind == "gradle") return "build.gradle";
+    return "CMakeLists.txt";
+}
+
+// "src/d2/d0/.../npm-17": the index spelled in base `fanout` gives a deep,
+// evenly filled tree; the leaf name keeps every manifest in its own folder.
+static QString manifestDir(const QString& kind, int index, const SyntheticRepoSpec& spec)
+{
+    QString dir = "src";
+    const int fanout = qMax(1, spec.fanout);
+    int rest = index;
+    for (int level = 0; level < spec.depth; level++) {
+        dir += QString("/d%1").arg(rest % fanout);
+        rest /= fanout;
+    }
+    return dir + QString("/%1-%2").arg(kind).arg(index);
+}
+
+static bool writeFile(const QDir& root, const QString& relPath, const QString& text, QString* err)
+{
+    const QString path = root.filePath(relPath);
+    if (!root.mkpath(relPath.section('/', 0, -2))) {
+        if (err) *err = QString("Cannot create directory for %1").arg(path);
+        return false;
+    }
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (err) *err = QString("Cannot write %1").arg(path);
+        return false;
+    }
+    f.write(text.toUtf8());
+    return true;
+}
+
+int SyntheticRepo::write(const QDir& root, const SyntheticRepoSpec& spec, QString* err)
+{
+    if (err) *err = QString();
+    if (!root.exists()) {
+        if (err) *err = QString("%1 does not exist").arg(root.absolutePath());
+        return -1;
+    }
+
+    QRandomGenerator rng(spec.seed);
+    int written = 0;
+
+    for (int i = 0; i < spec.manifestsPerKind; i++) {
+        for (int k = 0; k < kKindCount; k++) {
+            const QString kind = kKinds[k];
+            const QString rel = manifestDir(kind, i, spec) + "/" + manifestFileName(kind);
+            if (!writeFile(root, rel, manifestText(kind, i, spec, rng), err))
+                return -1;
+            written++;
+        }
+    }
+
+    // Vendored packages a scan must not descend into.
+    for (int i = 0; i < spec.decoyManifests; i++) {
+        const QString rel = QString("web/node_modules/decoy-%1/node_modules/inner/package.json").arg(i);
+        if (!writeFile(root, rel, manifestText("npm", i, spec, rng), err))
+            return -1;
+        written++;
+    }
+
+    return written;
+}
+
+void SyntheticRepo::generateGraph(const SyntheticGraphSpec& spec, GraphModel* graph)
+{
+    QRandomGenerator rng(spec.seed);
+    graph->clear();
+
+    // Names are unique, so ids come out dense in creation order: the root is
+    // 0, modules 1..modules and packages after them.
+    const int n = qMax(2, spec.nodes);
+    const int modules = qMax(1, n / 50);
+    graph->upsertNode("synthetic", "", "repo");
+    for (int i = 1; i < n; i++) {
+        const QString kind = kKinds[i % kKindCount];
+        if (i <= modules)
+            graph->upsertNode(QString("module-%1/manifest").arg(i), "", kind + ":module");
+        else
+            graph->upsertNode(QString("pkg-%1").arg(i), QString("%1.%2.0").arg(i % 7 + 1).arg(i % 13), kind);
+    }
+
+    for (int m = 1; m <= modules; m++)
+        graph->addEdge(0, m);
+
+    // Edges mostly point forward within a window, which gives a deep layered
+    // graph; a few point back and close cycles.
+    const int window = qMax(64, n / 20);
+    for (int i = 1; i < n; i++) {
+        for (int k = 0; k < spec.avgOutDegree; k++) {
+            int j = -1;
+            if (i > modules + 1 && int(rng.bounded(100)) < spec.backEdgePercent)
+                j = modules + 1 + int(rng.bounded(i - modules - 1));
+            else
+                j = qMax(i, modules) + 1 + int(rng.bounded(window));
+            if (j >= n)
+                continue;
+            graph->addEdge(i, j, "^" + graph->nodes()[j].version);
+        }
+    }
+}
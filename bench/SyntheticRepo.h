@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#include <QDir>
+#include <QString>
+
+class GraphModel;
+
+// Deterministic inputs for DepGraphBench. The same spec and seed always
+// produce byte-identical repositories and identical graphs, so timings from
+// different builds are comparable.
+struct SyntheticRepoSpec {
+    int manifestsPerKind = 200; // of each supported format
+    int depth = 6;              // directory levels above every manifest
+    int fanout = 4;             // subdirectories per level
+    int depsPerManifest = 12;
+    int packagePool = 2000;     // distinct package names per ecosystem
+    int decoyManifests = 200;   // package.json files under node_modules (must be skipped)
+    quint32 seed = 0x5eed0001u;
+};
+
+struct SyntheticGraphSpec {
+    int nodes = 20000;
+    int avgOutDegree = 3;
+    // Share of edges that point back to an earlier layer, creating cycles.
+    int backEdgePercent = 2;
+    quint32 seed = 0x5eed0002u;
+};
+
+class SyntheticRepo {
+public:
+    // Writes the manifests under root (which must exist and should be empty).
+    // Returns the number of files written, or -1 with *err set.
+    static int write(const QDir& root, const SyntheticRepoSpec& spec, QString* err);
+
+    // Builds the graph through GraphModel::upsertNode/addEdge, like a scan:
+    // a repo root, module nodes and layered dependencies with some cycles.
+    static void generateGraph(const SyntheticGraphSpec& spec, GraphModel* graph);
+};
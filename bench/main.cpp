@@ -0,0 +1,497 @@
+﻿// DepGraphBench: times the scan, model, layout, scene and export paths on
+// deterministic synthetic inputs and prints the results as JSON.
+//
+//   DepGraphBench --scale medium --repeat 5 --out results.json
+//
+// Each benchmark runs once to warm up, then --repeat timed iterations.
+// Scripted pans and zooms are timed frame by frame through GraphView's
+// RenderStats; with --frame-budget-ms the exit code is 3 if their p95
+// frame time exceeds the budget.
+
+#include <QApplication>
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QScrollBar>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <functional>
+
+#include "SyntheticRepo.h"
+#include "gui/GraphView.h"
+#include "gui/SvgWriter.h"
+#include "layout/LayeredLayout.h"
+#include "model/GraphModel.h"
+#include "model/ReachabilityIndex.h"
+#include "model/RegistryIndex.h"
+#include "model/TrigramIndex.h"
+#include "model/WhatIfOverlay.h"
+#include "parser/DependencyScanner.h"
+
+#ifndef DEPGRAPH_VERSION
+#define DEPGRAPH_VERSION "unknown"
+#endif
+
+namespace {
+
+struct Scale {
+    SyntheticRepoSpec repo;
+    SyntheticGraphSpec graph;
+};
+
+bool scaleByName(const QString& name, Scale* out)
+{
+    Scale s;
+    if (name == "small") {
+        s.repo.manifestsPerKind = 100;
+        s.repo.depth = 4;
+        s.repo.packagePool = 500;
+        s.repo.decoyManifests = 100;
+        s.graph.nodes = 5000;
+    } else if (name == "medium") {
+        s.repo.manifestsPerKind = 1000;
+        s.repo.depth = 6;
+        s.repo.packagePool = 3000;
+        s.repo.decoyManifests = 500;
+        s.graph.nodes = 30000;
+    } else if (name == "large") {
+        s.repo.manifestsPerKind = 4000;
+        s.repo.depth = 8;
+        s.repo.packagePool = 10000;
+        s.repo.decoyManifests = 2000;
+        s.graph.nodes = 120000;
+    } else {
+        return false;
+    }
+    *out = s;
+    return true;
+}
+
+// Keeps results observable so the timed work cannot be optimised away.
+qint64 g_sink = 0;
+
+class Runner {
+public:
+    Runner(int repeat, const QString& only)
+        : m_repeat(qMax(1, repeat))
+        , m_only(only)
+    {
+    }
+
+    // `setup` runs before every iteration, outside the timed region.
+    // `items` is the amount of work one iteration does (files, nodes...),
+    // reported so per-item cost can be derived.
+    bool selected(const QString& name) const { return m_only.isEmpty() || name.contains(m_only); }
+
+    void run(const QString& name, qint64 items, const std::function<void()>& fn,
+             const std::function<void()>& setup = {})
+    {
+        if (!selected(name))
+            return;
+
+        if (setup) setup();
+        fn(); // warm-up
+
+        QVector<double> ms;
+        ms.reserve(m_repeat);
+        for (int i = 0; i < m_repeat; i++) {
+            if (setup) setup();
+            QElapsedTimer t;
+            t.start();
+            fn();
+            ms.push_back(t.nsecsElapsed() / 1e6);
+        }
+        std::sort(ms.begin(), ms.end());
+
+        double sum = 0;
+        for (double v : ms)
+            sum += v;
+        const double median = ms.size() % 2 ? ms[ms.size() / 2]
+                                            : (ms[ms.size() / 2 - 1] + ms[ms.size() / 2]) / 2;
+
+        QJsonObject o;
+        o["name"] = name;
+        o["iterations"] = m_repeat;
+        o["items"] = items;
+        o["min_ms"] = ms.first();
+        o["median_ms"] = median;
+        o["mean_ms"] = sum / ms.size();
+        o["max_ms"] = ms.last();
+        m_results.push_back(o);
+
+        QTextStream(stderr) << QString("%1 %2 ms (median of %3, %4 items)\n")
+                                   .arg(name, -28)
+                                   .arg(median, 10, 'f', 3)
+                                   .arg(m_repeat)
+                                   .arg(items);
+    }
+
+    QJsonArray results() const { return m_results; }
+
+private:
+    int m_repeat;
+    QString m_only;
+    QJsonArray m_results;
+};
+
+QJsonObject specToJson(const Scale& s)
+{
+    QJsonObject repo;
+    repo["manifests_per_kind"] = s.repo.manifestsPerKind;
+    repo["depth"] = s.repo.depth;
+    repo["fanout"] = s.repo.fanout;
+    repo["deps_per_manifest"] = s.repo.depsPerManifest;
+    repo["package_pool"] = s.repo.packagePool;
+    repo["decoy_manifests"] = s.repo.decoyManifests;
+    repo["seed"] = qint64(s.repo.seed);
+
+    QJsonObject graph;
+    graph["nodes"] = s.graph.nodes;
+    graph["avg_out_degree"] = s.graph.avgOutDegree;
+    graph["back_edge_percent"] = s.graph.backEdgePercent;
+    graph["seed"] = qint64(s.graph.seed);
+
+    QJsonObject o;
+    o["repo"] = repo;
+    o["graph"] = graph;
+    return o;
+}
+
+void benchScan(Runner& r, const QDir& repo)
+{
+    QVector<QString> files;
+    r.run("scan.findCandidateFiles", 0, [&]() {
+        files = DependencyScanner::findCandidateFiles(repo);
+        g_sink += files.size();
+    });
+    if (files.isEmpty())
+        files = DependencyScanner::findCandidateFiles(repo);
+
+    // Parsers are timed on contents already in memory, so disk reads do not
+    // blur the comparison between formats.
+    QHash<QString, QVector<QByteArray>> byKind;
+    for (const QString& path : files) {
+        QFile f(path);
+        if (f.open(QIODevice::ReadOnly))
+            byKind[DependencyScanner::manifestKind(QFileInfo(path).fileName())].push_back(f.readAll());
+    }
+    const QStringList kinds = {"npm", "pypi", "maven", "gradle", "cmake"};
+    for (const QString& kind : kinds) {
+        const QVector<QByteArray>& contents = byKind[kind];
+        r.run("parse." + kind, contents.size(), [&]() {
+            ParsedDeps parsed;
+            QString err;
+            for (const QByteArray& bytes : contents) {
+                DependencyScanner::parseManifest(kind, bytes, &parsed, &err);
+                g_sink += parsed.deps.size();
+            }
+        });
+    }
+
+    r.run("scan.scanRepositoryToGraph", files.size(), [&]() {
+        GraphModel g;
+        QString err;
+        DependencyScanner::scanRepositoryToGraph(repo, &g, &err);
+        g_sink += g.edges().size();
+    });
+
+    // Rescan of an unchanged tree: every manifest is a cache hit.
+    ManifestCache cache;
+    {
+        GraphModel g;
+        QString err;
+        DependencyScanner::scanRepositoryToGraph(repo, &g, &err, &cache);
+    }
+    r.run("scan.scanRepositoryToGraph.cached", files.size(), [&]() {
+        GraphModel g;
+        QString err;
+        DependencyScanner::scanRepositoryToGraph(repo, &g, &err, &cache);
+        g_sink += g.edges().size();
+    });
+}
+
+void benchModel(Runner& r, const SyntheticGraphSpec& spec, GraphModel* graph)
+{
+    r.run("model.upsert", spec.nodes, [&]() {
+        SyntheticRepo::generateGraph(spec, graph);
+        g_sink += graph->edges().size();
+    });
+    if (graph->nodes().isEmpty())
+        SyntheticRepo::generateGraph(spec, graph);
+
+    const int n = graph->nodes().size();
+    const QVector<Edge>& edges = graph->edges();
+
+    r.run("model.reachabilityIndex", n, [&]() {
+        g_sink += ReachabilityIndex::build(n, edges)->nodeCount();
+    });
+    r.run("model.trigramIndex", n, [&]() {
+        g_sink += TrigramIndex::build(graph->nodes())->search("pkg-1", 1).size();
+    });
+
+    // Queries go through the model so they use (and build once) its indexes.
+    QRandomGenerator rng(42);
+    QVector<int> sample;
+    for (int i = 0; i < 200; i++)
+        sample.push_back(int(rng.bounded(n)));
+
+    r.run("model.downstream", sample.size(), [&]() {
+        for (int id : sample)
+            g_sink += graph->downstream(id).size();
+    });
+    r.run("model.upstream", sample.size(), [&]() {
+        for (int id : sample)
+            g_sink += graph->upstream(id).size();
+    });
+    r.run("model.shortestPath", sample.size(), [&]() {
+        for (int id : sample)
+            g_sink += graph->shortestPath(0, id).size();
+    });
+
+    const QStringList queries = {"pkg-1", "pkg-42", "module-*", "pkg-1?3", "/^pkg-9+$/", "pkgg 17", "manifest"};
+    r.run("model.search", queries.size(), [&]() {
+        for (const QString& q : queries)
+            g_sink += graph->search(q, 200).size();
+    });
+
+    // Simulated drops re-check only what lies below each node; the model's
+    // indexes are already built by the queries above.
+    r.run("model.whatIfDrop", sample.size(), [&]() {
+        WhatIfOverlay overlay(*graph);
+        for (int id : sample)
+            g_sink += overlay.dropNode(id);
+        g_sink += overlay.unreachable().size() + overlay.statusChanges().size();
+    });
+}
+
+// Registry metadata listing every package node: the index build, then the
+// per-scan pass over the whole graph.
+void benchRegistry(Runner& r, const GraphModel& graph, const QDir& work)
+{
+    const QString source = work.filePath("registry.jsonl");
+    const QString index = work.filePath("registry.idx");
+    {
+        QFile f(source);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return;
+        for (const Node& n : graph.nodes()) {
+            if (n.version.isEmpty() || n.kind == "cmake" || n.kind.endsWith(":module"))
+                continue;
+            const QString ecosystem = n.kind == "gradle" ? "maven" : n.kind;
+            f.write(QString(R"({"ecosystem":"%1","name":"%2","latest":"9.3.0","versions":["1.0.0","4.2.1","7.12.0","9.0.0","9.3.0"]})"
+                            "\n")
+                        .arg(ecosystem, n.name)
+                        .toUtf8());
+        }
+    }
+
+    r.run("model.registryIndex.build", graph.nodes().size(), [&]() {
+        QString err;
+        g_sink += RegistryIndex::build(source, index, &err) ? 1 : 0;
+    });
+    RegistryIndex registry;
+    QString err;
+    if (!registry.open(index, &err) && !(RegistryIndex::build(source, index, &err) && registry.open(index, &err)))
+        return;
+    r.run("model.registryLag", graph.nodes().size(), [&]() {
+        QVector<NodeStatus> statuses(graph.nodes().size(), NodeStatus::Stable);
+        g_sink += registry.markOutdated(graph.nodes(), &statuses);
+    });
+}
+
+// Paints `steps` frames synchronously, calling step(i) before each, and
+// reports the frame statistics.
+QJsonObject runFrames(GraphView& view, const QString& name, int steps, const std::function<void(int)>& step,
+                      double budgetMs, bool* withinBudget)
+{
+    view.setRenderStatsEnabled(true); // also clears earlier frames
+    for (int i = 0; i < steps; i++) {
+        step(i);
+        view.viewport()->repaint();
+    }
+    const RenderStats::Summary s = view.renderStats().summary();
+    view.setRenderStatsEnabled(false);
+
+    QJsonObject o;
+    o["name"] = name;
+    o["frames"] = s.frames;
+    o["p50_ms"] = s.p50Ms;
+    o["p95_ms"] = s.p95Ms;
+    o["p99_ms"] = s.p99Ms;
+    o["max_ms"] = s.maxMs;
+    o["avg_nodes_painted"] = s.avgNodesPainted;
+    o["avg_edges_painted"] = s.avgEdgesPainted;
+    o["avg_node_paint_ms"] = s.avgNodePaintMs;
+    o["avg_edge_paint_ms"] = s.avgEdgePaintMs;
+    o["avg_exposed_pixels"] = s.avgExposedPixels;
+    if (budgetMs > 0) {
+        o["budget_ms"] = budgetMs;
+        o["within_budget"] = s.p95Ms <= budgetMs;
+        if (s.p95Ms > budgetMs)
+            *withinBudget = false;
+    }
+
+    QTextStream(stderr) << QString("%1 p50 %2 ms, p95 %3 ms (%4 frames)\n")
+                               .arg(name, -28)
+                               .arg(s.p50Ms, 0, 'f', 3)
+                               .arg(s.p95Ms, 0, 'f', 3)
+                               .arg(s.frames);
+    return o;
+}
+
+void benchLayoutAndView(Runner& r, GraphModel* graph, double budgetMs, QJsonArray* render, bool* withinBudget)
+{
+    const int n = graph->nodes().size();
+    const QVector<Edge>& edges = graph->edges();
+
+    r.run("layout.layered", n, [&]() {
+        g_sink += LayeredLayout::compute(n, edges).size();
+    });
+
+    // The view collapses large graphs into clusters first, so these measure
+    // what a user would wait for, not a full-size scene.
+    GraphView view;
+    view.resize(1400, 850);
+    r.run("view.rebuildScene", n,
+          [&]() { view.setModel(graph); },
+          [&]() { view.setModel(nullptr); });
+    view.setModel(graph);
+    r.run("view.applyInitialLayout", n, [&]() { view.relayout(); });
+
+    view.show();
+    if (r.selected("render.pan")) {
+        view.resetView();
+        view.scale(2.5, 2.5); // close enough to draw full cards
+        QScrollBar* h = view.horizontalScrollBar();
+        QScrollBar* v = view.verticalScrollBar();
+        render->push_back(runFrames(view, "render.pan", 240, [&](int i) {
+            // Back and forth so the sequence stays inside the scene.
+            const int dir = (i / 60) % 2 ? -1 : 1;
+            h->setValue(h->value() + dir * 24);
+            v->setValue(v->value() + dir * 12);
+        }, budgetMs, withinBudget));
+    }
+    if (r.selected("render.zoom")) {
+        view.resetView();
+        render->push_back(runFrames(view, "render.zoom", 240, [&](int i) {
+            const qreal f = (i / 60) % 2 ? 1 / 1.04 : 1.04;
+            view.scale(f, f);
+        }, budgetMs, withinBudget));
+    }
+}
+
+void benchExport(Runner& r, const GraphModel& graph)
+{
+    const int items = graph.nodes().size() + graph.edges().size();
+    r.run("export.json", items, [&]() { g_sink += graph.toJson().size(); });
+    r.run("export.csv", items, [&]() { g_sink += graph.toCsv().size(); });
+
+    const QVector<QPointF> positions = LayeredLayout::compute(graph.nodes().size(), graph.edges());
+    r.run("export.svg", items, [&]() {
+        QBuffer out;
+        out.open(QIODevice::WriteOnly);
+        QString err;
+        SvgWriter::writeGraph(&out, graph, positions, &err);
+        g_sink += out.size();
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    // GraphView needs a GUI application but not a display.
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("DepGraphBench");
+    QApplication::setApplicationVersion(DEPGRAPH_VERSION);
+
+    QCommandLineParser cli;
+    cli.setApplicationDescription("DepGraph benchmarks on synthetic repositories and graphs.");
+    cli.addHelpOption();
+    cli.addVersionOption();
+    QCommandLineOption scaleOpt("scale", "Input size: small, medium or large.", "scale", "small");
+    QCommandLineOption repeatOpt("repeat", "Timed iterations per benchmark.", "n", "5");
+    QCommandLineOption outOpt("out", "Write the JSON results here instead of stdout.", "file");
+    QCommandLineOption onlyOpt("only", "Run benchmarks whose name contains this text.", "text");
+    QCommandLineOption workOpt("work-dir", "Generate the repository here (kept) instead of a temporary directory.", "dir");
+    QCommandLineOption budgetOpt("frame-budget-ms", "Fail (exit 3) if a scripted pan/zoom p95 frame exceeds this.", "ms");
+    cli.addOptions({scaleOpt, repeatOpt, outOpt, onlyOpt, workOpt, budgetOpt});
+    cli.process(app);
+
+    QTextStream err(stderr);
+    Scale scale;
+    if (!scaleByName(cli.value(scaleOpt), &scale)) {
+        err << "Unknown scale " << cli.value(scaleOpt) << "; use small, medium or large.\n";
+        return 2;
+    }
+
+    QTemporaryDir tmp;
+    const QString workPath = cli.isSet(workOpt) ? cli.value(workOpt) : tmp.path();
+    QDir work(workPath);
+    if (workPath.isEmpty() || !work.mkpath(".")) {
+        err << "Cannot create a work directory.\n";
+        return 1;
+    }
+
+    QString genErr;
+    const int files = SyntheticRepo::write(work, scale.repo, &genErr);
+    if (files < 0) {
+        err << genErr << "\n";
+        return 1;
+    }
+    err << "Generated " << files << " manifests in " << work.absolutePath() << "\n";
+
+    Runner runner(cli.value(repeatOpt).toInt(), cli.value(onlyOpt));
+    GraphModel graph;
+    QJsonArray render;
+    bool withinBudget = true;
+    benchScan(runner, work);
+    benchModel(runner, scale.graph, &graph);
+    benchRegistry(runner, graph, work);
+    benchLayoutAndView(runner, &graph, cli.value(budgetOpt).toDouble(), &render, &withinBudget);
+    benchExport(runner, graph);
+
+    QJsonObject root;
+    root["version"] = QString(DEPGRAPH_VERSION);
+    root["qt"] = QString(qVersion());
+    root["platform"] = QSysInfo::prettyProductName();
+    root["cpu"] = QSysInfo::currentCpuArchitecture();
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["scale"] = cli.value(scaleOpt);
+    root["spec"] = specToJson(scale);
+    root["files"] = files;
+    root["results"] = runner.results();
+    root["render"] = render;
+    root["sink"] = g_sink;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (cli.isSet(outOpt)) {
+        QFile f(cli.value(outOpt));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(json) != json.size()) {
+            err << "Cannot write " << cli.value(outOpt) << "\n";
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    if (!withinBudget) {
+        err << "Frame-time budget exceeded.\n";
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+﻿#include "GitBlobReader.h"
+
+#include "util/Trace.h"
+
+// A blob that takes longer than this to arrive means git is stuck.
+static constexpr int kReadTimeoutMs = 30000;
+
+GitBlobReader::~GitBlobReader()
+{
+    close();
+}
+
+bool GitBlobReader::open(const QString& repoPath, QString* err)
+{
+    close();
+
+    m_proc.setProgram("git");
+    m_proc.setArguments({"-C", repoPath, "cat-file", "--batch"});
+    m_proc.start();
+    if (!m_proc.waitForStarted(5000)) {
+        if (err) *err = "Failed to start git. Is git installed and on PATH?";
+        return false;
+    }
+    return true;
+}
+
+void GitBlobReader::close()
+{
+    if (m_proc.state() == QProcess::NotRunning)
+        return;
+    // EOF on stdin ends the batch.
+    m_proc.closeWriteChannel();
+    if (!m_proc.waitForFinished(2000)) {
+        m_proc.kill();
+        m_proc.waitForFinished(1000);
+    }
+}
+
+bool GitBlobReader::readLine(QByteArray* line)
+{
+    while (!m_proc.canReadLine()) {
+        if (!m_proc.waitForReadyRead(kReadTimeoutMs))
+            return false;
+    }
+    *line = m_proc.readLine();
+    line->chop(1);
+    return true;
+}
+
+bool GitBlobReader::readExactly(qint64 size, QByteArray* out)
+{
+    out->clear();
+    out->reserve(size);
+    while (out->size() < size) {
+        if (m_proc.bytesAvailable() == 0 && !m_proc.waitForReadyRead(kReadTimeoutMs))
+            return false;
+        out->append(m_proc.read(size - out->size()));
+    }
+    return true;
+}
+
+bool GitBlobReader::read(const QString& objectId, QByteArray* out, QString* err)
+{
+    if (!isOpen()) {
+        if (err) *err = "git cat-file is not running.";
+        return false;
+    }
+    Trace::Span span("git.catFile", objectId);
+
+    m_proc.write(objectId.toLatin1() + '\n');
+
+    // "<id> <type> <size>" or "<id> missing"
+    QByteArray header;
+    if (!readLine(&header)) {
+        if (err) *err = QString("No reply from git cat-file for %1").arg(objectId);
+        return false;
+    }
+    const QList<QByteArray> f = header.split(' ');
+    if (f.size() < 3) {
+        if (err) *err = QString("git cat-file: %1").arg(QString::fromUtf8(header));
+        return false;
+    }
+
+    bool ok = false;
+    const qint64 size = f[2].toLongLong(&ok);
+    QByteArray trailer;
+    if (!ok || !readExactly(size, out) || !readExactly(1, &trailer)) {
+        if (err) *err = QString("Truncated object %1 from git cat-file").arg(objectId);
+        close(); // the stream is out of sync now
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QProcess>
+#include <QString>
+
+// One long-lived `git cat-file --batch` process: object ids go in on stdin
+// and contents come back on stdout, so reading thousands of blobs costs a
+// single process start and no working tree.
+//
+// Synchronous. Create, use and destroy it on one (worker) thread.
+class GitBlobReader {
+public:
+    GitBlobReader() = default;
+    ~GitBlobReader();
+    GitBlobReader(const GitBlobReader&) = delete;
+    GitBlobReader& operator=(const GitBlobReader&) = delete;
+
+    bool open(const QString& repoPath, QString* err);
+    void close();
+    bool isOpen() const { return m_proc.state() == QProcess::Running; }
+
+    bool read(const QString& objectId, QByteArray* out, QString* err);
+
+private:
+    bool readLine(QByteArray* line);
+    bool readExactly(qint64 size, QByteArray* out);
+
+    QProcess m_proc;
+};
@@ -4,6 +4,41 @@
 #include <QProcess>
 #include <QRegularExpression>
 
+#include <algorithm>
+
+#include "util/Trace.h"
+
+// Runs git in `repoPath` and returns its stdout; stderr goes into the error.
+static bool runGit(const QString& repoPath, const QStringList& args, QByteArray* out, QString* errorOut)
+{
+    Trace::Span span("git", Trace::isEnabled() ? args.join(' ') : QString());
+    QProcess p;
+    p.setProgram("git");
+    p.setArguments(QStringList{"-C", repoPath} + args);
+
+    p.start();
+    if (!p.waitForStarted(5000)) {
+        if (errorOut) *errorOut = "Failed to start git. Is git installed and on PATH?";
+        return false;
+    }
+    if (!p.waitForFinished(-1)) {
+        if (errorOut) *errorOut = QString("git %1 did not finish.").arg(args.value(0));
+        return false;
+    }
+    if (p.exitStatus() != QProcess::NormalExit || p.exitCode() != 0) {
+        if (errorOut) {
+            *errorOut = QString("git %1 failed (exit %2):\n%3")
+                            .arg(args.value(0))
+                            .arg(p.exitCode())
+                            .arg(QString::fromUtf8(p.readAllStandardError()));
+        }
+        return false;
+    }
+
+    *out = p.readAllStandardOutput();
+    return true;
+}
+
 GitHandler::GitHandler(QObject* parent) : QObject(parent) {}
 
 QString GitHandler::guessRepoFolderName(const QString& url)
@@ -42,6 +77,7 @@ QString GitHandler::cloneRepo(const QString& url, const QDir& baseDir, QString*
     QString ts = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
     QString targetPath = baseDir.absoluteFilePath(QString("%1-%2").arg(folder, ts));
 
+    Trace::Span span("git.clone", url);
     QProcess p;
     p.setProgram("git");
     p.setArguments({"clone", "--depth", "1", url, targetPath});
@@ -68,3 +104,76 @@ QString GitHandler::cloneRepo(const QString& url, const QDir& baseDir, QString*
 
     return targetPath;
 }
+
+QVector<GitHandler::Commit> GitHandler::listCommits(const QString& repoPath, const QString& ref, int maxCount, QString* errorOut)
+{
+    if (errorOut) *errorOut = QString();
+
+    // One record per commit: id, committer time, subject, separated by 0x1f.
+    QByteArray out;
+    const QStringList args{"log", "--first-parent", "-n", QString::number(maxCount),
+                           "--format=%H%x1f%ct%x1f%s", ref.isEmpty() ? QString("HEAD") : ref, "--"};
+    if (!runGit(repoPath, args, &out, errorOut))
+        return {};
+
+    QVector<Commit> commits;
+    for (const QByteArray& line : out.split('\n')) {
+        const QList<QByteArray> f = line.split('\x1f');
+        if (f.size() < 3)
+            continue;
+        commits.push_back({QString::fromLatin1(f[0]), f[1].toLongLong(), QString::fromUtf8(f[2])});
+    }
+    std::reverse(commits.begin(), commits.end());
+    return commits;
+}
+
+QVector<GitHandler::Commit> GitHandler::listTags(const QString& repoPath, QString* errorOut)
+{
+    if (errorOut) *errorOut = QString();
+
+    // Annotated tags are peeled (%(*objectname)) to the commit they point at.
+    QByteArray out;
+    const QStringList args{"for-each-ref", "--sort=creatordate",
+                           "--format=%(refname:short)%1f%(objecttype)%1f%(objectname)%1f%(*objecttype)%1f%(*objectname)%1f%(creatordate:unix)",
+                           "refs/tags"};
+    if (!runGit(repoPath, args, &out, errorOut))
+        return {};
+
+    QVector<Commit> tags;
+    for (const QByteArray& line : out.split('\n')) {
+        const QList<QByteArray> f = line.split('\x1f');
+        if (f.size() < 6)
+            continue;
+        QString id;
+        if (f[1] == "commit")
+            id = QString::fromLatin1(f[2]);
+        else if (f[3] == "commit")
+            id = QString::fromLatin1(f[4]);
+        else
+            continue; // tags of trees or blobs
+        tags.push_back({id, f[5].toLongLong(), QString::fromUtf8(f[0])});
+    }
+    return tags;
+}
+
+QVector<GitHandler::TreeEntry> GitHandler::listBlobs(const QString& repoPath, const QString& commit, QString* errorOut)
+{
+    if (errorOut) *errorOut = QString();
+
+    // -z: "<mode> <type> <id>\t<path>\0", paths unquoted.
+    QByteArray out;
+    if (!runGit(repoPath, {"ls-tree", "-r", "-z", "--full-tree", commit}, &out, errorOut))
+        return {};
+
+    QVector<TreeEntry> entries;
+    for (const QByteArray& record : out.split('\0')) {
+        const int tab = record.indexOf('\t');
+        if (tab < 0)
+            continue;
+        const QList<QByteArray> meta = record.left(tab).split(' ');
+        if (meta.size() < 3 || meta[1] != "blob")
+            continue;
+        entries.push_back({QString::fromUtf8(record.mid(tab + 1)), QString::fromLatin1(meta[2])});
+    }
+    return entries;
+}
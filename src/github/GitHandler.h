@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QVector>
 #include <QDir>
 
 class GitHandler : public QObject {
@@ -14,4 +15,23 @@ public:
     QString cloneRepo(const QString& url, const QDir& baseDir, QString* errorOut);
 
     static QString guessRepoFolderName(const QString& url);
+
+    // Read-only history queries. Synchronous; safe to call from worker threads.
+    struct Commit {
+        QString id;
+        qint64 time = 0; // committer time, seconds since the epoch
+        QString subject; // first line of the message, or the tag name
+    };
+
+    struct TreeEntry {
+        QString path; // repo-relative, '/'-separated
+        QString blobId;
+    };
+
+    // The last `maxCount` commits reachable from `ref` (first-parent), oldest first.
+    static QVector<Commit> listCommits(const QString& repoPath, const QString& ref, int maxCount, QString* errorOut);
+    // Tags pointing at commits, oldest first.
+    static QVector<Commit> listTags(const QString& repoPath, QString* errorOut);
+    // Every blob in the commit's tree (git ls-tree -r).
+    static QVector<TreeEntry> listBlobs(const QString& repoPath, const QString& commit, QString* errorOut);
 };
@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include <QColor>
+#include <QPointF>
+
+#include <cmath>
+
+#include "model/GraphDiff.h"
+#include "model/Node.h"
+
+// Look of the graph shared by the scene items and the exporters that draw
+// without a scene (SvgWriter), so both produce the same picture.
+namespace GraphStyle {
+
+constexpr qreal kCardWidth = 210;
+constexpr qreal kCardHeight = 64;
+
+inline QColor statusColor(NodeStatus s)
+{
+    switch (s) {
+    case NodeStatus::Stable: return QColor(60, 220, 160);
+    case NodeStatus::Outdated: return QColor(245, 200, 80);
+    case NodeStatus::Deprecated: return QColor(255, 110, 110);
+    case NodeStatus::Conflict: return QColor(255, 80, 160);
+    case NodeStatus::Vulnerable: return QColor(170, 110, 255);
+    }
+    return QColor(60, 220, 160);
+}
+
+inline QColor diffColor(GraphDiff::Change c, int alpha)
+{
+    switch (c) {
+    case GraphDiff::Change::Added: return QColor(90, 230, 130, alpha);
+    case GraphDiff::Change::Removed: return QColor(255, 90, 90, alpha);
+    case GraphDiff::Change::Changed: return QColor(90, 200, 255, alpha);
+    case GraphDiff::Change::None: break;
+    }
+    return QColor();
+}
+
+// Paint order: later styles are drawn on top.
+enum EdgeStyle { PlainEdge, ChangedEdge, AddedEdge, RemovedEdge, HighlightedEdge, kEdgeStyles };
+
+// Aggregated edges are drawn wider the more model edges they stand for.
+constexpr int kWeightBuckets = 4;
+
+inline int weightBucket(int weight)
+{
+    if (weight <= 1) return 0;
+    if (weight < 10) return 1;
+    if (weight < 100) return 2;
+    return 3;
+}
+
+inline qreal edgeWidth(int style, int bucket)
+{
+    static constexpr qreal kBucketWidth[kWeightBuckets] = {1.4, 2.4, 3.6, 5.0};
+    return kBucketWidth[bucket] + (style == PlainEdge ? 0.0 : 0.8);
+}
+
+// Removed edges are additionally dashed.
+inline QColor edgeColor(int style)
+{
+    switch (style) {
+    case HighlightedEdge: return QColor(255, 235, 160, 150);
+    case RemovedEdge: return diffColor(GraphDiff::Change::Removed, 170);
+    case AddedEdge: return diffColor(GraphDiff::Change::Added, 170);
+    case ChangedEdge: return diffColor(GraphDiff::Change::Changed, 170);
+    }
+    return QColor(120, 170, 255, 60);
+}
+
+inline QColor arrowColor(int style)
+{
+    switch (style) {
+    case HighlightedEdge: return QColor(255, 235, 160, 170);
+    case RemovedEdge: return diffColor(GraphDiff::Change::Removed, 190);
+    case AddedEdge: return diffColor(GraphDiff::Change::Added, 190);
+    case ChangedEdge: return diffColor(GraphDiff::Change::Changed, 190);
+    }
+    return QColor(160, 200, 255, 80);
+}
+
+// A quadratic curve between two card centres, bowed to the left of the
+// direction of travel, with an arrowhead close to the target.
+struct EdgeGeometry {
+    QPointF p1;
+    QPointF ctrl;
+    QPointF p2;
+    QPointF arrow[3];
+
+    QPointF midpoint() const { return 0.25 * p1 + 0.5 * ctrl + 0.25 * p2; }
+
+    static EdgeGeometry between(const QPointF& p1, const QPointF& p2)
+    {
+        EdgeGeometry g;
+        const QPointF mid = (p1 + p2) * 0.5;
+        const QPointF d = p2 - p1;
+        QPointF n(-d.y(), d.x());
+        const qreal nlen = std::sqrt(QPointF::dotProduct(n, n));
+        if (nlen > 1e-6)
+            n /= nlen;
+
+        const qreal dist = std::sqrt(QPointF::dotProduct(d, d));
+        const qreal bend = qBound(-60.0, dist * 0.10, 60.0);
+        const QPointF c = mid + n * bend;
+        g.p1 = p1;
+        g.ctrl = c;
+        g.p2 = p2;
+
+        // Evaluated on the quadratic directly.
+        auto at = [&](qreal s) { return (1 - s) * (1 - s) * p1 + 2 * (1 - s) * s * c + s * s * p2; };
+        const QPointF t = at(0.93);
+        QPointF dir = at(0.96) - t;
+        const qreal len = std::sqrt(QPointF::dotProduct(dir, dir));
+        if (len > 1e-6) {
+            dir /= len;
+            const QPointF left(-dir.y(), dir.x());
+            g.arrow[0] = t;
+            g.arrow[1] = t + (-dir * 10) + (left * 4);
+            g.arrow[2] = t + (-dir * 10) - (left * 4);
+        } else {
+            g.arrow[0] = g.arrow[1] = g.arrow[2] = t;
+        }
+        return g;
+    }
+};
+
+} // namespace GraphStyle
@@ -3,17 +3,64 @@
 #include <QGraphicsScene>
 #include <QGraphicsDropShadowEffect>
 #include <QGraphicsSceneMouseEvent>
+#include <QFontMetricsF>
 #include <QKeyEvent>
 #include <QMouseEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
 #include <QWheelEvent>
 #include <QPainter>
 #include <QRandomGenerator>
 #include <QScrollBar>
-#include <QSvgGenerator>
-#include <QQueue>
+#include <QSaveFile>
 #include <QSet>
+#include <QStaticText>
+#include <QStringList>
+#include <QStyleOptionGraphicsItem>
+#include <QElapsedTimer>
 #include <QtMath>
 
+#include <cmath>
+
+#include "gui/GraphStyle.h"
+#include "gui/SvgWriter.h"
+#include "gui/TileCache.h"
+#include "layout/ForceLayout.h"
+#include "layout/LayeredLayout.h"
+#include "model/GraphDiff.h"
+#include "model/ReachabilityIndex.h"
+#include "util/MemoryReport.h"
+#include "util/Trace.h"
+
+// Below this zoom the view is composited from rasterised overview tiles.
+static constexpr qreal kTileLod = 0.18;
+// Clusters are collapsed until the visible frontier fits this many items.
+static constexpr int kFrontierBudget = 1500;
+
+// Rough per-object costs Qt does not expose, for reportMemory().
+static constexpr qint64 kGraphicsItemPrivateBytes = 360; // QGraphicsItemPrivate + QObject data
+static constexpr qint64 kStaticTextBytes = 160;          // QStaticTextPrivate
+static constexpr qint64 kStaticGlyphBytes = 24;          // glyph index and position per character
+static constexpr qint64 kGradientBrushBytes = 200;
+static constexpr qint64 kBspNodeBytes = 24;
+
+using GraphStyle::diffColor;
+
+// A supernode or aggregated edge shows the most significant change folded into it.
+static GraphDiff::Change strongerChange(GraphDiff::Change a, GraphDiff::Change b)
+{
+    auto rank = [](GraphDiff::Change c) {
+        switch (c) {
+        case GraphDiff::Change::None: return 0;
+        case GraphDiff::Change::Changed: return 1;
+        case GraphDiff::Change::Added: return 2;
+        case GraphDiff::Change::Removed: return 3;
+        }
+        return 0;
+    };
+    return rank(b) > rank(a) ? b : a;
+}
+
 class GraphView::NodeItem : public QGraphicsObject {
     Q_OBJECT
 public:
@@ -25,6 +72,9 @@ public:
         // Nodes move a lot during layout; caching tends to look "laggy"/smeary.
         setCacheMode(NoCache);
 
+        refreshStyle();
+        refreshLabels();
+
         // deterministic initial scatter (qrand/qsrand were removed in Qt 6)
         QRandomGenerator rng(quint32(n.id * 2654435761u));
         qreal x = (rng.bounded(400)) - 200;
@@ -34,171 +84,707 @@ public:
 
     QRectF boundingRect() const override { return QRectF(-m_w/2, -m_h/2, m_w, m_h); }
 
-    void setStatus(NodeStatus s) { m_node.status = s; update(); }
-    void setText(const QString& name, const QString& version) { m_node.name = name; m_node.version = version; update(); }
+    void setStatus(NodeStatus s)
+    {
+        m_node.status = s;
+        refreshStyle();
+        update();
+    }
+
+    void setText(const QString& name, const QString& version)
+    {
+        m_node.name = name;
+        m_node.version = version;
+        refreshLabels();
+        update();
+    }
 
     int nodeId() const { return m_node.id; }
     const Node& node() const { return m_node; }
 
+    qint64 memoryBytes() const
+    {
+        return qint64(sizeof(*this)) + kGraphicsItemPrivateBytes + kGradientBrushBytes +
+               MemoryReport::bytesOf(m_node.name) + MemoryReport::bytesOf(m_node.version) +
+               MemoryReport::bytesOf(m_node.kind) + MemoryReport::bytesOf(m_diffOldVersion) +
+               2 * kStaticTextBytes + (m_title.text().size() + m_sub.text().size()) * kStaticGlyphBytes;
+    }
+    bool isSupernode() const { return m_node.id <= -2; }
+
     QPointF velocity;
 
-    void setHighlighted(bool on) { m_highlight = on; update(); }
+    void setHighlighted(bool on)
+    {
+        if (on == m_highlight)
+            return;
+        m_highlight = on;
+        update();
+    }
+
+    bool isHighlighted() const { return m_highlight; }
+
+    // Part of a dependency cycle (for supernodes: contains one).
+    void setInCycle(bool on)
+    {
+        if (on == m_inCycle)
+            return;
+        m_inCycle = on;
+        update();
+    }
+    bool isInCycle() const { return m_inCycle; }
+
+    // Labels as drawn, i.e. already elided to the card width.
+    QString titleText() const { return m_title.text(); }
+    QString subtitleText() const { return m_sub.text(); }
+
+    GraphDiff::Change diffChange() const { return m_diff; }
+
+    // `oldVersion` is shown in the tooltip of changed nodes.
+    void setDiffChange(GraphDiff::Change c, const QString& oldVersion = QString())
+    {
+        m_diffOldVersion = oldVersion;
+        if (c == m_diff)
+            return;
+        m_diff = c;
+        setOpacity(c == GraphDiff::Change::Removed ? 0.55 : 1.0);
+        update();
+    }
+
+    // Colour of the node's dot in the rasterised overview.
+    QColor overviewColor() const
+    {
+        if (m_highlight)
+            return QColor(255, 245, 170, 220);
+        if (m_diff != GraphDiff::Change::None)
+            return diffColor(m_diff, 220);
+        return m_fill;
+    }
+    qreal overviewRadius() const { return m_h * 0.5; }
 
 signals:
     void clicked(int nodeId);
+    void doubleClicked(int nodeId);
 
 protected:
-    void paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*) override
+    void paint(QPainter* p, const QStyleOptionGraphicsItem* opt, QWidget*) override
     {
-        p->setRenderHint(QPainter::Antialiasing, true);
+        RenderStats& stats = m_owner->m_renderStats;
+        if (!stats.isEnabled()) {
+            paintCard(p, opt);
+            return;
+        }
+        QElapsedTimer t;
+        t.start();
+        paintCard(p, opt);
+        stats.addNodePaint(t.nsecsElapsed());
+    }
 
-        QColor base = m_owner->colorForStatus(m_node.status);
-        QColor fill = base;
-        fill.setAlpha(210);
+    void paintCard(QPainter* p, const QStyleOptionGraphicsItem* opt)
+    {
+        // Level of detail: how many device pixels one scene unit covers.
+        const qreal lod = opt->levelOfDetailFromTransform(p->worldTransform());
 
+        const bool inDiff = m_diff != GraphDiff::Change::None;
         QColor stroke = QColor(170, 210, 255, 60);
+        if (m_inCycle) stroke = QColor(255, 80, 160, 200);
+        if (inDiff) stroke = diffColor(m_diff, 230);
         if (isSelected()) stroke = QColor(255, 255, 255, 140);
         if (m_highlight) stroke = QColor(255, 245, 170, 200);
+        const Qt::PenStyle strokeStyle = m_diff == GraphDiff::Change::Removed ? Qt::DashLine : Qt::SolidLine;
 
-        QLinearGradient g(boundingRect().topLeft(), boundingRect().bottomRight());
-        g.setColorAt(0.0, fill.lighter(120));
-        g.setColorAt(1.0, fill.darker(130));
+        if (lod < kDotLod) {
+            // Far out only the colour is distinguishable.
+            p->setRenderHint(QPainter::Antialiasing, false);
+            p->setPen(Qt::NoPen);
+            p->setBrush((m_highlight || inDiff) ? stroke : m_fill);
+            p->drawEllipse(QPointF(0, 0), m_h * 0.5, m_h * 0.5);
+            return;
+        }
 
-        p->setPen(QPen(stroke, m_highlight ? 2.5 : 1.4));
-        p->setBrush(g);
+        if (lod < kTextLod) {
+            // Text would be unreadable at this size; draw the card without it.
+            p->setRenderHint(QPainter::Antialiasing, false);
+            p->setPen(QPen(stroke, (m_highlight || inDiff || isSupernode()) ? 2.5 : 1.4, strokeStyle));
+            p->setBrush(m_fill);
+            p->drawRect(boundingRect());
+            return;
+        }
+
+        p->setRenderHint(QPainter::Antialiasing, true);
+        p->setPen(QPen(stroke, (m_highlight || inDiff) ? 2.5 : 1.4, strokeStyle));
+        p->setBrush(m_cardBrush);
         p->drawRoundedRect(boundingRect(), 16, 16);
+        if (isSupernode()) {
+            // Double border marks a collapsed cluster.
+            p->setBrush(Qt::NoBrush);
+            p->drawRoundedRect(boundingRect().adjusted(4, 4, -4, -4), 12, 12);
+        }
+        if (m_inCycle) {
+            p->setBrush(Qt::NoBrush);
+            p->setPen(QPen(QColor(255, 80, 160, 220), 2.0, Qt::DashLine));
+            p->drawRoundedRect(boundingRect().adjusted(1, 1, -1, -1), 15, 15);
+        }
 
-        // label
+        // Labels are shaped once in refreshLabels(); drawing them is a blit of
+        // the cached glyph layout as long as the painter font matches.
+        const QRectF r = boundingRect().adjusted(12, 10, -12, -10);
         p->setPen(QColor(230, 240, 255, 235));
-        QFont f = p->font();
-        f.setBold(true);
-        f.setPointSizeF(f.pointSizeF() + 0.5);
-        p->setFont(f);
-
-        QString title = m_node.name;
-        if (title.size() > 26)
-            title = title.left(24) + "..";
-
-        QRectF r = boundingRect().adjusted(12, 10, -12, -10);
-        p->drawText(r, Qt::AlignTop | Qt::AlignLeft, title);
+        p->setFont(m_titleFont);
+        p->drawStaticText(r.topLeft(), m_title);
 
         p->setPen(QColor(205, 220, 240, 200));
-        QFont f2 = p->font();
-        f2.setBold(false);
-        f2.setPointSizeF(f2.pointSizeF() - 1);
-        p->setFont(f2);
-
-        const QString sub = (m_node.version.isEmpty() ? QString("(") + m_node.kind + ")" : (m_node.version + "  (" + m_node.kind + ")"));
-        p->drawText(r, Qt::AlignBottom | Qt::AlignLeft, sub);
+        p->setFont(m_subFont);
+        p->drawStaticText(QPointF(r.left(), r.bottom() - m_sub.size().height()), m_sub);
     }
 
     void hoverEnterEvent(QGraphicsSceneHoverEvent*) override
     {
-        setToolTip(QString("%1\n%2\nstatus: %3")
-                       .arg(m_node.name)
-                       .arg(m_node.version.isEmpty() ? "(no version)" : m_node.version)
-                       .arg(nodeStatusToString(m_node.status)));
+        QString tip = QString("%1\n%2\nstatus: %3")
+                          .arg(m_node.name)
+                          .arg(m_node.version.isEmpty() ? "(no version)" : m_node.version)
+                          .arg(nodeStatusToString(m_node.status));
+        if (m_inCycle)
+            tip += "\npart of a dependency cycle";
+        if (m_diff == GraphDiff::Change::Added)
+            tip += "\nadded since the baseline";
+        else if (m_diff == GraphDiff::Change::Removed)
+            tip += "\nremoved since the baseline";
+        else if (m_diff == GraphDiff::Change::Changed)
+            tip += m_diffOldVersion.isEmpty() ? QString("\nchanged since the baseline")
+                                              : QString("\nwas %1 in the baseline").arg(m_diffOldVersion);
+        if (isSupernode())
+            tip += "\ndouble-click to expand";
+        setToolTip(tip);
     }
 
     void mousePressEvent(QGraphicsSceneMouseEvent* e) override
     {
         if (e->button() == Qt::LeftButton) {
             emit clicked(m_node.id);
+            if (m_owner)
+                m_owner->nodeDragStarted();
         }
         QGraphicsObject::mousePressEvent(e);
     }
 
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override
+    {
+        QGraphicsObject::mouseReleaseEvent(e);
+        if (e->button() == Qt::LeftButton && m_owner)
+            m_owner->nodeDragFinished();
+    }
+
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* e) override
+    {
+        if (e->button() == Qt::LeftButton) {
+            emit doubleClicked(m_node.id);
+            e->accept();
+            return;
+        }
+        QGraphicsObject::mouseDoubleClickEvent(e);
+    }
+
     QVariant itemChange(GraphicsItemChange change, const QVariant& value) override
     {
         if (change == ItemPositionHasChanged) {
-            if (m_owner)
-                m_owner->updateEdges();
+            if (m_owner && !m_owner->m_bulkMove)
+                m_owner->nodeMoved(this, m_lastPos);
+            m_lastPos = pos();
         }
         return QGraphicsObject::itemChange(change, value);
     }
 
 private:
+    // Below kDotLod nodes are drawn as dots, below kTextLod as plain boxes.
+    static constexpr qreal kDotLod = 0.18;
+    static constexpr qreal kTextLod = 0.55;
+
+    void refreshStyle()
+    {
+        m_fill = m_owner->colorForStatus(m_node.status);
+        m_fill.setAlpha(210);
+
+        QLinearGradient g(boundingRect().topLeft(), boundingRect().bottomRight());
+        g.setColorAt(0.0, m_fill.lighter(120));
+        g.setColorAt(1.0, m_fill.darker(130));
+        m_cardBrush = QBrush(g);
+    }
+
+    void refreshLabels()
+    {
+        const QFont base = m_owner->font();
+
+        m_titleFont = base;
+        m_titleFont.setBold(true);
+        m_titleFont.setPointSizeF(base.pointSizeF() + 0.5);
+
+        m_subFont = base;
+        m_subFont.setPointSizeF(base.pointSizeF() - 1);
+
+        const qreal textWidth = m_w - 24;
+        const QString title = QFontMetricsF(m_titleFont).elidedText(m_node.name, Qt::ElideRight, textWidth);
+        const QString sub = (m_node.version.isEmpty() ? QString("(") + m_node.kind + ")" : (m_node.version + "  (" + m_node.kind + ")"));
+
+        m_title.setText(title);
+        m_title.setTextFormat(Qt::PlainText);
+        m_title.prepare(QTransform(), m_titleFont);
+
+        m_sub.setText(QFontMetricsF(m_subFont).elidedText(sub, Qt::ElideRight, textWidth));
+        m_sub.setTextFormat(Qt::PlainText);
+        m_sub.prepare(QTransform(), m_subFont);
+    }
+
     Node m_node;
     GraphView* m_owner = nullptr;
-    qreal m_w = 210;
-    qreal m_h = 64;
+    qreal m_w = GraphStyle::kCardWidth;
+    qreal m_h = GraphStyle::kCardHeight;
     bool m_highlight = false;
+    QPointF m_lastPos;
+
+    QColor m_fill;
+    bool m_inCycle = false;
+    GraphDiff::Change m_diff = GraphDiff::Change::None;
+    QString m_diffOldVersion;
+    QBrush m_cardBrush;
+    QFont m_titleFont;
+    QFont m_subFont;
+    QStaticText m_title;
+    QStaticText m_sub;
 };
 
-class GraphView::EdgeItem : public QGraphicsItem {
+// All edges live in one scene item. Geometry is kept in flat per-edge arrays
+// and bucketed into a uniform grid so paint() only touches edges that
+// intersect the exposed rect; everything visible is drawn in a few path calls.
+class GraphView::EdgeLayer : public QGraphicsItem {
 public:
-    EdgeItem(NodeItem* a, NodeItem* b)
-        : m_a(a), m_b(b)
+    enum Flag : quint8 {
+        Highlighted = 0x1,
+        Loose = 0x2, // geometry changed since the grid was built; tracked in m_loose
+        DiffAdded = 0x4,
+        DiffRemoved = 0x8,
+        DiffChanged = 0x10,
+        DiffMask = DiffAdded | DiffRemoved | DiffChanged
+    };
+
+    explicit EdgeLayer(RenderStats* stats)
+        : m_stats(stats)
     {
         setZValue(-10);
         setCacheMode(NoCache);
+        setFlag(ItemUsesExtendedStyleOption, true); // we need exposedRect for culling
     }
 
-    QRectF boundingRect() const override
+    QRectF boundingRect() const override { return m_bounds; }
+
+    qint64 memoryBytes() const
     {
-        return m_cachedRect;
+        qint64 bytes = qint64(sizeof(*this)) + kGraphicsItemPrivateBytes;
+        bytes += MemoryReport::bytesOf(m_src) + MemoryReport::bytesOf(m_dst) + MemoryReport::bytesOf(m_weight);
+        bytes += MemoryReport::bytesOf(m_p1) + MemoryReport::bytesOf(m_ctrl) + MemoryReport::bytesOf(m_p2);
+        bytes += MemoryReport::bytesOf(m_arrows) + MemoryReport::bytesOf(m_flags);
+        bytes += MemoryReport::bytesOf(m_cellOffsets) + MemoryReport::bytesOf(m_cellEdges) + MemoryReport::bytesOf(m_loose);
+        bytes += MemoryReport::bytesOf(m_visible) + MemoryReport::bytesOf(m_stamp);
+        bytes += MemoryReport::bytesOf(m_incident);
+        for (const QVector<int>& incident : m_incident)
+            bytes += MemoryReport::bytesOf(incident);
+        return bytes;
     }
 
-    void paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*) override
+    // `weights` holds how many model edges each drawn edge stands for.
+    void setEdges(const QVector<QPair<NodeItem*, NodeItem*>>& edges, const QVector<int>& weights)
     {
-        p->setRenderHint(QPainter::Antialiasing, true);
-        QPen pen(QColor(120, 170, 255, 60), 1.4);
-        p->setPen(pen);
-        p->drawPath(m_cachedPath);
-
-        // arrow head near target
-        QPointF t = m_cachedPath.pointAtPercent(0.93);
-        QPointF t2 = m_cachedPath.pointAtPercent(0.96);
-        QPointF dir = (t2 - t);
-        if (!dir.isNull()) {
-            dir /= std::sqrt(QPointF::dotProduct(dir, dir));
-            QPointF left(-dir.y(), dir.x());
-            QPointF a1 = t + (-dir * 10) + (left * 4);
-            QPointF a2 = t + (-dir * 10) - (left * 4);
-            QPolygonF tri;
-            tri << t << a1 << a2;
-            p->setBrush(QColor(160, 200, 255, 80));
-            p->setPen(Qt::NoPen);
-            p->drawPolygon(tri);
+        const int n = edges.size();
+        m_weight = weights;
+        m_weight.resize(n);
+        m_src.resize(n);
+        m_dst.resize(n);
+        m_p1.resize(n);
+        m_ctrl.resize(n);
+        m_p2.resize(n);
+        m_arrows.resize(n * 3);
+        m_flags.fill(0, n);
+        m_stamp.fill(0, n);
+        m_incident.clear();
+
+        for (int i = 0; i < n; i++) {
+            m_src[i] = edges[i].first;
+            m_dst[i] = edges[i].second;
+            m_weight[i] = qMax(1, m_weight[i]);
+            m_incident[m_src[i]].push_back(i);
+            m_incident[m_dst[i]].push_back(i);
         }
+        syncAll();
     }
 
-    void syncGeometry()
+    int edgeCount() const { return m_src.size(); }
+
+    // Recomputes every edge and rebuilds the grid (after layouts / bulk moves).
+    void syncAll()
     {
-        if (!m_a || !m_b)
-            return;
+        for (int i = 0; i < m_src.size(); i++)
+            computeGeometry(i);
+
+        QRectF bounds;
+        for (int i = 0; i < m_src.size(); i++)
+            bounds |= edgeRect(i);
+        bounds = bounds.adjusted(-45, -45, 45, 45);
+        if (bounds != m_bounds) {
+            prepareGeometryChange();
+            m_bounds = bounds;
+        }
+        rebuildGrid();
+        update();
+    }
 
-        const QPointF p1 = m_a->pos();
-        const QPointF p2 = m_b->pos();
-
-        // Curved edge
-        QPainterPath path;
-        QPointF mid = (p1 + p2) * 0.5;
-        QPointF d = p2 - p1;
-        QPointF n(-d.y(), d.x());
-        const qreal nlen = std::sqrt(QPointF::dotProduct(n, n));
-        if (nlen > 1e-6)
-            n /= nlen;
-
-        const qreal dist = std::sqrt(QPointF::dotProduct(d, d));
-        const qreal bend = qBound(-60.0, dist * 0.10, 60.0);
-        const QPointF c = mid + n * bend;
-        path.moveTo(p1);
-        path.quadTo(c, p2);
-
-        const QRectF nr = path.boundingRect().adjusted(-45, -45, 45, 45);
-        if (nr != m_cachedRect) {
+    // Recomputes only the edges incident to a node that was moved interactively.
+    // They are moved to the loose list instead of re-bucketing the whole grid.
+    // Returns the scene area touched by the old and new geometry.
+    QRectF syncNode(const NodeItem* node)
+    {
+        auto it = m_incident.constFind(node);
+        if (it == m_incident.constEnd())
+            return QRectF();
+
+        QRectF dirty;
+        for (int i : it.value()) {
+            dirty |= edgeRect(i);
+            computeGeometry(i);
+            dirty |= edgeRect(i);
+            if (!(m_flags[i] & Loose)) {
+                m_flags[i] |= Loose;
+                m_loose.push_back(i);
+            }
+        }
+
+        const QRectF bounds = m_bounds | dirty.adjusted(-45, -45, 45, 45);
+        if (bounds != m_bounds) {
             prepareGeometryChange();
-            m_cachedRect = nr;
+            m_bounds = bounds;
+        }
+        if (m_loose.size() > kMaxLoose)
+            rebuildGrid();
+        update(dirty);
+        return dirty;
+    }
+
+    void writeSvg(SvgWriter* w) const
+    {
+        for (int i = 0; i < m_src.size(); i++) {
+            quint8 f = 0;
+            if (m_flags[i] & Highlighted) f |= SvgWriter::Highlighted;
+            if (m_flags[i] & DiffAdded) f |= SvgWriter::Added;
+            if (m_flags[i] & DiffRemoved) f |= SvgWriter::Removed;
+            if (m_flags[i] & DiffChanged) f |= SvgWriter::Changed;
+            w->addEdge(m_p1[i], m_p2[i], m_weight[i], f);
         }
-        m_cachedPath = path;
+    }
+
+    void exportLines(QVector<QLineF>* lines, QVector<quint8>* highlighted) const
+    {
+        lines->reserve(m_src.size());
+        highlighted->reserve(m_src.size());
+        for (int i = 0; i < m_src.size(); i++) {
+            lines->push_back(QLineF(m_p1[i], m_p2[i]));
+            highlighted->push_back((m_flags[i] & Highlighted) ? 1 : 0);
+        }
+    }
+
+    // Returns the scene area of edges whose highlight state changed.
+    QRectF setHighlighted(const QSet<int>& nodeIds)
+    {
+        QRectF dirty;
+        for (int i = 0; i < m_src.size(); i++) {
+            const bool on = !nodeIds.isEmpty() && nodeIds.contains(m_src[i]->nodeId()) && nodeIds.contains(m_dst[i]->nodeId());
+            const quint8 f = on ? (m_flags[i] | Highlighted) : (m_flags[i] & ~Highlighted);
+            if (f != m_flags[i]) {
+                m_flags[i] = f;
+                dirty |= edgeRect(i);
+            }
+        }
+        if (!dirty.isNull())
+            update(dirty);
+        return dirty;
+    }
+
+    // `changes` holds one GraphDiff::Change per edge (missing entries mean
+    // none). Returns the scene area of edges whose overlay changed.
+    QRectF setDiff(const QVector<GraphDiff::Change>& changes)
+    {
+        QRectF dirty;
+        for (int i = 0; i < m_src.size(); i++) {
+            quint8 f = m_flags[i] & ~DiffMask;
+            switch (changes.value(i, GraphDiff::Change::None)) {
+            case GraphDiff::Change::Added: f |= DiffAdded; break;
+            case GraphDiff::Change::Removed: f |= DiffRemoved; break;
+            case GraphDiff::Change::Changed: f |= DiffChanged; break;
+            case GraphDiff::Change::None: break;
+            }
+            if (f != m_flags[i]) {
+                m_flags[i] = f;
+                dirty |= edgeRect(i);
+            }
+        }
+        if (!dirty.isNull())
+            update(dirty);
+        return dirty;
+    }
+
+    void paint(QPainter* p, const QStyleOptionGraphicsItem* opt, QWidget*) override
+    {
+        if (!m_stats || !m_stats->isEnabled()) {
+            paintEdges(p, opt);
+            return;
+        }
+        QElapsedTimer t;
+        t.start();
+        paintEdges(p, opt);
+        m_stats->addEdgePaint(t.nsecsElapsed(), m_visible.size());
     }
 
 private:
-    NodeItem* m_a;
-    NodeItem* m_b;
-    QPainterPath m_cachedPath;
-    QRectF m_cachedRect;
+    void paintEdges(QPainter* p, const QStyleOptionGraphicsItem* opt)
+    {
+        const QRectF exposed = opt->exposedRect;
+        const qreal lod = opt->levelOfDetailFromTransform(p->worldTransform());
+
+        collectVisible(exposed);
+        if (m_visible.isEmpty())
+            return;
+
+        if (lod < kLineLod) {
+            // Far out: straight segments without arrowheads, no antialiasing.
+            QVector<QLineF> lines[kStyles][kWeightBuckets];
+            for (int i : m_visible)
+                lines[styleOf(i)][GraphStyle::weightBucket(m_weight[i])].push_back(QLineF(m_p1[i], m_p2[i]));
+
+            p->setRenderHint(QPainter::Antialiasing, false);
+            for (int s = 0; s < kStyles; s++) {
+                for (int b = 0; b < kWeightBuckets; b++) {
+                    if (lines[s][b].isEmpty())
+                        continue;
+                    p->setPen(stylePen(s, b));
+                    p->drawLines(lines[s][b]);
+                }
+            }
+            return;
+        }
+
+        // Aggregated edges are bucketed by weight so each width is one path.
+        QPainterPath curves[kStyles][kWeightBuckets];
+        QPainterPath arrows[kStyles];
+        for (int i : m_visible) {
+            const int s = styleOf(i);
+            QPainterPath& c = curves[s][GraphStyle::weightBucket(m_weight[i])];
+            c.moveTo(m_p1[i]);
+            c.quadTo(m_ctrl[i], m_p2[i]);
+
+            QPainterPath& a = arrows[s];
+            a.moveTo(m_arrows[i * 3]);
+            a.lineTo(m_arrows[i * 3 + 1]);
+            a.lineTo(m_arrows[i * 3 + 2]);
+            a.closeSubpath();
+        }
+
+        p->setRenderHint(QPainter::Antialiasing, true);
+        p->setBrush(Qt::NoBrush);
+        for (int s = 0; s < kStyles; s++) {
+            for (int b = 0; b < kWeightBuckets; b++) {
+                if (curves[s][b].isEmpty())
+                    continue;
+                p->setPen(stylePen(s, b));
+                p->drawPath(curves[s][b]);
+            }
+        }
+
+        p->setPen(Qt::NoPen);
+        for (int s = 0; s < kStyles; s++) {
+            if (arrows[s].isEmpty())
+                continue;
+            p->setBrush(GraphStyle::arrowColor(s));
+            p->drawPath(arrows[s]);
+        }
+
+        if (lod < kCountLod)
+            return;
+
+        // Edge counts on aggregated edges, at the curve's midpoint.
+        p->setPen(QColor(205, 220, 240, 200));
+        for (int i : m_visible) {
+            if (m_weight[i] <= 1)
+                continue;
+            const QPointF mid = 0.25 * m_p1[i] + 0.5 * m_ctrl[i] + 0.25 * m_p2[i];
+            p->drawText(QRectF(mid.x() - 30, mid.y() - 18, 60, 14), Qt::AlignCenter, QString::number(m_weight[i]));
+        }
+    }
+
+    // Below kLineLod edges are drawn as straight lines without arrowheads.
+    static constexpr qreal kLineLod = 0.35;
+    // Below kCountLod aggregated edges are drawn without their counts.
+    static constexpr qreal kCountLod = 0.55;
+    static constexpr int kWeightBuckets = GraphStyle::kWeightBuckets;
+    static constexpr int kMaxLoose = 4096;
+    static constexpr int kMaxCellsPerEdge = 64;
+    static constexpr int kStyles = GraphStyle::kEdgeStyles;
+
+    int styleOf(int i) const
+    {
+        const quint8 f = m_flags[i];
+        if (f & Highlighted) return GraphStyle::HighlightedEdge;
+        if (f & DiffRemoved) return GraphStyle::RemovedEdge;
+        if (f & DiffAdded) return GraphStyle::AddedEdge;
+        if (f & DiffChanged) return GraphStyle::ChangedEdge;
+        return GraphStyle::PlainEdge;
+    }
+
+    static QPen stylePen(int style, int bucket)
+    {
+        return QPen(GraphStyle::edgeColor(style), GraphStyle::edgeWidth(style, bucket),
+                    style == GraphStyle::RemovedEdge ? Qt::DashLine : Qt::SolidLine);
+    }
+
+    QRectF edgeRect(int i) const
+    {
+        const QPointF& a = m_p1[i];
+        const QPointF& c = m_ctrl[i];
+        const QPointF& b = m_p2[i];
+        const qreal x0 = qMin(a.x(), qMin(b.x(), c.x()));
+        const qreal x1 = qMax(a.x(), qMax(b.x(), c.x()));
+        const qreal y0 = qMin(a.y(), qMin(b.y(), c.y()));
+        const qreal y1 = qMax(a.y(), qMax(b.y(), c.y()));
+        // Aggregated edges also carry a count label at the midpoint.
+        const qreal pad = m_weight[i] > 1 ? 30 : 12;
+        return QRectF(QPointF(x0, y0), QPointF(x1, y1)).adjusted(-pad, -pad, pad, pad);
+    }
+
+    void computeGeometry(int i)
+    {
+        const auto g = GraphStyle::EdgeGeometry::between(m_src[i]->pos(), m_dst[i]->pos());
+        m_p1[i] = g.p1;
+        m_ctrl[i] = g.ctrl;
+        m_p2[i] = g.p2;
+        m_arrows[i * 3] = g.arrow[0];
+        m_arrows[i * 3 + 1] = g.arrow[1];
+        m_arrows[i * 3 + 2] = g.arrow[2];
+    }
+
+    void rebuildGrid()
+    {
+        for (int i : m_loose)
+            m_flags[i] &= ~Loose;
+        m_loose.clear();
+
+        const int n = m_src.size();
+        m_gridOrigin = m_bounds.topLeft();
+        // Aim for roughly 16k cells over the whole graph, but never tiny ones.
+        m_cellSize = qMax<qreal>(256.0, std::sqrt(m_bounds.width() * m_bounds.height() / 16384.0));
+        m_cols = qMax(1, int(std::ceil(m_bounds.width() / m_cellSize)));
+        m_rows = qMax(1, int(std::ceil(m_bounds.height() / m_cellSize)));
+
+        // Two passes (count, fill) into CSR arrays. Edges spanning too many
+        // cells are kept in the loose list and tested individually.
+        QVector<QRect> spans(n);
+        m_cellOffsets.fill(0, m_cols * m_rows + 1);
+        for (int i = 0; i < n; i++) {
+            spans[i] = cellSpan(edgeRect(i));
+            if (spans[i].width() * spans[i].height() > kMaxCellsPerEdge) {
+                m_flags[i] |= Loose;
+                m_loose.push_back(i);
+                continue;
+            }
+            for (int y = spans[i].top(); y <= spans[i].bottom(); y++)
+                for (int x = spans[i].left(); x <= spans[i].right(); x++)
+                    m_cellOffsets[y * m_cols + x + 1]++;
+        }
+        for (int c = 0; c < m_cols * m_rows; c++)
+            m_cellOffsets[c + 1] += m_cellOffsets[c];
+
+        m_cellEdges.resize(m_cellOffsets.last());
+        QVector<int> fill = m_cellOffsets;
+        for (int i = 0; i < n; i++) {
+            if (m_flags[i] & Loose)
+                continue;
+            for (int y = spans[i].top(); y <= spans[i].bottom(); y++)
+                for (int x = spans[i].left(); x <= spans[i].right(); x++)
+                    m_cellEdges[fill[y * m_cols + x]++] = i;
+        }
+    }
+
+    // Inclusive cell range covered by a scene rect, clamped to the grid.
+    QRect cellSpan(const QRectF& r) const
+    {
+        const int x0 = qBound(0, int((r.left() - m_gridOrigin.x()) / m_cellSize), m_cols - 1);
+        const int x1 = qBound(0, int((r.right() - m_gridOrigin.x()) / m_cellSize), m_cols - 1);
+        const int y0 = qBound(0, int((r.top() - m_gridOrigin.y()) / m_cellSize), m_rows - 1);
+        const int y1 = qBound(0, int((r.bottom() - m_gridOrigin.y()) / m_cellSize), m_rows - 1);
+        return QRect(QPoint(x0, y0), QPoint(x1, y1));
+    }
+
+    void collectVisible(const QRectF& exposed)
+    {
+        m_visible.clear();
+        if (m_src.isEmpty())
+            return;
+
+        // Per-edge stamps deduplicate edges that sit in several cells.
+        if (++m_epoch == 0) {
+            m_stamp.fill(0);
+            m_epoch = 1;
+        }
+
+        auto consider = [&](int i) {
+            if (m_stamp[i] == m_epoch)
+                return;
+            m_stamp[i] = m_epoch;
+            if (edgeRect(i).intersects(exposed))
+                m_visible.push_back(i);
+        };
+
+        if (!m_cellOffsets.isEmpty()) {
+            const QRect span = cellSpan(exposed);
+            for (int y = span.top(); y <= span.bottom(); y++) {
+                for (int x = span.left(); x <= span.right(); x++) {
+                    const int c = y * m_cols + x;
+                    for (int k = m_cellOffsets[c]; k < m_cellOffsets[c + 1]; k++) {
+                        const int i = m_cellEdges[k];
+                        if (!(m_flags[i] & Loose))
+                            consider(i);
+                    }
+                }
+            }
+        }
+        for (int i : m_loose)
+            consider(i);
+    }
+
+    // Endpoints
+    QVector<NodeItem*> m_src;
+    QVector<NodeItem*> m_dst;
+    QVector<int> m_weight;
+    QHash<const NodeItem*, QVector<int>> m_incident;
+
+    // Geometry (one entry per edge; arrows hold three points per edge)
+    QVector<QPointF> m_p1;
+    QVector<QPointF> m_ctrl;
+    QVector<QPointF> m_p2;
+    QVector<QPointF> m_arrows;
+    QVector<quint8> m_flags;
+    QRectF m_bounds;
+
+    // Spatial grid in CSR form
+    QPointF m_gridOrigin;
+    qreal m_cellSize = 256.0;
+    int m_cols = 0;
+    int m_rows = 0;
+    QVector<int> m_cellOffsets;
+    QVector<int> m_cellEdges;
+    QVector<int> m_loose;
+
+    RenderStats* m_stats = nullptr;
+
+    // Scratch for paint()
+    QVector<int> m_visible;
+    QVector<quint32> m_stamp;
+    quint32 m_epoch = 0;
 };
 
 GraphView::GraphView(QWidget* parent)
@@ -214,17 +800,27 @@ GraphView::GraphView(QWidget* parent)
     setOptimizationFlags(QGraphicsView::DontSavePainterState | QGraphicsView::DontAdjustForAntialiasing);
 
     setBackgroundBrush(QBrush(QColor(8, 12, 18)));
+
+    m_forceLayout = new ForceLayout(this);
+    connect(m_forceLayout, &ForceLayout::positionsUpdated, this, &GraphView::onForceLayoutFrame);
+    connect(m_forceLayout, &ForceLayout::finished, this, &GraphView::onForceLayoutFinished);
+
+    m_tiles = new TileCache(this);
+    connect(m_tiles, &TileCache::tileReady, this, [this](const QRectF& r) {
+        if (tileModeActive())
+            viewport()->update(mapFromScene(r).boundingRect());
+    });
+
+    // The HUD only repaints its own corner, a few times a second; repainting
+    // it from every frame would itself cause a frame.
+    m_hudTimer = new QTimer(this);
+    m_hudTimer->setInterval(250);
+    connect(m_hudTimer, &QTimer::timeout, this, [this]() { viewport()->update(hudRect()); });
 }
 
 QColor GraphView::colorForStatus(NodeStatus s) const
 {
-    switch (s) {
-    case NodeStatus::Stable: return QColor(60, 220, 160);
-    case NodeStatus::Outdated: return QColor(245, 200, 80);
-    case NodeStatus::Deprecated: return QColor(255, 110, 110);
-    case NodeStatus::Conflict: return QColor(255, 80, 160);
-    }
-    return QColor(60, 220, 160);
+    return GraphStyle::statusColor(s);
 }
 
 void GraphView::setModel(GraphModel* model)
@@ -244,91 +840,198 @@ void GraphView::setModel(GraphModel* model)
 
 void GraphView::rebuildScene()
 {
+    QElapsedTimer timer;
+    timer.start();
+
+    m_highlighted.clear();
+    m_clusters.clear();
+    if (m_model) {
+        m_clusters.build(*m_model);
+        m_clusters.collapseToBudget(kFrontierBudget);
+    }
+    populateScene();
+    fitInitial();
+
+    m_renderStats.recordRebuild(timer.nsecsElapsed());
+}
+
+void GraphView::populateScene()
+{
+    stopForceLayout();
+
     m_scene->clear();
     m_nodeItems.clear();
-    m_edgeItems.clear();
-    m_highlighted.clear();
+    m_visibleItems.clear();
+    m_edgeLayer = nullptr;
+    m_visible = ClusterModel::VisibleGraph();
+    m_nodeDrag = false;
+    m_nodeDragDirty = QRectF();
 
     if (!m_model)
         return;
 
-    // Create nodes
-    for (const Node& n : m_model->nodes()) {
+    m_visible = m_clusters.visibleGraph(*m_model);
+
+    // Create nodes and supernodes for the frontier only
+    m_visibleItems.reserve(m_visible.nodes.size());
+    for (const ClusterModel::VisibleNode& v : m_visible.nodes) {
+        Node n;
+        if (const ClusterModel::Cluster* c = m_clusters.cluster(v.cluster)) {
+            n.id = v.id;
+            n.name = c->label;
+            n.version = QString("%1 nodes").arg(c->size);
+            n.kind = "cluster:" + ClusterModel::levelToString(c->level);
+            n.status = c->status;
+        } else {
+            n = *m_model->nodeById(v.id);
+        }
+
         auto* item = new NodeItem(n, this);
         item->setZValue(10);
-        connect(item, &NodeItem::clicked, this, &GraphView::nodeSelected);
+        connect(item, &NodeItem::clicked, this, [this](int id) {
+            if (id >= 0)
+                emit nodeSelected(id);
+        });
+        // Queued: expanding rebuilds the scene, which deletes the sender.
+        connect(item, &NodeItem::doubleClicked, this, &GraphView::onNodeDoubleClicked, Qt::QueuedConnection);
         m_scene->addItem(item);
-        m_nodeItems.insert(n.id, item);
+        m_nodeItems.insert(v.id, item);
+        m_visibleItems.push_back(item);
     }
 
-    // Create edges
-    for (const Edge& e : m_model->edges()) {
-        auto* a = m_nodeItems.value(e.from, nullptr);
-        auto* b = m_nodeItems.value(e.to, nullptr);
-        if (!a || !b)
-            continue;
-        auto* edge = new EdgeItem(a, b);
-        m_scene->addItem(edge);
-        m_edgeItems.push_back(edge);
+    // Create edges (already aggregated between visible endpoints)
+    QVector<QPair<NodeItem*, NodeItem*>> edges;
+    QVector<int> weights;
+    edges.reserve(m_visible.edges.size());
+    weights.reserve(m_visible.edges.size());
+    for (const ClusterModel::VisibleEdge& e : m_visible.edges) {
+        edges.push_back({m_visibleItems[e.from], m_visibleItems[e.to]});
+        weights.push_back(e.weight);
     }
 
+    applyCycleFlags();
     applyInitialLayout();
-    updateEdges();
-    fitInitial();
+
+    m_edgeLayer = new EdgeLayer(&m_renderStats);
+    m_scene->addItem(m_edgeLayer);
+    m_edgeLayer->setEdges(edges, weights);
+
+    applyHighlight();
+    applyDiff();
+    invalidateTiles();
 }
 
-void GraphView::applyInitialLayout()
+void GraphView::refreshCycles()
+{
+    if (applyCycleFlags())
+        invalidateTiles();
+}
+
+// A supernode is flagged if any node folded into it is. Returns whether a
+// flag changed.
+bool GraphView::applyCycleFlags()
 {
-    if (!m_model || m_nodeItems.isEmpty())
+    const auto reach = m_model ? m_model->reachabilityIfBuilt() : nullptr;
+    QVector<bool> inCycle(m_visibleItems.size(), false);
+    if (reach) {
+        const Condensation& scc = reach->condensation();
+        const int n = qMin(reach->nodeCount(), m_visible.nodeToVisible.size());
+        for (int id = 0; id < n; id++) {
+            if (scc.isCyclic(scc.componentOf(id)))
+                inCycle[m_visible.nodeToVisible[id]] = true;
+        }
+    }
+    bool changed = false;
+    for (int i = 0; i < m_visibleItems.size(); i++) {
+        changed = changed || m_visibleItems[i]->isInCycle() != inCycle[i];
+        m_visibleItems[i]->setInCycle(inCycle[i]);
+    }
+    return changed;
+}
+
+void GraphView::onNodeDoubleClicked(int id)
+{
+    const int cluster = ClusterModel::clusterFromSupernodeId(id);
+    if (cluster >= 0)
+        expandCluster(cluster);
+    else
+        collapseCluster(m_clusters.clusterOfNode(id));
+}
+
+void GraphView::expandCluster(int clusterId)
+{
+    const ClusterModel::Cluster* c = m_clusters.cluster(clusterId);
+    if (!c || m_clusters.isExpanded(clusterId))
         return;
 
-    // Deterministic layered layout from the repo root (node 0). This is fast and stable.
-    const int rootId = 0;
+    m_clusters.expand(clusterId);
+    populateScene();
 
-    QHash<int, int> depth;
-    QQueue<int> q;
-    depth.insert(rootId, 0);
-    q.enqueue(rootId);
+    // Keep the user's eye on what was just opened.
+    const int anchor = !c->members.isEmpty() ? c->members.first()
+                                             : ClusterModel::supernodeId(c->children.value(0, -1));
+    if (auto* ni = m_nodeItems.value(anchor, nullptr))
+        centerOn(ni);
+    emit viewportChanged();
+}
 
-    while (!q.isEmpty()) {
-        int cur = q.dequeue();
-        const int d = depth.value(cur);
-        for (int to : m_model->outgoing(cur)) {
-            if (depth.contains(to))
-                continue;
-            depth.insert(to, d + 1);
-            q.enqueue(to);
-        }
-    }
+void GraphView::collapseCluster(int clusterId)
+{
+    if (clusterId <= 0 || !m_clusters.isExpanded(clusterId))
+        return;
 
-    // Group nodes by depth. Unreachable nodes go to the last column.
-    int maxDepth = 0;
-    for (auto it = depth.begin(); it != depth.end(); ++it)
-        maxDepth = qMax(maxDepth, it.value());
+    m_clusters.collapse(clusterId);
+    populateScene();
 
-    QVector<QVector<int>> cols(maxDepth + 2);
-    const int unreachableCol = maxDepth + 1;
+    if (auto* ni = m_nodeItems.value(ClusterModel::supernodeId(clusterId), nullptr))
+        centerOn(ni);
+    emit viewportChanged();
+}
 
-    for (const Node& n : m_model->nodes()) {
-        const int d = depth.contains(n.id) ? depth.value(n.id) : unreachableCol;
-        cols[d].push_back(n.id);
-    }
+void GraphView::collapseClusters()
+{
+    m_clusters.collapseToBudget(kFrontierBudget);
+    populateScene();
+    fitToContents();
+}
 
-    const qreal xStep = 360.0;
-    const qreal yStep = 92.0;
+void GraphView::applyInitialLayout()
+{
+    if (!m_model || m_visibleItems.isEmpty())
+        return;
 
-    for (int d = 0; d < cols.size(); d++) {
-        auto& v = cols[d];
-        std::sort(v.begin(), v.end());
-        const qreal x = (d - 0) * xStep;
-        const qreal y0 = -0.5 * (qMax(1, v.size()) - 1) * yStep;
+    QElapsedTimer timer;
+    timer.start();
 
-        for (int i = 0; i < v.size(); i++) {
-            if (auto* item = m_nodeItems.value(v[i], nullptr)) {
-                item->setPos(QPointF(x, y0 + i * yStep));
-            }
-        }
-    }
+    // Deterministic layered layout over the visible graph. This is fast and
+    // stable, and cycles are contracted before layering.
+    const QVector<QPointF> pos = LayeredLayout::compute(m_visibleItems.size(), visibleEdges());
+
+    m_bulkMove = true;
+    for (int i = 0; i < m_visibleItems.size(); i++)
+        m_visibleItems[i]->setPos(pos[i]);
+    m_bulkMove = false;
+
+    m_renderStats.recordLayout(timer.nsecsElapsed());
+}
+
+QVector<Edge> GraphView::visibleEdges() const
+{
+    QVector<Edge> edges;
+    edges.reserve(m_visible.edges.size());
+    for (const ClusterModel::VisibleEdge& e : m_visible.edges)
+        edges.push_back({e.from, e.to});
+    return edges;
+}
+
+void GraphView::applyPositions(const QVector<QPointF>& positions)
+{
+    m_bulkMove = true;
+    const int n = qMin(positions.size(), m_visibleItems.size());
+    for (int i = 0; i < n; i++)
+        m_visibleItems[i]->setPos(positions[i]);
+    m_bulkMove = false;
+    updateEdges();
 }
 
 void GraphView::fitInitial()
@@ -341,6 +1044,7 @@ void GraphView::fitInitial()
     m_scene->setSceneRect(r);
     fitInView(r, Qt::KeepAspectRatio);
     m_zoom = 1.0;
+    emit viewportChanged();
 }
 
 void GraphView::wheelEvent(QWheelEvent* e)
@@ -353,6 +1057,7 @@ void GraphView::wheelEvent(QWheelEvent* e)
     }
     m_zoom = next;
     scale(factor, factor);
+    emit viewportChanged();
 }
 
 void GraphView::mousePressEvent(QMouseEvent* e)
@@ -398,12 +1103,23 @@ void GraphView::keyPressEvent(QKeyEvent* e)
         e->accept();
         return;
     }
+    if (e->key() == Qt::Key_H) {
+        setHudVisible(!m_hudVisible);
+        e->accept();
+        return;
+    }
     QGraphicsView::keyPressEvent(e);
 }
 
 void GraphView::focusNode(int nodeId)
 {
     auto* ni = m_nodeItems.value(nodeId, nullptr);
+    if (!ni && m_model && m_model->nodeById(nodeId)) {
+        // Hidden inside a collapsed cluster: open the clusters above it.
+        m_clusters.reveal(nodeId);
+        populateScene();
+        ni = m_nodeItems.value(nodeId, nullptr);
+    }
     if (!ni)
         return;
     centerOn(ni);
@@ -419,6 +1135,7 @@ void GraphView::fitToContents()
     m_scene->setSceneRect(r);
     fitInView(r, Qt::KeepAspectRatio);
     m_zoom = 1.0;
+    emit viewportChanged();
 }
 
 void GraphView::resetView()
@@ -430,81 +1147,471 @@ void GraphView::resetView()
 
 void GraphView::relayout()
 {
+    stopForceLayout();
     applyInitialLayout();
     updateEdges();
     fitToContents();
 }
 
+void GraphView::forceLayout()
+{
+    if (!m_model || m_visibleItems.isEmpty())
+        return;
+
+    // Every node moves on every streamed frame; keeping the BSP index up to date
+    // would cost more than the frame itself.
+    m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+    m_forceLayoutFitted = false;
+    m_forceLayout->start(m_visibleItems.size(), visibleEdges());
+}
+
+void GraphView::stopForceLayout()
+{
+    if (!m_forceLayout->isRunning() && m_scene->itemIndexMethod() == QGraphicsScene::BspTreeIndex)
+        return;
+    m_forceLayout->cancel();
+    m_scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+}
+
+void GraphView::onForceLayoutFrame(const QVector<QPointF>& positions)
+{
+    applyPositions(positions);
+    if (!m_forceLayoutFitted) {
+        m_forceLayoutFitted = true;
+        fitToContents();
+    }
+}
+
+void GraphView::onForceLayoutFinished(const QVector<QPointF>& positions)
+{
+    applyPositions(positions);
+    m_scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+    fitToContents();
+}
+
 void GraphView::highlightImpactFrom(int nodeId)
 {
     m_highlighted.clear();
+    if (!m_model)
+        return;
+
+    // Downstream set straight from the precomputed index; no graph walk here.
+    m_highlighted = m_model->downstream(nodeId);
+    applyHighlight();
+}
 
-    // BFS downstream from nodeId in model edges
+void GraphView::highlightUpstreamOf(int nodeId)
+{
+    m_highlighted.clear();
     if (!m_model)
         return;
 
-    QQueue<int> q;
-    QSet<int> seen;
-    q.enqueue(nodeId);
-    seen.insert(nodeId);
-
-    while (!q.isEmpty()) {
-        int cur = q.dequeue();
-        m_highlighted.insert(cur);
-        for (int to : m_model->outgoing(cur)) {
-            if (!seen.contains(to)) {
-                seen.insert(to);
-                q.enqueue(to);
-            }
-        }
+    m_highlighted = m_model->upstream(nodeId);
+    applyHighlight();
+}
+
+void GraphView::highlightNodes(const QVector<int>& nodeIds)
+{
+    m_highlighted = nodeIds;
+    applyHighlight();
+}
+
+void GraphView::applyHighlight()
+{
+    // A supernode lights up when any node folded into it is highlighted.
+    QSet<int> visibleIds;
+    for (int id : m_highlighted) {
+        const int v = m_visible.nodeToVisible.value(id, -1);
+        if (v >= 0)
+            visibleIds.insert(m_visible.nodes[v].id);
+    }
+
+    // Items repaint themselves only when their state actually flips, and only
+    // the overview tiles under them are dropped.
+    QRectF dirty;
+    for (auto it = m_nodeItems.begin(); it != m_nodeItems.end(); ++it) {
+        NodeItem* item = it.value();
+        const bool on = visibleIds.contains(it.key());
+        if (item->isHighlighted() == on)
+            continue;
+        item->setHighlighted(on);
+        dirty |= item->sceneBoundingRect();
     }
+    if (m_edgeLayer)
+        dirty |= m_edgeLayer->setHighlighted(visibleIds);
 
-    for (auto it = m_nodeItems.begin(); it != m_nodeItems.end(); ++it)
-        it.value()->setHighlighted(m_highlighted.contains(it.key()));
+    if (!dirty.isNull()) {
+        m_tileSceneDirty = true;
+        m_tiles->invalidate(dirty);
+    }
 }
 
 void GraphView::clearHighlight()
 {
     m_highlighted.clear();
-    for (auto it = m_nodeItems.begin(); it != m_nodeItems.end(); ++it)
-        it.value()->setHighlighted(false);
+    applyHighlight();
 }
 
-void GraphView::exportPng(const QString& filePath)
+void GraphView::setDiff(std::shared_ptr<const GraphDiff> diff)
 {
-    QRectF r = m_scene->itemsBoundingRect().adjusted(-40, -40, 40, 40);
-    QImage img(r.size().toSize() * 2, QImage::Format_ARGB32_Premultiplied);
-    img.fill(QColor(8, 12, 18));
+    m_diff = std::move(diff);
+    applyDiff();
+}
 
-    QPainter p(&img);
-    p.setRenderHint(QPainter::Antialiasing, true);
-    p.translate(-r.topLeft());
-    p.scale(2.0, 2.0);
-    m_scene->render(&p);
-    p.end();
+void GraphView::applyDiff()
+{
+    using Change = GraphDiff::Change;
+    QVector<Change> nodeChanges(m_visibleItems.size(), Change::None);
+    QVector<QString> oldVersions(m_visibleItems.size());
+    QVector<Change> edgeChanges(m_visible.edges.size(), Change::None);
+
+    if (m_diff) {
+        for (const GraphDiff::NodeDelta& nd : m_diff->nodeDeltas()) {
+            const int v = m_visible.nodeToVisible.value(nd.id, -1);
+            if (v < 0)
+                continue;
+            nodeChanges[v] = strongerChange(nodeChanges[v], nd.change);
+            if (m_visible.nodes[v].id == nd.id)
+                oldVersions[v] = nd.oldVersion;
+        }
 
-    img.save(filePath);
+        if (!m_diff->edgeDeltas().isEmpty()) {
+            QHash<quint64, int> edgeIndex;
+            edgeIndex.reserve(m_visible.edges.size());
+            for (int i = 0; i < m_visible.edges.size(); i++)
+                edgeIndex.insert((quint64(quint32(m_visible.edges[i].from)) << 32) | quint32(m_visible.edges[i].to), i);
+
+            for (const GraphDiff::EdgeDelta& ed : m_diff->edgeDeltas()) {
+                const int a = m_visible.nodeToVisible.value(ed.from, -1);
+                const int b = m_visible.nodeToVisible.value(ed.to, -1);
+                if (a < 0 || b < 0 || a == b)
+                    continue;
+                const int i = edgeIndex.value((quint64(quint32(a)) << 32) | quint32(b), -1);
+                if (i >= 0)
+                    edgeChanges[i] = strongerChange(edgeChanges[i], ed.change);
+            }
+        }
+    }
+
+    QRectF dirty;
+    for (int i = 0; i < m_visibleItems.size(); i++) {
+        NodeItem* item = m_visibleItems[i];
+        const bool flips = item->diffChange() != nodeChanges[i];
+        item->setDiffChange(nodeChanges[i], oldVersions[i]);
+        if (flips)
+            dirty |= item->sceneBoundingRect();
+    }
+    if (m_edgeLayer)
+        dirty |= m_edgeLayer->setDiff(edgeChanges);
+
+    if (!dirty.isNull()) {
+        m_tileSceneDirty = true;
+        m_tiles->invalidate(dirty);
+    }
 }
 
-void GraphView::exportSvg(const QString& filePath)
+TiledPngExport* GraphView::createPngExport(const TiledPngExport::Options& options, QObject* parent)
 {
-    QRectF r = m_scene->itemsBoundingRect().adjusted(-40, -40, 40, 40);
+    const QRectF r = m_scene->itemsBoundingRect().adjusted(-40, -40, 40, 40);
+    return new TiledPngExport(m_scene, r, QColor(8, 12, 18), options, parent);
+}
+
+bool GraphView::exportSvg(const QString& filePath, QString* err)
+{
+    // Written from the items' state rather than rendered through the scene:
+    // shared styles and compound edge paths instead of one element per item.
+    if (m_visibleItems.isEmpty()) {
+        if (err)
+            *err = "Nothing to export: the graph is empty.";
+        return false;
+    }
 
-    QSvgGenerator gen;
-    gen.setFileName(filePath);
-    gen.setSize(r.size().toSize());
-    gen.setViewBox(r);
+    QSaveFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err)
+            *err = QString("Cannot write %1: %2").arg(filePath, f.errorString());
+        return false;
+    }
 
-    QPainter p(&gen);
-    p.fillRect(r, QColor(8, 12, 18));
-    m_scene->render(&p);
-    p.end();
+    Trace::Span span("export.svg");
+    SvgWriter w(&f);
+    w.begin(m_scene->itemsBoundingRect().adjusted(-40, -40, 40, 40));
+    if (m_edgeLayer)
+        m_edgeLayer->writeSvg(&w);
+    for (const NodeItem* ni : m_visibleItems) {
+        quint8 flags = 0;
+        if (ni->isInCycle()) flags |= SvgWriter::Cycle;
+        if (ni->isSupernode()) flags |= SvgWriter::Cluster;
+        if (ni->isHighlighted()) flags |= SvgWriter::Highlighted;
+        switch (ni->diffChange()) {
+        case GraphDiff::Change::Added: flags |= SvgWriter::Added; break;
+        case GraphDiff::Change::Removed: flags |= SvgWriter::Removed; break;
+        case GraphDiff::Change::Changed: flags |= SvgWriter::Changed; break;
+        case GraphDiff::Change::None: break;
+        }
+        w.addNode(ni->pos(), ni->titleText(), ni->subtitleText(), ni->node().status, flags);
+    }
+
+    if (!w.finish(err))
+        return false;
+    if (!f.commit()) {
+        if (err)
+            *err = QString("Cannot write %1: %2").arg(filePath, f.errorString());
+        return false;
+    }
+    return true;
 }
 
 void GraphView::updateEdges()
 {
-    for (auto* e : m_edgeItems)
-        e->syncGeometry();
+    if (m_edgeLayer)
+        m_edgeLayer->syncAll();
+    invalidateTiles();
+}
+
+void GraphView::nodeMoved(const NodeItem* item, const QPointF& oldPos)
+{
+    QRectF dirty = item->sceneBoundingRect();
+    dirty |= item->boundingRect().translated(oldPos);
+    if (m_edgeLayer)
+        dirty |= m_edgeLayer->syncNode(item);
+
+    // Rebuilding the overview scene is O(nodes + edges), far too much per
+    // mouse move; a drag only collects what it touched until release.
+    if (m_nodeDrag) {
+        m_nodeDragDirty |= dirty;
+        return;
+    }
+
+    // Only the tiles under the moved node and its edges go stale.
+    m_tileSceneDirty = true;
+    m_tiles->invalidate(dirty);
+}
+
+void GraphView::nodeDragStarted()
+{
+    m_nodeDrag = true;
+    m_nodeDragDirty = QRectF();
+}
+
+void GraphView::nodeDragFinished()
+{
+    if (!m_nodeDrag)
+        return;
+    m_nodeDrag = false;
+    if (m_nodeDragDirty.isNull())
+        return;
+
+    m_tileSceneDirty = true;
+    m_tiles->invalidate(m_nodeDragDirty);
+    m_nodeDragDirty = QRectF();
+}
+
+bool GraphView::tileModeActive() const
+{
+    return transform().m11() < kTileLod && !m_nodeItems.isEmpty();
+}
+
+void GraphView::invalidateTiles()
+{
+    m_tileSceneDirty = true;
+    m_tiles->invalidateAll();
+}
+
+void GraphView::refreshTileScene()
+{
+    m_tileSceneDirty = false;
+
+    auto scene = std::make_shared<TileScene>();
+    scene->nodePos.reserve(m_nodeItems.size());
+    scene->nodeColor.reserve(m_nodeItems.size());
+    for (auto* ni : m_nodeItems) {
+        scene->nodePos.push_back(ni->pos());
+        scene->nodeColor.push_back(ni->overviewColor().rgba());
+        scene->nodeRadius = ni->overviewRadius();
+    }
+    if (m_edgeLayer)
+        m_edgeLayer->exportLines(&scene->edges, &scene->edgeHighlighted);
+    scene->finalize();
+    m_tiles->setScene(std::move(scene));
+}
+
+QRectF GraphView::overviewBounds()
+{
+    if (m_tileSceneDirty)
+        refreshTileScene();
+    return m_tiles->scene() ? m_tiles->scene()->bounds : QRectF();
+}
+
+void GraphView::drawOverview(QPainter* p, const QRectF& sceneRect, qreal scale)
+{
+    if (m_tileSceneDirty)
+        refreshTileScene();
+    m_tiles->draw(p, sceneRect, scale);
+}
+
+void GraphView::paintEvent(QPaintEvent* e)
+{
+    // HUD-only refreshes are not frames the user waits for.
+    if (!m_renderStats.isEnabled() || (m_hudVisible && hudRect().contains(e->region().boundingRect()))) {
+        paintScene(e);
+        return;
+    }
+
+    qint64 exposed = 0;
+    for (const QRect& r : e->region())
+        exposed += qint64(r.width()) * r.height();
+    m_renderStats.beginFrame(exposed, tileModeActive());
+    QElapsedTimer timer;
+    timer.start();
+    paintScene(e);
+    m_renderStats.endFrame(timer.nsecsElapsed());
+}
+
+void GraphView::paintScene(QPaintEvent* e)
+{
+    if (!tileModeActive()) {
+        QGraphicsView::paintEvent(e);
+        return;
+    }
+
+    // Overview zoom: composite cached tiles instead of walking every item.
+    QPainter p(viewport());
+    p.setRenderHints(renderHints());
+    p.setClipRegion(e->region());
+    p.setTransform(viewportTransform());
+    const QRectF exposed = mapToScene(e->rect()).boundingRect();
+    drawBackground(&p, exposed);
+    drawForeground(&p, exposed);
+}
+
+void GraphView::drawBackground(QPainter* p, const QRectF& rect)
+{
+    QGraphicsView::drawBackground(p, rect);
+    if (tileModeActive())
+        drawOverview(p, rect, transform().m11());
+}
+
+void GraphView::reportMemory(MemoryReport* report) const
+{
+    qint64 items = 0;
+    for (const NodeItem* ni : m_nodeItems)
+        items += ni->memoryBytes();
+    report->add("view", "node items", items, m_nodeItems.size());
+    if (m_edgeLayer)
+        report->add("view", "edge layer", m_edgeLayer->memoryBytes(), m_edgeLayer->edgeCount());
+    report->add("view", "item lookup", MemoryReport::bytesOf(m_nodeItems) + MemoryReport::bytesOf(m_visibleItems));
+    report->add("view", "visible graph",
+                MemoryReport::bytesOf(m_visible.nodes) + MemoryReport::bytesOf(m_visible.edges) +
+                    MemoryReport::bytesOf(m_visible.nodeToVisible));
+    report->add("view", "clusters", m_clusters.memoryBytes(), m_clusters.clusters().size());
+
+    // QGraphicsScene's BSP index: a complete tree whose leaves list the items
+    // they intersect. Depth 0 means Qt picks it from the item count.
+    if (m_scene->itemIndexMethod() == QGraphicsScene::BspTreeIndex) {
+        const int itemCount = m_nodeItems.size() + (m_edgeLayer ? 1 : 0);
+        int depth = m_scene->bspTreeDepth();
+        if (depth == 0 && itemCount > 0)
+            depth = qMax(int(std::log2(double(itemCount))), 5);
+        const qint64 leaves = depth > 0 ? (qint64(1) << depth) : 0;
+        // Cards are small next to leaf rects, so most sit in one or two leaves.
+        const qint64 bytes = 2 * leaves * kBspNodeBytes + leaves * MemoryReport::kArrayHeader +
+                             qint64(itemCount) * 2 * qint64(sizeof(void*));
+        report->add("view", "BSP index", bytes, leaves);
+    }
+
+    report->add("caches", "overview tiles", m_tiles->cachedBytes());
+    if (const auto scene = m_tiles->scene())
+        report->add("caches", "tile scene", scene->memoryBytes());
+}
+
+void GraphView::drawForeground(QPainter* p, const QRectF& rect)
+{
+    QGraphicsView::drawForeground(p, rect);
+    if (m_hudVisible)
+        drawHud(p);
+}
+
+void GraphView::setRenderStatsEnabled(bool on)
+{
+    m_statsRequested = on;
+    m_renderStats.setEnabled(on || m_hudVisible);
+    m_renderStats.clearFrames();
+}
+
+void GraphView::setHudVisible(bool visible)
+{
+    if (m_hudVisible == visible)
+        return;
+    m_hudVisible = visible;
+    m_renderStats.setEnabled(visible || m_statsRequested);
+    if (visible) {
+        m_renderStats.clearFrames();
+        m_hudTimer->start();
+    } else {
+        m_hudTimer->stop();
+    }
+    viewport()->update(hudRect());
+    emit hudVisibleChanged(visible);
+}
+
+QRect GraphView::hudRect() const
+{
+    return QRect(8, 8, 340, 112);
+}
+
+void GraphView::drawHud(QPainter* p)
+{
+    const RenderStats::Summary s = m_renderStats.summary();
+    auto ms = [](double v) { return v < 0 ? QString("-") : QString::number(v, 'f', 1); };
+
+    QStringList lines;
+    lines << QString("frame p50 %1  p95 %2  p99 %3 ms  (%4)")
+                 .arg(ms(s.p50Ms), ms(s.p95Ms), ms(s.p99Ms))
+                 .arg(s.frames);
+    lines << QString("painted %1 nodes, %2 edges")
+                 .arg(qRound(s.avgNodesPainted))
+                 .arg(qRound(s.avgEdgesPainted));
+    lines << QString("paint: nodes %1 ms, edges %2 ms").arg(ms(s.avgNodePaintMs), ms(s.avgEdgePaintMs));
+    lines << QString("exposed %1 kpx%2")
+                 .arg(qRound(s.avgExposedPixels / 1000))
+                 .arg(tileModeActive() ? "  (tiles)" : "");
+    lines << QString("rebuildScene %1 ms, layout %2 ms").arg(ms(s.lastRebuildMs), ms(s.lastLayoutMs));
+
+    // Viewport coordinates, whatever the scene transform is.
+    p->save();
+    p->resetTransform();
+    const QRect r = hudRect();
+    p->setRenderHint(QPainter::Antialiasing, true);
+    p->setPen(QColor(120, 160, 210, 120));
+    p->setBrush(QColor(4, 8, 14, 210));
+    p->drawRoundedRect(r, 6, 6);
+
+    QFont f = font();
+    f.setStyleHint(QFont::Monospace);
+    f.setFamily("monospace");
+    f.setPointSizeF(8.5);
+    p->setFont(f);
+    p->setPen(QColor(205, 225, 250));
+    p->drawText(r.adjusted(10, 8, -10, -8), Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+    p->restore();
+}
+
+void GraphView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+    if (m_hudVisible) {
+        // Scrolling blits the viewport, HUD included; repaint both copies.
+        viewport()->update(hudRect());
+        viewport()->update(hudRect().translated(dx, dy));
+    }
+    emit viewportChanged();
+}
+
+void GraphView::resizeEvent(QResizeEvent* e)
+{
+    QGraphicsView::resizeEvent(e);
+    emit viewportChanged();
 }
 
 #include "GraphView.moc"
@@ -5,28 +5,75 @@
 #include <QTimer>
 #include <QHash>
 
+#include <memory>
+
+#include "gui/RenderStats.h"
+#include "gui/TiledPngExport.h"
+#include "model/ClusterModel.h"
 #include "model/GraphModel.h"
 
+class ForceLayout;
+class GraphDiff;
+class MemoryReport;
+class TileCache;
+
 class GraphView : public QGraphicsView {
     Q_OBJECT
 public:
     explicit GraphView(QWidget* parent = nullptr);
 
     void setModel(GraphModel* model);
+    // Overlay for a model holding GraphDiff::merged(): added parts green,
+    // removed red, changed versions blue. Null clears it.
+    void setDiff(std::shared_ptr<const GraphDiff> diff);
+    // Marks cycle members from the model's reachability index. The scene only
+    // uses an index that is already built; call this once a background build
+    // has been installed (MainWindow's cycle scan).
+    void refreshCycles();
+
+    // A PNG export of the whole scene, not yet started; owned by `parent`.
+    TiledPngExport* createPngExport(const TiledPngExport::Options& options, QObject* parent);
+    bool exportSvg(const QString& filePath, QString* err);
+
+    // Overview rendering shared with the minimap (tiles, not scene items).
+    TileCache* tileCache() const { return m_tiles; }
+    QRectF overviewBounds();
+    void drawOverview(QPainter* p, const QRectF& sceneRect, qreal scale);
+
+    // Frame timings and paint counters (see RenderStats). Collected while
+    // the HUD is shown or while enabled here, e.g. by a benchmark driving
+    // scripted pans and zooms.
+    const RenderStats& renderStats() const { return m_renderStats; }
+    void setRenderStatsEnabled(bool on);
+    bool isHudVisible() const { return m_hudVisible; }
 
-    void exportPng(const QString& filePath);
-    void exportSvg(const QString& filePath);
+    // Adds scene items, the BSP index estimate, edge geometry and clusters
+    // under "view", and overview tiles under "caches".
+    void reportMemory(MemoryReport* report) const;
 
 signals:
     void nodeSelected(int nodeId);
+    // Visible scene area changed (scroll, zoom, resize).
+    void viewportChanged();
+    void hudVisibleChanged(bool visible);
 
 public slots:
     void focusNode(int nodeId);
     void highlightImpactFrom(int nodeId);
+    void highlightUpstreamOf(int nodeId);
+    void highlightNodes(const QVector<int>& nodeIds);
     void clearHighlight();
     void fitToContents();
     void resetView();
     void relayout();
+    void forceLayout();
+    // Render HUD in the top-left corner (also toggled with H).
+    void setHudVisible(bool visible);
+
+    // Cluster frontier. The scene only holds what is currently expanded.
+    void expandCluster(int clusterId);
+    void collapseCluster(int clusterId);
+    void collapseClusters();
 
 protected:
     void wheelEvent(QWheelEvent* e) override;
@@ -34,28 +81,77 @@ protected:
     void mouseMoveEvent(QMouseEvent* e) override;
     void mouseReleaseEvent(QMouseEvent* e) override;
     void keyPressEvent(QKeyEvent* e) override;
+    void paintEvent(QPaintEvent* e) override;
+    void drawBackground(QPainter* p, const QRectF& rect) override;
+    void drawForeground(QPainter* p, const QRectF& rect) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* e) override;
 
 private slots:
     void rebuildScene();
+    void onNodeDoubleClicked(int id);
+    void onForceLayoutFrame(const QVector<QPointF>& positions);
+    void onForceLayoutFinished(const QVector<QPointF>& positions);
 
 private:
     class NodeItem;
-    class EdgeItem;
+    class EdgeLayer;
 
+    void populateScene();
+    void applyHighlight();
+    void applyDiff();
+    bool applyCycleFlags();
     void fitInitial();
     QColor colorForStatus(NodeStatus s) const;
     void updateEdges();
+    void nodeMoved(const NodeItem* item, const QPointF& oldPos);
+    void nodeDragStarted();
+    void nodeDragFinished();
     void applyInitialLayout();
+    QVector<Edge> visibleEdges() const;
+    void applyPositions(const QVector<QPointF>& positions);
+    void stopForceLayout();
+    bool tileModeActive() const;
+    void invalidateTiles();
+    void refreshTileScene();
+    void paintScene(QPaintEvent* e);
+    void drawHud(QPainter* p);
+    QRect hudRect() const;
 
     GraphModel* m_model = nullptr;
     QGraphicsScene* m_scene = nullptr;
 
+    // Keyed by visible id: node id, or ClusterModel::supernodeId() for collapsed clusters.
     QHash<int, NodeItem*> m_nodeItems;
-    QVector<EdgeItem*> m_edgeItems;
+    QVector<NodeItem*> m_visibleItems; // index into m_visible.nodes -> item
+    EdgeLayer* m_edgeLayer = nullptr;
+
+    ClusterModel m_clusters;
+    ClusterModel::VisibleGraph m_visible;
+
+    ForceLayout* m_forceLayout = nullptr;
+    bool m_forceLayoutFitted = false;
+    // Set while many nodes are moved at once; edges are synced once afterwards
+    // instead of on every item move.
+    bool m_bulkMove = false;
+
+    // Far-out zoom levels are composited from rasterised tiles.
+    TileCache* m_tiles = nullptr;
+    bool m_tileSceneDirty = true;
+    // While a node is dragged the overview is brought up to date once, on
+    // release, for the union of everything the drag touched.
+    bool m_nodeDrag = false;
+    QRectF m_nodeDragDirty;
 
     bool m_panning = false;
     QPoint m_panStart;
 
-    QSet<int> m_highlighted;
+    QVector<int> m_highlighted; // model node ids
+    std::shared_ptr<const GraphDiff> m_diff;
     qreal m_zoom = 1.0;
+
+    RenderStats m_renderStats;
+    bool m_statsRequested = false; // setRenderStatsEnabled(), independent of the HUD
+    bool m_hudVisible = false;
+    QTimer* m_hudTimer = nullptr;
 };
@@ -2,23 +2,50 @@
 
 #include <QAction>
 #include <QApplication>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QFontDatabase>
 #include <QInputDialog>
 #include <QLabel>
 #include <QLineEdit>
+#include <QListView>
 #include <QListWidget>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QSlider>
 #include <QSplitter>
 #include <QStatusBar>
+#include <QTimer>
 #include <QToolBar>
 #include <QVBoxLayout>
 #include <QSaveFile>
+#include <QSettings>
 #include <QtConcurrent/QtConcurrentRun>
 #include <QDate>
+#include <QDateTime>
 
 #include "gui/GraphView.h"
+#include "gui/MiniMap.h"
+#include "gui/NodeListModel.h"
+#include "model/AdvisoryDb.h"
+#include "model/GraphDiff.h"
+#include "model/ReachabilityIndex.h"
+#include "model/RegistryIndex.h"
+#include "model/TrigramIndex.h"
+#include "model/VersionConflicts.h"
+#include "model/WhatIfOverlay.h"
 #include "parser/DependencyScanner.h"
+#include "util/MemoryReport.h"
+#include "util/Trace.h"
+
+// Filter matches lit on the canvas, best ranked first.
+static constexpr int kMaxFilterHighlights = 500;
 
 static bool writeBytesAtomically(const QString& path, const QByteArray& bytes, QString* err)
 {
@@ -38,34 +65,171 @@ static bool writeBytesAtomically(const QString& path, const QByteArray& bytes, Q
     return true;
 }
 
+// Registry lag and advisories on top of the statuses from the version
+// analysis; a vulnerability outranks anything else.
+static void overlayLocalMetadata(const QVector<Node>& nodes, const RegistryIndex* registry, const AdvisoryDb* advisories,
+                                 QVector<NodeStatus>* statuses)
+{
+    if (registry)
+        registry->markOutdated(nodes, statuses);
+    if (advisories)
+        advisories->markVulnerable(nodes, statuses);
+}
+
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
     , m_git(this)
+    , m_manifestCache(std::make_shared<ManifestCache>())
 {
     buildUi();
 
     m_view->setModel(&m_graph);
     connect(m_view, &GraphView::nodeSelected, this, &MainWindow::onNodeSelected);
     connect(&m_graph, &GraphModel::changed, this, &MainWindow::repopulateNodeList);
+    connect(&m_graph, &GraphModel::changed, this, &MainWindow::repopulateCycleList);
+    connect(&m_graph, &GraphModel::changed, this, [this]() {
+        if (m_whatIf)
+            discardWhatIf();
+    });
 
     connect(&m_scanWatcher, &QFutureWatcher<GraphModel::Data>::finished, this, [this]() {
-        const GraphModel::Data result = m_scanWatcher.result();
-        m_graph.replaceFromData(result);
+        // Moved out of the future: result() would leave the future sharing
+        // every container, and the first status update below would then
+        // copy the whole graph on this thread.
+        GraphModel::Data result = m_scanWatcher.future().takeResult();
+        clearDiff();
+        if (!m_graph.nodes().isEmpty()) {
+            m_previousScan = m_graph.toData();
+            m_actDiffPrevious->setEnabled(true);
+        }
+        m_graph.adopt(std::move(result));
+        m_previousSelectedId = -1;
+        m_pickedNodeId = -1;
         setBusy(false, "Scan complete.");
+        // Metadata loaded while the scan ran has not been matched yet.
+        if (m_advisories != m_scanAdvisories || m_registry != m_scanRegistry)
+            applyLocalMetadata();
+        m_scanAdvisories.reset();
+        m_scanRegistry.reset();
 
         const int nNodes = m_graph.nodes().size();
         const int nEdges = m_graph.edges().size();
 
-        m_status->setText(QString("Repo: %1\nNodes: %2   Edges: %3")
-                              .arg(m_repoDir.absolutePath())
-                              .arg(nNodes)
-                              .arg(nEdges));
+        QString status = QString("Repo: %1\nNodes: %2   Edges: %3")
+                             .arg(m_repoDir.absolutePath())
+                             .arg(nNodes)
+                             .arg(nEdges);
+        if (m_registry) {
+            int behind = 0;
+            for (const Node& n : m_graph.nodes()) {
+                if (n.status == NodeStatus::Outdated)
+                    behind++;
+            }
+            status += QString("\nOutdated: %1 (%2 packages in registry metadata)").arg(behind).arg(m_registry->packageCount());
+        }
+        if (m_advisories) {
+            int vulnerable = 0;
+            for (const Node& n : m_graph.nodes()) {
+                if (n.status == NodeStatus::Vulnerable)
+                    vulnerable++;
+            }
+            status += QString("\nVulnerable: %1 (%2 advisories loaded)").arg(vulnerable).arg(m_advisories->advisoryCount());
+        }
+        if (Trace::isEnabled()) {
+            const QString trace = Trace::summaryText();
+            if (!trace.isEmpty())
+                status += "\n\nTrace: " + trace;
+        }
+        status += "\n\nMemory: " + memoryReport().summaryLine();
+        m_status->setText(status);
 
         statusBar()->showMessage(QString("Scan complete. %1 nodes, %2 edges.").arg(nNodes).arg(nEdges), 3500);
         applyFilter();
     });
 
+    connect(&m_historyWatcher, &QFutureWatcher<DependencyHistory>::finished, this, [this]() {
+        DependencyHistory result = m_historyWatcher.future().takeResult();
+        m_actHistory->setEnabled(true);
+        if (!result.error.isEmpty()) {
+            setBusy(false);
+            QMessageBox::warning(this, "Dependency history failed", result.error);
+            return;
+        }
+        if (result.entries.isEmpty()) {
+            setBusy(false);
+            QMessageBox::information(this, "Dependency history", "No commits found.");
+            return;
+        }
+
+        clearDiff();
+        m_history = std::move(result);
+        setBusy(false, QString("Read %1 commits: %2 manifest blobs parsed, %3 reused.")
+                           .arg(m_history.entries.size())
+                           .arg(m_history.blobsParsed)
+                           .arg(m_history.blobsReused));
+
+        const int last = m_history.entries.size() - 1;
+        m_historySlider->blockSignals(true);
+        m_historySlider->setRange(0, last);
+        m_historySlider->setValue(last);
+        m_historySlider->blockSignals(false);
+        m_historySlider->setVisible(true);
+        m_historyLabel->setVisible(true);
+        m_actExportTimeline->setEnabled(true);
+        showHistoryEntry(last);
+    });
+
+    connect(&m_advisoryWatcher, &QFutureWatcher<AdvisoryLoad>::finished, this, [this]() {
+        const AdvisoryLoad result = m_advisoryWatcher.result();
+        m_actAdvisories->setEnabled(true);
+        m_actRebuildAdvisories->setEnabled(result.db || m_advisories);
+        if (!result.db) {
+            statusBar()->clearMessage();
+            QMessageBox::warning(this, "Advisory database", result.error);
+            return;
+        }
+        m_advisories = result.db;
+        QSettings().setValue("advisories/source", m_advisories->sourcePath());
+        applyLocalMetadata();
+        statusBar()->showMessage(QString("Advisories loaded: %1 advisories for %2 packages.")
+                                     .arg(m_advisories->advisoryCount())
+                                     .arg(m_advisories->packageCount()),
+                                 4000);
+    });
+
+    connect(&m_cycleWatcher, &QFutureWatcher<CycleScan>::finished, this, [this]() {
+        CycleScan result = m_cycleWatcher.future().takeResult();
+        // A newer request is already running if the edges moved on meanwhile.
+        if (result.revision != m_graph.topologyRevision())
+            return;
+        m_graph.setReachability(std::move(result.reach), result.revision);
+        fillCycleList(result.cycles);
+        m_view->refreshCycles();
+    });
+
+    connect(&m_registryWatcher, &QFutureWatcher<RegistryLoad>::finished, this, [this]() {
+        const RegistryLoad result = m_registryWatcher.result();
+        m_actRegistry->setEnabled(true);
+        if (!result.index) {
+            statusBar()->clearMessage();
+            QMessageBox::warning(this, "Registry metadata", result.error);
+            return;
+        }
+        m_registry = result.index;
+        QSettings().setValue("registry/source", m_registry->sourcePath());
+        applyLocalMetadata();
+        statusBar()->showMessage(QString("Registry metadata loaded: %1 packages.").arg(m_registry->packageCount()), 4000);
+    });
+
     statusBar()->showMessage("Open a folder or clone a repo to scan dependencies.");
+
+    // The index is cached, so reopening last session's database is cheap.
+    const QString advisorySource = QSettings().value("advisories/source").toString();
+    if (!advisorySource.isEmpty() && QFileInfo::exists(advisorySource))
+        openAdvisories(advisorySource, false);
+    const QString registrySource = QSettings().value("registry/source").toString();
+    if (!registrySource.isEmpty() && QFileInfo::exists(registrySource))
+        openRegistry(registrySource);
 }
 
 void MainWindow::buildUi()
@@ -91,18 +255,40 @@ void MainWindow::buildUi()
 
     tb->addSeparator();
 
+    // The view is created further down, so these resolve m_view when triggered.
     auto* actRelayout = new QAction("Relayout", this);
-    connect(actRelayout, &QAction::triggered, m_view, &GraphView::relayout);
+    connect(actRelayout, &QAction::triggered, this, [this]() { m_view->relayout(); });
     tb->addAction(actRelayout);
 
+    auto* actForceLayout = new QAction("Force Layout", this);
+    connect(actForceLayout, &QAction::triggered, this, [this]() { m_view->forceLayout(); });
+    tb->addAction(actForceLayout);
+
     auto* actFit = new QAction("Fit", this);
-    connect(actFit, &QAction::triggered, m_view, &GraphView::fitToContents);
+    connect(actFit, &QAction::triggered, this, [this]() { m_view->fitToContents(); });
     tb->addAction(actFit);
 
     auto* actResetView = new QAction("Reset View", this);
-    connect(actResetView, &QAction::triggered, m_view, &GraphView::resetView);
+    connect(actResetView, &QAction::triggered, this, [this]() { m_view->resetView(); });
     tb->addAction(actResetView);
 
+    auto* actCollapse = new QAction("Collapse Clusters", this);
+    actCollapse->setToolTip("Fold modules and ecosystems back into supernodes (double-click one to expand it)");
+    connect(actCollapse, &QAction::triggered, this, [this]() { m_view->collapseClusters(); });
+    tb->addAction(actCollapse);
+
+    tb->addSeparator();
+
+    auto* actUpstream = new QAction("Upstream", this);
+    actUpstream->setToolTip("Highlight everything that transitively depends on the selected node");
+    connect(actUpstream, &QAction::triggered, this, &MainWindow::showUpstream);
+    tb->addAction(actUpstream);
+
+    auto* actWhy = new QAction("Why Is This Here?", this);
+    actWhy->setToolTip("Show the shortest dependency chains to the selected node from the previously selected one, or from the repo");
+    connect(actWhy, &QAction::triggered, this, &MainWindow::explainSelected);
+    tb->addAction(actWhy);
+
     tb->addSeparator();
 
     m_actJson = new QAction("Export JSON", this);
@@ -136,6 +322,108 @@ void MainWindow::buildUi()
     connect(actQuit, &QAction::triggered, qApp, &QApplication::quit);
     fileMenu->addAction(actQuit);
 
+    auto* compareMenu = menuBar()->addMenu("Compare");
+    m_actDiffPrevious = new QAction("Diff With Previous Scan", this);
+    m_actDiffPrevious->setToolTip("Show what the last rescan added, removed or changed");
+    m_actDiffPrevious->setEnabled(false);
+    connect(m_actDiffPrevious, &QAction::triggered, this, &MainWindow::diffWithPreviousScan);
+    compareMenu->addAction(m_actDiffPrevious);
+
+    auto* actDiffSnapshot = new QAction("Diff With Snapshot...", this);
+    actDiffSnapshot->setToolTip("Compare the current graph with a JSON export");
+    connect(actDiffSnapshot, &QAction::triggered, this, &MainWindow::diffWithSnapshot);
+    compareMenu->addAction(actDiffSnapshot);
+
+    compareMenu->addSeparator();
+
+    m_actExportDiff = new QAction("Export Diff...", this);
+    m_actExportDiff->setEnabled(false);
+    connect(m_actExportDiff, &QAction::triggered, this, &MainWindow::exportDiff);
+    compareMenu->addAction(m_actExportDiff);
+
+    m_actClearDiff = new QAction("Clear Diff", this);
+    m_actClearDiff->setEnabled(false);
+    connect(m_actClearDiff, &QAction::triggered, this, &MainWindow::clearDiff);
+    compareMenu->addAction(m_actClearDiff);
+
+    compareMenu->addSeparator();
+
+    m_actHistory = new QAction("Dependency History...", this);
+    m_actHistory->setToolTip("Read the manifests of recent commits or tags from git and scrub through them");
+    connect(m_actHistory, &QAction::triggered, this, &MainWindow::scanHistory);
+    compareMenu->addAction(m_actHistory);
+
+    m_actExportTimeline = new QAction("Export Timeline...", this);
+    m_actExportTimeline->setEnabled(false);
+    connect(m_actExportTimeline, &QAction::triggered, this, &MainWindow::exportTimeline);
+    compareMenu->addAction(m_actExportTimeline);
+
+    auto* simulateMenu = menuBar()->addMenu("Simulate");
+    auto* actDrop = new QAction("Drop Selected Dependency", this);
+    actDrop->setToolTip("What breaks if nothing requires the selected node any more");
+    connect(actDrop, &QAction::triggered, this, &MainWindow::simulateDrop);
+    simulateMenu->addAction(actDrop);
+
+    auto* actVersion = new QAction("Change Selected Version...", this);
+    actVersion->setToolTip("Re-check statuses as if the selected node were at another version");
+    connect(actVersion, &QAction::triggered, this, &MainWindow::simulateVersion);
+    simulateMenu->addAction(actVersion);
+
+    simulateMenu->addSeparator();
+
+    m_actCommitWhatIf = new QAction("Commit Simulation", this);
+    m_actCommitWhatIf->setToolTip("Apply the simulated edits to the graph");
+    m_actCommitWhatIf->setEnabled(false);
+    connect(m_actCommitWhatIf, &QAction::triggered, this, &MainWindow::commitWhatIf);
+    simulateMenu->addAction(m_actCommitWhatIf);
+
+    m_actDiscardWhatIf = new QAction("Discard Simulation", this);
+    m_actDiscardWhatIf->setEnabled(false);
+    connect(m_actDiscardWhatIf, &QAction::triggered, this, &MainWindow::discardWhatIf);
+    simulateMenu->addAction(m_actDiscardWhatIf);
+
+    auto* toolsMenu = menuBar()->addMenu("Tools");
+    auto* actTrace = new QAction("Record Scan Trace", this);
+    actTrace->setToolTip("Time scan phases and parsers and count files, bytes and dependencies per ecosystem");
+    actTrace->setCheckable(true);
+    actTrace->setChecked(Trace::isEnabled());
+    connect(actTrace, &QAction::toggled, this, [](bool on) { Trace::setEnabled(on); });
+    toolsMenu->addAction(actTrace);
+
+    auto* actExportTrace = new QAction("Export Trace...", this);
+    actExportTrace->setToolTip("Save the last recorded trace for chrome://tracing or Perfetto");
+    connect(actExportTrace, &QAction::triggered, this, &MainWindow::exportTrace);
+    toolsMenu->addAction(actExportTrace);
+
+    auto* actMemory = new QAction("Memory Report...", this);
+    actMemory->setToolTip("Estimated memory used by the model, the scene, the lists and caches");
+    connect(actMemory, &QAction::triggered, this, &MainWindow::showMemoryReport);
+    toolsMenu->addAction(actMemory);
+
+    toolsMenu->addSeparator();
+    m_actAdvisories = new QAction("Load Advisory Database...", this);
+    m_actAdvisories->setToolTip("Match dependencies against a local OSV dump (directory or zip of JSON files)");
+    connect(m_actAdvisories, &QAction::triggered, this, &MainWindow::loadAdvisories);
+    toolsMenu->addAction(m_actAdvisories);
+
+    m_actRebuildAdvisories = new QAction("Rebuild Advisory Index", this);
+    m_actRebuildAdvisories->setToolTip("Re-read the advisory dump, e.g. after files in it were updated in place");
+    m_actRebuildAdvisories->setEnabled(false);
+    connect(m_actRebuildAdvisories, &QAction::triggered, this, &MainWindow::rebuildAdvisories);
+    toolsMenu->addAction(m_actRebuildAdvisories);
+
+    m_actRegistry = new QAction("Load Registry Metadata...", this);
+    m_actRegistry->setToolTip("Compare versions against a mirrored registry dump (JSON Lines of latest versions)");
+    connect(m_actRegistry, &QAction::triggered, this, &MainWindow::loadRegistry);
+    toolsMenu->addAction(m_actRegistry);
+
+    toolsMenu->addSeparator();
+    m_actHud = new QAction("Render HUD", this);
+    m_actHud->setToolTip("Overlay frame times and paint counts on the graph (H)");
+    m_actHud->setCheckable(true);
+    connect(m_actHud, &QAction::toggled, this, [this](bool on) { m_view->setHudVisible(on); });
+    toolsMenu->addAction(m_actHud);
+
     auto* helpMenu = menuBar()->addMenu("Help");
     auto* actAbout = new QAction("About", this);
     connect(actAbout, &QAction::triggered, this, &MainWindow::showAbout);
@@ -152,21 +440,63 @@ void MainWindow::buildUi()
     leftLayout->setSpacing(8);
 
     m_filterEdit = new QLineEdit(left);
-    m_filterEdit->setPlaceholderText("Filter nodes (substring)...");
-    connect(m_filterEdit, &QLineEdit::textChanged, this, &MainWindow::applyFilter);
+    m_filterEdit->setPlaceholderText("Search nodes: text, glob*, /regex/...");
     leftLayout->addWidget(m_filterEdit);
 
-    m_nodeList = new QListWidget(left);
+    // Typing restarts the timer; the filter runs once the user pauses.
+    m_filterTimer = new QTimer(this);
+    m_filterTimer->setSingleShot(true);
+    m_filterTimer->setInterval(150);
+    connect(m_filterEdit, &QLineEdit::textChanged, m_filterTimer, qOverload<>(&QTimer::start));
+    connect(m_filterTimer, &QTimer::timeout, this, &MainWindow::applyFilter);
+
+    m_nodeListModel = new NodeListModel(&m_graph, this);
+    m_nodeList = new QListView(left);
+    m_nodeList->setModel(m_nodeListModel);
+    m_nodeList->setUniformItemSizes(true);
     m_nodeList->setSelectionMode(QAbstractItemView::SingleSelection);
-    connect(m_nodeList, &QListWidget::itemSelectionChanged, this, &MainWindow::focusSelectedListItem);
+    connect(m_nodeList->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::focusSelectedListItem);
+    // Filtering and reloads move the current row too; only clicks count.
+    connect(m_nodeList->selectionModel(), &QItemSelectionModel::currentChanged, this,
+            [this](const QModelIndex& current) {
+                if (!m_updatingListSelection && current.isValid())
+                    rememberPick(current.data(NodeListModel::NodeIdRole).toInt());
+            });
     leftLayout->addWidget(m_nodeList, 1);
 
+    auto* cyclesLabel = new QLabel("Cycles", left);
+    leftLayout->addWidget(cyclesLabel);
+
+    m_cycleList = new QListWidget(left);
+    m_cycleList->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_cycleList->setMaximumHeight(140);
+    connect(m_cycleList, &QListWidget::itemSelectionChanged, this, &MainWindow::focusSelectedCycle);
+    leftLayout->addWidget(m_cycleList);
+
+    // Hidden until a dependency history is loaded. Without tracking the
+    // diff is rebuilt once when the handle is released, not on every step.
+    m_historyLabel = new QLabel(left);
+    m_historyLabel->setWordWrap(true);
+    m_historyLabel->setVisible(false);
+    leftLayout->addWidget(m_historyLabel);
+
+    m_historySlider = new QSlider(Qt::Horizontal, left);
+    m_historySlider->setTracking(false);
+    m_historySlider->setPageStep(1);
+    m_historySlider->setVisible(false);
+    connect(m_historySlider, &QSlider::valueChanged, this, &MainWindow::showHistoryEntry);
+    leftLayout->addWidget(m_historySlider);
+
     m_status = new QLabel(left);
     m_status->setWordWrap(true);
     m_status->setText("No repository loaded.");
     leftLayout->addWidget(m_status);
 
     m_view = new GraphView(splitter);
+    connect(m_view, &GraphView::hudVisibleChanged, m_actHud, &QAction::setChecked);
+
+    // Inserted above the status label once the view it navigates exists.
+    leftLayout->insertWidget(leftLayout->indexOf(m_status), new MiniMap(m_view, left));
 
     splitter->setStretchFactor(0, 0);
     splitter->setStretchFactor(1, 1);
@@ -248,14 +578,36 @@ void MainWindow::scanIntoGraph()
         return;
 
     setBusy(true, "Scanning...");
+    // Each scan's trace starts empty.
+    Trace::reset();
 
     const QDir repo = m_repoDir;
-    auto fut = QtConcurrent::run([repo]() -> GraphModel::Data {
+    m_scanAdvisories = m_advisories;
+    m_scanRegistry = m_registry;
+    auto fut = QtConcurrent::run([repo, cache = m_manifestCache, advisories = m_scanAdvisories,
+                                  registry = m_scanRegistry]() -> GraphModel::Data {
         GraphModel tmp; // local builder; never returned by value
         QString err;
-        (void)DependencyScanner::scanRepositoryToGraph(repo, &tmp, &err);
+        (void)DependencyScanner::scanRepositoryToGraph(repo, &tmp, &err, cache.get());
         // Best-effort: errors are non-fatal today; tmp may be partially filled.
-        return tmp.toData();
+        if (advisories || registry) {
+            QVector<NodeStatus> statuses;
+            statuses.reserve(tmp.nodes().size());
+            for (const Node& n : tmp.nodes())
+                statuses.push_back(n.status);
+            overlayLocalMetadata(tmp.nodes(), registry.get(), advisories.get(), &statuses);
+            tmp.setStatuses(statuses);
+        }
+        GraphModel::Data data = tmp.takeData();
+        {
+            Trace::Span span("scan.reachabilityIndex");
+            data.reachability = ReachabilityIndex::build(data.nodes.size(), data.edges);
+        }
+        {
+            Trace::Span span("scan.searchIndex");
+            data.search = TrigramIndex::build(data.nodes);
+        }
+        return data;
     });
     m_scanWatcher.setFuture(fut);
 }
@@ -310,10 +662,60 @@ void MainWindow::exportCsv()
 
 void MainWindow::exportPng()
 {
+    struct Preset {
+        const char* label;
+        TiledPngExport::Options options;
+    };
+    static const Preset kPresets[] = {
+        {"2x (192 DPI)", {2.0, 0, 192}},
+        {"1x (96 DPI)", {1.0, 0, 96}},
+        {"4x (384 DPI)", {4.0, 0, 384}},
+        {"8x (768 DPI)", {8.0, 0, 768}},
+        {"Longest side 8192 px", {1.0, 8192, 0}},
+        {"Longest side 32768 px", {1.0, 32768, 0}},
+    };
+    QStringList labels;
+    for (const Preset& p : kPresets)
+        labels << p.label;
+
+    bool ok = false;
+    const QString choice = QInputDialog::getItem(this, "Export PNG", "Resolution:", labels, 0, false, &ok);
+    if (!ok)
+        return;
     const QString path = QFileDialog::getSaveFileName(this, "Export PNG", defaultExportBaseName() + ".png", "PNG (*.png)");
     if (path.isEmpty())
         return;
-    m_view->exportPng(path);
+
+    TiledPngExport* job = m_view->createPngExport(kPresets[labels.indexOf(choice)].options, this);
+    const QSize size = job->outputSize();
+    m_actPng->setEnabled(false);
+
+    auto* progress = new QProgressDialog(QString("Exporting %1 x %2 px...").arg(size.width()).arg(size.height()),
+                                         "Cancel", 0, job->tileCount(), this);
+    progress->setWindowTitle("Export PNG");
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(300);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    connect(job, &TiledPngExport::progress, progress, [progress](int done, int) { progress->setValue(done); });
+    connect(progress, &QProgressDialog::canceled, job, &TiledPngExport::cancel);
+    connect(job, &TiledPngExport::finished, this, [this, job, progress, size](bool done, const QString& error) {
+        progress->deleteLater();
+        job->deleteLater();
+        m_actPng->setEnabled(true);
+        if (done)
+            statusBar()->showMessage(QString("Exported PNG (%1 x %2 px)").arg(size.width()).arg(size.height()), 4000);
+        else if (!error.isEmpty())
+            QMessageBox::warning(this, "Export failed", error);
+    });
+
+    QString err;
+    if (!job->start(path, &err)) {
+        progress->deleteLater();
+        job->deleteLater();
+        m_actPng->setEnabled(true);
+        QMessageBox::warning(this, "Export failed", err);
+    }
 }
 
 void MainWindow::exportSvg()
@@ -321,7 +723,398 @@ void MainWindow::exportSvg()
     const QString path = QFileDialog::getSaveFileName(this, "Export SVG", defaultExportBaseName() + ".svg", "SVG (*.svg)");
     if (path.isEmpty())
         return;
-    m_view->exportSvg(path);
+    QString err;
+    if (!m_view->exportSvg(path, &err))
+        QMessageBox::warning(this, "Export failed", err);
+}
+
+MemoryReport MainWindow::memoryReport() const
+{
+    // Per QListWidgetItem: the item, its QVariant map and a little slack.
+    static constexpr qint64 kListItemBytes = 120;
+
+    MemoryReport report;
+    m_graph.reportMemory(&report, "model");
+    if (m_diff)
+        m_diffGraph.reportMemory(&report, "diff model");
+    m_view->reportMemory(&report);
+
+    report.add("node list", "list model", m_nodeListModel->memoryBytes(), m_nodeListModel->rowCount());
+    qint64 cycleItems = 0;
+    for (int i = 0; i < m_cycleList->count(); i++)
+        cycleItems += kListItemBytes + MemoryReport::bytesOf(m_cycleList->item(i)->text());
+    report.add("node list", "cycle list", cycleItems, m_cycleList->count());
+    return report;
+}
+
+void MainWindow::showMemoryReport()
+{
+    QDialog dlg(this);
+    dlg.setWindowTitle("Memory Report");
+    dlg.resize(620, 520);
+
+    auto* text = new QPlainTextEdit(&dlg);
+    text->setReadOnly(true);
+    text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    text->setPlainText(memoryReport().toText());
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dlg);
+    auto* refresh = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+    auto* save = buttons->addButton("Save JSON...", QDialogButtonBox::ActionRole);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    connect(refresh, &QPushButton::clicked, &dlg, [this, text]() { text->setPlainText(memoryReport().toText()); });
+    connect(save, &QPushButton::clicked, &dlg, [this, &dlg]() {
+        const QString path = QFileDialog::getSaveFileName(&dlg, "Save Memory Report", defaultExportBaseName() + "-memory.json", "JSON (*.json)");
+        if (path.isEmpty())
+            return;
+        QString err;
+        if (!writeBytesAtomically(path, memoryReport().toJson(), &err))
+            QMessageBox::warning(&dlg, "Save failed", err);
+    });
+
+    auto* layout = new QVBoxLayout(&dlg);
+    layout->addWidget(text);
+    layout->addWidget(buttons);
+    dlg.exec();
+}
+
+void MainWindow::loadAdvisories()
+{
+    QMessageBox box(this);
+    box.setWindowTitle("Load Advisory Database");
+    box.setText("Load an OSV advisory dump from a zip file or from a directory of JSON files?");
+    auto* zipButton = box.addButton("Zip File...", QMessageBox::AcceptRole);
+    auto* dirButton = box.addButton("Directory...", QMessageBox::AcceptRole);
+    box.addButton(QMessageBox::Cancel);
+    box.exec();
+
+    QString source;
+    if (box.clickedButton() == zipButton)
+        source = QFileDialog::getOpenFileName(this, "OSV Advisory Dump", QString(), "Zip archives (*.zip)");
+    else if (box.clickedButton() == dirButton)
+        source = QFileDialog::getExistingDirectory(this, "OSV Advisory Directory");
+    if (!source.isEmpty())
+        openAdvisories(source, false);
+}
+
+void MainWindow::rebuildAdvisories()
+{
+    if (m_advisories)
+        openAdvisories(m_advisories->sourcePath(), true);
+}
+
+void MainWindow::openAdvisories(const QString& source, bool rebuild)
+{
+    if (m_advisoryWatcher.isRunning())
+        return;
+
+    m_actAdvisories->setEnabled(false);
+    m_actRebuildAdvisories->setEnabled(false);
+    statusBar()->showMessage("Loading advisories...");
+    // Parsing a full dump takes a while the first time; later loads only map the index.
+    auto fut = QtConcurrent::run([source, rebuild]() -> AdvisoryLoad {
+        AdvisoryLoad result;
+        auto db = std::make_shared<AdvisoryDb>();
+        if (db->load(source, rebuild, &result.error))
+            result.db = std::move(db);
+        return result;
+    });
+    m_advisoryWatcher.setFuture(fut);
+}
+
+void MainWindow::loadRegistry()
+{
+    const QString source = QFileDialog::getOpenFileName(this, "Registry Metadata", QString(),
+                                                        "JSON Lines (*.jsonl *.ndjson);;All files (*)");
+    if (!source.isEmpty())
+        openRegistry(source);
+}
+
+void MainWindow::openRegistry(const QString& source)
+{
+    if (m_registryWatcher.isRunning())
+        return;
+
+    m_actRegistry->setEnabled(false);
+    statusBar()->showMessage("Loading registry metadata...");
+    auto fut = QtConcurrent::run([source]() -> RegistryLoad {
+        RegistryLoad result;
+        auto index = std::make_shared<RegistryIndex>();
+        if (index->load(source, &result.error))
+            result.index = std::move(index);
+        return result;
+    });
+    m_registryWatcher.setFuture(fut);
+}
+
+// Statuses from the versions alone, then registry lag and advisories on top.
+void MainWindow::applyLocalMetadata()
+{
+    if (m_graph.nodes().isEmpty() || m_scanWatcher.isRunning())
+        return;
+    QVector<NodeStatus> statuses = VersionConflicts::analyze(m_graph.nodes(), m_graph.edges()).statuses;
+    overlayLocalMetadata(m_graph.nodes(), m_registry.get(), m_advisories.get(), &statuses);
+    m_graph.setStatuses(statuses);
+}
+
+void MainWindow::exportTrace()
+{
+    if (Trace::spanTotals().isEmpty()) {
+        QMessageBox::information(this, "Export Trace", "Nothing recorded. Enable Tools > Record Scan Trace and rescan.");
+        return;
+    }
+    const QString path = QFileDialog::getSaveFileName(this, "Export Trace", defaultExportBaseName() + "-trace.json", "Trace JSON (*.json)");
+    if (path.isEmpty())
+        return;
+    QString err;
+    if (!writeBytesAtomically(path, Trace::toChromeJson(), &err))
+        QMessageBox::warning(this, "Export failed", err);
+}
+
+void MainWindow::diffWithPreviousScan()
+{
+    if (m_previousScan.nodes.isEmpty())
+        return;
+    showDiff(m_previousScan, m_graph.toData(), "previous scan");
+}
+
+void MainWindow::diffWithSnapshot()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Diff With Snapshot", QString(), "JSON (*.json)");
+    if (path.isEmpty())
+        return;
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Diff failed", QString("Cannot read %1").arg(path));
+        return;
+    }
+
+    GraphModel::Data snapshot;
+    QString err;
+    if (!GraphModel::fromJson(f.readAll(), &snapshot, &err)) {
+        QMessageBox::warning(this, "Diff failed", err);
+        return;
+    }
+    showDiff(snapshot, m_graph.toData(), QFileInfo(path).fileName());
+}
+
+void MainWindow::showDiff(const GraphModel::Data& before, const GraphModel::Data& after, const QString& baseline)
+{
+    m_historyShown = -1;
+    m_diff = std::make_shared<GraphDiff>(GraphDiff::compute(before, after));
+
+    m_diffGraph.replaceFromData(m_diff->merged());
+    m_view->setModel(&m_diffGraph);
+    m_view->setDiff(m_diff);
+    m_actExportDiff->setEnabled(true);
+    m_actClearDiff->setEnabled(true);
+
+    const int edgeChanges = m_diff->edgeDeltas().size();
+    statusBar()->showMessage(QString("Diff against %1: %2 added, %3 removed, %4 changed nodes; %5 edge changes.")
+                                 .arg(baseline)
+                                 .arg(m_diff->count(GraphDiff::Change::Added))
+                                 .arg(m_diff->count(GraphDiff::Change::Removed))
+                                 .arg(m_diff->count(GraphDiff::Change::Changed))
+                                 .arg(edgeChanges));
+}
+
+void MainWindow::exportDiff()
+{
+    if (!m_diff)
+        return;
+    const QString path = QFileDialog::getSaveFileName(this, "Export Diff", defaultExportBaseName() + "-diff.json", "JSON (*.json)");
+    if (path.isEmpty())
+        return;
+    QString err;
+    if (!writeBytesAtomically(path, m_diff->toJson(), &err))
+        QMessageBox::warning(this, "Export failed", err);
+}
+
+void MainWindow::scanHistory()
+{
+    if (m_historyWatcher.isRunning())
+        return;
+    if (!m_repoDir.exists()) {
+        QMessageBox::information(this, "No repo", "Open a folder or clone a repo first.");
+        return;
+    }
+
+    bool ok = false;
+    const QString source = QInputDialog::getItem(this, "Dependency History", "Read manifests of:",
+                                                 {"Recent commits", "Tags"}, 0, false, &ok);
+    if (!ok)
+        return;
+    const int count = QInputDialog::getInt(this, "Dependency History", "How many (newest):", 20, 2, 1000, 1, &ok);
+    if (!ok)
+        return;
+
+    setBusy(true, "Reading dependency history...");
+    m_actHistory->setEnabled(false);
+
+    const QString repo = m_repoDir.absolutePath();
+    const bool tags = source == "Tags";
+    auto fut = QtConcurrent::run([repo, tags, count]() -> DependencyHistory {
+        DependencyHistory history;
+        QString err;
+        QVector<GitHandler::Commit> commits;
+        if (tags) {
+            commits = GitHandler::listTags(repo, &err);
+            if (commits.size() > count)
+                commits.remove(0, commits.size() - count);
+        } else {
+            commits = GitHandler::listCommits(repo, "HEAD", count, &err);
+        }
+        if (err.isEmpty())
+            HistoryScanner::scan(repo, commits, &history, &err);
+        history.error = err;
+        return history;
+    });
+    m_historyWatcher.setFuture(fut);
+}
+
+void MainWindow::showHistoryEntry(int index)
+{
+    if (index < 0 || index >= m_history.entries.size())
+        return;
+
+    // Each entry is shown as a diff against the one before it; the oldest
+    // entry against itself, so it appears unchanged.
+    const DependencyHistory::Entry& entry = m_history.entries[index];
+    const DependencyHistory::Entry& before = m_history.entries[index > 0 ? index - 1 : 0];
+    showDiff(before.graph, entry.graph, index > 0 ? before.commit.id.left(10) : QString("itself"));
+    m_historyShown = index;
+
+    m_historyLabel->setText(QString("History %1/%2: %3  %4\n%5")
+                                .arg(index + 1)
+                                .arg(m_history.entries.size())
+                                .arg(entry.commit.id.left(10))
+                                .arg(QDateTime::fromSecsSinceEpoch(entry.commit.time).toString("yyyy-MM-dd"))
+                                .arg(entry.commit.subject));
+}
+
+void MainWindow::exportTimeline()
+{
+    if (m_history.entries.isEmpty())
+        return;
+    const QString path = QFileDialog::getSaveFileName(this, "Export Timeline", defaultExportBaseName() + "-history.json", "JSON (*.json)");
+    if (path.isEmpty())
+        return;
+    QString err;
+    if (!writeBytesAtomically(path, m_history.toJson(), &err))
+        QMessageBox::warning(this, "Export failed", err);
+}
+
+void MainWindow::clearDiff()
+{
+    if (!m_diff)
+        return;
+    m_historyShown = -1;
+    m_diff.reset();
+    m_view->setDiff(nullptr);
+    m_view->setModel(&m_graph);
+    m_diffGraph.clear();
+    m_actExportDiff->setEnabled(false);
+    m_actClearDiff->setEnabled(false);
+}
+
+WhatIfOverlay* MainWindow::whatIf()
+{
+    if (!m_whatIf) {
+        // Simulations run on the current graph, not on a diff.
+        clearDiff();
+        m_whatIf = std::make_shared<WhatIfOverlay>(m_graph);
+        m_whatIf->setLocalMetadata(m_registry, m_advisories);
+    }
+    return m_whatIf.get();
+}
+
+void MainWindow::simulateDrop()
+{
+    const Node* target = m_graph.nodeById(selectedNodeId());
+    if (!target) {
+        statusBar()->showMessage("Select a node first.", 2500);
+        return;
+    }
+    if (whatIf()->dropNode(target->id) == 0) {
+        statusBar()->showMessage(QString("Nothing requires %1.").arg(target->name), 2500);
+        return;
+    }
+    showWhatIf();
+}
+
+void MainWindow::simulateVersion()
+{
+    const Node* target = m_graph.nodeById(selectedNodeId());
+    if (!target) {
+        statusBar()->showMessage("Select a node first.", 2500);
+        return;
+    }
+    const QString current = m_whatIf ? m_whatIf->version(target->id) : target->version;
+    bool ok = false;
+    const QString version = QInputDialog::getText(this, "Change Version", QString("Version of %1:").arg(target->name),
+                                                  QLineEdit::Normal, current, &ok);
+    if (!ok)
+        return;
+    whatIf()->setVersion(target->id, version);
+    showWhatIf();
+}
+
+void MainWindow::commitWhatIf()
+{
+    if (!m_whatIf)
+        return;
+    // Taken out first: the change notification below discards any overlay.
+    std::shared_ptr<WhatIfOverlay> overlay = std::move(m_whatIf);
+    const int edits = overlay->editCount();
+    if (!m_graph.applyOverlay(std::move(*overlay))) {
+        showWhatIf();
+        statusBar()->showMessage("The simulation no longer matches the graph; it was discarded.", 4000);
+        return;
+    }
+    showWhatIf();
+    statusBar()->showMessage(QString("Committed %1 simulated edits.").arg(edits), 4000);
+}
+
+void MainWindow::discardWhatIf()
+{
+    m_whatIf.reset();
+    showWhatIf();
+}
+
+void MainWindow::showWhatIf()
+{
+    const bool active = m_whatIf && !m_whatIf->isEmpty();
+    m_actCommitWhatIf->setEnabled(active);
+    m_actDiscardWhatIf->setEnabled(active);
+    if (!active) {
+        m_view->clearHighlight();
+        statusBar()->clearMessage();
+        return;
+    }
+
+    const QVector<int> lost = m_whatIf->unreachable();
+    const QVector<WhatIfOverlay::StatusChange> changes = m_whatIf->statusChanges();
+    QVector<int> affected = lost;
+    int conflicts = 0;
+    for (const WhatIfOverlay::StatusChange& c : changes) {
+        affected.push_back(c.nodeId);
+        if (c.after == NodeStatus::Conflict)
+            conflicts++;
+    }
+    // Dependents whose requirement an edited version breaks, so the bump
+    // shows where it would have to be followed up.
+    const QVector<WhatIfOverlay::Violation> broken = m_whatIf->violations();
+    for (const WhatIfOverlay::Violation& v : broken)
+        affected.push_back(v.requirerId);
+    m_view->highlightNodes(affected);
+    statusBar()->showMessage(QString("What if (%1 edits): %2 nodes no longer pulled in, %3 change status, %4 in conflict, "
+                                     "%5 requirements broken.")
+                                 .arg(m_whatIf->editCount())
+                                 .arg(lost.size())
+                                 .arg(changes.size())
+                                 .arg(conflicts)
+                                 .arg(broken.size()));
 }
 
 void MainWindow::onNodeSelected(int nodeId)
@@ -329,79 +1122,96 @@ void MainWindow::onNodeSelected(int nodeId)
     if (m_updatingListSelection)
         return;
 
-    const Node* n = m_graph.nodeById(nodeId);
+    // A history entry is a different graph: its ids do not index the list.
+    const GraphModel& shown = m_diff ? m_diffGraph : m_graph;
+    const Node* n = shown.nodeById(nodeId);
     if (!n)
         return;
 
-    // Best-effort: select the matching list row by storing nodeId in item data.
-    m_updatingListSelection = true;
-    for (int i = 0; i < m_nodeList->count(); i++) {
-        auto* it = m_nodeList->item(i);
-        if (!it)
-            continue;
-        if (it->data(Qt::UserRole).toInt() == nodeId) {
-            m_nodeList->setCurrentRow(i);
-            break;
+    if (m_historyShown < 0) {
+        rememberPick(nodeId);
+        m_updatingListSelection = true;
+        selectNodeInList(nodeId);
+        m_updatingListSelection = false;
+    }
+
+    QString message = QString("%1  %2  [%3]").arg(n->name, n->version, n->kind);
+    if (m_registry) {
+        const RegistryIndex::Lag lag = m_registry->lag(n->kind, n->name, n->version);
+        if (lag.known && (lag.majorsBehind > 0 || lag.minorsBehind > 0))
+            message += QString("  behind: %1 major, %2 minor (latest %3)").arg(lag.majorsBehind).arg(lag.minorsBehind).arg(lag.latest);
+        else if (lag.known)
+            message += QString("  up to date (latest %1)").arg(lag.latest);
+    }
+    if (n->status == NodeStatus::Vulnerable && m_advisories) {
+        QStringList ids;
+        for (int a : m_advisories->match(n->kind, n->name, n->version)) {
+            const AdvisoryDb::Advisory adv = m_advisories->advisory(a);
+            ids.push_back(adv.severity == AdvisoryDb::Severity::Unknown
+                              ? adv.id
+                              : QString("%1 (%2)").arg(adv.id, AdvisoryDb::severityToString(adv.severity)));
         }
+        message += "  vulnerable: " + ids.join(", ");
     }
-    m_updatingListSelection = false;
+    statusBar()->showMessage(message, 4000);
+}
 
-    statusBar()->showMessage(QString("%1  %2  [%3]").arg(n->name, n->version, n->kind), 4000);
+void MainWindow::rememberPick(int nodeId)
+{
+    if (nodeId == m_pickedNodeId)
+        return;
+    m_previousSelectedId = m_pickedNodeId;
+    m_pickedNodeId = nodeId;
+}
+
+void MainWindow::selectNodeInList(int nodeId)
+{
+    const int row = m_nodeListModel->rowOfNode(nodeId);
+    if (row < 0)
+        return;
+    const QModelIndex index = m_nodeListModel->index(row);
+    m_nodeList->setCurrentIndex(index);
+    m_nodeList->scrollTo(index);
 }
 
 void MainWindow::repopulateNodeList()
 {
-    // Keep selection stable if possible; rebuild contents based on filter.
-    applyFilter();
+    // Keep selection stable if possible; rescan with the current filter.
+    const int keepSelectedId = selectedNodeId();
+
+    m_updatingListSelection = true;
+    m_nodeListModel->reload();
+    if (keepSelectedId >= 0)
+        selectNodeInList(keepSelectedId);
+    m_updatingListSelection = false;
 }
 
 void MainWindow::applyFilter()
 {
+    m_filterTimer->stop();
+
     const QString needle = m_filterEdit ? m_filterEdit->text().trimmed() : QString();
-    const int keepSelectedId = (m_nodeList && m_nodeList->currentItem())
-                                  ? m_nodeList->currentItem()->data(Qt::UserRole).toInt()
-                                  : -1;
+    const int keepSelectedId = selectedNodeId();
 
     m_updatingListSelection = true;
-    m_nodeList->clear();
-
-    for (const Node& n : m_graph.nodes()) {
-        if (!needle.isEmpty()) {
-            if (!n.name.contains(needle, Qt::CaseInsensitive) &&
-                !n.kind.contains(needle, Qt::CaseInsensitive) &&
-                !n.version.contains(needle, Qt::CaseInsensitive)) {
-                continue;
-            }
-        }
-
-        QString line = n.name;
-        if (!n.version.isEmpty())
-            line += "  " + n.version;
-        if (!n.kind.isEmpty())
-            line += "  (" + n.kind + ")";
-
-        auto* item = new QListWidgetItem(line, m_nodeList);
-        item->setData(Qt::UserRole, n.id);
-        if (n.status == NodeStatus::Outdated)
-            item->setForeground(QColor(245, 200, 80));
-        else if (n.status == NodeStatus::Deprecated)
-            item->setForeground(QColor(255, 110, 110));
-        else if (n.status == NodeStatus::Conflict)
-            item->setForeground(QColor(255, 80, 160));
-    }
+    m_nodeListModel->setFilter(needle);
+    if (keepSelectedId >= 0)
+        selectNodeInList(keepSelectedId);
+    m_updatingListSelection = false;
 
-    // Restore selection.
-    if (keepSelectedId >= 0) {
-        for (int i = 0; i < m_nodeList->count(); i++) {
-            auto* it = m_nodeList->item(i);
-            if (it && it->data(Qt::UserRole).toInt() == keepSelectedId) {
-                m_nodeList->setCurrentRow(i);
-                break;
-            }
-        }
+    // The best matches are lit on the canvas too; rows are already ranked.
+    // Short or fuzzy queries can match most of a large graph, and lighting
+    // all of it would say nothing.
+    if (needle.isEmpty()) {
+        m_view->clearHighlight();
+    } else {
+        const int count = qMin(m_nodeListModel->rowCount(), kMaxFilterHighlights);
+        QVector<int> ids;
+        ids.reserve(count);
+        for (int row = 0; row < count; row++)
+            ids.push_back(m_nodeListModel->nodeAt(row));
+        m_view->highlightNodes(ids);
     }
-
-    m_updatingListSelection = false;
 }
 
 void MainWindow::focusSelectedListItem()
@@ -409,11 +1219,140 @@ void MainWindow::focusSelectedListItem()
     if (m_updatingListSelection)
         return;
 
-    auto* it = m_nodeList->currentItem();
-    if (!it)
+    const int nodeId = selectedNodeId();
+    if (nodeId < 0)
         return;
 
-    const int nodeId = it->data(Qt::UserRole).toInt();
     m_view->focusNode(nodeId);
     m_view->highlightImpactFrom(nodeId);
 }
+
+int MainWindow::selectedNodeId() const
+{
+    const QModelIndex index = m_nodeList->currentIndex();
+    return index.isValid() ? index.data(NodeListModel::NodeIdRole).toInt() : -1;
+}
+
+void MainWindow::showUpstream()
+{
+    const Node* target = m_graph.nodeById(selectedNodeId());
+    if (!target) {
+        statusBar()->showMessage("Select a node first.", 2500);
+        return;
+    }
+
+    const QVector<int> up = m_graph.upstream(target->id);
+    int modules = 0;
+    for (int id : up) {
+        const Node* n = m_graph.nodeById(id);
+        if (n && n->id != target->id && n->kind.endsWith(":module"))
+            modules++;
+    }
+
+    m_view->highlightUpstreamOf(target->id);
+    statusBar()->showMessage(QString("%1 nodes (%2 modules) transitively depend on %3.")
+                                 .arg(up.size() - 1)
+                                 .arg(modules)
+                                 .arg(target->name));
+}
+
+void MainWindow::explainSelected()
+{
+    const Node* target = m_graph.nodeById(selectedNodeId());
+    if (!target) {
+        statusBar()->showMessage("Select a node first.", 2500);
+        return;
+    }
+
+    // Select the node to start from first, then the target; without an
+    // earlier selection, start from node 0, the repo root the scanner hangs
+    // everything from.
+    const Node* source = m_graph.nodeById(m_previousSelectedId);
+    if (!source || source->id == target->id)
+        source = m_graph.nodeById(0);
+    if (!source)
+        return;
+
+    QVector<QVector<int>> paths = m_graph.kShortestPaths(source->id, target->id, 3);
+    if (paths.isEmpty() && source->id != 0) {
+        statusBar()->showMessage(QString("%1 does not depend on %2; showing chains from the repo root.")
+                                     .arg(source->name, target->name), 3500);
+        source = m_graph.nodeById(0);
+        paths = m_graph.kShortestPaths(0, target->id, 3);
+    }
+    if (paths.isEmpty()) {
+        statusBar()->showMessage(QString("%1 is not reachable from the repo root.").arg(target->name), 3500);
+        return;
+    }
+
+    QStringList lines;
+    for (const QVector<int>& path : paths) {
+        QStringList names;
+        for (int id : path)
+            names << m_graph.nodeById(id)->name;
+        lines << names.join("  ->  ");
+    }
+
+    m_view->highlightNodes(paths.first());
+    QMessageBox::information(this, QString("Why is %1 here? (from %2)").arg(target->name, source->name), lines.join("\n\n"));
+}
+
+void MainWindow::repopulateCycleList()
+{
+    // Runs on every model change; only added or removed nodes and edges can
+    // change the cycles.
+    const quint64 revision = m_graph.topologyRevision();
+    if (revision == m_cycleRevision)
+        return;
+    m_cycleRevision = revision;
+
+    // Scans hand over an index built on their worker; use it when present.
+    if (const auto reach = m_graph.reachabilityIfBuilt()) {
+        fillCycleList(GraphModel::cycles(*reach));
+        return;
+    }
+
+    m_cycleList->clear();
+    m_cycleList->addItem("Finding cycles...");
+    const int nodeCount = m_graph.nodes().size();
+    const QVector<Edge> edges = m_graph.edges();
+    m_cycleWatcher.setFuture(QtConcurrent::run([nodeCount, edges, revision]() {
+        CycleScan scan;
+        scan.reach = ReachabilityIndex::build(nodeCount, edges);
+        scan.cycles = GraphModel::cycles(*scan.reach);
+        scan.revision = revision;
+        return scan;
+    }));
+}
+
+void MainWindow::fillCycleList(const QVector<QVector<int>>& cycles)
+{
+    m_cycleList->clear();
+    for (const QVector<int>& members : cycles) {
+        QStringList names;
+        for (int i = 0; i < members.size() && i < 4; i++)
+            names << m_graph.nodeById(members[i])->name;
+        if (members.size() > 4)
+            names << "...";
+
+        auto* item = new QListWidgetItem(QString("%1 nodes: %2").arg(members.size()).arg(names.join(", ")), m_cycleList);
+        item->setData(Qt::UserRole, QVariant::fromValue(members));
+        item->setForeground(QColor(255, 80, 160));
+    }
+
+    if (cycles.isEmpty())
+        m_cycleList->addItem("No cycles.");
+}
+
+void MainWindow::focusSelectedCycle()
+{
+    auto* it = m_cycleList->currentItem();
+    if (!it || !it->data(Qt::UserRole).isValid())
+        return;
+
+    const QVector<int> members = it->data(Qt::UserRole).value<QVector<int>>();
+    if (members.isEmpty())
+        return;
+    m_view->focusNode(members.first());
+    m_view->highlightNodes(members);
+}
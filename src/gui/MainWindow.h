@@ -4,16 +4,29 @@
 #include <QDir>
 #include <QFutureWatcher>
 
+#include <memory>
+
 class QLabel;
+class QListView;
 class QListWidget;
 class QLineEdit;
+class QSlider;
 class QSplitter;
 class QAction;
+class QTimer;
 
 #include "model/GraphModel.h"
 #include "github/GitHandler.h"
-
+#include "parser/HistoryScanner.h"
+
+class AdvisoryDb;
+class ManifestCache;
+class WhatIfOverlay;
+class RegistryIndex;
+class GraphDiff;
+class MemoryReport;
 class GraphView;
+class NodeListModel;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -29,12 +42,33 @@ private slots:
     void exportCsv();
     void exportPng();
     void exportSvg();
+    void exportTrace();
+    void showMemoryReport();
+    void loadAdvisories();
+    void rebuildAdvisories();
+    void loadRegistry();
 
     void showAbout();
 
     void onNodeSelected(int nodeId);
     void applyFilter();
     void focusSelectedListItem();
+    void showUpstream();
+    void explainSelected();
+    void focusSelectedCycle();
+
+    void diffWithPreviousScan();
+    void diffWithSnapshot();
+    void exportDiff();
+    void clearDiff();
+    void scanHistory();
+    void exportTimeline();
+    void showHistoryEntry(int index);
+
+    void simulateDrop();
+    void simulateVersion();
+    void commitWhatIf();
+    void discardWhatIf();
 
 private:
     void buildUi();
@@ -42,7 +76,20 @@ private:
     void scanIntoGraph();
     void setBusy(bool busy, const QString& message = QString());
     void repopulateNodeList();
+    void repopulateCycleList();
+    void fillCycleList(const QVector<QVector<int>>& cycles);
+    void selectNodeInList(int nodeId);
+    // A node the user picked, in the list or on the canvas.
+    void rememberPick(int nodeId);
+    void showDiff(const GraphModel::Data& before, const GraphModel::Data& after, const QString& baseline);
+    MemoryReport memoryReport() const;
+    void openAdvisories(const QString& source, bool rebuild);
+    void openRegistry(const QString& source);
+    void applyLocalMetadata();
+    WhatIfOverlay* whatIf();
+    void showWhatIf();
     QString defaultExportBaseName() const;
+    int selectedNodeId() const;
 
     QDir m_repoDir;
 
@@ -50,9 +97,14 @@ private:
     GitHandler m_git;
 
     GraphView* m_view = nullptr;
-    QListWidget* m_nodeList = nullptr;
+    QListView* m_nodeList = nullptr;
+    NodeListModel* m_nodeListModel = nullptr;
+    QTimer* m_filterTimer = nullptr;
+    QListWidget* m_cycleList = nullptr;
     QLineEdit* m_filterEdit = nullptr;
     QLabel* m_status = nullptr;
+    QSlider* m_historySlider = nullptr;
+    QLabel* m_historyLabel = nullptr;
 
     bool m_updatingListSelection = false;
 
@@ -63,6 +115,68 @@ private:
     QAction* m_actCsv = nullptr;
     QAction* m_actPng = nullptr;
     QAction* m_actSvg = nullptr;
+    QAction* m_actDiffPrevious = nullptr;
+    QAction* m_actExportDiff = nullptr;
+    QAction* m_actClearDiff = nullptr;
+    QAction* m_actHistory = nullptr;
+    QAction* m_actExportTimeline = nullptr;
+    QAction* m_actHud = nullptr;
+    QAction* m_actAdvisories = nullptr;
+    QAction* m_actRebuildAdvisories = nullptr;
+    QAction* m_actRegistry = nullptr;
+    QAction* m_actCommitWhatIf = nullptr;
+    QAction* m_actDiscardWhatIf = nullptr;
+
+    // Edits tried from the Simulate menu; m_graph is untouched until they
+    // are committed. Dropped whenever the graph changes underneath.
+    std::shared_ptr<WhatIfOverlay> m_whatIf;
+
+    // Baseline for "Diff With Previous Scan": the graph before the last scan.
+    GraphModel::Data m_previousScan;
+    // While a diff is shown the view displays m_diffGraph (GraphDiff::merged()).
+    GraphModel m_diffGraph;
+    std::shared_ptr<const GraphDiff> m_diff;
+
+    // Loaded by "Dependency History..."; the slider picks the entry to show.
+    DependencyHistory m_history;
+    // Entry the diff view shows, or -1 when it shows the current graph.
+    int m_historyShown = -1;
+    // Node selected before the current one; "Why Is This Here?" explains
+    // the chains from it, or from the repo root when there is none.
+    int m_previousSelectedId = -1;
+    int m_pickedNodeId = -1; // the user's latest pick
+
+    // Parse results of the last scan; rescans only parse changed manifests.
+    // Shared with the scan worker, which may outlive a repo switch.
+    std::shared_ptr<ManifestCache> m_manifestCache;
+
+    // Local OSV advisories; scans mark matching nodes Vulnerable.
+    std::shared_ptr<const AdvisoryDb> m_advisories;
+    // Mirrored registry metadata; scans mark nodes a major version behind Outdated.
+    std::shared_ptr<const RegistryIndex> m_registry;
+    // What the running scan matched against.
+    std::shared_ptr<const AdvisoryDb> m_scanAdvisories;
+    std::shared_ptr<const RegistryIndex> m_scanRegistry;
+    struct AdvisoryLoad {
+        std::shared_ptr<const AdvisoryDb> db;
+        QString error;
+    };
+    struct RegistryLoad {
+        std::shared_ptr<const RegistryIndex> index;
+        QString error;
+    };
+    // Cycles are found off the GUI thread when the graph has no index yet.
+    struct CycleScan {
+        std::shared_ptr<const ReachabilityIndex> reach;
+        QVector<QVector<int>> cycles;
+        quint64 revision = 0;
+    };
+    // Topology the cycle list shows; status and version edits keep it.
+    quint64 m_cycleRevision = ~quint64(0);
 
     QFutureWatcher<GraphModel::Data> m_scanWatcher;
+    QFutureWatcher<DependencyHistory> m_historyWatcher;
+    QFutureWatcher<AdvisoryLoad> m_advisoryWatcher;
+    QFutureWatcher<RegistryLoad> m_registryWatcher;
+    QFutureWatcher<CycleScan> m_cycleWatcher;
 };
@@ -0,0 +1,78 @@
+﻿#include "MiniMap.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+#include "gui/GraphView.h"
+#include "gui/TileCache.h"
+
+MiniMap::MiniMap(GraphView* view, QWidget* parent)
+    : QWidget(parent), m_view(view)
+{
+    setMinimumHeight(120);
+    setCursor(Qt::PointingHandCursor);
+
+    connect(m_view, &GraphView::viewportChanged, this, qOverload<>(&QWidget::update));
+    connect(m_view->tileCache(), &TileCache::tileReady, this, qOverload<>(&QWidget::update));
+    connect(m_view->tileCache(), &TileCache::invalidated, this, qOverload<>(&QWidget::update));
+}
+
+QTransform MiniMap::sceneToWidget() const
+{
+    const QRectF bounds = m_view->overviewBounds();
+    if (bounds.isEmpty())
+        return QTransform();
+
+    const qreal s = 0.95 * qMin(width() / bounds.width(), height() / bounds.height());
+    QTransform t;
+    t.translate(width() * 0.5, height() * 0.5);
+    t.scale(s, s);
+    t.translate(-bounds.center().x(), -bounds.center().y());
+    return t;
+}
+
+void MiniMap::paintEvent(QPaintEvent*)
+{
+    QPainter p(this);
+    p.fillRect(rect(), QColor(8, 12, 18));
+    p.setPen(QColor(28, 38, 52));
+    p.drawRect(rect().adjusted(0, 0, -1, -1));
+
+    const QRectF bounds = m_view->overviewBounds();
+    if (bounds.isEmpty())
+        return;
+
+    const QTransform t = sceneToWidget();
+    p.setTransform(t);
+    p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+    m_view->drawOverview(&p, bounds, t.m11());
+
+    // Visible area of the main view.
+    const QPolygonF visible = m_view->mapToScene(m_view->viewport()->rect());
+    p.setRenderHint(QPainter::Antialiasing, true);
+    QPen pen(QColor(255, 245, 170, 200), 0);
+    p.setPen(pen);
+    p.setBrush(QColor(255, 245, 170, 30));
+    p.drawPolygon(visible);
+}
+
+void MiniMap::mousePressEvent(QMouseEvent* e)
+{
+    if (e->button() == Qt::LeftButton)
+        navigateTo(e->pos());
+}
+
+void MiniMap::mouseMoveEvent(QMouseEvent* e)
+{
+    if (e->buttons() & Qt::LeftButton)
+        navigateTo(e->pos());
+}
+
+void MiniMap::navigateTo(const QPoint& pos)
+{
+    bool invertible = false;
+    const QTransform inv = sceneToWidget().inverted(&invertible);
+    if (!invertible)
+        return;
+    m_view->centerOn(inv.map(QPointF(pos)));
+}
@@ -0,0 +1,26 @@
+﻿#pragma once
+
+#include <QWidget>
+
+class GraphView;
+
+// Overview of the whole graph, composited from the view's overview tiles.
+// Shows the visible area and recentres the view on click/drag.
+class MiniMap : public QWidget {
+    Q_OBJECT
+public:
+    explicit MiniMap(GraphView* view, QWidget* parent = nullptr);
+
+    QSize sizeHint() const override { return QSize(240, 170); }
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseMoveEvent(QMouseEvent* e) override;
+
+private:
+    QTransform sceneToWidget() const;
+    void navigateTo(const QPoint& pos);
+
+    GraphView* m_view = nullptr;
+};
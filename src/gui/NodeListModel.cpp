@@ -0,0 +1,106 @@
+﻿#include "NodeListModel.h"
+
+#include <QColor>
+
+#include "model/GraphModel.h"
+#include "util/MemoryReport.h"
+
+NodeListModel::NodeListModel(const GraphModel* graph, QObject* parent)
+    : QAbstractListModel(parent), m_graph(graph)
+{
+    reload();
+}
+
+int NodeListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant NodeListModel::data(const QModelIndex& index, int role) const
+{
+    const Node* n = m_graph->nodeById(nodeAt(index.row()));
+    if (!n)
+        return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString line = n->name;
+        if (!n->version.isEmpty())
+            line += "  " + n->version;
+        if (!n->kind.isEmpty())
+            line += "  (" + n->kind + ")";
+        return line;
+    }
+    case Qt::ForegroundRole:
+        if (n->status == NodeStatus::Outdated)
+            return QColor(245, 200, 80);
+        if (n->status == NodeStatus::Deprecated)
+            return QColor(255, 110, 110);
+        if (n->status == NodeStatus::Conflict)
+            return QColor(255, 80, 160);
+        if (n->status == NodeStatus::Vulnerable)
+            return QColor(170, 110, 255);
+        return QVariant();
+    case NodeIdRole:
+        return n->id;
+    default:
+        return QVariant();
+    }
+}
+
+int NodeListModel::nodeAt(int row) const
+{
+    return (row >= 0 && row < m_rows.size()) ? m_rows[row] : -1;
+}
+
+int NodeListModel::rowOfNode(int nodeId) const
+{
+    return (nodeId >= 0 && nodeId < m_rowOfNode.size()) ? m_rowOfNode[nodeId] : -1;
+}
+
+void NodeListModel::setFilter(const QString& needle)
+{
+    const QString next = needle.trimmed();
+    if (next == m_filter)
+        return;
+
+    m_filter = next;
+    reload();
+}
+
+void NodeListModel::reload()
+{
+    const int n = m_graph->nodes().size();
+    QVector<int> rows;
+    if (m_filter.isEmpty()) {
+        rows.resize(n);
+        for (int id = 0; id < n; id++)
+            rows[id] = id;
+    } else {
+        rows = m_graph->search(m_filter);
+    }
+
+    m_rowOfNode.fill(-1, n);
+    setRows(std::move(rows));
+}
+
+void NodeListModel::setRows(QVector<int> rows)
+{
+    // Only the ids that were or are listed need their row index touched.
+    for (int id : m_rows) {
+        if (id < m_rowOfNode.size())
+            m_rowOfNode[id] = -1;
+    }
+
+    beginResetModel();
+    m_rows = std::move(rows);
+    endResetModel();
+
+    for (int row = 0; row < m_rows.size(); row++)
+        m_rowOfNode[m_rows[row]] = row;
+}
+
+qint64 NodeListModel::memoryBytes() const
+{
+    return MemoryReport::bytesOf(m_rows) + MemoryReport::bytesOf(m_rowOfNode) + MemoryReport::bytesOf(m_filter);
+}
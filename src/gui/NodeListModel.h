@@ -0,0 +1,48 @@
+﻿#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+
+class GraphModel;
+
+// Rows are node ids that pass the filter; everything shown is computed in
+// data() on demand, so only the rows on screen ever cost anything.
+// Filtering goes through the graph's trigram index (GraphModel::search), so
+// rows are ranked best match first rather than in node order.
+class NodeListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Role {
+        NodeIdRole = Qt::UserRole
+    };
+
+    explicit NodeListModel(const GraphModel* graph, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    // Text, glob or /regex/ over name, version and kind; see TrigramIndex.
+    void setFilter(const QString& needle);
+    QString filter() const { return m_filter; }
+
+    int nodeAt(int row) const;
+    // -1 when the node is filtered out.
+    int rowOfNode(int nodeId) const;
+
+    // Estimated heap bytes of the row mappings; rows themselves are computed
+    // on demand and cost nothing.
+    qint64 memoryBytes() const;
+
+public slots:
+    // Graph contents changed: rescan with the current filter.
+    void reload();
+
+private:
+    void setRows(QVector<int> rows);
+
+    const GraphModel* m_graph = nullptr;
+    QString m_filter;
+    QVector<int> m_rows;      // row -> node id
+    QVector<int> m_rowOfNode; // node id -> row, or -1
+};
@@ -0,0 +1,83 @@
+﻿#include "RenderStats.h"
+
+#include <algorithm>
+
+// Nearest-rank percentile of sorted values.
+static double percentile(const QVector<double>& sorted, int pct)
+{
+    if (sorted.isEmpty())
+        return 0;
+    const int rank = qBound(0, int((pct * qint64(sorted.size()) + 99) / 100) - 1, int(sorted.size()) - 1);
+    return sorted[rank];
+}
+
+void RenderStats::clearFrames()
+{
+    m_ring.clear();
+    m_next = 0;
+    m_current = Frame();
+}
+
+void RenderStats::beginFrame(qint64 exposedPixels, bool tiles)
+{
+    m_current = Frame();
+    m_current.exposedPixels = exposedPixels;
+    m_current.tiles = tiles;
+}
+
+void RenderStats::endFrame(qint64 frameNs)
+{
+    m_current.frameNs = frameNs;
+    if (m_ring.size() < kHistory) {
+        m_ring.push_back(m_current);
+    } else {
+        m_ring[m_next] = m_current;
+    }
+    m_next = (m_next + 1) % kHistory;
+}
+
+QVector<RenderStats::Frame> RenderStats::frames() const
+{
+    if (m_ring.size() < kHistory)
+        return m_ring;
+    QVector<Frame> out;
+    out.reserve(kHistory);
+    for (int i = 0; i < kHistory; i++)
+        out.push_back(m_ring[(m_next + i) % kHistory]);
+    return out;
+}
+
+RenderStats::Summary RenderStats::summary() const
+{
+    Summary s;
+    s.lastRebuildMs = m_lastRebuildNs < 0 ? -1 : m_lastRebuildNs / 1e6;
+    s.lastLayoutMs = m_lastLayoutNs < 0 ? -1 : m_lastLayoutNs / 1e6;
+    s.frames = m_ring.size();
+    if (m_ring.isEmpty())
+        return s;
+
+    QVector<double> ms;
+    ms.reserve(m_ring.size());
+    for (const Frame& f : m_ring) {
+        ms.push_back(f.frameNs / 1e6);
+        s.avgNodesPainted += f.nodesPainted;
+        s.avgEdgesPainted += f.edgesPainted;
+        s.avgNodePaintMs += f.nodePaintNs / 1e6;
+        s.avgEdgePaintMs += f.edgePaintNs / 1e6;
+        s.avgExposedPixels += f.exposedPixels;
+    }
+    std::sort(ms.begin(), ms.end());
+
+    s.p50Ms = percentile(ms, 50);
+    s.p95Ms = percentile(ms, 95);
+    s.p99Ms = percentile(ms, 99);
+    s.maxMs = ms.last();
+
+    const double n = m_ring.size();
+    s.avgNodesPainted /= n;
+    s.avgEdgesPainted /= n;
+    s.avgNodePaintMs /= n;
+    s.avgEdgePaintMs /= n;
+    s.avgExposedPixels /= n;
+    return s;
+}
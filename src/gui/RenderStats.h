@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include <QVector>
+#include <QtGlobal>
+
+// Frame timings and paint counters for GraphView: what the render HUD shows,
+// and what benchmarks read to check frame-time budgets.
+//
+// Collection is off until enabled. When it is off, items skip their paint
+// timers and the view does not time frames.
+class RenderStats {
+public:
+    struct Frame {
+        qint64 frameNs = 0;
+        qint64 nodePaintNs = 0; // summed over NodeItem::paint calls
+        qint64 edgePaintNs = 0; // EdgeLayer::paint
+        int nodesPainted = 0;
+        int edgesPainted = 0;
+        qint64 exposedPixels = 0;
+        bool tiles = false; // composited from overview tiles
+    };
+
+    struct Summary {
+        int frames = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+        double avgNodesPainted = 0;
+        double avgEdgesPainted = 0;
+        double avgNodePaintMs = 0;
+        double avgEdgePaintMs = 0;
+        double avgExposedPixels = 0;
+        double lastRebuildMs = -1; // -1 until measured
+        double lastLayoutMs = -1;
+    };
+
+    // Frames kept for percentiles; older ones are overwritten.
+    static constexpr int kHistory = 240;
+
+    void setEnabled(bool on) { m_enabled = on; }
+    bool isEnabled() const { return m_enabled; }
+    // Forgets frames, not the last rebuild/layout times.
+    void clearFrames();
+
+    void beginFrame(qint64 exposedPixels, bool tiles);
+    void endFrame(qint64 frameNs);
+    void addNodePaint(qint64 ns)
+    {
+        m_current.nodePaintNs += ns;
+        m_current.nodesPainted++;
+    }
+    void addEdgePaint(qint64 ns, int edges)
+    {
+        m_current.edgePaintNs += ns;
+        m_current.edgesPainted += edges;
+    }
+
+    // Timed whether or not frame collection is on; they are rare.
+    void recordRebuild(qint64 ns) { m_lastRebuildNs = ns; }
+    void recordLayout(qint64 ns) { m_lastLayoutNs = ns; }
+
+    // Over the retained frames (at most kHistory), oldest first.
+    QVector<Frame> frames() const;
+    Summary summary() const;
+
+private:
+    bool m_enabled = false;
+    Frame m_current;
+    QVector<Frame> m_ring;
+    int m_next = 0; // ring slot the next frame goes into
+    qint64 m_lastRebuildNs = -1;
+    qint64 m_lastLayoutNs = -1;
+};
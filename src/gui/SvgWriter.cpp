@@ -0,0 +1,333 @@
+﻿#include "SvgWriter.h"
+
+#include <QIODevice>
+#include <QtMath>
+
+#include "gui/GraphStyle.h"
+#include "model/GraphModel.h"
+#include "model/ReachabilityIndex.h"
+#include "util/Trace.h"
+
+// Output is handed to the device in pieces of about this size.
+static constexpr int kWriteChunk = 64 * 1024;
+// A compound path is closed and a new one started past this many bytes of
+// path data, so no single element (or buffer) grows with the graph.
+static constexpr int kPathChunk = 256 * 1024;
+
+static const NodeStatus kStatuses[] = {
+    NodeStatus::Stable,
+    NodeStatus::Outdated,
+    NodeStatus::Deprecated,
+    NodeStatus::Conflict,
+    NodeStatus::Vulnerable,
+};
+
+// One decimal is finer than anything visible at the card scale.
+static void appendNumber(QByteArray* out, qreal v)
+{
+    const qint64 tenths = qRound64(v * 10);
+    if (tenths % 10 == 0)
+        out->append(QByteArray::number(tenths / 10));
+    else
+        out->append(QByteArray::number(tenths / 10.0, 'f', 1));
+}
+
+static void appendPoint(QByteArray* out, const QPointF& p)
+{
+    appendNumber(out, p.x());
+    out->append(' ');
+    appendNumber(out, p.y());
+}
+
+static QByteArray cssColor(const QColor& c)
+{
+    if (c.alpha() == 255)
+        return c.name().toLatin1();
+    return QString("rgba(%1,%2,%3,%4)")
+        .arg(c.red())
+        .arg(c.green())
+        .arg(c.blue())
+        .arg(c.alphaF(), 0, 'g', 2)
+        .toLatin1();
+}
+
+static QByteArray escaped(const QString& text)
+{
+    return text.toHtmlEscaped().toUtf8();
+}
+
+SvgWriter::SvgWriter(QIODevice* out)
+    : m_out(out)
+{
+}
+
+void SvgWriter::write(const QByteArray& bytes)
+{
+    m_buf.append(bytes);
+    if (m_buf.size() < kWriteChunk || !m_error.isEmpty())
+        return;
+    if (m_out->write(m_buf) != m_buf.size())
+        m_error = m_out->errorString();
+    m_buf.clear();
+}
+
+void SvgWriter::begin(const QRectF& bounds)
+{
+    QByteArray head = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\"";
+    head += " width=\"" + QByteArray::number(qCeil(bounds.width())) + "\"";
+    head += " height=\"" + QByteArray::number(qCeil(bounds.height())) + "\"";
+    head += " viewBox=\"";
+    appendNumber(&head, bounds.x());
+    head += ' ';
+    appendNumber(&head, bounds.y());
+    head += ' ';
+    appendNumber(&head, bounds.width());
+    head += ' ';
+    appendNumber(&head, bounds.height());
+    head += "\">\n";
+    write(head);
+    writeStyle();
+
+    QByteArray bg = "<rect class=\"bg\" x=\"";
+    appendNumber(&bg, bounds.x());
+    bg += "\" y=\"";
+    appendNumber(&bg, bounds.y());
+    bg += "\" width=\"";
+    appendNumber(&bg, bounds.width());
+    bg += "\" height=\"";
+    appendNumber(&bg, bounds.height());
+    bg += "\"/>\n";
+    write(bg);
+}
+
+void SvgWriter::writeStyle()
+{
+    using namespace GraphStyle;
+
+    // Card shapes, centred on the origin: the card, the inner border of a
+    // collapsed cluster and the dashed ring of a cycle member.
+    const QByteArray w = QByteArray::number(kCardWidth);
+    const QByteArray h = QByteArray::number(kCardHeight);
+    QByteArray defs = "<defs>\n";
+    defs += "<rect id=\"c\" x=\"" + QByteArray::number(-kCardWidth / 2) + "\" y=\"" +
+            QByteArray::number(-kCardHeight / 2) + "\" width=\"" + w + "\" height=\"" + h + "\" rx=\"16\"/>\n";
+    defs += "<rect id=\"ci\" x=\"" + QByteArray::number(-kCardWidth / 2 + 4) + "\" y=\"" +
+            QByteArray::number(-kCardHeight / 2 + 4) + "\" width=\"" + QByteArray::number(kCardWidth - 8) +
+            "\" height=\"" + QByteArray::number(kCardHeight - 8) + "\" rx=\"12\" fill=\"none\"/>\n";
+    defs += "<rect id=\"cc\" x=\"" + QByteArray::number(-kCardWidth / 2 + 1) + "\" y=\"" +
+            QByteArray::number(-kCardHeight / 2 + 1) + "\" width=\"" + QByteArray::number(kCardWidth - 2) +
+            "\" height=\"" + QByteArray::number(kCardHeight - 2) + "\" rx=\"15\" fill=\"none\" stroke=\"" +
+            cssColor(QColor(255, 80, 160, 220)) + "\" stroke-width=\"2\" stroke-dasharray=\"6 4\"/>\n";
+
+    // One gradient per status, as on the cards in the view.
+    QByteArray css = ".bg{fill:#080c12}\n"
+                     ".n{stroke:" + cssColor(QColor(170, 210, 255, 60)) + ";stroke-width:1.4}\n";
+    for (NodeStatus s : kStatuses) {
+        QColor fill = statusColor(s);
+        fill.setAlpha(210);
+        const QByteArray id = "g" + QByteArray::number(int(s));
+        defs += "<linearGradient id=\"" + id + "\" x1=\"0\" y1=\"0\" x2=\"1\" y2=\"1\">";
+        defs += "<stop offset=\"0\" stop-color=\"" + fill.lighter(120).name().toLatin1() + "\" stop-opacity=\"" +
+                QByteArray::number(fill.alphaF(), 'g', 2) + "\"/>";
+        defs += "<stop offset=\"1\" stop-color=\"" + fill.darker(130).name().toLatin1() + "\" stop-opacity=\"" +
+                QByteArray::number(fill.alphaF(), 'g', 2) + "\"/>";
+        defs += "</linearGradient>\n";
+        css += ".s" + QByteArray::number(int(s)) + "{fill:url(#" + id + ")}\n";
+    }
+    defs += "</defs>\n";
+
+    // Later rules win, in the order the view picks a card's outline.
+    css += ".n.cy{stroke:" + cssColor(QColor(255, 80, 160, 200)) + "}\n";
+    css += ".n.chg{stroke:" + cssColor(diffColor(GraphDiff::Change::Changed, 230)) + ";stroke-width:2.5}\n";
+    css += ".n.add{stroke:" + cssColor(diffColor(GraphDiff::Change::Added, 230)) + ";stroke-width:2.5}\n";
+    css += ".n.rem{stroke:" + cssColor(diffColor(GraphDiff::Change::Removed, 230)) +
+           ";stroke-width:2.5;stroke-dasharray:6 4;opacity:.55}\n";
+    css += ".n.hl{stroke:" + cssColor(QColor(255, 245, 170, 200)) + ";stroke-width:2.5}\n";
+    css += "text{stroke:none;font-family:sans-serif}\n";
+    css += ".t{fill:" + cssColor(QColor(230, 240, 255, 235)) + ";font-size:13px;font-weight:bold}\n";
+    css += ".v{fill:" + cssColor(QColor(205, 220, 240, 200)) + ";font-size:11px}\n";
+    css += ".wc{fill:" + cssColor(QColor(205, 220, 240, 200)) + ";font-size:11px;text-anchor:middle}\n";
+    css += ".e{fill:none}\n";
+    for (int s = 0; s < kStyles; s++) {
+        css += ".e" + QByteArray::number(s) + "{stroke:" + cssColor(edgeColor(s)) + "}\n";
+        css += ".a" + QByteArray::number(s) + "{fill:" + cssColor(arrowColor(s)) + "}\n";
+    }
+    css += ".e" + QByteArray::number(int(RemovedEdge)) + "{stroke-dasharray:6 4}\n";
+
+    write(defs);
+    write("<style>\n" + css + "</style>\n");
+}
+
+void SvgWriter::addEdge(const QPointF& from, const QPointF& to, int weight, quint8 flags)
+{
+    using namespace GraphStyle;
+
+    int style = PlainEdge;
+    if (flags & Highlighted)
+        style = HighlightedEdge;
+    else if (flags & Removed)
+        style = RemovedEdge;
+    else if (flags & Added)
+        style = AddedEdge;
+    else if (flags & Changed)
+        style = ChangedEdge;
+
+    const EdgeGeometry g = EdgeGeometry::between(from, to);
+    QByteArray& curve = m_curves[style][weightBucket(weight)];
+    curve += 'M';
+    appendPoint(&curve, g.p1);
+    curve += 'Q';
+    appendPoint(&curve, g.ctrl);
+    curve += ' ';
+    appendPoint(&curve, g.p2);
+
+    QByteArray& arrow = m_arrows[style];
+    arrow += 'M';
+    appendPoint(&arrow, g.arrow[0]);
+    arrow += 'L';
+    appendPoint(&arrow, g.arrow[1]);
+    arrow += ' ';
+    appendPoint(&arrow, g.arrow[2]);
+    arrow += 'Z';
+
+    if (weight > 1) {
+        const QPointF mid = g.midpoint();
+        m_counts += "<text class=\"wc\" x=\"";
+        appendNumber(&m_counts, mid.x());
+        m_counts += "\" y=\"";
+        appendNumber(&m_counts, mid.y() - 6);
+        m_counts += "\">" + QByteArray::number(weight) + "</text>\n";
+    }
+
+    if (curve.size() > kPathChunk || arrow.size() > kPathChunk || m_counts.size() > kPathChunk)
+        flushEdgeBuffers();
+}
+
+void SvgWriter::flushBuffer(QByteArray* buffer, const char* open)
+{
+    if (buffer->isEmpty())
+        return;
+    write(QByteArray(open) + *buffer + "\"/>\n");
+    buffer->clear();
+}
+
+void SvgWriter::flushEdgeBuffers()
+{
+    // Everything buffered goes out together, in paint order: curves, then
+    // arrowheads, then the counts on aggregated edges.
+    for (int s = 0; s < kStyles; s++) {
+        for (int b = 0; b < kWeightBuckets; b++) {
+            const QByteArray open = "<path class=\"e e" + QByteArray::number(s) + "\" stroke-width=\"" +
+                                    QByteArray::number(GraphStyle::edgeWidth(s, b)) + "\" d=\"";
+            flushBuffer(&m_curves[s][b], open.constData());
+        }
+    }
+    for (int s = 0; s < kStyles; s++) {
+        const QByteArray open = "<path class=\"a" + QByteArray::number(s) + "\" d=\"";
+        flushBuffer(&m_arrows[s], open.constData());
+    }
+    write(m_counts);
+    m_counts.clear();
+}
+
+void SvgWriter::addNode(const QPointF& centre, const QString& title, const QString& subtitle, NodeStatus status,
+                        quint8 flags)
+{
+    if (!m_edgesDone) {
+        flushEdgeBuffers();
+        m_edgesDone = true;
+    }
+
+    QByteArray g = "<g class=\"n s" + QByteArray::number(int(status));
+    if (flags & Cycle)
+        g += " cy";
+    if (flags & Changed)
+        g += " chg";
+    if (flags & Added)
+        g += " add";
+    if (flags & Removed)
+        g += " rem";
+    if (flags & Highlighted)
+        g += " hl";
+    g += "\" transform=\"translate(";
+    appendNumber(&g, centre.x());
+    g += ',';
+    appendNumber(&g, centre.y());
+    g += ")\"><use xlink:href=\"#c\"/>";
+    if (flags & Cluster)
+        g += "<use xlink:href=\"#ci\"/>";
+    if (flags & Cycle)
+        g += "<use xlink:href=\"#cc\"/>";
+
+    // Baselines of the two label lines as laid out on the card.
+    const QByteArray x = QByteArray::number(-GraphStyle::kCardWidth / 2 + 12);
+    g += "<text class=\"t\" x=\"" + x + "\" y=\"-9\">" + escaped(title) + "</text>";
+    g += "<text class=\"v\" x=\"" + x + "\" y=\"19\">" + escaped(subtitle) + "</text></g>\n";
+    write(g);
+}
+
+bool SvgWriter::finish(QString* err)
+{
+    flushEdgeBuffers();
+    write("</svg>\n");
+    if (m_error.isEmpty() && !m_buf.isEmpty() && m_out->write(m_buf) != m_buf.size())
+        m_error = m_out->errorString();
+    m_buf.clear();
+
+    if (!m_error.isEmpty()) {
+        if (err)
+            *err = m_error;
+        return false;
+    }
+    return true;
+}
+
+QString SvgWriter::elide(const QString& text, int maxChars)
+{
+    if (text.size() <= maxChars)
+        return text;
+    return text.left(qMax(0, maxChars - 1)) + QChar(0x2026);
+}
+
+bool SvgWriter::writeGraph(QIODevice* out, const GraphModel& graph, const QVector<QPointF>& positions, QString* err)
+{
+    // Character budgets that fit the card at the default label sizes.
+    static constexpr int kTitleChars = 24;
+    static constexpr int kSubtitleChars = 30;
+
+    Trace::Span span("export.svg");
+    const QVector<Node>& nodes = graph.nodes();
+    auto placed = [&](int id) { return id >= 0 && id < positions.size() && !qIsNaN(positions[id].x()); };
+
+    QRectF bounds;
+    for (const Node& n : nodes) {
+        if (placed(n.id))
+            bounds |= QRectF(positions[n.id] - QPointF(GraphStyle::kCardWidth / 2, GraphStyle::kCardHeight / 2),
+                             QSizeF(GraphStyle::kCardWidth, GraphStyle::kCardHeight));
+    }
+    if (bounds.isNull()) {
+        if (err)
+            *err = "Nothing to export: the graph is empty.";
+        return false;
+    }
+
+    SvgWriter w(out);
+    w.begin(bounds.adjusted(-40, -40, 40, 40));
+    for (const Edge& e : graph.edges()) {
+        if (placed(e.from) && placed(e.to))
+            w.addEdge(positions[e.from], positions[e.to]);
+    }
+
+    const auto reach = graph.reachability();
+    const Condensation& scc = reach->condensation();
+    for (const Node& n : nodes) {
+        if (!placed(n.id))
+            continue;
+        const QString sub = n.version.isEmpty() ? QString("(%1)").arg(n.kind) : QString("%1  (%2)").arg(n.version, n.kind);
+        const bool cyclic = n.id < reach->nodeCount() && scc.isCyclic(scc.componentOf(n.id));
+        w.addNode(positions[n.id], elide(n.name, kTitleChars), elide(sub, kSubtitleChars), n.status,
+                  cyclic ? Cycle : 0);
+    }
+    return w.finish(err);
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+#include "gui/GraphStyle.h"
+#include "model/Node.h"
+
+class GraphModel;
+class QIODevice;
+
+// Writes a drawing of the graph as SVG straight to a device, without a scene.
+//
+// Styling lives in one <style> block and shared <defs>: a card is a <use> of
+// one rounded rect inside a group whose classes give the status gradient and
+// overlays (cycle, cluster, highlight, diff). Edges are not one element each
+// but appended to a compound path per style and width, arrowheads to one per
+// style. Output is buffered in small chunks and long compound paths are split,
+// so memory stays flat however large the graph.
+//
+//   SvgWriter w(&file);
+//   w.begin(bounds);
+//   w.addEdge(...);  // all edges first, so cards are drawn on top
+//   w.addNode(...);
+//   w.finish(&err);
+class SvgWriter {
+public:
+    enum Flag : quint8 {
+        Cycle = 0x1,
+        Cluster = 0x2, // a collapsed cluster (drawn with a double border)
+        Highlighted = 0x4,
+        Added = 0x8,
+        Removed = 0x10,
+        Changed = 0x20
+    };
+
+    explicit SvgWriter(QIODevice* out);
+
+    // `bounds` is the drawn area in scene units; it becomes the viewBox.
+    void begin(const QRectF& bounds);
+    // Endpoints are card centres. `weight` > 1 marks an aggregated edge.
+    void addEdge(const QPointF& from, const QPointF& to, int weight = 1, quint8 flags = 0);
+    // Labels are written as given; callers elide them to the card width.
+    void addNode(const QPointF& centre, const QString& title, const QString& subtitle, NodeStatus status,
+                 quint8 flags = 0);
+    bool finish(QString* err);
+
+    // The whole model with one position per node id (LayeredLayout::compute()
+    // or the scene's), cycle members flagged. Nodes without a position are
+    // skipped along with their edges.
+    static bool writeGraph(QIODevice* out, const GraphModel& graph, const QVector<QPointF>& positions, QString* err);
+
+    // Shortens `text` to `maxChars` characters with an ellipsis; for callers
+    // without font metrics.
+    static QString elide(const QString& text, int maxChars);
+
+private:
+    static constexpr int kStyles = GraphStyle::kEdgeStyles;
+    static constexpr int kWeightBuckets = GraphStyle::kWeightBuckets;
+
+    void flushEdgeBuffers();
+    void flushBuffer(QByteArray* buffer, const char* open);
+    void write(const QByteArray& bytes);
+    void writeStyle();
+
+    QIODevice* m_out = nullptr;
+    QByteArray m_buf;
+    QString m_error;
+    bool m_edgesDone = false;
+    QByteArray m_curves[kStyles][kWeightBuckets];
+    QByteArray m_arrows[kStyles];
+    QByteArray m_counts;
+};
@@ -0,0 +1,304 @@
+﻿#include "TileCache.h"
+
+#include <QPainter>
+#include <QThread>
+
+#include <algorithm>
+#include <cmath>
+
+#include "util/MemoryReport.h"
+
+static int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+qint64 TileScene::memoryBytes() const
+{
+    return MemoryReport::bytesOf(nodePos) + MemoryReport::bytesOf(nodeColor) + MemoryReport::bytesOf(edges) +
+           MemoryReport::bytesOf(edgeHighlighted) + MemoryReport::bytesOf(m_nodeOffsets) +
+           MemoryReport::bytesOf(m_nodeItems) + MemoryReport::bytesOf(m_edgeOffsets) +
+           MemoryReport::bytesOf(m_edgeItems) + MemoryReport::bytesOf(m_longEdges);
+}
+
+void TileScene::finalize()
+{
+    bounds = QRectF();
+    for (const QPointF& p : nodePos)
+        bounds |= QRectF(p.x() - nodeRadius, p.y() - nodeRadius, 2 * nodeRadius, 2 * nodeRadius);
+
+    // ~256 cells along the longer side is plenty for tile-sized queries.
+    m_origin = bounds.topLeft();
+    m_cell = qMax<qreal>(64.0, qMax(bounds.width(), bounds.height()) / 256.0);
+    m_cols = qMax(1, int(std::ceil(bounds.width() / m_cell)));
+    m_rows = qMax(1, int(std::ceil(bounds.height() / m_cell)));
+    const int cells = m_cols * m_rows;
+
+    // Nodes: one cell each (by centre). Two-pass CSR fill.
+    m_nodeOffsets.fill(0, cells + 1);
+    QVector<int> nodeCell(nodePos.size());
+    for (int i = 0; i < nodePos.size(); i++) {
+        const QRect s = cellSpan(QRectF(nodePos[i], QSizeF(0, 0)));
+        nodeCell[i] = s.top() * m_cols + s.left();
+        m_nodeOffsets[nodeCell[i] + 1]++;
+    }
+    for (int c = 0; c < cells; c++)
+        m_nodeOffsets[c + 1] += m_nodeOffsets[c];
+    m_nodeItems.resize(nodePos.size());
+    {
+        QVector<int> fill = m_nodeOffsets;
+        for (int i = 0; i < nodePos.size(); i++)
+            m_nodeItems[fill[nodeCell[i]]++] = i;
+    }
+
+    // Edges: every cell their bounding box touches, unless that is too many.
+    const int kMaxCellsPerEdge = 64;
+    QVector<QRect> spans(edges.size());
+    m_edgeOffsets.fill(0, cells + 1);
+    m_longEdges.clear();
+    for (int i = 0; i < edges.size(); i++) {
+        spans[i] = cellSpan(QRectF(edges[i].p1(), edges[i].p2()).normalized());
+        if (spans[i].width() * spans[i].height() > kMaxCellsPerEdge) {
+            m_longEdges.push_back(i);
+            spans[i] = QRect();
+            continue;
+        }
+        for (int y = spans[i].top(); y <= spans[i].bottom(); y++)
+            for (int x = spans[i].left(); x <= spans[i].right(); x++)
+                m_edgeOffsets[y * m_cols + x + 1]++;
+    }
+    for (int c = 0; c < cells; c++)
+        m_edgeOffsets[c + 1] += m_edgeOffsets[c];
+    m_edgeItems.resize(m_edgeOffsets.last());
+    {
+        QVector<int> fill = m_edgeOffsets;
+        for (int i = 0; i < edges.size(); i++) {
+            if (spans[i].isNull())
+                continue;
+            for (int y = spans[i].top(); y <= spans[i].bottom(); y++)
+                for (int x = spans[i].left(); x <= spans[i].right(); x++)
+                    m_edgeItems[fill[y * m_cols + x]++] = i;
+        }
+    }
+}
+
+QRect TileScene::cellSpan(const QRectF& r) const
+{
+    const int x0 = qBound(0, int((r.left() - m_origin.x()) / m_cell), m_cols - 1);
+    const int x1 = qBound(0, int((r.right() - m_origin.x()) / m_cell), m_cols - 1);
+    const int y0 = qBound(0, int((r.top() - m_origin.y()) / m_cell), m_rows - 1);
+    const int y1 = qBound(0, int((r.bottom() - m_origin.y()) / m_cell), m_rows - 1);
+    return QRect(QPoint(x0, y0), QPoint(x1, y1));
+}
+
+QVector<int> TileScene::nodesIn(const QRectF& r) const
+{
+    QVector<int> out;
+    if (m_nodeOffsets.isEmpty())
+        return out;
+    const QRect span = cellSpan(r.adjusted(-nodeRadius, -nodeRadius, nodeRadius, nodeRadius));
+    for (int y = span.top(); y <= span.bottom(); y++) {
+        for (int x = span.left(); x <= span.right(); x++) {
+            const int c = y * m_cols + x;
+            for (int k = m_nodeOffsets[c]; k < m_nodeOffsets[c + 1]; k++)
+                out.push_back(m_nodeItems[k]);
+        }
+    }
+    return out;
+}
+
+QVector<int> TileScene::edgesIn(const QRectF& r) const
+{
+    QVector<int> out;
+    if (m_edgeOffsets.isEmpty())
+        return out;
+    const QRect span = cellSpan(r);
+    for (int y = span.top(); y <= span.bottom(); y++) {
+        for (int x = span.left(); x <= span.right(); x++) {
+            const int c = y * m_cols + x;
+            for (int k = m_edgeOffsets[c]; k < m_edgeOffsets[c + 1]; k++)
+                out.push_back(m_edgeItems[k]);
+        }
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+
+    for (int i : m_longEdges) {
+        if (QRectF(edges[i].p1(), edges[i].p2()).normalized().intersects(r))
+            out.push_back(i);
+    }
+    return out;
+}
+
+TileCache::TileCache(QObject* parent) : QObject(parent)
+{
+    m_tiles.setMaxCost(256 * 1024); // KiB
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+TileCache::~TileCache()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void TileCache::setScene(std::shared_ptr<const TileScene> scene)
+{
+    m_scene = std::move(scene);
+}
+
+void TileCache::invalidate(const QRectF& sceneRect)
+{
+    if (sceneRect.isEmpty())
+        return;
+
+    const QList<TileKey> keys = m_tiles.keys();
+    for (const TileKey& k : keys) {
+        if (tileRect(k).intersects(sceneRect))
+            m_tiles.remove(k);
+    }
+    // Renders in flight over this area predate the change; the rest stay good.
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (tileRect(it.key()).intersects(sceneRect))
+            it.value() = false;
+    }
+    emit invalidated();
+}
+
+void TileCache::invalidateAll()
+{
+    m_tiles.clear();
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it)
+        it.value() = false;
+    emit invalidated();
+}
+
+qint64 TileCache::cachedBytes() const
+{
+    return qint64(m_tiles.totalCost()) * 1024;
+}
+
+int TileCache::levelForScale(qreal scale)
+{
+    // Finest level whose resolution is still >= the requested one, so tiles are
+    // only ever scaled down when composited.
+    if (scale >= 1.0)
+        return 0;
+    return qBound(0, int(std::floor(std::log2(1.0 / scale))), 30);
+}
+
+qreal TileCache::scaleForLevel(int level)
+{
+    return std::ldexp(1.0, -level);
+}
+
+QRectF TileCache::tileRect(const TileKey& key)
+{
+    const qreal span = kTileSize / scaleForLevel(key.level);
+    return QRectF(key.tx * span, key.ty * span, span, span);
+}
+
+void TileCache::draw(QPainter* p, const QRectF& sceneRect, qreal scale)
+{
+    if (!m_scene || m_scene->nodePos.isEmpty())
+        return;
+
+    const QRectF area = sceneRect & m_scene->bounds;
+    if (area.isEmpty())
+        return;
+
+    const int level = levelForScale(scale);
+    const qreal span = kTileSize / scaleForLevel(level);
+    const int x0 = int(std::floor(area.left() / span));
+    const int x1 = int(std::floor(area.right() / span));
+    const int y0 = int(std::floor(area.top() / span));
+    const int y1 = int(std::floor(area.bottom() / span));
+
+    for (int ty = y0; ty <= y1; ty++) {
+        for (int tx = x0; tx <= x1; tx++) {
+            const TileKey key{level, tx, ty};
+            if (const QImage* img = m_tiles.object(key)) {
+                p->drawImage(tileRect(key), *img);
+                continue;
+            }
+            request(key);
+            drawFallback(p, key);
+        }
+    }
+}
+
+bool TileCache::drawFallback(QPainter* p, const TileKey& key)
+{
+    const QRectF target = tileRect(key);
+    for (int up = 1; up <= 3; up++) {
+        const TileKey parent{key.level + up, floorDiv(key.tx, 1 << up), floorDiv(key.ty, 1 << up)};
+        const QImage* img = m_tiles.object(parent);
+        if (!img)
+            continue;
+
+        const QRectF parentRect = tileRect(parent);
+        const qreal s = scaleForLevel(parent.level);
+        const QRectF source((target.left() - parentRect.left()) * s,
+                            (target.top() - parentRect.top()) * s,
+                            target.width() * s,
+                            target.height() * s);
+        p->drawImage(target, *img, source);
+        return true;
+    }
+    return false;
+}
+
+void TileCache::request(const TileKey& key)
+{
+    // Keep the queue short so tiles for regions panned past are not rendered
+    // long after they stopped mattering; later repaints request the rest.
+    if (m_pending.contains(key) || m_pending.size() >= m_pool.maxThreadCount() * 2)
+        return;
+    m_pending.insert(key, true);
+
+    const std::shared_ptr<const TileScene> scene = m_scene;
+    const QRectF area = tileRect(key);
+    const qreal scale = scaleForLevel(key.level);
+
+    m_pool.start([this, key, scene, area, scale]() {
+        const QImage img = renderTile(*scene, area, scale);
+        QMetaObject::invokeMethod(this, [this, key, img, area]() {
+            if (m_pending.take(key))
+                m_tiles.insert(key, new QImage(img), int(qMax<qsizetype>(1, img.sizeInBytes() / 1024)));
+            // Stale renders are dropped; the repaint this triggers requests them again.
+            emit tileReady(area);
+        }, Qt::QueuedConnection);
+    });
+}
+
+QImage TileCache::renderTile(const TileScene& scene, const QRectF& area, qreal scale)
+{
+    QImage img(kTileSize, kTileSize, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+
+    QPainter p(&img);
+    p.scale(scale, scale);
+    p.translate(-area.topLeft());
+    p.setRenderHint(QPainter::Antialiasing, false);
+
+    QVector<QLineF> lines;
+    QVector<QLineF> highlighted;
+    for (int i : scene.edgesIn(area))
+        (scene.edgeHighlighted[i] ? highlighted : lines).push_back(scene.edges[i]);
+
+    // Width 0 = cosmetic one-pixel pen, whatever the tile scale.
+    p.setPen(QPen(QColor(120, 170, 255, 60), 0));
+    p.drawLines(lines);
+    if (!highlighted.isEmpty()) {
+        p.setPen(QPen(QColor(255, 235, 160, 150), 0));
+        p.drawLines(highlighted);
+    }
+
+    const qreal r = qMax(scene.nodeRadius, 1.0 / scale);
+    for (int i : scene.nodesIn(area)) {
+        const QPointF& c = scene.nodePos[i];
+        p.fillRect(QRectF(c.x() - r, c.y() - r, 2 * r, 2 * r), QColor::fromRgba(scene.nodeColor[i]));
+    }
+    p.end();
+    return img;
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QLineF>
+#include <QObject>
+#include <QRectF>
+#include <QThreadPool>
+#include <QVector>
+
+#include <memory>
+
+class QPainter;
+
+// Plain-data copy of what the overview needs (node dots and straight edges),
+// bucketed into a uniform grid. Immutable once finalized, so worker threads can
+// rasterise from it while the GUI keeps editing the real scene.
+struct TileScene {
+    QVector<QPointF> nodePos;
+    QVector<QRgb> nodeColor;
+    QVector<QLineF> edges;
+    QVector<quint8> edgeHighlighted;
+    qreal nodeRadius = 32.0;
+
+    QRectF bounds;
+
+    // Builds bounds and the grid; call once after filling the arrays.
+    void finalize();
+
+    QVector<int> nodesIn(const QRectF& r) const;
+    QVector<int> edgesIn(const QRectF& r) const;
+
+    // Estimated heap bytes of the arrays and the grid.
+    qint64 memoryBytes() const;
+
+private:
+    QRect cellSpan(const QRectF& r) const;
+
+    QPointF m_origin;
+    qreal m_cell = 1.0;
+    int m_cols = 0;
+    int m_rows = 0;
+    QVector<int> m_nodeOffsets;
+    QVector<int> m_nodeItems;
+    QVector<int> m_edgeOffsets;
+    QVector<int> m_edgeItems;
+    QVector<int> m_longEdges;
+};
+
+// Cache of rasterised overview tiles. Level L renders the scene at 2^-L device
+// pixels per scene unit into fixed-size tiles; tiles are rendered on a private
+// thread pool and handed back to the GUI thread when done.
+class TileCache : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kTileSize = 256;
+
+    explicit TileCache(QObject* parent = nullptr);
+    ~TileCache() override;
+
+    // Replaces the scene snapshot. Cached tiles are kept; call invalidate() or
+    // invalidateAll() for the regions that actually changed.
+    void setScene(std::shared_ptr<const TileScene> scene);
+    std::shared_ptr<const TileScene> scene() const { return m_scene; }
+
+    void invalidate(const QRectF& sceneRect);
+    void invalidateAll();
+
+    // Draws the tiles covering sceneRect. The painter is expected to map scene
+    // coordinates already; `scale` is its device pixels per scene unit.
+    // Missing tiles are scheduled and coarser cached tiles stand in meanwhile.
+    void draw(QPainter* p, const QRectF& sceneRect, qreal scale);
+
+    qint64 cachedBytes() const;
+
+signals:
+    void tileReady(const QRectF& sceneRect);
+    void invalidated();
+
+private:
+    struct TileKey {
+        int level = 0;
+        int tx = 0;
+        int ty = 0;
+        bool operator==(const TileKey& o) const { return level == o.level && tx == o.tx && ty == o.ty; }
+        friend size_t qHash(const TileKey& k, size_t seed = 0) { return qHashMulti(seed, k.level, k.tx, k.ty); }
+    };
+
+    static int levelForScale(qreal scale);
+    static qreal scaleForLevel(int level);
+    static QRectF tileRect(const TileKey& key);
+    static QImage renderTile(const TileScene& scene, const QRectF& area, qreal scale);
+
+    void request(const TileKey& key);
+    bool drawFallback(QPainter* p, const TileKey& key);
+
+    std::shared_ptr<const TileScene> m_scene;
+    QCache<TileKey, QImage> m_tiles; // cost in KiB
+    // Tiles being rendered; false once an invalidation overlapped them, so the
+    // result is dropped on arrival instead of cached.
+    QHash<TileKey, bool> m_pending;
+    QThreadPool m_pool;
+};
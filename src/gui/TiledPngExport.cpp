@@ -0,0 +1,174 @@
+﻿#include "TiledPngExport.h"
+
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <cmath>
+
+#include "util/Trace.h"
+
+TiledPngExport::TiledPngExport(QGraphicsScene* scene, const QRectF& sourceRect, const QColor& background,
+                               const Options& options, QObject* parent)
+    : QObject(parent), m_scene(scene), m_source(sourceRect), m_background(background), m_options(options)
+{
+    const qreal longest = qMax(sourceRect.width(), sourceRect.height());
+    if (longest > 0) {
+        m_scale = options.longestSide > 0 ? options.longestSide / longest : options.scale;
+        m_scale = qMin(m_scale, kMaxSide / longest);
+        m_size = QSize(qMax(1, int(std::ceil(sourceRect.width() * m_scale))),
+                       qMax(1, int(std::ceil(sourceRect.height() * m_scale))));
+        m_bandHeight = int(qBound<qint64>(1, kBandBytes / (qint64(m_size.width()) * 4), m_size.height()));
+    }
+
+    connect(&m_encoder, &QFutureWatcher<QString>::finished, this, &TiledPngExport::bandEncoded);
+}
+
+TiledPngExport::~TiledPngExport()
+{
+    // The worker uses m_writer and this object.
+    if (m_encoding)
+        m_encoder.waitForFinished();
+}
+
+int TiledPngExport::tileCount() const
+{
+    if (m_size.isEmpty())
+        return 0;
+    const int bands = (m_size.height() + m_bandHeight - 1) / m_bandHeight;
+    const int columns = (m_size.width() + kTileSize - 1) / kTileSize;
+    return bands * columns;
+}
+
+bool TiledPngExport::start(const QString& filePath, QString* err)
+{
+    if (m_size.isEmpty()) {
+        if (err)
+            *err = "Nothing to export: the graph is empty.";
+        return false;
+    }
+    if (!m_writer.open(filePath, m_size.width(), m_size.height(), m_options.dpi, err))
+        return false;
+
+    m_running = true;
+    scheduleRender();
+    return true;
+}
+
+void TiledPngExport::cancel()
+{
+    if (m_running)
+        stop(false, QString());
+}
+
+void TiledPngExport::scheduleRender()
+{
+    // One tile per event-loop turn, so input and repaints are handled between tiles.
+    if (m_renderScheduled || !m_running)
+        return;
+    m_renderScheduled = true;
+    QTimer::singleShot(0, this, [this]() {
+        m_renderScheduled = false;
+        renderTile();
+    });
+}
+
+void TiledPngExport::renderTile()
+{
+    if (!m_running || m_bandTop >= m_size.height())
+        return;
+    if (!m_scene) {
+        stop(false, "The graph was closed during the export.");
+        return;
+    }
+
+    if (m_band.isNull()) {
+        // Back-pressure: wait until the encoder has taken the queued band.
+        if (!m_queued.isNull())
+            return;
+        m_band = QImage(m_size.width(), qMin(m_bandHeight, m_size.height() - m_bandTop), QImage::Format_RGB32);
+        m_band.fill(m_background);
+    }
+
+    const int w = qMin(kTileSize, m_size.width() - m_tileX);
+    const int h = m_band.height();
+    {
+        Trace::Span span("export.renderTile");
+        const QRectF target(m_tileX, 0, w, h);
+        const QRectF source(m_source.left() + m_tileX / m_scale, m_source.top() + m_bandTop / m_scale,
+                            w / m_scale, h / m_scale);
+        QPainter p(&m_band);
+        p.setRenderHint(QPainter::Antialiasing, true);
+        p.setRenderHint(QPainter::TextAntialiasing, true);
+        m_scene->render(&p, target, source, Qt::IgnoreAspectRatio);
+    }
+    m_tileX += w;
+    emit progress(++m_tilesDone, tileCount());
+
+    if (m_tileX >= m_size.width()) {
+        m_queued = m_band;
+        m_band = QImage();
+        m_tileX = 0;
+        m_bandTop += h;
+        encodeNext();
+    }
+    if (m_bandTop < m_size.height() && (!m_band.isNull() || m_queued.isNull()))
+        scheduleRender();
+}
+
+void TiledPngExport::encodeNext()
+{
+    if (m_encoding || m_queued.isNull())
+        return;
+
+    const QImage band = m_queued;
+    m_queued = QImage();
+    m_rowsQueued += band.height();
+    const bool last = m_rowsQueued == m_size.height();
+    m_encoding = true;
+    m_encoder.setFuture(QtConcurrent::run([this, band, last]() -> QString {
+        QString err;
+        if (!m_writer.writeRows(band, &err))
+            return err;
+        if (last && !m_writer.finish(&err))
+            return err;
+        return QString();
+    }));
+
+    // The queue slot is free again.
+    if (m_band.isNull() && m_bandTop < m_size.height())
+        scheduleRender();
+}
+
+void TiledPngExport::bandEncoded()
+{
+    m_encoding = false;
+    if (!m_running)
+        return;
+
+    const QString err = m_encoder.result();
+    if (!err.isEmpty()) {
+        stop(false, err);
+        return;
+    }
+    if (m_writer.rowsWritten() == m_size.height()) {
+        stop(true, QString());
+        return;
+    }
+    encodeNext();
+}
+
+void TiledPngExport::stop(bool ok, const QString& error)
+{
+    if (m_encoding) {
+        m_encoder.waitForFinished();
+        m_encoding = false;
+    }
+    m_running = false;
+    m_band = QImage();
+    m_queued = QImage();
+    if (!ok)
+        m_writer.abort();
+    emit finished(ok, error);
+}
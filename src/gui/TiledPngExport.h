@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <QColor>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QPointer>
+#include <QRectF>
+#include <QSize>
+
+#include "util/PngStreamWriter.h"
+
+class QGraphicsScene;
+
+// Exports a scene region as PNG without ever holding the whole image.
+//
+// The output is produced in bands of rows, each rendered tile by tile and
+// then handed to a PngStreamWriter on a worker thread. Scene items belong to
+// the GUI thread, so tiles are rendered there, one per event-loop turn, which
+// keeps the window responsive; filtering and deflating, the bulk of the
+// work, run on the worker while the next band renders. At most three bands
+// are alive at once (rendering, queued, encoding), so memory stays bounded
+// whatever the output size.
+class TiledPngExport : public QObject {
+    Q_OBJECT
+public:
+    struct Options {
+        qreal scale = 2.0;   // output pixels per scene unit
+        int longestSide = 0; // > 0: scale so the longer side has this many pixels
+        int dpi = 0;         // > 0: recorded in the file (pHYs)
+    };
+
+    // Largest output side; larger requests are scaled down to fit.
+    static constexpr int kMaxSide = 1 << 17;
+    static constexpr int kTileSize = 1024;
+    // Upper bound for one band of rows.
+    static constexpr qint64 kBandBytes = 16 * 1024 * 1024;
+
+    TiledPngExport(QGraphicsScene* scene, const QRectF& sourceRect, const QColor& background,
+                   const Options& options, QObject* parent = nullptr);
+    ~TiledPngExport() override;
+
+    QSize outputSize() const { return m_size; }
+    int tileCount() const;
+
+    // Opens the file and starts rendering; progress and the outcome arrive
+    // through signals.
+    bool start(const QString& filePath, QString* err);
+    // Waits for the band being encoded, discards the partial file and emits
+    // finished(false, {}).
+    void cancel();
+
+signals:
+    void progress(int tilesDone, int tilesTotal);
+    // `error` is empty on success and on cancellation.
+    void finished(bool ok, const QString& error);
+
+private:
+    void scheduleRender();
+    void renderTile();
+    void encodeNext();
+    void bandEncoded();
+    void stop(bool ok, const QString& error);
+
+    QPointer<QGraphicsScene> m_scene;
+    QRectF m_source;
+    QColor m_background;
+    Options m_options;
+    QSize m_size;
+    qreal m_scale = 1.0;
+    int m_bandHeight = 1;
+
+    PngStreamWriter m_writer;
+    QFutureWatcher<QString> m_encoder;
+
+    QImage m_band;    // being rendered
+    QImage m_queued;  // rendered, waiting for the encoder
+    int m_bandTop = 0; // output row of m_band
+    int m_tileX = 0;   // next tile column in m_band
+    int m_rowsQueued = 0;
+    int m_tilesDone = 0;
+    bool m_running = false;
+    bool m_renderScheduled = false;
+    bool m_encoding = false;
+};
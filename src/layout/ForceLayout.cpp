@@ -0,0 +1,565 @@
+﻿#include "ForceLayout.h"
+
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// One level of the multilevel hierarchy: an undirected graph in CSR form.
+struct Level {
+    int n = 0;
+    QVector<int> offsets; // n + 1 entries
+    QVector<int> targets;
+    QVector<double> mass; // number of original nodes collapsed into each vertex
+    QVector<int> parent;  // vertex -> vertex of the next coarser level
+};
+
+quint64 pairKey(int a, int b)
+{
+    if (a > b)
+        std::swap(a, b);
+    return (quint64(quint32(a)) << 32) | quint32(b);
+}
+
+void buildAdjacency(Level* lvl, QVector<quint64> keys)
+{
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    lvl->offsets.fill(0, lvl->n + 1);
+    for (quint64 k : keys) {
+        lvl->offsets[int(k >> 32) + 1]++;
+        lvl->offsets[int(k & 0xffffffffu) + 1]++;
+    }
+    for (int i = 0; i < lvl->n; i++)
+        lvl->offsets[i + 1] += lvl->offsets[i];
+
+    lvl->targets.resize(lvl->offsets[lvl->n]);
+    QVector<int> fill = lvl->offsets;
+    for (quint64 k : keys) {
+        const int a = int(k >> 32);
+        const int b = int(k & 0xffffffffu);
+        lvl->targets[fill[a]++] = b;
+        lvl->targets[fill[b]++] = a;
+    }
+}
+
+// Matches every vertex with its lightest unmatched neighbour and collapses the
+// pairs into `coarse`. Returns false when the level would not shrink enough.
+bool coarsen(Level* fine, Level* coarse, QRandomGenerator& rng)
+{
+    const int n = fine->n;
+    QVector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    QVector<int> match(n, -1);
+    int lonely = -1;
+    for (int u : order) {
+        if (match[u] >= 0 || u == lonely)
+            continue;
+
+        int best = -1;
+        double bestMass = 0.0;
+        for (int k = fine->offsets[u]; k < fine->offsets[u + 1]; k++) {
+            const int v = fine->targets[k];
+            if (match[v] >= 0 || v == lonely)
+                continue;
+            if (best < 0 || fine->mass[v] < bestMass) {
+                best = v;
+                bestMass = fine->mass[v];
+            }
+        }
+        if (best >= 0) {
+            match[u] = best;
+            match[best] = u;
+            continue;
+        }
+
+        // Isolated vertices never match along edges; pair them with each other
+        // so graphs with many loose nodes still coarsen.
+        if (fine->offsets[u] == fine->offsets[u + 1]) {
+            if (lonely >= 0) {
+                match[u] = lonely;
+                match[lonely] = u;
+                lonely = -1;
+            } else {
+                lonely = u;
+            }
+            continue;
+        }
+        match[u] = u;
+    }
+    if (lonely >= 0)
+        match[lonely] = lonely;
+
+    fine->parent.fill(-1, n);
+    int c = 0;
+    for (int u = 0; u < n; u++) {
+        if (fine->parent[u] >= 0)
+            continue;
+        fine->parent[u] = c;
+        fine->parent[match[u]] = c;
+        c++;
+    }
+
+    if (c > n * 0.85) {
+        fine->parent.clear();
+        return false;
+    }
+
+    coarse->n = c;
+    coarse->mass.fill(0.0, c);
+    for (int u = 0; u < n; u++)
+        coarse->mass[fine->parent[u]] += fine->mass[u];
+
+    QVector<quint64> keys;
+    keys.reserve(fine->targets.size() / 2);
+    for (int u = 0; u < n; u++) {
+        for (int k = fine->offsets[u]; k < fine->offsets[u + 1]; k++) {
+            const int v = fine->targets[k];
+            if (u >= v)
+                continue;
+            const int a = fine->parent[u];
+            const int b = fine->parent[v];
+            if (a != b)
+                keys.push_back(pairKey(a, b));
+        }
+    }
+    buildAdjacency(coarse, std::move(keys));
+    return true;
+}
+
+// Barnes-Hut quadtree over flat position/mass arrays. Cells live in one vector;
+// the four children of a cell are stored consecutively.
+class QuadTree {
+public:
+    void build(const double* xs, const double* ys, const double* mass, int n)
+    {
+        m_xs = xs;
+        m_ys = ys;
+        m_mass = mass;
+        m_cells.clear();
+        m_leafOf.fill(-1, n);
+        if (n <= 0)
+            return;
+
+        double minX = xs[0], maxX = xs[0], minY = ys[0], maxY = ys[0];
+        for (int i = 1; i < n; i++) {
+            minX = std::min(minX, xs[i]);
+            maxX = std::max(maxX, xs[i]);
+            minY = std::min(minY, ys[i]);
+            maxY = std::max(maxY, ys[i]);
+        }
+
+        Cell root;
+        root.cx = 0.5 * (minX + maxX);
+        root.cy = 0.5 * (minY + maxY);
+        root.half = 0.5 * std::max(maxX - minX, maxY - minY) + 1.0;
+        m_cells.reserve(n * 2);
+        m_cells.push_back(root);
+
+        for (int i = 0; i < n; i++)
+            insert(0, i);
+
+        for (Cell& c : m_cells) {
+            if (c.mass > 0.0) {
+                c.comX /= c.mass;
+                c.comY /= c.mass;
+            }
+        }
+    }
+
+    // Accumulates the repulsive force acting on body i.
+    void repulsion(int i, double thetaSq, double strength, double* outFx, double* outFy) const
+    {
+        if (m_cells.isEmpty())
+            return;
+
+        const double x = m_xs[i];
+        const double y = m_ys[i];
+        const double mi = m_mass[i];
+        double fx = 0.0;
+        double fy = 0.0;
+
+        auto push = [&](double dx, double dy, double m) {
+            const double d2 = dx * dx + dy * dy;
+            // Coincident bodies have no direction to push in, and the force
+            // would blow up; the prolongation jitter and their edges part them.
+            if (d2 < kMinDistSq)
+                return;
+            const double s = strength * mi * m / d2;
+            fx += dx * s;
+            fy += dy * s;
+        };
+
+        int stack[kMaxStack];
+        int sp = 0;
+        stack[sp++] = 0;
+        while (sp > 0) {
+            const int ci = stack[--sp];
+            const Cell& c = m_cells[ci];
+            if (c.mass <= 0.0)
+                continue;
+
+            const double dx = x - c.comX;
+            const double dy = y - c.comY;
+
+            if (c.child < 0) {
+                if (ci != m_leafOf[i]) {
+                    push(dx, dy, c.mass);
+                    continue;
+                }
+                // The body's own leaf: only the others sharing it push.
+                const double m = c.mass - mi;
+                if (m <= 0.0)
+                    continue;
+                push(x - (c.comX * c.mass - x * mi) / m, y - (c.comY * c.mass - y * mi) / m, m);
+                continue;
+            }
+
+            const bool inside = std::abs(x - c.cx) <= c.half && std::abs(y - c.cy) <= c.half;
+            const double size = 2.0 * c.half;
+            if ((!inside && size * size < thetaSq * (dx * dx + dy * dy)) || sp + 4 > kMaxStack) {
+                push(dx, dy, c.mass);
+                continue;
+            }
+            for (int q = 0; q < 4; q++)
+                stack[sp++] = c.child + q;
+        }
+
+        *outFx += fx;
+        *outFy += fy;
+    }
+
+private:
+    struct Cell {
+        double cx = 0.0, cy = 0.0, half = 0.0;
+        double comX = 0.0, comY = 0.0, mass = 0.0;
+        int child = -1; // first of four consecutive children, -1 for leaves
+        int body = -1;
+    };
+
+    static constexpr int kMaxStack = 256;
+    static constexpr double kMinHalf = 1e-3;
+    static constexpr double kMinDistSq = 1e-4;
+
+    static int quadrant(const Cell& c, double x, double y)
+    {
+        return (x >= c.cx ? 1 : 0) | (y >= c.cy ? 2 : 0);
+    }
+
+    void split(int c)
+    {
+        const Cell parent = m_cells[c];
+        const double h = parent.half * 0.5;
+        const int first = m_cells.size();
+        for (int q = 0; q < 4; q++) {
+            Cell ch;
+            ch.cx = parent.cx + ((q & 1) ? h : -h);
+            ch.cy = parent.cy + ((q & 2) ? h : -h);
+            ch.half = h;
+            m_cells.push_back(ch);
+        }
+        m_cells[c].child = first;
+    }
+
+    void insert(int cell, int i)
+    {
+        const double x = m_xs[i];
+        const double y = m_ys[i];
+        const double m = m_mass[i];
+
+        int c = cell;
+        for (;;) {
+            Cell& cur = m_cells[c];
+            const bool empty = cur.mass <= 0.0;
+            cur.mass += m;
+            cur.comX += x * m;
+            cur.comY += y * m;
+
+            if (cur.child >= 0) {
+                c = cur.child + quadrant(cur, x, y);
+                continue;
+            }
+            if (empty) {
+                cur.body = i;
+                m_leafOf[i] = c;
+                return;
+            }
+            if (cur.half < kMinHalf) {
+                m_leafOf[i] = c; // (nearly) coincident bodies share one leaf
+                return;
+            }
+
+            const int b = cur.body;
+            cur.body = -1;
+            split(c); // invalidates `cur`
+            if (b >= 0) {
+                const Cell& sc = m_cells[c];
+                insert(sc.child + quadrant(sc, m_xs[b], m_ys[b]), b); // lands in an empty child
+            }
+            const Cell& sc = m_cells[c];
+            c = sc.child + quadrant(sc, x, y);
+        }
+    }
+
+    QVector<Cell> m_cells;
+    QVector<int> m_leafOf; // body -> leaf cell holding it
+    const double* m_xs = nullptr;
+    const double* m_ys = nullptr;
+    const double* m_mass = nullptr;
+};
+
+struct Chunk {
+    int begin = 0;
+    int end = 0;
+    double energy = 0.0;
+};
+
+} // namespace
+
+ForceLayout::ForceLayout(QObject* parent) : QObject(parent) {}
+
+ForceLayout::~ForceLayout()
+{
+    cancel();
+}
+
+void ForceLayout::start(int nodeCount, const QVector<Edge>& edges)
+{
+    cancel();
+    m_cancel = false;
+    m_framePending = false;
+
+    const int gen = ++m_generation;
+    const Params params = m_params;
+
+    m_future = QtConcurrent::run([this, nodeCount, edges, params, gen]() {
+        auto onFrame = [this, gen](const QVector<QPointF>& positions) {
+            if (m_framePending.exchange(true))
+                return;
+            QMetaObject::invokeMethod(this, [this, gen, positions]() {
+                m_framePending = false;
+                if (gen == m_generation)
+                    emit positionsUpdated(positions);
+            }, Qt::QueuedConnection);
+        };
+
+        const QVector<QPointF> result = compute(nodeCount, edges, params, &m_cancel, onFrame);
+        if (m_cancel)
+            return;
+
+        QMetaObject::invokeMethod(this, [this, gen, result]() {
+            if (gen == m_generation)
+                emit finished(result);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void ForceLayout::cancel()
+{
+    // Bumping the generation drops frames that are already queued.
+    ++m_generation;
+    m_cancel = true;
+    m_future.waitForFinished();
+}
+
+QVector<QPointF> ForceLayout::compute(int nodeCount,
+                                      const QVector<Edge>& edges,
+                                      const Params& params,
+                                      const std::atomic<bool>* cancel,
+                                      const std::function<void(const QVector<QPointF>&)>& onFrame)
+{
+    if (nodeCount <= 0)
+        return {};
+
+    auto cancelled = [cancel]() { return cancel && cancel->load(); };
+
+    // Build the hierarchy. levels[0] is the input graph.
+    QVector<Level> levels;
+    levels.reserve(32);
+    {
+        Level finest;
+        finest.n = nodeCount;
+        finest.mass.fill(1.0, nodeCount);
+        QVector<quint64> keys;
+        keys.reserve(edges.size());
+        for (const Edge& e : edges) {
+            if (e.from < 0 || e.to < 0 || e.from >= nodeCount || e.to >= nodeCount || e.from == e.to)
+                continue;
+            keys.push_back(pairKey(e.from, e.to));
+        }
+        buildAdjacency(&finest, std::move(keys));
+        levels.push_back(std::move(finest));
+    }
+
+    QRandomGenerator rng(0x5eed1234u);
+    while (levels.size() < 30 && levels.last().n > 64) {
+        if (cancelled())
+            return {};
+        Level coarse;
+        if (!coarsen(&levels.last(), &coarse, rng))
+            break;
+        levels.push_back(std::move(coarse));
+    }
+
+    // ancestors[l][f]: vertex of level l that original node f is collapsed into.
+    // Only needed to expand coarse-level frames to one position per node.
+    QVector<QVector<int>> ancestors;
+    if (onFrame) {
+        ancestors.resize(levels.size());
+        ancestors[0].resize(nodeCount);
+        std::iota(ancestors[0].begin(), ancestors[0].end(), 0);
+        for (int l = 1; l < levels.size(); l++) {
+            ancestors[l].resize(nodeCount);
+            const QVector<int>& parent = levels[l - 1].parent;
+            for (int f = 0; f < nodeCount; f++)
+                ancestors[l][f] = parent[ancestors[l - 1][f]];
+        }
+    }
+
+    const double K = params.idealEdgeLength;
+    const double strength = 0.2 * K * K;
+    const double thetaSq = params.theta * params.theta;
+    const int threads = qMax(1, QThread::idealThreadCount());
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    qint64 lastFrame = -params.frameIntervalMs;
+
+    // Coarsest level starts from a deterministic random scatter.
+    const int top = levels.size() - 1;
+    QVector<double> xs(levels[top].n);
+    QVector<double> ys(levels[top].n);
+    {
+        const double side = K * std::sqrt(double(levels[top].n));
+        for (int i = 0; i < levels[top].n; i++) {
+            xs[i] = (rng.generateDouble() - 0.5) * side;
+            ys[i] = (rng.generateDouble() - 0.5) * side;
+        }
+    }
+
+    QuadTree tree;
+    for (int l = top; l >= 0; l--) {
+        const Level& lvl = levels[l];
+        const int n = lvl.n;
+
+        if (l < top) {
+            // Prolong: children start at their parent's position, slightly jittered.
+            const QVector<int>& parent = lvl.parent;
+            QVector<double> fx(n);
+            QVector<double> fy(n);
+            for (int u = 0; u < n; u++) {
+                fx[u] = xs[parent[u]] + (rng.generateDouble() - 0.5) * K * 0.2;
+                fy[u] = ys[parent[u]] + (rng.generateDouble() - 0.5) * K * 0.2;
+            }
+            xs = std::move(fx);
+            ys = std::move(fy);
+        }
+
+        const int iterations = top == 0
+            ? params.coarsestIterations
+            : params.finestIterations + (params.coarsestIterations - params.finestIterations) * l / top;
+
+        const int chunkSize = qMax(256, n / (threads * 4) + 1);
+        QVector<Chunk> chunks;
+        for (int b = 0; b < n; b += chunkSize)
+            chunks.push_back({b, qMin(n, b + chunkSize), 0.0});
+
+        QVector<double> nx(n);
+        QVector<double> ny(n);
+        double step = (l == top) ? K : K * 0.3;
+        double energy0 = std::numeric_limits<double>::max();
+        int progress = 0;
+
+        for (int iter = 0; iter < iterations; iter++) {
+            if (cancelled())
+                return {};
+
+            tree.build(xs.constData(), ys.constData(), lvl.mass.constData(), n);
+
+            // Double-buffered: every chunk reads the old positions and writes
+            // only its own slice of the new ones, so no locking is needed.
+            // Raw pointers, taken here: QVector's non-const operator[] may
+            // detach, which is not safe from the workers.
+            const double* px = xs.constData();
+            const double* py = ys.constData();
+            double* outX = nx.data();
+            double* outY = ny.data();
+            const int* offsets = lvl.offsets.constData();
+            const int* targets = lvl.targets.constData();
+            QtConcurrent::blockingMap(chunks, [&](Chunk& ch) {
+                ch.energy = 0.0;
+                for (int i = ch.begin; i < ch.end; i++) {
+                    double fx = 0.0;
+                    double fy = 0.0;
+                    tree.repulsion(i, thetaSq, strength, &fx, &fy);
+
+                    for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+                        const int j = targets[k];
+                        const double dx = px[j] - px[i];
+                        const double dy = py[j] - py[i];
+                        const double d = std::sqrt(dx * dx + dy * dy);
+                        fx += dx * d / K;
+                        fy += dy * d / K;
+                    }
+
+                    const double f2 = fx * fx + fy * fy;
+                    ch.energy += f2;
+                    if (f2 > 0.0) {
+                        const double s = step / std::sqrt(f2);
+                        outX[i] = px[i] + fx * s;
+                        outY[i] = py[i] + fy * s;
+                    } else {
+                        outX[i] = px[i];
+                        outY[i] = py[i];
+                    }
+                }
+            });
+            std::swap(xs, nx);
+            std::swap(ys, ny);
+
+            double energy = 0.0;
+            for (const Chunk& ch : chunks)
+                energy += ch.energy;
+
+            // Adaptive cooling (Hu 2005).
+            if (energy < energy0) {
+                if (++progress >= 5) {
+                    progress = 0;
+                    step /= 0.9;
+                }
+            } else {
+                progress = 0;
+                step *= 0.9;
+            }
+            energy0 = energy;
+
+            if (onFrame && frameTimer.elapsed() - lastFrame >= params.frameIntervalMs) {
+                lastFrame = frameTimer.elapsed();
+                QVector<QPointF> frame(nodeCount);
+                const QVector<int>& anc = ancestors[l];
+                for (int f = 0; f < nodeCount; f++)
+                    frame[f] = QPointF(xs[anc[f]], ys[anc[f]]);
+                onFrame(frame);
+            }
+
+            if (step < K * 0.01)
+                break;
+        }
+    }
+
+    QVector<QPointF> out(nodeCount);
+    for (int i = 0; i < nodeCount; i++)
+        out[i] = QPointF(xs[i], ys[i]);
+    return out;
+}
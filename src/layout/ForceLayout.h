@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QFuture>
+#include <QPointF>
+#include <QVector>
+
+#include <atomic>
+#include <functional>
+
+#include "model/Edge.h"
+
+// Multilevel force-directed layout:
+// coarsen the graph by edge matching, lay out the coarsest level, then prolong
+// and refine level by level. Repulsion is approximated with a Barnes-Hut
+// quadtree and forces are accumulated in parallel on the global thread pool.
+class ForceLayout : public QObject {
+    Q_OBJECT
+public:
+    struct Params {
+        qreal idealEdgeLength = 300.0;
+        qreal theta = 0.9;           // Barnes-Hut opening criterion
+        int coarsestIterations = 300;
+        int finestIterations = 40;
+        int frameIntervalMs = 33;    // cap for streamed intermediate frames (~30 fps)
+    };
+
+    explicit ForceLayout(QObject* parent = nullptr);
+    ~ForceLayout() override;
+
+    void setParams(const Params& params) { m_params = params; }
+    const Params& params() const { return m_params; }
+
+    // Starts a layout on a worker thread. Node ids are expected to be 0..nodeCount-1.
+    // Any layout still running is cancelled first.
+    void start(int nodeCount, const QVector<Edge>& edges);
+    void cancel();
+    bool isRunning() const { return m_future.isRunning(); }
+
+    // Synchronous entry point (used by start() on the worker thread).
+    // onFrame is called from the computing thread, at most once per frameIntervalMs.
+    static QVector<QPointF> compute(int nodeCount,
+                                    const QVector<Edge>& edges,
+                                    const Params& params,
+                                    const std::atomic<bool>* cancel = nullptr,
+                                    const std::function<void(const QVector<QPointF>&)>& onFrame = {});
+
+signals:
+    void positionsUpdated(const QVector<QPointF>& positions);
+    void finished(const QVector<QPointF>& positions);
+
+private:
+    Params m_params;
+    QFuture<void> m_future;
+    std::atomic<bool> m_cancel{false};
+    // Set while a streamed frame is queued to the GUI thread; frames produced in
+    // the meantime are dropped instead of piling up in the event queue.
+    std::atomic<bool> m_framePending{false};
+    int m_generation = 0;
+};
@@ -0,0 +1,57 @@
+﻿#include "LayeredLayout.h"
+
+QVector<int> LayeredLayout::layers(const Condensation& scc, int nodeCount)
+{
+    const CsrGraph& dag = scc.dag();
+    const int count = scc.componentCount();
+
+    // Longest path from the sources. Component ids are in reverse
+    // topological order, so walking them downwards visits predecessors first.
+    QVector<int> compLayer(count, 0);
+    int maxLayer = 0;
+    for (int c = count - 1; c >= 0; c--) {
+        for (const int* d = dag.outBegin(c); d != dag.outEnd(c); ++d) {
+            compLayer[*d] = qMax(compLayer[*d], compLayer[c] + 1);
+            maxLayer = qMax(maxLayer, compLayer[*d]);
+        }
+    }
+
+    const int isolatedLayer = maxLayer + 1;
+    QVector<int> layer(nodeCount, 0);
+    for (int v = 0; v < nodeCount; v++) {
+        const int c = scc.componentOf(v);
+        const bool isolated = scc.componentSize(c) == 1 && !scc.isCyclic(c) && dag.outDegree(c) == 0 && dag.inDegree(c) == 0;
+        layer[v] = isolated ? isolatedLayer : compLayer[c];
+    }
+    return layer;
+}
+
+QVector<QPointF> LayeredLayout::compute(int nodeCount, const QVector<Edge>& edges)
+{
+    return compute(nodeCount, edges, Params());
+}
+
+QVector<QPointF> LayeredLayout::compute(int nodeCount, const QVector<Edge>& edges, const Params& params)
+{
+    const CsrGraph graph = CsrGraph::fromEdges(nodeCount, edges);
+    const Condensation scc = Condensation::compute(graph);
+    const QVector<int> layer = layers(scc, nodeCount);
+
+    int columns = 0;
+    for (int l : layer)
+        columns = qMax(columns, l + 1);
+
+    // Ids ascending within each column keeps the result stable across runs.
+    QVector<int> columnSize(columns, 0);
+    for (int l : layer)
+        columnSize[l]++;
+
+    QVector<int> placed(columns, 0);
+    QVector<QPointF> pos(nodeCount);
+    for (int v = 0; v < nodeCount; v++) {
+        const int l = layer[v];
+        const qreal y0 = -0.5 * (qMax(1, columnSize[l]) - 1) * params.yStep;
+        pos[v] = QPointF(l * params.xStep, y0 + placed[l]++ * params.yStep);
+    }
+    return pos;
+}
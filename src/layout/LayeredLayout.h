@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include <QPointF>
+#include <QVector>
+
+#include "model/Condensation.h"
+#include "model/Edge.h"
+
+// Deterministic column layout for a directed graph. Strongly connected
+// components are contracted first, so cycles cannot break the layering:
+// each component sits one column right of its deepest predecessor and all
+// members of a component share a column. Isolated nodes get a column of
+// their own at the end.
+class LayeredLayout {
+public:
+    struct Params {
+        qreal xStep = 360.0;
+        qreal yStep = 92.0;
+    };
+
+    // Column per node.
+    static QVector<int> layers(const Condensation& scc, int nodeCount);
+
+    // Positions per node id (0..nodeCount-1), columns centred on y = 0.
+    static QVector<QPointF> compute(int nodeCount, const QVector<Edge>& edges);
+    static QVector<QPointF> compute(int nodeCount, const QVector<Edge>& edges, const Params& params);
+};
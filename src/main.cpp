@@ -1,8 +1,31 @@
 ﻿#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
 #include <QFile>
+#include <QSaveFile>
 #include <QTextStream>
 
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#ifdef Q_OS_WIN
+#include <qt_windows.h>
+#endif
+
+#include "gui/GraphView.h"
 #include "gui/MainWindow.h"
+#include "gui/SvgWriter.h"
+#include "layout/LayeredLayout.h"
+#include "model/AdvisoryDb.h"
+#include "model/GraphModel.h"
+#include "model/ReachabilityIndex.h"
+#include "model/RegistryIndex.h"
+#include "model/TrigramIndex.h"
+#include "parser/DependencyScanner.h"
+#include "server/QueryServer.h"
+#include "util/MemoryReport.h"
+#include "util/Trace.h"
 
 static void loadAppStyle()
 {
@@ -13,14 +36,185 @@ static void loadAppStyle()
     qApp->setStyleSheet(ts.readAll());
 }
 
+// DepGraph is a GUI-subsystem program on Windows and starts without a
+// console, so the command-line modes attach to the one they were run from.
+// Streams redirected to a file or pipe are left alone; started from Explorer
+// there is no console to attach to and output goes nowhere, as before.
+static void attachConsole()
+{
+#ifdef Q_OS_WIN
+    static bool attached = false;
+    if (attached)
+        return;
+    attached = true;
+
+    const bool outRedirected = GetFileType(GetStdHandle(STD_OUTPUT_HANDLE)) != FILE_TYPE_UNKNOWN;
+    const bool errRedirected = GetFileType(GetStdHandle(STD_ERROR_HANDLE)) != FILE_TYPE_UNKNOWN;
+    if ((outRedirected && errRedirected) || !AttachConsole(ATTACH_PARENT_PROCESS))
+        return;
+    if (!outRedirected)
+        std::freopen("CONOUT$", "w", stdout);
+    if (!errRedirected)
+        std::freopen("CONOUT$", "w", stderr);
+#endif
+}
+
+// Scans a repository the way the window does, builds the scene, prints the
+// memory report and exits. No window is shown.
+static int runMemoryReport(const QString& repoPath, bool json)
+{
+    GraphModel graph;
+    QString err;
+    // As in the window, scan errors are not fatal unless nothing was found.
+    if (!DependencyScanner::scanRepositoryToGraph(QDir(repoPath), &graph, &err)) {
+        std::fprintf(stderr, "Scan: %s\n", qPrintable(err));
+        if (graph.nodes().isEmpty())
+            return 1;
+    }
+
+    GraphModel::Data data = graph.takeData();
+    data.reachability = ReachabilityIndex::build(data.nodes.size(), data.edges);
+    data.search = TrigramIndex::build(data.nodes);
+    graph.adopt(std::move(data));
+
+    GraphView view;
+    view.setModel(&graph);
+
+    MemoryReport report;
+    graph.reportMemory(&report);
+    view.reportMemory(&report);
+
+    const QByteArray out = json ? report.toJson() : report.toText().toUtf8() + '\n';
+    std::fwrite(out.constData(), 1, size_t(out.size()), stdout);
+    return 0;
+}
+
+// Scans a repository, lays it out in columns and writes the SVG without
+// building a scene. `outPath` empty writes to stdout.
+static int runSvgExport(const QString& repoPath, const QString& outPath)
+{
+    GraphModel graph;
+    QString err;
+    if (!DependencyScanner::scanRepositoryToGraph(QDir(repoPath), &graph, &err)) {
+        std::fprintf(stderr, "Scan: %s\n", qPrintable(err));
+        if (graph.nodes().isEmpty())
+            return 1;
+    }
+    const QVector<QPointF> positions = LayeredLayout::compute(graph.nodes().size(), graph.edges());
+
+    if (outPath.isEmpty()) {
+        QFile out;
+        if (!out.open(stdout, QIODevice::WriteOnly) || !SvgWriter::writeGraph(&out, graph, positions, &err)) {
+            std::fprintf(stderr, "SVG export failed: %s\n", qPrintable(err));
+            return 1;
+        }
+        return 0;
+    }
+
+    QSaveFile out(outPath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        std::fprintf(stderr, "Cannot write %s: %s\n", qPrintable(outPath), qPrintable(out.errorString()));
+        return 1;
+    }
+    if (!SvgWriter::writeGraph(&out, graph, positions, &err) || !out.commit()) {
+        std::fprintf(stderr, "SVG export failed: %s\n", qPrintable(err.isEmpty() ? out.errorString() : err));
+        return 1;
+    }
+    return 0;
+}
+
+// Holds the repositories' graphs in memory and answers queries on a local
+// socket until killed (see QueryServer for the protocol). Registry metadata
+// and an advisory dump, when given, are loaded once and applied to every scan.
+static int runServer(const QStringList& repoPaths, const QString& socketName, int refreshSeconds,
+                     const QString& registryPath, const QString& advisoryPath)
+{
+    QString err;
+    std::shared_ptr<RegistryIndex> registry;
+    if (!registryPath.isEmpty()) {
+        registry = std::make_shared<RegistryIndex>();
+        if (!registry->load(registryPath, &err)) {
+            std::fprintf(stderr, "Cannot load registry metadata %s: %s\n", qPrintable(registryPath), qPrintable(err));
+            return 1;
+        }
+    }
+    std::shared_ptr<AdvisoryDb> advisories;
+    if (!advisoryPath.isEmpty()) {
+        advisories = std::make_shared<AdvisoryDb>();
+        if (!advisories->load(advisoryPath, false, &err)) {
+            std::fprintf(stderr, "Cannot load advisories %s: %s\n", qPrintable(advisoryPath), qPrintable(err));
+            return 1;
+        }
+    }
+
+    QueryServer server;
+    for (const QString& path : repoPaths)
+        server.addRepository(QDir(path));
+    server.setRefreshInterval(refreshSeconds);
+    server.setLocalMetadata(std::move(registry), std::move(advisories));
+
+    if (!server.start(socketName, &err)) {
+        std::fprintf(stderr, "%s\n", qPrintable(err));
+        return 1;
+    }
+    std::fprintf(stderr, "Serving %d repositories on %s\n", int(repoPaths.size()), qPrintable(server.serverPath()));
+    return qApp->exec();
+}
+
 int main(int argc, char *argv[])
 {
+    // The command-line modes need a QApplication but never show a window.
+    for (int i = 1; i < argc; i++) {
+        const bool headless = std::strcmp(argv[i], "--memory-report") == 0 || std::strcmp(argv[i], "--export-svg") == 0 ||
+                              std::strcmp(argv[i], "--serve") == 0;
+        if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        if (headless)
+            attachConsole();
+    }
+
     QApplication app(argc, argv);
     QApplication::setApplicationName("DepGraph");
     QApplication::setOrganizationName("DepGraph");
 
+    QCommandLineParser cli;
+    cli.setApplicationDescription("Dependency graph viewer");
+    cli.addHelpOption();
+    const QCommandLineOption memoryOpt("memory-report", "Scan <repo>, print estimated memory use and exit.", "repo");
+    const QCommandLineOption jsonOpt("json", "Print the memory report as JSON.");
+    const QCommandLineOption svgOpt("export-svg", "Scan <repo>, write the graph as SVG and exit.", "repo");
+    const QCommandLineOption outputOpt({"o", "output"}, "File for --export-svg (default: stdout).", "file");
+    const QCommandLineOption serveOpt("serve", "Keep <repo> scanned and answer queries on a local socket (repeatable).", "repo");
+    const QCommandLineOption socketOpt("socket", "Socket name or path for --serve (default: depgraph).", "name", "depgraph");
+    const QCommandLineOption refreshOpt("refresh", "Seconds between rescans for --serve; 0 only on request (default: 30).",
+                                        "seconds", "30");
+    const QCommandLineOption registryOpt("registry", "Registry metadata dump to mark outdated packages with for --serve.", "file");
+    const QCommandLineOption advisoriesOpt("advisories", "Advisory dump to mark vulnerable packages with for --serve.", "file");
+    cli.addOption(memoryOpt);
+    cli.addOption(jsonOpt);
+    cli.addOption(svgOpt);
+    cli.addOption(outputOpt);
+    cli.addOption(serveOpt);
+    cli.addOption(socketOpt);
+    cli.addOption(refreshOpt);
+    cli.addOption(registryOpt);
+    cli.addOption(advisoriesOpt);
+    cli.process(app);
+
+    if (cli.isSet(memoryOpt))
+        return runMemoryReport(cli.value(memoryOpt), cli.isSet(jsonOpt));
+    if (cli.isSet(svgOpt))
+        return runSvgExport(cli.value(svgOpt), cli.value(outputOpt));
+    if (cli.isSet(serveOpt))
+        return runServer(cli.values(serveOpt), cli.value(socketOpt), cli.value(refreshOpt).toInt(), cli.value(registryOpt),
+                         cli.value(advisoriesOpt));
+
     loadAppStyle();
 
+    // DEPGRAPH_TRACE=1 records scan traces from startup (Tools > Record Scan Trace).
+    if (qEnvironmentVariableIntValue("DEPGRAPH_TRACE") != 0)
+        Trace::setEnabled(true);
+
     MainWindow w;
     w.resize(1400, 850);
     w.show();
@@ -0,0 +1,697 @@
+﻿#include "AdvisoryDb.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+
+#include "model/Version.h"
+#include "util/PackageIndex.h"
+#include "util/Parallel.h"
+#include "util/PerfectHash.h"
+#include "util/Trace.h"
+#include "util/ZipReader.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr char kMagic[8] = {'D', 'G', 'A', 'D', 'V', 'I', 'D', 'X'};
+constexpr quint32 kFormatVersion = 1;
+constexpr quint32 kByteOrder = 0x01020304;
+
+// Summaries are for the status bar and tooltips; details stay in the dump.
+constexpr int kMaxSummaryChars = 240;
+
+enum IntervalFlag : quint8 {
+    HasMin = 0x1,
+    HasMax = 0x2,
+    MinInclusive = 0x4,
+    MaxInclusive = 0x8
+};
+
+// Every record is a multiple of 8 bytes, so each table stays aligned.
+struct Header {
+    char magic[8];
+    quint32 formatVersion;
+    quint32 byteOrder;
+    quint64 sourceStamp;
+    quint32 packageCount;
+    quint32 intervalCount;
+    quint32 advisoryCount;
+    quint32 stringBytes;
+};
+
+struct PackageRecord {
+    quint64 hash;
+    quint32 keyOffset; // "ecosystem\x1fname" in the string pool
+    quint32 keyLength;
+    quint32 firstInterval;
+    quint32 intervalCount;
+};
+
+struct IntervalRecord {
+    quint64 minHi;
+    quint64 minLo;
+    quint64 maxHi;
+    quint64 maxLo;
+    quint32 advisory;
+    quint8 flags;
+    quint8 pad[3];
+};
+
+struct AdvisoryRecord {
+    quint32 idOffset;
+    quint32 summaryOffset;
+    quint16 idLength;
+    quint16 summaryLength;
+    quint8 severity;
+    quint8 pad[3];
+};
+
+static_assert(sizeof(Header) == 40, "index layout");
+static_assert(sizeof(PackageRecord) == 24, "index layout");
+static_assert(sizeof(IntervalRecord) == 40, "index layout");
+static_assert(sizeof(AdvisoryRecord) == 16, "index layout");
+
+const Header* headerOf(const uchar* data)
+{
+    return reinterpret_cast<const Header*>(data);
+}
+
+const PackageRecord* packagesOf(const uchar* data)
+{
+    return reinterpret_cast<const PackageRecord*>(data + sizeof(Header));
+}
+
+const IntervalRecord* intervalsOf(const uchar* data)
+{
+    return reinterpret_cast<const IntervalRecord*>(packagesOf(data) + headerOf(data)->packageCount);
+}
+
+const AdvisoryRecord* advisoriesOf(const uchar* data)
+{
+    return reinterpret_cast<const AdvisoryRecord*>(intervalsOf(data) + headerOf(data)->intervalCount);
+}
+
+const char* stringsOf(const uchar* data)
+{
+    return reinterpret_cast<const char*>(advisoriesOf(data) + headerOf(data)->advisoryCount);
+}
+
+qint64 expectedSize(const Header& h)
+{
+    return qint64(sizeof(Header)) + qint64(h.packageCount) * qint64(sizeof(PackageRecord)) +
+           qint64(h.intervalCount) * qint64(sizeof(IntervalRecord)) +
+           qint64(h.advisoryCount) * qint64(sizeof(AdvisoryRecord)) + qint64(h.stringBytes);
+}
+
+// Node kinds to OSV ecosystems, in the lower-case form keys use.
+QString ecosystemForKind(const QString& kind)
+{
+    if (kind.endsWith(":module"))
+        return QString(); // the repository's own modules
+    if (kind.startsWith("npm"))
+        return "npm";
+    if (kind.startsWith("pypi"))
+        return "pypi";
+    if (kind.startsWith("maven") || kind.startsWith("gradle"))
+        return "maven";
+    return QString();
+}
+
+QString ecosystemForOsv(const std::string& ecosystem)
+{
+    if (ecosystem == "npm")
+        return "npm";
+    if (ecosystem == "PyPI")
+        return "pypi";
+    if (ecosystem == "Maven")
+        return "maven";
+    return QString();
+}
+
+AdvisoryDb::Severity severityFromString(const std::string& s)
+{
+    const QString t = QString::fromStdString(s).toUpper();
+    if (t == "LOW")
+        return AdvisoryDb::Severity::Low;
+    if (t == "MODERATE" || t == "MEDIUM")
+        return AdvisoryDb::Severity::Moderate;
+    if (t == "HIGH")
+        return AdvisoryDb::Severity::High;
+    if (t == "CRITICAL")
+        return AdvisoryDb::Severity::Critical;
+    return AdvisoryDb::Severity::Unknown;
+}
+
+std::string stringField(const json& obj, const char* key)
+{
+    if (!obj.is_object())
+        return std::string();
+    const auto it = obj.find(key);
+    return it != obj.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+
+struct ParsedInterval {
+    QByteArray key;
+    VersionRange::Interval interval;
+};
+
+struct ParsedAdvisory {
+    QByteArray id;
+    QByteArray summary;
+    AdvisoryDb::Severity severity = AdvisoryDb::Severity::Unknown;
+    QVector<ParsedInterval> intervals;
+};
+
+// OSV range events in order: "introduced" opens an interval, "fixed" closes
+// it exclusively and "last_affected" inclusively. "introduced": "0" means
+// from the first version. An interval still open at the end is unbounded.
+bool rangeIntervals(const json& events, VersionScheme scheme, QVector<VersionRange::Interval>* out)
+{
+    if (!events.is_array())
+        return false;
+    bool open = false;
+    VersionRange::Interval current;
+    for (const json& ev : events) {
+        if (!ev.is_object())
+            continue;
+        VersionKey key;
+        if (ev.contains("introduced")) {
+            const std::string v = stringField(ev, "introduced");
+            current = VersionRange::Interval();
+            if (v != "0") {
+                if (!Version::parse(QString::fromStdString(v), scheme, &key))
+                    return false;
+                current.hasMin = true;
+                current.min = key;
+                current.minInclusive = true;
+            }
+            open = true;
+        } else if (ev.contains("fixed") || ev.contains("last_affected")) {
+            const bool fixed = ev.contains("fixed");
+            const std::string v = stringField(ev, fixed ? "fixed" : "last_affected");
+            if (!open)
+                continue;
+            if (!Version::parse(QString::fromStdString(v), scheme, &key))
+                return false;
+            current.hasMax = true;
+            current.max = key;
+            current.maxInclusive = !fixed;
+            out->push_back(current);
+            open = false;
+        }
+    }
+    if (open)
+        out->push_back(current);
+    return true;
+}
+
+void parseAffected(const json& affected, ParsedAdvisory* adv)
+{
+    if (!affected.is_object())
+        return;
+    const json& pkg = affected.value("package", json::object());
+    const QString ecosystem = ecosystemForOsv(stringField(pkg, "ecosystem"));
+    const std::string name = stringField(pkg, "name");
+    if (ecosystem.isEmpty() || name.empty())
+        return;
+    const QByteArray key = PackageIndex::packageKey(ecosystem, QString::fromStdString(name));
+    const VersionScheme scheme = Version::schemeForKind(ecosystem);
+
+    QVector<VersionRange::Interval> intervals;
+    const json& ranges = affected.value("ranges", json::array());
+    if (ranges.is_array()) {
+        for (const json& range : ranges) {
+            const std::string type = stringField(range, "type");
+            if (type != "SEMVER" && type != "ECOSYSTEM")
+                continue; // GIT ranges name commits, not versions
+            QVector<VersionRange::Interval> parsed;
+            if (rangeIntervals(range.value("events", json::array()), scheme, &parsed))
+                intervals += parsed;
+        }
+    }
+
+    // Explicit lists repeat what the ranges say; they are only needed when
+    // no range could be used.
+    if (intervals.isEmpty()) {
+        const json& versions = affected.value("versions", json::array());
+        if (versions.is_array()) {
+            for (const json& v : versions) {
+                VersionKey k;
+                if (!v.is_string() || !Version::parse(QString::fromStdString(v.get<std::string>()), scheme, &k))
+                    continue;
+                VersionRange::Interval point;
+                point.hasMin = point.hasMax = true;
+                point.min = point.max = k;
+                point.minInclusive = point.maxInclusive = true;
+                intervals.push_back(point);
+            }
+        }
+    }
+
+    for (const VersionRange::Interval& i : intervals)
+        adv->intervals.push_back({key, i});
+
+    if (adv->severity == AdvisoryDb::Severity::Unknown) {
+        adv->severity = severityFromString(stringField(affected.value("database_specific", json::object()), "severity"));
+        if (adv->severity == AdvisoryDb::Severity::Unknown)
+            adv->severity = severityFromString(stringField(affected.value("ecosystem_specific", json::object()), "severity"));
+    }
+}
+
+void parseAdvisory(const json& obj, QVector<ParsedAdvisory>* out)
+{
+    if (!obj.is_object() || obj.contains("withdrawn"))
+        return;
+    ParsedAdvisory adv;
+    adv.id = QByteArray::fromStdString(stringField(obj, "id"));
+    if (adv.id.isEmpty())
+        return;
+    std::string summary = stringField(obj, "summary");
+    if (summary.empty())
+        summary = stringField(obj, "details");
+    QString text = QString::fromStdString(summary).simplified();
+    if (text.size() > kMaxSummaryChars)
+        text = text.left(kMaxSummaryChars - 3) + "...";
+    adv.summary = text.toUtf8();
+    adv.severity = severityFromString(stringField(obj.value("database_specific", json::object()), "severity"));
+
+    const json& affected = obj.value("affected", json::array());
+    if (affected.is_array()) {
+        for (const json& a : affected)
+            parseAffected(a, &adv);
+    }
+    if (!adv.intervals.isEmpty())
+        out->push_back(std::move(adv));
+}
+
+// One file is usually one advisory; arrays of advisories are accepted too.
+bool parseFile(const QByteArray& bytes, QVector<ParsedAdvisory>* out)
+{
+    json j;
+    try {
+        j = json::parse(bytes.constData(), bytes.constData() + bytes.size());
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (j.is_array()) {
+        for (const json& obj : j)
+            parseAdvisory(obj, out);
+    } else {
+        parseAdvisory(j, out);
+    }
+    return true;
+}
+
+bool containsKey(const IntervalRecord& r, const VersionKey& v)
+{
+    VersionKey min;
+    min.hi = r.minHi;
+    min.lo = r.minLo;
+    VersionKey max;
+    max.hi = r.maxHi;
+    max.lo = r.maxLo;
+    if ((r.flags & HasMin) && ((r.flags & MinInclusive) ? v < min : v <= min))
+        return false;
+    if ((r.flags & HasMax) && ((r.flags & MaxInclusive) ? v > max : v >= max))
+        return false;
+    return true;
+}
+
+// The version a requirement resolves to at its lowest, or false when it has
+// no usable lower bound.
+bool lowestAdmitted(const VersionRange& range, VersionKey* out)
+{
+    if (!range.valid || range.isEmpty())
+        return false;
+    const VersionRange::Interval* lowest = nullptr;
+    for (const VersionRange::Interval& i : range.intervals) {
+        if (!i.hasMin)
+            return false;
+        if (!lowest || i.min < lowest->min)
+            lowest = &i;
+    }
+    if (!lowest->minInclusive)
+        return false; // ">1.2.0": the next version is unknown
+    *out = lowest->min.releaseOfFloor();
+    return true;
+}
+
+} // namespace
+
+AdvisoryDb::~AdvisoryDb()
+{
+    close();
+}
+
+void AdvisoryDb::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    m_file.close();
+}
+
+bool AdvisoryDb::build(const QString& sourcePath, const QString& indexPath, QString* err)
+{
+    Trace::Span span("advisories.build", sourcePath);
+    const quint64 stamp = PackageIndex::sourceStamp(sourcePath);
+    if (stamp == 0) {
+        if (err) *err = QString("%1 does not exist.").arg(sourcePath);
+        return false;
+    }
+
+    // Sources: JSON files of a directory tree, or JSON entries of a zip.
+    const bool isDir = QFileInfo(sourcePath).isDir();
+    QStringList files;
+    ZipReader zip;
+    QVector<ZipReader::Entry> entries;
+    if (isDir) {
+        QDirIterator it(sourcePath, QStringList{"*.json"}, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+            files.push_back(it.next());
+    } else {
+        if (!zip.open(sourcePath, err))
+            return false;
+        for (const ZipReader::Entry& e : zip.entries()) {
+            if (e.name.endsWith(".json", Qt::CaseInsensitive))
+                entries.push_back(e);
+        }
+    }
+    const int sourceCount = isDir ? files.size() : entries.size();
+    if (sourceCount == 0) {
+        if (err) *err = QString("No OSV JSON files found in %1.").arg(sourcePath);
+        return false;
+    }
+
+    // Parse in parallel; each source has its own slot, so no locking.
+    QVector<QVector<ParsedAdvisory>> parsed(sourceCount);
+    std::atomic<int> failed{0};
+    Parallel::forChunks(sourceCount, 64, [&](int begin, int end) {
+        QByteArray bytes;
+        for (int i = begin; i < end; i++) {
+            bool ok = false;
+            if (isDir) {
+                QFile f(files[i]);
+                ok = f.open(QIODevice::ReadOnly);
+                if (ok)
+                    bytes = f.readAll();
+            } else {
+                ok = zip.read(entries[i], &bytes, nullptr);
+            }
+            if (!ok || !parseFile(bytes, &parsed[i]))
+                failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    Trace::count("advisories", "files", sourceCount);
+    Trace::count("advisories", "failed", failed.load());
+    if (failed.load() == sourceCount) {
+        if (err) *err = QString("None of the files in %1 could be read as OSV JSON.").arg(sourcePath);
+        return false;
+    }
+
+    // Merge: advisories get their final index, intervals are grouped by package.
+    QByteArray strings;
+    auto addString = [&strings](const QByteArray& s) {
+        const quint32 offset = quint32(strings.size());
+        strings += s;
+        return offset;
+    };
+
+    QVector<AdvisoryRecord> advisories;
+    QHash<QByteArray, int> advisoryIndex;
+    QHash<QByteArray, QVector<IntervalRecord>> byPackage;
+    for (const QVector<ParsedAdvisory>& list : parsed) {
+        for (const ParsedAdvisory& adv : list) {
+            // Aggregate dumps can carry the same advisory more than once.
+            if (advisoryIndex.contains(adv.id))
+                continue;
+            const int index = advisories.size();
+            advisoryIndex.insert(adv.id, index);
+
+            AdvisoryRecord rec;
+            std::memset(&rec, 0, sizeof(rec));
+            const QByteArray id = adv.id.left(0xffff);
+            const QByteArray summary = adv.summary.left(0xffff);
+            rec.idOffset = addString(id);
+            rec.idLength = quint16(id.size());
+            rec.summaryOffset = addString(summary);
+            rec.summaryLength = quint16(summary.size());
+            rec.severity = quint8(adv.severity);
+            advisories.push_back(rec);
+
+            for (const ParsedInterval& pi : adv.intervals) {
+                IntervalRecord r;
+                std::memset(&r, 0, sizeof(r));
+                const VersionRange::Interval& i = pi.interval;
+                r.minHi = i.min.hi;
+                r.minLo = i.min.lo;
+                r.maxHi = i.max.hi;
+                r.maxLo = i.max.lo;
+                r.advisory = quint32(index);
+                r.flags = (i.hasMin ? HasMin : 0) | (i.hasMax ? HasMax : 0) | (i.minInclusive ? MinInclusive : 0) |
+                          (i.maxInclusive ? MaxInclusive : 0);
+                byPackage[pi.key].push_back(r);
+            }
+        }
+    }
+    parsed.clear();
+
+    struct PendingPackage {
+        quint64 hash;
+        QByteArray key;
+    };
+    QVector<PendingPackage> keys;
+    keys.reserve(byPackage.size());
+    for (auto it = byPackage.constBegin(); it != byPackage.constEnd(); ++it)
+        keys.push_back({PerfectHash::hashBytes(it.key()), it.key()});
+    std::sort(keys.begin(), keys.end(), [](const PendingPackage& a, const PendingPackage& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.key < b.key;
+    });
+
+    QVector<PackageRecord> packages;
+    QVector<IntervalRecord> intervals;
+    packages.reserve(keys.size());
+    for (const PendingPackage& k : keys) {
+        const QVector<IntervalRecord>& list = byPackage.value(k.key);
+        PackageRecord p;
+        std::memset(&p, 0, sizeof(p));
+        p.hash = k.hash;
+        p.keyOffset = addString(k.key);
+        p.keyLength = quint32(k.key.size());
+        p.firstInterval = quint32(intervals.size());
+        p.intervalCount = quint32(list.size());
+        intervals += list;
+        packages.push_back(p);
+    }
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.formatVersion = kFormatVersion;
+    h.byteOrder = kByteOrder;
+    h.sourceStamp = stamp;
+    h.packageCount = quint32(packages.size());
+    h.intervalCount = quint32(intervals.size());
+    h.advisoryCount = quint32(advisories.size());
+    h.stringBytes = quint32(strings.size());
+
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+    QSaveFile f(indexPath);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = QString("Cannot write %1").arg(indexPath);
+        return false;
+    }
+    auto writeBlock = [&f](const void* data, qint64 bytes) {
+        return bytes == 0 || f.write(static_cast<const char*>(data), bytes) == bytes;
+    };
+    const bool written = writeBlock(&h, sizeof(h)) &&
+                         writeBlock(packages.constData(), qint64(packages.size()) * qint64(sizeof(PackageRecord))) &&
+                         writeBlock(intervals.constData(), qint64(intervals.size()) * qint64(sizeof(IntervalRecord))) &&
+                         writeBlock(advisories.constData(), qint64(advisories.size()) * qint64(sizeof(AdvisoryRecord))) &&
+                         writeBlock(strings.constData(), strings.size());
+    if (!written) {
+        if (err) *err = QString("Failed writing %1").arg(indexPath);
+        return false;
+    }
+    if (!f.commit()) {
+        if (err) *err = QString("Failed committing %1").arg(indexPath);
+        return false;
+    }
+    return true;
+}
+
+bool AdvisoryDb::open(const QString& indexPath, QString* err)
+{
+    close();
+    m_file.setFileName(indexPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (err) *err = QString("Cannot open %1").arg(indexPath);
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(Header))) {
+        if (err) *err = QString("%1 is not an advisory index.").arg(indexPath);
+        close();
+        return false;
+    }
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        if (err) *err = QString("Cannot map %1").arg(indexPath);
+        close();
+        return false;
+    }
+
+    const Header* h = headerOf(m_data);
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->formatVersion != kFormatVersion ||
+        h->byteOrder != kByteOrder || expectedSize(*h) != m_size) {
+        if (err) *err = QString("%1 is not an advisory index of this version.").arg(indexPath);
+        close();
+        return false;
+    }
+    return true;
+}
+
+QString AdvisoryDb::defaultIndexPath(const QString& sourcePath)
+{
+    const QByteArray path = QFileInfo(sourcePath).absoluteFilePath().toUtf8();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+           QString("/advisories-%1.idx").arg(PerfectHash::hashBytes(path), 16, 16, QChar('0'));
+}
+
+bool AdvisoryDb::load(const QString& sourcePath, bool rebuild, QString* err)
+{
+    const QString indexPath = defaultIndexPath(sourcePath);
+    const quint64 stamp = PackageIndex::sourceStamp(sourcePath);
+    if (stamp == 0) {
+        if (err) *err = QString("%1 does not exist.").arg(sourcePath);
+        return false;
+    }
+
+    // A missing, foreign or outdated index is rebuilt rather than reported.
+    if (!rebuild && open(indexPath, nullptr) && headerOf(m_data)->sourceStamp == stamp) {
+        m_sourcePath = sourcePath;
+        return true;
+    }
+    close();
+    if (!build(sourcePath, indexPath, err) || !open(indexPath, err))
+        return false;
+    m_sourcePath = sourcePath;
+    return true;
+}
+
+int AdvisoryDb::findPackage(const QByteArray& key) const
+{
+    if (!m_data)
+        return -1;
+    const quint64 hash = PerfectHash::hashBytes(key);
+    const PackageRecord* begin = packagesOf(m_data);
+    const PackageRecord* end = begin + headerOf(m_data)->packageCount;
+    const PackageRecord* it =
+        std::lower_bound(begin, end, hash, [](const PackageRecord& p, quint64 h) { return p.hash < h; });
+    const char* strings = stringsOf(m_data);
+    for (; it != end && it->hash == hash; ++it) {
+        if (it->keyLength == quint32(key.size()) && std::memcmp(strings + it->keyOffset, key.constData(), key.size()) == 0)
+            return int(it - begin);
+    }
+    return -1;
+}
+
+QString AdvisoryDb::string(quint32 offset, quint32 length) const
+{
+    return QString::fromUtf8(stringsOf(m_data) + offset, int(length));
+}
+
+QVector<int> AdvisoryDb::match(const QString& kind, const QString& name, const QString& version) const
+{
+    QVector<int> out;
+    const QString ecosystem = ecosystemForKind(kind);
+    if (!m_data || ecosystem.isEmpty())
+        return out;
+    const int p = findPackage(PackageIndex::packageKey(ecosystem, name));
+    if (p < 0)
+        return out;
+
+    const VersionScheme scheme = Version::schemeForKind(kind);
+    VersionKey v;
+    if (!Version::parse(version.trimmed(), scheme, &v) && !lowestAdmitted(Version::parseRange(version, scheme), &v))
+        return out;
+
+    const PackageRecord& pkg = packagesOf(m_data)[p];
+    const IntervalRecord* intervals = intervalsOf(m_data) + pkg.firstInterval;
+    for (quint32 i = 0; i < pkg.intervalCount; i++) {
+        const int advisory = int(intervals[i].advisory);
+        if (containsKey(intervals[i], v) && !out.contains(advisory))
+            out.push_back(advisory);
+    }
+    return out;
+}
+
+int AdvisoryDb::markVulnerable(const QVector<Node>& nodes, QVector<NodeStatus>* statuses) const
+{
+    if (!m_data)
+        return 0;
+    Trace::Span span("scan.advisories");
+    std::atomic<int> marked{0};
+    // Detached here, once: the workers write through the raw pointer, and
+    // each node only to its own slot.
+    NodeStatus* out = statuses->data();
+    const int count = statuses->size();
+    Parallel::forChunks(nodes.size(), 1024, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const Node& n = nodes[i];
+            if (n.id < 0 || n.id >= count)
+                continue;
+            if (!match(n.kind, n.name, n.version).isEmpty()) {
+                out[n.id] = NodeStatus::Vulnerable;
+                marked.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return marked.load();
+}
+
+AdvisoryDb::Advisory AdvisoryDb::advisory(int index) const
+{
+    Advisory a;
+    if (!m_data || index < 0 || index >= advisoryCount())
+        return a;
+    const AdvisoryRecord& r = advisoriesOf(m_data)[index];
+    a.id = string(r.idOffset, r.idLength);
+    a.summary = string(r.summaryOffset, r.summaryLength);
+    a.severity = Severity(r.severity);
+    return a;
+}
+
+int AdvisoryDb::advisoryCount() const
+{
+    return m_data ? int(headerOf(m_data)->advisoryCount) : 0;
+}
+
+int AdvisoryDb::packageCount() const
+{
+    return m_data ? int(headerOf(m_data)->packageCount) : 0;
+}
+
+QString AdvisoryDb::severityToString(Severity s)
+{
+    switch (s) {
+    case Severity::Low: return "low";
+    case Severity::Moderate: return "moderate";
+    case Severity::High: return "high";
+    case Severity::Critical: return "critical";
+    case Severity::Unknown: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "model/Node.h"
+
+// Security advisories from a local OSV dump (a directory or zip of OSV JSON
+// files, e.g. the per-ecosystem all.zip from osv.dev), matched against nodes
+// without any network access.
+//
+// The dump is parsed once into a compact index file. Loading the index maps
+// it and reads nothing else, so it is cheap at every start:
+//   header | packages (sorted by name hash) | intervals | advisories | strings
+// Packages are keyed by ecosystem and name. Each package points at a run of
+// affected version intervals, already turned into VersionKeys, and each
+// interval at the advisory it came from. The file is in native byte order;
+// an index written on another architecture is simply rebuilt.
+//
+// npm, PyPI and Maven advisories are indexed (Maven ones also match gradle
+// nodes). SEMVER and ECOSYSTEM ranges and explicit version lists are used;
+// GIT ranges are not. After open() the object is immutable and can be shared
+// between threads.
+class AdvisoryDb {
+public:
+    enum class Severity : quint8 { Unknown, Low, Moderate, High, Critical };
+
+    struct Advisory {
+        QString id;      // GHSA-..., PYSEC-..., ...
+        QString summary;
+        Severity severity = Severity::Unknown;
+    };
+
+    AdvisoryDb() = default;
+    ~AdvisoryDb();
+    AdvisoryDb(const AdvisoryDb&) = delete;
+    AdvisoryDb& operator=(const AdvisoryDb&) = delete;
+
+    // Parses the dump at `sourcePath` (in parallel) and writes the index.
+    static bool build(const QString& sourcePath, const QString& indexPath, QString* err);
+
+    // Maps an index written by build().
+    bool open(const QString& indexPath, QString* err);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Opens the cached index for `sourcePath`, building it first when it is
+    // missing, stale (the dump changed) or `rebuild` is set.
+    bool load(const QString& sourcePath, bool rebuild, QString* err);
+
+    // Where load() keeps the index for a dump: the user cache directory.
+    static QString defaultIndexPath(const QString& sourcePath);
+
+    // Advisories affecting `version` of package `name`. A concrete version is
+    // checked as is. A requirement ("^1.2.0", ">=2.1,<3") is checked at the
+    // lowest version it admits, which is what a fresh install of the minimum
+    // would get; requirements without a lower bound ("*", "<3") never match,
+    // since any answer would be a guess.
+    QVector<int> match(const QString& kind, const QString& name, const QString& version) const;
+
+    // Sets statuses[i] to Vulnerable for every node with a match, in one
+    // parallel pass. `statuses` is per node id. Returns the number of nodes
+    // marked.
+    int markVulnerable(const QVector<Node>& nodes, QVector<NodeStatus>* statuses) const;
+
+    Advisory advisory(int index) const;
+    int advisoryCount() const;
+    int packageCount() const;
+    QString sourcePath() const { return m_sourcePath; }
+
+    static QString severityToString(Severity s);
+
+private:
+    // Index into the package table, or -1.
+    int findPackage(const QByteArray& key) const;
+    QString string(quint32 offset, quint32 length) const;
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QString m_sourcePath;
+};
@@ -0,0 +1,355 @@
+﻿#include "ClusterModel.h"
+
+#include <QQueue>
+
+#include <algorithm>
+
+#include "util/MemoryReport.h"
+
+static int statusSeverity(NodeStatus s)
+{
+    switch (s) {
+    case NodeStatus::Stable: return 0;
+    case NodeStatus::Outdated: return 1;
+    case NodeStatus::Deprecated: return 2;
+    case NodeStatus::Conflict: return 3;
+    case NodeStatus::Vulnerable: return 4;
+    }
+    return 0;
+}
+
+static bool isModuleKind(const QString& kind)
+{
+    return kind.endsWith(":module");
+}
+
+static QString rangeLabel(const QString& first, const QString& last)
+{
+    const auto shorten = [](const QString& s) { return s.size() > 20 ? s.left(18) + ".." : s; };
+    if (first == last)
+        return shorten(first);
+    return shorten(first) + " - " + shorten(last);
+}
+
+void ClusterModel::clear()
+{
+    m_clusters.clear();
+    m_expanded.clear();
+    m_nodeCluster.clear();
+    m_dirClusters.clear();
+    m_ecosystemClusters.clear();
+}
+
+int ClusterModel::addCluster(int parent, Level level, const QString& label)
+{
+    Cluster c;
+    c.id = m_clusters.size();
+    c.parent = parent;
+    c.level = level;
+    c.label = label;
+    m_clusters.push_back(c);
+    m_expanded.push_back(false);
+    if (parent >= 0)
+        m_clusters[parent].children.push_back(c.id);
+    return c.id;
+}
+
+int ClusterModel::directoryCluster(const QString& dir)
+{
+    if (dir.isEmpty())
+        return 0;
+    auto it = m_dirClusters.constFind(dir);
+    if (it != m_dirClusters.constEnd())
+        return it.value();
+
+    const int parent = directoryCluster(dir.section('/', 0, -2));
+    const int id = addCluster(parent, Level::Directory, dir.section('/', -1));
+    m_dirClusters.insert(dir, id);
+    return id;
+}
+
+int ClusterModel::ecosystemCluster(const QString& kind)
+{
+    auto it = m_ecosystemClusters.constFind(kind);
+    if (it != m_ecosystemClusters.constEnd())
+        return it.value();
+
+    const int id = addCluster(0, Level::Ecosystem, kind.isEmpty() ? QString("other") : kind);
+    m_ecosystemClusters.insert(kind, id);
+    return id;
+}
+
+void ClusterModel::build(const GraphModel& model)
+{
+    clear();
+
+    const QVector<Node>& nodes = model.nodes();
+    m_nodeCluster.fill(-1, nodes.size());
+
+    // Root: the repo. Repo pseudo nodes are its direct members.
+    QString repoLabel = "repo";
+    for (const Node& n : nodes) {
+        if (n.kind == "repo") {
+            repoLabel = n.name;
+            break;
+        }
+    }
+    addCluster(-1, Level::Repo, repoLabel);
+    m_expanded[0] = true;
+
+    // Modules, nested under their directories.
+    for (const Node& n : nodes) {
+        if (n.kind == "repo") {
+            m_nodeCluster[n.id] = 0;
+            m_clusters[0].members.push_back(n.id);
+        } else if (isModuleKind(n.kind)) {
+            const int dir = directoryCluster(n.name.section('/', 0, -2));
+            const int c = addCluster(dir, Level::Module, n.name.section('/', -1));
+            m_nodeCluster[n.id] = c;
+            m_clusters[c].members.push_back(n.id);
+        }
+    }
+
+    // Packages used by exactly one module live in that module's cluster;
+    // shared ones go to the ecosystem cluster of their kind.
+    for (const Node& n : nodes) {
+        if (m_nodeCluster[n.id] >= 0)
+            continue;
+
+        int owner = -1;
+        bool shared = false;
+        for (int from : model.incoming(n.id)) {
+            const Node* src = model.nodeById(from);
+            if (!src || !isModuleKind(src->kind))
+                continue;
+            const int c = m_nodeCluster[from];
+            if (owner < 0) {
+                owner = c;
+            } else if (owner != c) {
+                shared = true;
+                break;
+            }
+        }
+
+        const int c = (owner >= 0 && !shared) ? owner : ecosystemCluster(n.kind);
+        m_nodeCluster[n.id] = c;
+        m_clusters[c].members.push_back(n.id);
+    }
+
+    // Groups are appended, so they too get larger ids than their parents.
+    const int builtClusters = m_clusters.size();
+    for (int c = 0; c < builtClusters; c++) {
+        if (m_clusters[c].members.size() > kMaxMembers)
+            splitMembers(c, nodes);
+    }
+
+    // Children always have larger ids than their parents, so a reverse sweep
+    // folds sizes and statuses bottom-up.
+    for (Cluster& c : m_clusters) {
+        c.size = c.members.size();
+        for (int id : c.members) {
+            if (statusSeverity(nodes[id].status) > statusSeverity(c.status))
+                c.status = nodes[id].status;
+        }
+    }
+    for (int i = m_clusters.size() - 1; i > 0; i--) {
+        Cluster& parent = m_clusters[m_clusters[i].parent];
+        parent.size += m_clusters[i].size;
+        if (statusSeverity(m_clusters[i].status) > statusSeverity(parent.status))
+            parent.status = m_clusters[i].status;
+    }
+}
+
+void ClusterModel::splitMembers(int clusterId, const QVector<Node>& nodes)
+{
+    // Repo and manifest pseudo nodes stay where they are; packages are sorted
+    // by name so each group covers a contiguous, labelled name range.
+    QVector<int> ids;
+    QVector<int> pinned;
+    for (int id : m_clusters[clusterId].members)
+        (nodes[id].kind == "repo" || isModuleKind(nodes[id].kind) ? pinned : ids).push_back(id);
+    if (ids.size() <= kMaxMembers)
+        return;
+    m_clusters[clusterId].members = pinned;
+
+    std::sort(ids.begin(), ids.end(), [&nodes](int a, int b) {
+        const int c = QString::compare(nodes[a].name, nodes[b].name, Qt::CaseInsensitive);
+        return c != 0 ? c < 0 : a < b;
+    });
+
+    int span = kMaxMembers;
+    while ((ids.size() + span - 1) / span > kMaxMembers)
+        span *= kMaxMembers;
+    addGroups(clusterId, ids, 0, ids.size(), span, nodes);
+}
+
+void ClusterModel::addGroups(int parent, const QVector<int>& ids, int begin, int end, int span,
+                             const QVector<Node>& nodes)
+{
+    // Even out the group sizes rather than leaving a short last group.
+    const int count = end - begin;
+    const int groups = (count + span - 1) / span;
+    const int per = (count + groups - 1) / groups;
+
+    for (int b = begin; b < end; b += per) {
+        const int e = qMin(end, b + per);
+        const int g = addCluster(parent, Level::Group, rangeLabel(nodes[ids[b]].name, nodes[ids[e - 1]].name));
+        if (e - b > kMaxMembers) {
+            addGroups(g, ids, b, e, span / kMaxMembers, nodes);
+            continue;
+        }
+        for (int k = b; k < e; k++) {
+            m_nodeCluster[ids[k]] = g;
+            m_clusters[g].members.push_back(ids[k]);
+        }
+    }
+}
+
+const ClusterModel::Cluster* ClusterModel::cluster(int id) const
+{
+    if (id < 0 || id >= m_clusters.size())
+        return nullptr;
+    return &m_clusters[id];
+}
+
+int ClusterModel::clusterOfNode(int nodeId) const
+{
+    if (nodeId < 0 || nodeId >= m_nodeCluster.size())
+        return -1;
+    return m_nodeCluster[nodeId];
+}
+
+QString ClusterModel::levelToString(Level level)
+{
+    switch (level) {
+    case Level::Repo: return "repo";
+    case Level::Directory: return "directory";
+    case Level::Module: return "module";
+    case Level::Ecosystem: return "ecosystem";
+    case Level::Group: return "group";
+    }
+    return "repo";
+}
+
+bool ClusterModel::isExpanded(int clusterId) const
+{
+    return clusterId >= 0 && clusterId < m_expanded.size() && m_expanded[clusterId];
+}
+
+void ClusterModel::expand(int clusterId)
+{
+    if (clusterId >= 0 && clusterId < m_expanded.size())
+        m_expanded[clusterId] = true;
+}
+
+void ClusterModel::collapse(int clusterId)
+{
+    // The root stays expanded; collapsing it would leave a single dot.
+    if (clusterId > 0 && clusterId < m_expanded.size())
+        m_expanded[clusterId] = false;
+}
+
+void ClusterModel::expandAll()
+{
+    m_expanded.fill(true);
+}
+
+void ClusterModel::reveal(int nodeId)
+{
+    for (int c = clusterOfNode(nodeId); c >= 0; c = m_clusters[c].parent)
+        m_expanded[c] = true;
+}
+
+void ClusterModel::collapseToBudget(int budget)
+{
+    if (m_clusters.isEmpty())
+        return;
+
+    m_expanded.fill(false);
+    m_expanded[0] = true;
+
+    int visible = m_clusters[0].members.size() + m_clusters[0].children.size();
+    QQueue<int> q;
+    for (int child : m_clusters[0].children)
+        q.enqueue(child);
+
+    while (!q.isEmpty()) {
+        const int c = q.dequeue();
+        const Cluster& cl = m_clusters[c];
+        const int delta = cl.members.size() + cl.children.size() - 1;
+        if (visible + delta > budget)
+            continue;
+        visible += delta;
+        m_expanded[c] = true;
+        for (int child : cl.children)
+            q.enqueue(child);
+    }
+}
+
+ClusterModel::VisibleGraph ClusterModel::visibleGraph(const GraphModel& model) const
+{
+    VisibleGraph g;
+    const QVector<Node>& nodes = model.nodes();
+
+    // repCluster[c]: the collapsed cluster that represents c on screen,
+    // or -1 if c and all its ancestors are expanded. Parents precede children.
+    QVector<int> repCluster(m_clusters.size(), -1);
+    QVector<int> clusterIndex(m_clusters.size(), -1);
+    for (const Cluster& c : m_clusters) {
+        if (c.parent >= 0 && repCluster[c.parent] >= 0)
+            repCluster[c.id] = repCluster[c.parent];
+        else if (!m_expanded[c.id])
+            repCluster[c.id] = c.id;
+
+        if (repCluster[c.id] == c.id) {
+            clusterIndex[c.id] = g.nodes.size();
+            g.nodes.push_back({supernodeId(c.id), c.id});
+        }
+    }
+
+    g.nodeToVisible.resize(nodes.size());
+    for (const Node& n : nodes) {
+        const int c = clusterOfNode(n.id);
+        const int rep = c >= 0 ? repCluster[c] : -1;
+        if (rep >= 0) {
+            g.nodeToVisible[n.id] = clusterIndex[rep];
+        } else {
+            g.nodeToVisible[n.id] = g.nodes.size();
+            g.nodes.push_back({n.id, -1});
+        }
+    }
+
+    // Aggregate model edges between visible endpoints; edges inside one
+    // supernode disappear.
+    QHash<quint64, int> weights;
+    for (const Edge& e : model.edges()) {
+        if (e.from < 0 || e.to < 0 || e.from >= nodes.size() || e.to >= nodes.size())
+            continue;
+        const int a = g.nodeToVisible[e.from];
+        const int b = g.nodeToVisible[e.to];
+        if (a == b)
+            continue;
+        weights[(quint64(quint32(a)) << 32) | quint32(b)]++;
+    }
+
+    g.edges.reserve(weights.size());
+    for (auto it = weights.constBegin(); it != weights.constEnd(); ++it)
+        g.edges.push_back({int(it.key() >> 32), int(it.key() & 0xffffffffu), it.value()});
+    std::sort(g.edges.begin(), g.edges.end(), [](const VisibleEdge& x, const VisibleEdge& y) {
+        return x.from != y.from ? x.from < y.from : x.to < y.to;
+    });
+
+    return g;
+}
+
+qint64 ClusterModel::memoryBytes() const
+{
+    qint64 bytes = MemoryReport::bytesOf(m_clusters) + MemoryReport::bytesOf(m_expanded) +
+                   MemoryReport::bytesOf(m_nodeCluster) + MemoryReport::bytesOf(m_dirClusters) +
+                   MemoryReport::bytesOf(m_ecosystemClusters);
+    for (const Cluster& c : m_clusters)
+        bytes += MemoryReport::bytesOf(c.label) + MemoryReport::bytesOf(c.children) + MemoryReport::bytesOf(c.members);
+    for (auto it = m_dirClusters.cbegin(); it != m_dirClusters.cend(); ++it)
+        bytes += MemoryReport::bytesOf(it.key());
+    return bytes;
+}
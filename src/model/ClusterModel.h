@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "model/GraphModel.h"
+
+// Hierarchical grouping of a GraphModel for display:
+//   repo > directory > module (manifest pseudo node + packages only it uses)
+//   repo > ecosystem (packages shared between modules, one cluster per kind)
+// Clusters with more than kMaxMembers packages put them into name-range groups
+// (nested if need be), so expanding any one cluster adds a bounded frontier.
+// Each cluster is either expanded (its children are shown) or collapsed into a
+// single supernode. The set of visible supernodes and nodes is the frontier.
+class ClusterModel {
+public:
+    enum class Level {
+        Repo,
+        Directory,
+        Module,
+        Ecosystem,
+        Group
+    };
+
+    static constexpr int kMaxMembers = 200;
+
+    struct Cluster {
+        int id = -1;
+        int parent = -1;
+        Level level = Level::Repo;
+        QString label;
+        QVector<int> children; // child cluster ids
+        QVector<int> members;  // node ids placed directly in this cluster
+        int size = 0;          // nodes in the whole subtree
+        NodeStatus status = NodeStatus::Stable; // worst status in the subtree
+    };
+
+    struct VisibleNode {
+        int id = -1;      // node id, or supernodeId(cluster) for collapsed clusters
+        int cluster = -1; // cluster id for supernodes, -1 for plain nodes
+    };
+
+    struct VisibleEdge {
+        int from = -1; // indices into VisibleGraph::nodes
+        int to = -1;
+        int weight = 0; // number of model edges aggregated into this one
+    };
+
+    struct VisibleGraph {
+        QVector<VisibleNode> nodes;
+        QVector<VisibleEdge> edges;
+        QVector<int> nodeToVisible; // model node id -> index into nodes
+    };
+
+    void build(const GraphModel& model);
+    void clear();
+
+    const QVector<Cluster>& clusters() const { return m_clusters; }
+    const Cluster* cluster(int id) const;
+    int clusterOfNode(int nodeId) const;
+
+    // Supernode ids are negative so they never collide with node ids (or -1).
+    static int supernodeId(int clusterId) { return -2 - clusterId; }
+    static int clusterFromSupernodeId(int id) { return id <= -2 ? -2 - id : -1; }
+    static QString levelToString(Level level);
+
+    bool isExpanded(int clusterId) const;
+    void expand(int clusterId);
+    void collapse(int clusterId);
+    void expandAll();
+    // Expands ancestors of the node's cluster so the node itself is visible.
+    void reveal(int nodeId);
+    // Collapses everything below the root, then expands clusters breadth-first
+    // as long as the frontier stays within `budget` visible nodes.
+    void collapseToBudget(int budget);
+
+    VisibleGraph visibleGraph(const GraphModel& model) const;
+
+    // Estimated heap bytes of the hierarchy (not of a VisibleGraph).
+    qint64 memoryBytes() const;
+
+private:
+    int addCluster(int parent, Level level, const QString& label);
+    int directoryCluster(const QString& dir);
+    int ecosystemCluster(const QString& kind);
+    void splitMembers(int clusterId, const QVector<Node>& nodes);
+    void addGroups(int parent, const QVector<int>& ids, int begin, int end, int span, const QVector<Node>& nodes);
+
+    QVector<Cluster> m_clusters;
+    QVector<bool> m_expanded;
+    QVector<int> m_nodeCluster; // node id -> innermost cluster
+    QHash<QString, int> m_dirClusters;
+    QHash<QString, int> m_ecosystemClusters;
+};
@@ -0,0 +1,99 @@
+﻿#include "Condensation.h"
+
+#include "util/MemoryReport.h"
+
+Condensation Condensation::compute(const CsrGraph& graph)
+{
+    Condensation c;
+    const int n = graph.nodeCount;
+    c.m_component.fill(-1, n);
+    c.m_members.reserve(n);
+    c.m_offsets.push_back(0);
+
+    QVector<int> index(n, -1);
+    QVector<int> low(n, 0);
+    QVector<int> cursor(n, 0);
+    QVector<quint8> onStack(n, 0);
+    QVector<int> stack;
+    QVector<int> calls; // explicit DFS call stack
+    int counter = 0;
+
+    auto visit = [&](int v) {
+        index[v] = low[v] = counter++;
+        cursor[v] = graph.outOffsets[v];
+        stack.push_back(v);
+        onStack[v] = 1;
+        calls.push_back(v);
+    };
+
+    for (int s = 0; s < n; s++) {
+        if (index[s] >= 0)
+            continue;
+        visit(s);
+
+        while (!calls.isEmpty()) {
+            const int v = calls.last();
+            if (cursor[v] < graph.outOffsets[v + 1]) {
+                const int w = graph.outTargets[cursor[v]++];
+                if (index[w] < 0)
+                    visit(w);
+                else if (onStack[w])
+                    low[v] = qMin(low[v], index[w]);
+                continue;
+            }
+
+            calls.pop_back();
+            if (low[v] == index[v]) {
+                // v is the root of a component; it is complete once popped.
+                const int comp = c.m_offsets.size() - 1;
+                int w;
+                do {
+                    w = stack.takeLast();
+                    onStack[w] = 0;
+                    c.m_component[w] = comp;
+                    c.m_members.push_back(w);
+                } while (w != v);
+                c.m_offsets.push_back(c.m_members.size());
+            }
+            if (!calls.isEmpty()) {
+                const int u = calls.last();
+                low[u] = qMin(low[u], low[v]);
+            }
+        }
+    }
+
+    // Contract: one edge per distinct pair of components.
+    const int count = c.componentCount();
+    c.m_selfLoop.fill(0, count);
+    QVector<int> seenFrom(count, -1);
+    QVector<Edge> dagEdges;
+    for (int comp = 0; comp < count; comp++) {
+        for (const int* m = c.membersBegin(comp); m != c.membersEnd(comp); ++m) {
+            for (const int* t = graph.outBegin(*m); t != graph.outEnd(*m); ++t) {
+                const int d = c.m_component[*t];
+                if (d == comp) {
+                    if (*t == *m)
+                        c.m_selfLoop[comp] = 1;
+                    continue;
+                }
+                if (seenFrom[d] == comp)
+                    continue;
+                seenFrom[d] = comp;
+                dagEdges.push_back({comp, d});
+            }
+        }
+    }
+    c.m_dag = CsrGraph::fromEdges(count, dagEdges);
+    return c;
+}
+
+QVector<int> Condensation::members(int c) const
+{
+    return QVector<int>(membersBegin(c), membersEnd(c));
+}
+
+qint64 Condensation::memoryBytes() const
+{
+    return MemoryReport::bytesOf(m_component) + MemoryReport::bytesOf(m_offsets) +
+           MemoryReport::bytesOf(m_members) + MemoryReport::bytesOf(m_selfLoop) + m_dag.memoryBytes();
+}
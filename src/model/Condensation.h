@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <QVector>
+
+#include "model/CsrGraph.h"
+
+// Strongly connected components of a graph and the DAG obtained by
+// contracting each of them to a single vertex.
+class Condensation {
+public:
+    // Iterative Tarjan: linear time, no recursion.
+    static Condensation compute(const CsrGraph& graph);
+
+    int componentCount() const { return m_offsets.isEmpty() ? 0 : m_offsets.size() - 1; }
+    int componentOf(int node) const { return m_component[node]; }
+    int componentSize(int c) const { return m_offsets[c + 1] - m_offsets[c]; }
+    const int* membersBegin(int c) const { return m_members.constData() + m_offsets[c]; }
+    const int* membersEnd(int c) const { return m_members.constData() + m_offsets[c + 1]; }
+    QVector<int> members(int c) const;
+
+    // True for components that contain a cycle (more than one node, or a self loop).
+    bool isCyclic(int c) const { return componentSize(c) > 1 || m_selfLoop[c]; }
+
+    // Edges between distinct components, deduplicated. Component ids are in
+    // reverse topological order: every DAG edge goes from a higher id to a lower one.
+    const CsrGraph& dag() const { return m_dag; }
+
+    qint64 memoryBytes() const;
+
+private:
+    QVector<int> m_component; // node -> component
+    QVector<int> m_offsets;   // component -> range in m_members
+    QVector<int> m_members;
+    QVector<quint8> m_selfLoop;
+    CsrGraph m_dag;
+};
@@ -0,0 +1,45 @@
+﻿#include "CsrGraph.h"
+
+#include "util/MemoryReport.h"
+
+CsrGraph CsrGraph::fromEdges(int nodeCount, const QVector<Edge>& edges)
+{
+    CsrGraph g;
+    g.nodeCount = nodeCount;
+    g.outOffsets.fill(0, nodeCount + 1);
+    g.inOffsets.fill(0, nodeCount + 1);
+
+    auto valid = [nodeCount](const Edge& e) {
+        return e.from >= 0 && e.to >= 0 && e.from < nodeCount && e.to < nodeCount;
+    };
+
+    // Two passes: count degrees, then fill.
+    for (const Edge& e : edges) {
+        if (!valid(e))
+            continue;
+        g.outOffsets[e.from + 1]++;
+        g.inOffsets[e.to + 1]++;
+    }
+    for (int v = 0; v < nodeCount; v++) {
+        g.outOffsets[v + 1] += g.outOffsets[v];
+        g.inOffsets[v + 1] += g.inOffsets[v];
+    }
+
+    g.outTargets.resize(g.outOffsets[nodeCount]);
+    g.inTargets.resize(g.inOffsets[nodeCount]);
+    QVector<int> outFill = g.outOffsets;
+    QVector<int> inFill = g.inOffsets;
+    for (const Edge& e : edges) {
+        if (!valid(e))
+            continue;
+        g.outTargets[outFill[e.from]++] = e.to;
+        g.inTargets[inFill[e.to]++] = e.from;
+    }
+    return g;
+}
+
+qint64 CsrGraph::memoryBytes() const
+{
+    return MemoryReport::bytesOf(outOffsets) + MemoryReport::bytesOf(outTargets) +
+           MemoryReport::bytesOf(inOffsets) + MemoryReport::bytesOf(inTargets);
+}
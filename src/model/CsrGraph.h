@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include <QVector>
+
+#include "model/Edge.h"
+
+// Compressed adjacency (both directions) over dense node ids 0..nodeCount-1.
+// Neighbours of v are targets[offsets[v] .. offsets[v + 1]).
+struct CsrGraph {
+    int nodeCount = 0;
+    QVector<int> outOffsets;
+    QVector<int> outTargets;
+    QVector<int> inOffsets;
+    QVector<int> inTargets;
+
+    // Edges with endpoints outside [0, nodeCount) are dropped.
+    static CsrGraph fromEdges(int nodeCount, const QVector<Edge>& edges);
+
+    // Estimated heap bytes (see MemoryReport).
+    qint64 memoryBytes() const;
+
+    int outDegree(int v) const { return outOffsets[v + 1] - outOffsets[v]; }
+    int inDegree(int v) const { return inOffsets[v + 1] - inOffsets[v]; }
+    const int* outBegin(int v) const { return outTargets.constData() + outOffsets[v]; }
+    const int* outEnd(int v) const { return outTargets.constData() + outOffsets[v + 1]; }
+    const int* inBegin(int v) const { return inTargets.constData() + inOffsets[v]; }
+    const int* inEnd(int v) const { return inTargets.constData() + inOffsets[v + 1]; }
+};
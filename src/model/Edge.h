@@ -1,6 +1,11 @@
 ﻿#pragma once
 
+#include <QString>
+
 struct Edge {
     int from = -1;
     int to = -1;
+    // Version requirement `from` declares on `to`, as written in the manifest
+    // ("^1.2.0", ">=2.0", "[1.0,2.0)"). Empty when there is none.
+    QString constraint;
 };
@@ -0,0 +1,188 @@
+﻿#include "GraphDiff.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+
+static QString nodeKey(const Node& n)
+{
+    return n.kind + ":" + n.name;
+}
+
+GraphDiff GraphDiff::compute(const GraphModel::Data& before, const GraphModel::Data& after)
+{
+    GraphDiff d;
+    GraphModel::Data& merged = d.m_merged;
+    merged = after;
+
+    QHash<QString, int> beforeByKey;
+    beforeByKey.reserve(before.nodes.size());
+    for (int i = 0; i < before.nodes.size(); i++)
+        beforeByKey.insert(nodeKey(before.nodes[i]), i);
+
+    // Nodes of `after` keep their ids; matched ones map their old id onto it.
+    QVector<int> beforeToMerged(before.nodes.size(), -1);
+    for (const Node& n : after.nodes) {
+        auto it = beforeByKey.constFind(nodeKey(n));
+        if (it == beforeByKey.constEnd()) {
+            d.m_nodeDeltas.push_back({n.id, Change::Added, QString()});
+            continue;
+        }
+        beforeToMerged[it.value()] = n.id;
+        const QString& oldVersion = before.nodes[it.value()].version;
+        if (oldVersion != n.version)
+            d.m_nodeDeltas.push_back({n.id, Change::Changed, oldVersion});
+    }
+
+    for (int i = 0; i < before.nodes.size(); i++) {
+        if (beforeToMerged[i] >= 0)
+            continue;
+        Node n = before.nodes[i];
+        n.id = merged.nodes.size();
+        merged.nodes.push_back(n);
+        merged.keyToId.insert(nodeKey(n), n.id);
+        beforeToMerged[i] = n.id;
+        d.m_nodeDeltas.push_back({n.id, Change::Removed, n.version});
+    }
+
+    // Edges, compared in merged id space.
+    QHash<quint64, int> afterEdges;
+    afterEdges.reserve(after.edges.size());
+    for (int i = 0; i < after.edges.size(); i++)
+        afterEdges.insert(edgeKey(after.edges[i].from, after.edges[i].to), i);
+
+    QVector<bool> matched(after.edges.size(), false);
+    for (const Edge& e : before.edges) {
+        const int from = beforeToMerged.value(e.from, -1);
+        const int to = beforeToMerged.value(e.to, -1);
+        if (from < 0 || to < 0)
+            continue;
+
+        auto it = afterEdges.constFind(edgeKey(from, to));
+        if (it != afterEdges.constEnd()) {
+            matched[it.value()] = true;
+            const QString& now = after.edges[it.value()].constraint;
+            if (now != e.constraint)
+                d.m_edgeDeltas.push_back({from, to, Change::Changed, e.constraint, now});
+            continue;
+        }
+
+        merged.edges.push_back({from, to, e.constraint});
+        merged.out[from].insert(to);
+        merged.in[to].insert(from);
+        d.m_edgeDeltas.push_back({from, to, Change::Removed, e.constraint, QString()});
+    }
+    for (int i = 0; i < after.edges.size(); i++) {
+        const Edge& e = after.edges[i];
+        if (!matched[i])
+            d.m_edgeDeltas.push_back({e.from, e.to, Change::Added, QString(), e.constraint});
+    }
+
+    // Indexes built for `after` do not cover what was appended.
+    if (merged.nodes.size() != after.nodes.size() || merged.edges.size() != after.edges.size()) {
+        merged.reachability.reset();
+        merged.search.reset();
+    }
+
+    d.m_nodeChange.fill(Change::None, merged.nodes.size());
+    for (const NodeDelta& nd : d.m_nodeDeltas)
+        d.m_nodeChange[nd.id] = nd.change;
+    for (const EdgeDelta& ed : d.m_edgeDeltas)
+        d.m_edgeChange.insert(edgeKey(ed.from, ed.to), ed.change);
+
+    return d;
+}
+
+GraphDiff::Change GraphDiff::nodeChange(int mergedId) const
+{
+    return m_nodeChange.value(mergedId, Change::None);
+}
+
+GraphDiff::Change GraphDiff::edgeChange(int from, int to) const
+{
+    return m_edgeChange.value(edgeKey(from, to), Change::None);
+}
+
+int GraphDiff::count(Change change) const
+{
+    int n = 0;
+    for (const NodeDelta& nd : m_nodeDeltas) {
+        if (nd.change == change)
+            n++;
+    }
+    return n;
+}
+
+QByteArray GraphDiff::toJson() const
+{
+    return QJsonDocument(toJsonObject()).toJson(QJsonDocument::Compact);
+}
+
+QJsonObject GraphDiff::toJsonObject() const
+{
+    const QVector<Node>& nodes = m_merged.nodes;
+
+    QJsonArray addedNodes;
+    QJsonArray removedNodes;
+    QJsonArray changedNodes;
+    for (const NodeDelta& nd : m_nodeDeltas) {
+        const Node& n = nodes[nd.id];
+        QJsonObject o;
+        o["key"] = nodeKey(n);
+        switch (nd.change) {
+        case Change::Added:
+            o["version"] = n.version;
+            addedNodes.push_back(o);
+            break;
+        case Change::Removed:
+            o["version"] = nd.oldVersion;
+            removedNodes.push_back(o);
+            break;
+        case Change::Changed:
+            o["from"] = nd.oldVersion;
+            o["to"] = n.version;
+            changedNodes.push_back(o);
+            break;
+        case Change::None:
+            break;
+        }
+    }
+
+    QJsonArray addedEdges;
+    QJsonArray removedEdges;
+    QJsonArray changedEdges;
+    for (const EdgeDelta& ed : m_edgeDeltas) {
+        QJsonArray a;
+        a.push_back(nodeKey(nodes[ed.from]));
+        a.push_back(nodeKey(nodes[ed.to]));
+        switch (ed.change) {
+        case Change::Added:
+            addedEdges.push_back(a);
+            break;
+        case Change::Removed:
+            removedEdges.push_back(a);
+            break;
+        case Change::Changed:
+            a.push_back(ed.oldConstraint);
+            a.push_back(ed.newConstraint);
+            changedEdges.push_back(a);
+            break;
+        case Change::None:
+            break;
+        }
+    }
+
+    QJsonObject nodeDelta;
+    nodeDelta["added"] = addedNodes;
+    nodeDelta["removed"] = removedNodes;
+    nodeDelta["changed"] = changedNodes;
+
+    QJsonObject edgeDelta;
+    edgeDelta["added"] = addedEdges;
+    edgeDelta["removed"] = removedEdges;
+    edgeDelta["changed"] = changedEdges;
+
+    QJsonObject root;
+    root["nodes"] = nodeDelta;
+    root["edges"] = edgeDelta;
+    return root;
+}
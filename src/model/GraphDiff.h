@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QVector>
+
+#include "model/GraphModel.h"
+
+// Difference between two graphs (two scans, or a scan and a JSON snapshot).
+// Nodes are matched by their "kind:name" key, never by id, and edges by the
+// keys of their endpoints; both passes are one hash lookup per element.
+//
+// The result is expressed on a merged graph: every node and edge of `after`
+// with its id unchanged, followed by what only exists in `before`. The view
+// shows the merged graph with an overlay, so removed parts stay visible.
+class GraphDiff {
+public:
+    enum class Change : quint8 {
+        None,
+        Added,
+        Removed,
+        Changed // node: version differs; edge: requirement differs
+    };
+
+    struct NodeDelta {
+        int id = -1; // in merged()
+        Change change = Change::None;
+        QString oldVersion;
+    };
+
+    struct EdgeDelta {
+        int from = -1; // in merged()
+        int to = -1;
+        Change change = Change::None;
+        QString oldConstraint;
+        QString newConstraint;
+    };
+
+    static GraphDiff compute(const GraphModel::Data& before, const GraphModel::Data& after);
+
+    const GraphModel::Data& merged() const { return m_merged; }
+    const QVector<NodeDelta>& nodeDeltas() const { return m_nodeDeltas; }
+    const QVector<EdgeDelta>& edgeDeltas() const { return m_edgeDeltas; }
+    bool isEmpty() const { return m_nodeDeltas.isEmpty() && m_edgeDeltas.isEmpty(); }
+
+    Change nodeChange(int mergedId) const;
+    Change edgeChange(int from, int to) const;
+    int count(Change change) const; // nodes with that change
+
+    // Only what changed, keyed by "kind:name":
+    //   {"nodes":{"added":[...],"removed":[...],"changed":[...]},
+    //    "edges":{"added":[[from,to],...],"removed":[...],"changed":[...]}}
+    QByteArray toJson() const;
+    QJsonObject toJsonObject() const;
+
+private:
+    static quint64 edgeKey(int from, int to) { return (quint64(quint32(from)) << 32) | quint32(to); }
+
+    GraphModel::Data m_merged;
+    QVector<NodeDelta> m_nodeDeltas;
+    QVector<EdgeDelta> m_edgeDeltas;
+    QVector<Change> m_nodeChange;        // merged id -> change
+    QHash<quint64, Change> m_edgeChange; // changed edges only
+};
@@ -4,6 +4,24 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 
+#include <algorithm>
+#include <utility>
+
+#include "model/PathQuery.h"
+#include "model/ReachabilityIndex.h"
+#include "model/TrigramIndex.h"
+#include "model/WhatIfOverlay.h"
+#include "util/MemoryReport.h"
+
+static std::shared_ptr<GraphModel::EdgeIndex> buildEdgeIndex(const QVector<Edge>& edges)
+{
+    auto index = std::make_shared<GraphModel::EdgeIndex>();
+    index->reserve(edges.size());
+    for (int i = 0; i < edges.size(); i++)
+        index->insert(GraphModel::edgeKey(edges[i].from, edges[i].to), i);
+    return index;
+}
+
 GraphModel::GraphModel(QObject* parent) : QObject(parent) {}
 
 void GraphModel::clear()
@@ -13,6 +31,12 @@ void GraphModel::clear()
     m_keyToId.clear();
     m_out.clear();
     m_in.clear();
+    m_reachability.reset();
+    m_search.reset();
+    m_searchWritable.reset();
+    m_edgeIndex.reset();
+    m_edgeIndexWritable.reset();
+    m_topologyRevision++;
     emit changed();
 }
 
@@ -25,6 +49,14 @@ void GraphModel::replaceFrom(const GraphModel& other)
     m_keyToId = other.m_keyToId;
     m_out = other.m_out;
     m_in = other.m_in;
+    m_reachability = other.m_reachability;
+    m_search = other.m_search;
+    m_searchWritable.reset();
+    other.m_searchWritable.reset();
+    m_edgeIndex = other.m_edgeIndex;
+    m_edgeIndexWritable.reset();
+    other.m_edgeIndexWritable.reset();
+    m_topologyRevision++;
     emit changed();
 }
 
@@ -35,6 +67,28 @@ void GraphModel::replaceFromData(const Data& data)
     m_keyToId = data.keyToId;
     m_out = data.out;
     m_in = data.in;
+    m_reachability = data.reachability;
+    m_search = data.search;
+    m_searchWritable.reset();
+    m_edgeIndex.reset();
+    m_edgeIndexWritable.reset();
+    m_topologyRevision++;
+    emit changed();
+}
+
+void GraphModel::adopt(Data&& data)
+{
+    m_nodes = std::move(data.nodes);
+    m_edges = std::move(data.edges);
+    m_keyToId = std::move(data.keyToId);
+    m_out = std::move(data.out);
+    m_in = std::move(data.in);
+    m_reachability = std::move(data.reachability);
+    m_search = std::move(data.search);
+    m_searchWritable.reset();
+    m_edgeIndex.reset();
+    m_edgeIndexWritable.reset();
+    m_topologyRevision++;
     emit changed();
 }
 
@@ -46,6 +100,26 @@ GraphModel::Data GraphModel::toData() const
     d.keyToId = m_keyToId;
     d.out = m_out;
     d.in = m_in;
+    d.reachability = m_reachability;
+    d.search = m_search;
+    m_searchWritable.reset();
+    return d;
+}
+
+GraphModel::Data GraphModel::takeData()
+{
+    Data d;
+    d.nodes = std::exchange(m_nodes, {});
+    d.edges = std::exchange(m_edges, {});
+    d.keyToId = std::exchange(m_keyToId, {});
+    d.out = std::exchange(m_out, {});
+    d.in = std::exchange(m_in, {});
+    d.reachability = std::exchange(m_reachability, nullptr);
+    d.search = std::exchange(m_search, nullptr);
+    m_searchWritable.reset();
+    m_edgeIndex.reset();
+    m_edgeIndexWritable.reset();
+    m_topologyRevision++;
     return d;
 }
 
@@ -62,30 +136,39 @@ int GraphModel::ensureNodeId(const QString& name, const QString& kind)
     n.kind = kind.trimmed();
     m_nodes.push_back(n);
     m_keyToId.insert(key, n.id);
+    m_reachability.reset();
+    m_topologyRevision++;
+    reindexNode(n.id);
     return n.id;
 }
 
+void GraphModel::reindexNode(int id)
+{
+    if (!m_search)
+        return;
+    // Handed out since the last edit (toData(), searchIndex(), replaceFrom()):
+    // readers may hold it on other threads, so edit a copy.
+    if (!m_searchWritable) {
+        m_searchWritable = std::make_shared<TrigramIndex>(*m_search);
+        m_search = m_searchWritable;
+    }
+    m_searchWritable->addNode(m_nodes[id]);
+}
+
 int GraphModel::upsertNode(const QString& name, const QString& version, const QString& kind)
 {
     int id = ensureNodeId(name, kind);
     Node& n = m_nodes[id];
-    if (!version.trimmed().isEmpty())
+    if (!version.trimmed().isEmpty() && n.version != version.trimmed()) {
         n.version = version.trimmed();
-
-    // Heuristics for status: very rough but functional.
-    const QString v = n.version;
-    if (v.contains("SNAPSHOT", Qt::CaseInsensitive) || v.contains("-alpha", Qt::CaseInsensitive) || v.contains("-beta", Qt::CaseInsensitive))
-        n.status = NodeStatus::Outdated;
-    if (v.contains("deprecated", Qt::CaseInsensitive))
-        n.status = NodeStatus::Deprecated;
-    if (v.contains("!"))
-        n.status = NodeStatus::Conflict;
+        reindexNode(id);
+    }
 
     emit changed();
     return id;
 }
 
-void GraphModel::addEdge(int fromId, int toId)
+void GraphModel::addEdge(int fromId, int toId, const QString& constraint)
 {
     if (fromId < 0 || toId < 0 || fromId == toId)
         return;
@@ -93,9 +176,13 @@ void GraphModel::addEdge(int fromId, int toId)
     if (m_out[fromId].contains(toId))
         return;
 
-    m_edges.push_back({fromId, toId});
+    m_edges.push_back({fromId, toId, constraint.trimmed()});
     m_out[fromId].insert(toId);
     m_in[toId].insert(fromId);
+    m_reachability.reset();
+    m_topologyRevision++;
+    if (m_edgeIndex)
+        writableEdgeIndex()->insert(edgeKey(fromId, toId), m_edges.size() - 1);
     emit changed();
 }
 
@@ -137,12 +224,116 @@ QVector<int> GraphModel::incoming(int toId) const
     return in;
 }
 
+std::shared_ptr<const ReachabilityIndex> GraphModel::reachability() const
+{
+    if (!m_reachability)
+        m_reachability = ReachabilityIndex::build(m_nodes.size(), m_edges);
+    return m_reachability;
+}
+
+void GraphModel::setReachability(std::shared_ptr<const ReachabilityIndex> index, quint64 revision)
+{
+    if (revision == m_topologyRevision)
+        m_reachability = std::move(index);
+}
+
+QVector<int> GraphModel::downstream(int nodeId) const
+{
+    return reachability()->downstream(nodeId);
+}
+
+QVector<int> GraphModel::upstream(int nodeId) const
+{
+    return reachability()->upstream(nodeId);
+}
+
+QVector<int> GraphModel::shortestPath(int fromId, int toId) const
+{
+    return PathQuery(reachability()).shortestPath(fromId, toId);
+}
+
+QVector<QVector<int>> GraphModel::kShortestPaths(int fromId, int toId, int k) const
+{
+    return PathQuery(reachability()).kShortestPaths(fromId, toId, k);
+}
+
+QVector<QVector<int>> GraphModel::cycles() const
+{
+    return cycles(*reachability());
+}
+
+QVector<QVector<int>> GraphModel::cycles(const ReachabilityIndex& reach)
+{
+    const Condensation& scc = reach.condensation();
+
+    QVector<QVector<int>> out;
+    for (int c = 0; c < scc.componentCount(); c++) {
+        if (!scc.isCyclic(c))
+            continue;
+        QVector<int> members = scc.members(c);
+        std::sort(members.begin(), members.end());
+        out.push_back(members);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const QVector<int>& a, const QVector<int>& b) {
+        return a.size() > b.size();
+    });
+    return out;
+}
+
+std::shared_ptr<const GraphModel::EdgeIndex> GraphModel::edgeIndex() const
+{
+    if (!m_edgeIndex)
+        m_edgeIndex = buildEdgeIndex(m_edges);
+    m_edgeIndexWritable.reset();
+    return m_edgeIndex;
+}
+
+// Built if needed. Handed out since the last edit (edgeIndex(), e.g. to an
+// overlay, or replaceFrom()): readers may hold it on other threads, so the
+// edit goes to a copy.
+GraphModel::EdgeIndex* GraphModel::writableEdgeIndex()
+{
+    if (!m_edgeIndexWritable) {
+        m_edgeIndexWritable = m_edgeIndex ? std::make_shared<EdgeIndex>(*m_edgeIndex) : buildEdgeIndex(m_edges);
+        m_edgeIndex = m_edgeIndexWritable;
+    }
+    return m_edgeIndexWritable.get();
+}
+
+std::shared_ptr<const TrigramIndex> GraphModel::searchIndex() const
+{
+    searchRef();
+    m_searchWritable.reset();
+    return m_search;
+}
+
+// Builds the index if needed without handing it out.
+const TrigramIndex& GraphModel::searchRef() const
+{
+    if (!m_search) {
+        m_searchWritable = TrigramIndex::build(m_nodes);
+        m_search = m_searchWritable;
+    }
+    return *m_search;
+}
+
+QVector<int> GraphModel::search(const QString& query, int limit) const
+{
+    QVector<int> ids;
+    const QVector<TrigramIndex::Match> matches = searchRef().search(query, limit);
+    ids.reserve(matches.size());
+    for (const TrigramIndex::Match& m : matches)
+        ids.push_back(m.nodeId);
+    return ids;
+}
+
 void GraphModel::setNodeVersion(int id, const QString& version)
 {
     Node* n = nodeById(id);
     if (!n)
         return;
     n->version = version.trimmed();
+    reindexNode(id);
     emit changed();
 }
 
@@ -155,26 +346,102 @@ void GraphModel::setNodeStatus(int id, NodeStatus status)
     emit changed();
 }
 
-bool GraphModel::removeEdge(int fromId, int toId)
+void GraphModel::setStatuses(const QVector<NodeStatus>& statuses)
 {
-    if (!m_out.contains(fromId) || !m_out[fromId].contains(toId))
+    const int n = qMin(statuses.size(), m_nodes.size());
+    for (int i = 0; i < n; i++)
+        m_nodes[i].status = statuses[i];
+    emit changed();
+}
+
+bool GraphModel::takeEdge(int fromId, int toId)
+{
+    auto out = m_out.find(fromId);
+    if (out == m_out.end() || !out->contains(toId))
         return false;
 
-    m_out[fromId].remove(toId);
+    out->remove(toId);
     m_in[toId].remove(fromId);
+    m_reachability.reset();
+    m_topologyRevision++;
+
+    EdgeIndex* index = writableEdgeIndex();
+    const int i = index->take(edgeKey(fromId, toId));
+    const int last = m_edges.size() - 1;
+    if (i != last) {
+        m_edges[i] = std::move(m_edges[last]);
+        (*index)[edgeKey(m_edges[i].from, m_edges[i].to)] = i;
+    }
+    m_edges.removeLast();
+    return true;
+}
 
-    for (int i = 0; i < m_edges.size(); i++) {
-        if (m_edges[i].from == fromId && m_edges[i].to == toId) {
-            m_edges.removeAt(i);
-            emit changed();
-            return true;
-        }
+bool GraphModel::removeEdge(int fromId, int toId)
+{
+    if (!takeEdge(fromId, toId))
+        return false;
+    emit changed();
+    return true;
+}
+
+bool GraphModel::applyOverlay(WhatIfOverlay overlay)
+{
+    // Cheap sanity check only; owners drop overlays when the model changes.
+    if (overlay.base().nodes.size() != m_nodes.size() || overlay.base().edges.size() != m_edges.size())
+        return false;
+
+    // Let go of the overlay's references first, so the edits below do not
+    // copy the whole graph.
+    const WhatIfOverlay::Edits edits = overlay.release();
+
+    for (auto it = edits.versions.cbegin(); it != edits.versions.cend(); ++it) {
+        m_nodes[it.key()].version = it.value();
+        reindexNode(it.key());
     }
+    for (quint64 key : edits.removedEdges)
+        takeEdge(int(key >> 32), int(quint32(key)));
+    for (auto it = edits.statuses.cbegin(); it != edits.statuses.cend(); ++it)
+        m_nodes[it.key()].status = it.value();
 
     emit changed();
     return true;
 }
 
+void GraphModel::reportMemory(MemoryReport* report, const QString& component) const
+{
+    qint64 strings = 0;
+    for (const Node& n : m_nodes)
+        strings += MemoryReport::bytesOf(n.name) + MemoryReport::bytesOf(n.version) + MemoryReport::bytesOf(n.kind);
+    report->add(component, "nodes", MemoryReport::bytesOf(m_nodes), m_nodes.size());
+    report->add(component, "node strings", strings);
+
+    qint64 constraints = 0;
+    for (const Edge& e : m_edges)
+        constraints += MemoryReport::bytesOf(e.constraint);
+    report->add(component, "edges", MemoryReport::bytesOf(m_edges) + constraints, m_edges.size());
+
+    qint64 keys = MemoryReport::bytesOf(m_keyToId);
+    for (auto it = m_keyToId.cbegin(); it != m_keyToId.cend(); ++it)
+        keys += MemoryReport::bytesOf(it.key());
+    report->add(component, "key index", keys, m_keyToId.size());
+
+    qint64 adjacency = MemoryReport::bytesOf(m_out) + MemoryReport::bytesOf(m_in);
+    for (const QSet<int>& s : m_out)
+        adjacency += MemoryReport::bytesOf(s);
+    for (const QSet<int>& s : m_in)
+        adjacency += MemoryReport::bytesOf(s);
+    report->add(component, "adjacency hashes", adjacency, m_out.size() + m_in.size());
+    if (m_edgeIndex)
+        report->add(component, "edge index", MemoryReport::bytesOf(*m_edgeIndex), m_edgeIndex->size());
+
+    // Shared with snapshots and other models holding the same data, so these
+    // may be counted more than once across components.
+    if (m_reachability)
+        report->add(component, "reachability index", m_reachability->memoryBytes());
+    if (m_search)
+        report->add(component, "search index", m_search->memoryBytes());
+}
+
 QByteArray GraphModel::toJson() const
 {
     QJsonObject root;
@@ -195,15 +462,74 @@ QByteArray GraphModel::toJson() const
         QJsonObject o;
         o["from"] = e.from;
         o["to"] = e.to;
+        if (!e.constraint.isEmpty())
+            o["constraint"] = e.constraint;
         edges.push_back(o);
     }
 
+    QJsonArray cycles;
+    for (const QVector<int>& members : this->cycles()) {
+        QJsonArray ids;
+        for (int id : members)
+            ids.push_back(id);
+        cycles.push_back(ids);
+    }
+
     root["nodes"] = nodes;
     root["edges"] = edges;
+    root["cycles"] = cycles;
 
     return QJsonDocument(root).toJson(QJsonDocument::Indented);
 }
 
+bool GraphModel::fromJson(const QByteArray& json, Data* out, QString* err)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    if (!doc.isObject()) {
+        if (err)
+            *err = doc.isNull() ? parseError.errorString() : QString("Not a graph export");
+        return false;
+    }
+    const QJsonObject root = doc.object();
+
+    Data d;
+    QHash<int, int> fileToId;
+    for (const QJsonValue& v : root["nodes"].toArray()) {
+        const QJsonObject o = v.toObject();
+        Node n;
+        n.name = o["name"].toString().trimmed();
+        n.version = o["version"].toString().trimmed();
+        n.kind = o["kind"].toString().trimmed();
+        n.status = nodeStatusFromString(o["status"].toString());
+
+        const QString key = n.kind + ":" + n.name;
+        auto it = d.keyToId.constFind(key);
+        if (it != d.keyToId.constEnd()) {
+            fileToId.insert(o["id"].toInt(-1), it.value());
+            continue;
+        }
+        n.id = d.nodes.size();
+        d.nodes.push_back(n);
+        d.keyToId.insert(key, n.id);
+        fileToId.insert(o["id"].toInt(-1), n.id);
+    }
+
+    for (const QJsonValue& v : root["edges"].toArray()) {
+        const QJsonObject o = v.toObject();
+        const int from = fileToId.value(o["from"].toInt(-1), -1);
+        const int to = fileToId.value(o["to"].toInt(-1), -1);
+        if (from < 0 || to < 0 || from == to || d.out[from].contains(to))
+            continue;
+        d.edges.push_back({from, to, o["constraint"].toString().trimmed()});
+        d.out[from].insert(to);
+        d.in[to].insert(from);
+    }
+
+    *out = std::move(d);
+    return true;
+}
+
 QByteArray GraphModel::toCsv() const
 {
     QByteArray out;
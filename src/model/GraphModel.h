@@ -5,31 +5,59 @@
 #include <QHash>
 #include <QSet>
 
+#include <memory>
+
 #include "model/Node.h"
 #include "model/Edge.h"
 
+class MemoryReport;
+class ReachabilityIndex;
+class TrigramIndex;
+class WhatIfOverlay;
+
 class GraphModel : public QObject {
     Q_OBJECT
 public:
     explicit GraphModel(QObject* parent = nullptr);
 
+    // (from, to) -> position in edges().
+    using EdgeIndex = QHash<quint64, int>;
+    static quint64 edgeKey(int from, int to) { return (quint64(quint32(from)) << 32) | quint32(to); }
+
+    // A graph snapshot. The containers are implicitly shared, so copying one
+    // is cheap until either side writes; the writer then copies the whole
+    // container. Results handed between threads are moved (takeData(),
+    // adopt()) so no reference is left behind to trigger that.
     struct Data {
         QVector<Node> nodes;
         QVector<Edge> edges;
         QHash<QString, int> keyToId;
         QHash<int, QSet<int>> out;
         QHash<int, QSet<int>> in;
+        // Optional; built off the GUI thread so the model does not have to.
+        std::shared_ptr<const ReachabilityIndex> reachability;
+        std::shared_ptr<const TrigramIndex> search;
     };
 
     void clear();
-    // Replace entire graph contents from another instance (used to apply results
-    // built in a worker thread onto the GUI-owned model).
+    // Replace entire graph contents from another instance. The containers
+    // stay shared with the source until one side writes; results built in a
+    // worker thread are handed over with adopt() instead.
     void replaceFrom(const GraphModel& other);
     void replaceFromData(const Data& data);
+    // Takes over a snapshot's containers and indexes in constant time; the
+    // model is then their only owner.
+    void adopt(Data&& data);
     Data toData() const;
+    // Moves the contents out and leaves the model empty, without a change
+    // notification (for builders that are discarded afterwards).
+    Data takeData();
 
+    // Status is left alone here; VersionConflicts::analyze() sets it for the
+    // whole graph once scanning is done. A non-empty version replaces the
+    // previous one; per-dependent requirements live on the edges.
     int upsertNode(const QString& name, const QString& version, const QString& kind);
-    void addEdge(int fromId, int toId);
+    void addEdge(int fromId, int toId, const QString& constraint = QString());
 
     const QVector<Node>& nodes() const { return m_nodes; }
     const QVector<Edge>& edges() const { return m_edges; }
@@ -40,20 +68,76 @@ public:
     QVector<int> outgoing(int fromId) const;
     QVector<int> incoming(int toId) const;
 
+    // Transitive-dependency index for the current edges. Built on first use
+    // if the last replaceFromData() or adopt() did not supply one; any edge
+    // change drops it.
+    std::shared_ptr<const ReachabilityIndex> reachability() const;
+    // The index if it is already built, without building it.
+    std::shared_ptr<const ReachabilityIndex> reachabilityIfBuilt() const { return m_reachability; }
+    // Installs an index built elsewhere (e.g. on a worker) from this model's
+    // nodes and edges as of `revision`; ignored if they changed since.
+    void setReachability(std::shared_ptr<const ReachabilityIndex> index, quint64 revision);
+    // Bumped whenever nodes or edges are added or removed, i.e. whenever
+    // reachability() may change. Status and version edits leave it alone.
+    quint64 topologyRevision() const { return m_topologyRevision; }
+
+    // Closure queries; both include the node itself.
+    QVector<int> downstream(int nodeId) const;
+    QVector<int> upstream(int nodeId) const;
+    // Dependency chains fromId -> ... -> toId, shortest first; empty if none.
+    QVector<int> shortestPath(int fromId, int toId) const;
+    QVector<QVector<int>> kShortestPaths(int fromId, int toId, int k) const;
+
+    // Node ids of every dependency cycle (non-trivial SCC), largest first.
+    // The full condensed DAG is reachability()->condensation().
+    QVector<QVector<int>> cycles() const;
+    static QVector<QVector<int>> cycles(const ReachabilityIndex& reach);
+
+    // Edge positions. Built on first use (removeEdge() builds it too). Edge
+    // additions and removals update it in place until it is handed out here;
+    // the first edit after that works on a copy.
+    std::shared_ptr<const EdgeIndex> edgeIndex() const;
+
+    // Node search index. Built on first use if replaceFromData() or adopt()
+    // did not supply one. Node additions and renames update it in place
+    // until it is handed out (here or in toData()); the first edit after
+    // that works on a copy.
+    std::shared_ptr<const TrigramIndex> searchIndex() const;
+    // Node ids matching a filter-box query (text, glob or /regex/), best first.
+    QVector<int> search(const QString& query, int limit = -1) const;
+
     // simulation helpers
     void setNodeVersion(int id, const QString& version);
     void setNodeStatus(int id, NodeStatus status);
+    // Bulk update (one change notification); sized like nodes().
+    void setStatuses(const QVector<NodeStatus>& statuses);
+    // O(1) through edgeIndex(); the last edge takes the removed one's place.
     bool removeEdge(int fromId, int toId);
+    // Commits a simulation taken from this model's current contents (one
+    // change notification). Fails, leaving the model alone, if the overlay's
+    // base is visibly a different graph.
+    bool applyOverlay(WhatIfOverlay overlay);
 
     // export
     QByteArray toJson() const;
     QByteArray toCsv() const;
+    // Reads a toJson() export back (e.g. a saved snapshot to diff against).
+    // Ids are reassigned densely; duplicate keys and dangling edges are dropped.
+    static bool fromJson(const QByteArray& json, Data* out, QString* err = nullptr);
+
+    // Adds estimated heap usage of nodes, strings, the key index, adjacency
+    // and whichever indexes are built, under `component`.
+    void reportMemory(MemoryReport* report, const QString& component = "model") const;
 
 signals:
     void changed();
 
 private:
     int ensureNodeId(const QString& name, const QString& kind);
+    void reindexNode(int id);
+    const TrigramIndex& searchRef() const;
+    bool takeEdge(int fromId, int toId);
+    EdgeIndex* writableEdgeIndex();
 
     QVector<Node> m_nodes;
     QVector<Edge> m_edges;
@@ -61,4 +145,13 @@ private:
 
     QHash<int, QSet<int>> m_out;
     QHash<int, QSet<int>> m_in;
+
+    mutable std::shared_ptr<const ReachabilityIndex> m_reachability;
+    mutable std::shared_ptr<const TrigramIndex> m_search;
+    // The same index while only this model holds it; reset when it is
+    // handed out, so a snapshot never sees a later edit.
+    mutable std::shared_ptr<TrigramIndex> m_searchWritable;
+    mutable std::shared_ptr<const EdgeIndex> m_edgeIndex;
+    mutable std::shared_ptr<EdgeIndex> m_edgeIndexWritable; // as m_searchWritable
+    quint64 m_topologyRevision = 0;
 };
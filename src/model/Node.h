@@ -8,7 +8,8 @@ enum class NodeStatus {
     Stable,
     Outdated,
     Deprecated,
-    Conflict
+    Conflict,
+    Vulnerable // matches a known security advisory (AdvisoryDb)
 };
 
 struct Node {
@@ -28,6 +29,16 @@ static inline QString nodeStatusToString(NodeStatus s)
     case NodeStatus::Outdated: return "outdated";
     case NodeStatus::Deprecated: return "deprecated";
     case NodeStatus::Conflict: return "conflict";
+    case NodeStatus::Vulnerable: return "vulnerable";
     }
     return "stable";
 }
+
+static inline NodeStatus nodeStatusFromString(const QString& s)
+{
+    if (s == "outdated") return NodeStatus::Outdated;
+    if (s == "deprecated") return NodeStatus::Deprecated;
+    if (s == "conflict") return NodeStatus::Conflict;
+    if (s == "vulnerable") return NodeStatus::Vulnerable;
+    return NodeStatus::Stable;
+}
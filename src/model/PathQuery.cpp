@@ -0,0 +1,157 @@
+﻿#include "PathQuery.h"
+
+#include <algorithm>
+
+PathQuery::PathQuery(std::shared_ptr<const ReachabilityIndex> index)
+    : m_index(std::move(index))
+{
+    const int n = m_index ? m_index->nodeCount() : 0;
+    m_fwdSeen.fill(0, n);
+    m_bwdSeen.fill(0, n);
+    m_blocked.fill(0, n);
+    m_fwdParent.fill(-1, n);
+    m_bwdParent.fill(-1, n);
+}
+
+void PathQuery::nextEpoch()
+{
+    if (++m_epoch == 0) {
+        m_fwdSeen.fill(0);
+        m_bwdSeen.fill(0);
+        m_blocked.fill(0);
+        m_epoch = 1;
+    }
+}
+
+QVector<int> PathQuery::shortestPath(int from, int to)
+{
+    if (!m_index || from < 0 || to < 0 || from >= m_index->nodeCount() || to >= m_index->nodeCount())
+        return {};
+    // Without a closure the check is a walk of its own; the search below
+    // finds nothing just as well.
+    if (m_index->hasClosure() && !m_index->reaches(from, to))
+        return {};
+    nextEpoch();
+    return search(from, to, {});
+}
+
+QVector<int> PathQuery::search(int from, int to, const QSet<quint64>& blockedEdges)
+{
+    const CsrGraph& g = m_index->graph();
+    const quint32 epoch = m_epoch;
+    if (m_blocked[from] == epoch || m_blocked[to] == epoch)
+        return {};
+    if (from == to)
+        return {from};
+
+    // Level-synchronous BFS from both ends, always growing the smaller
+    // frontier. Once a level produces a meeting, the best meeting on that
+    // level is a shortest path.
+    QVector<int> fwd{from};
+    QVector<int> bwd{to};
+    QVector<int> next;
+    m_fwdSeen[from] = epoch;
+    m_fwdParent[from] = -1;
+    m_bwdSeen[to] = epoch;
+    m_bwdParent[to] = -1;
+
+    int meetFrom = -1; // last node on the forward side
+    int meetTo = -1;   // first node on the backward side
+
+    while (!fwd.isEmpty() && !bwd.isEmpty() && meetFrom < 0) {
+        const bool forward = fwd.size() <= bwd.size();
+        QVector<int>& frontier = forward ? fwd : bwd;
+        QVector<quint32>& seen = forward ? m_fwdSeen : m_bwdSeen;
+        QVector<quint32>& other = forward ? m_bwdSeen : m_fwdSeen;
+        QVector<int>& parent = forward ? m_fwdParent : m_bwdParent;
+
+        next.clear();
+        for (int u : frontier) {
+            const int* begin = forward ? g.outBegin(u) : g.inBegin(u);
+            const int* end = forward ? g.outEnd(u) : g.inEnd(u);
+            for (const int* it = begin; it != end; ++it) {
+                const int v = *it;
+                if (m_blocked[v] == epoch)
+                    continue;
+                if (!blockedEdges.isEmpty() && blockedEdges.contains(forward ? edgeKey(u, v) : edgeKey(v, u)))
+                    continue;
+                if (other[v] == epoch && meetFrom < 0) {
+                    // All meetings on this level have the same length; the first will do.
+                    meetFrom = forward ? u : v;
+                    meetTo = forward ? v : u;
+                }
+                if (seen[v] == epoch)
+                    continue;
+                seen[v] = epoch;
+                parent[v] = u;
+                next.push_back(v);
+            }
+        }
+        frontier.swap(next);
+    }
+
+    if (meetFrom < 0)
+        return {};
+
+    QVector<int> path;
+    for (int v = meetFrom; v >= 0; v = m_fwdParent[v])
+        path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    for (int v = meetTo; v >= 0; v = m_bwdParent[v])
+        path.push_back(v);
+    return path;
+}
+
+QVector<QVector<int>> PathQuery::kShortestPaths(int from, int to, int k)
+{
+    QVector<QVector<int>> found;
+    if (k <= 0)
+        return found;
+
+    QVector<int> first = shortestPath(from, to);
+    if (first.isEmpty())
+        return found;
+    found.push_back(first);
+
+    QVector<QVector<int>> candidates;
+    while (found.size() < k) {
+        const QVector<int>& prev = found.last();
+
+        // Deviate from the previous path at every node except the target.
+        for (int i = 0; i + 1 < prev.size(); i++) {
+            const int spur = prev[i];
+
+            // Edges that would recreate an already-found path with this root.
+            QSet<quint64> blockedEdges;
+            for (const QVector<int>& p : found) {
+                if (p.size() > i + 1 && std::equal(prev.begin(), prev.begin() + i + 1, p.begin()))
+                    blockedEdges.insert(edgeKey(p[i], p[i + 1]));
+            }
+
+            // The root must stay loopless.
+            nextEpoch();
+            for (int r = 0; r < i; r++)
+                m_blocked[prev[r]] = m_epoch;
+
+            const QVector<int> spurPath = search(spur, to, blockedEdges);
+            if (spurPath.isEmpty())
+                continue;
+
+            QVector<int> total(prev.begin(), prev.begin() + i);
+            total += spurPath;
+            if (!candidates.contains(total) && !found.contains(total))
+                candidates.push_back(total);
+        }
+
+        if (candidates.isEmpty())
+            break;
+
+        // Shortest candidate next; ties keep discovery order.
+        auto best = std::min_element(candidates.begin(), candidates.end(), [](const QVector<int>& a, const QVector<int>& b) {
+            return a.size() < b.size();
+        });
+        found.push_back(*best);
+        candidates.erase(best);
+    }
+    return found;
+}
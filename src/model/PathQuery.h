@@ -0,0 +1,41 @@
+﻿#pragma once
+
+#include <QSet>
+#include <QVector>
+
+#include <memory>
+
+#include "model/ReachabilityIndex.h"
+
+// Dependency-chain queries over a ReachabilityIndex snapshot. Paths are node
+// id sequences from `from` to `to`, both included; length is the hop count.
+//
+// Scratch space is sized to the graph once per PathQuery and reused between
+// searches, so keep one around for a batch of queries. Not thread safe.
+class PathQuery {
+public:
+    explicit PathQuery(std::shared_ptr<const ReachabilityIndex> index);
+
+    // One shortest chain (bidirectional BFS), or empty if `to` is not reachable.
+    QVector<int> shortestPath(int from, int to);
+
+    // Up to k loopless chains in order of length (Yen's algorithm).
+    QVector<QVector<int>> kShortestPaths(int from, int to, int k);
+
+private:
+    static quint64 edgeKey(int from, int to) { return (quint64(quint32(from)) << 32) | quint32(to); }
+
+    // Shortest path that avoids nodes stamped in m_blocked and the given edges.
+    QVector<int> search(int from, int to, const QSet<quint64>& blockedEdges);
+    void nextEpoch();
+
+    std::shared_ptr<const ReachabilityIndex> m_index;
+
+    // Per-node scratch, valid where the stamp equals the current epoch.
+    QVector<quint32> m_fwdSeen;
+    QVector<quint32> m_bwdSeen;
+    QVector<quint32> m_blocked;
+    QVector<int> m_fwdParent;
+    QVector<int> m_bwdParent;
+    quint32 m_epoch = 0;
+};
@@ -0,0 +1,256 @@
+﻿#include "ReachabilityIndex.h"
+
+#include <QtAlgorithms>
+
+#include <algorithm>
+
+#include "util/MemoryReport.h"
+
+namespace {
+
+// Visit marks for walks over indexes too large for a closure. One per thread,
+// since the index is shared between threads; a mark is current when it
+// equals the walk's epoch, so nothing is cleared between walks.
+struct WalkScratch {
+    QVector<quint32> marks;
+    QVector<int> stack;
+    quint32 epoch = 0;
+
+    quint32 begin(int count)
+    {
+        if (marks.size() < count)
+            marks.resize(count);
+        if (++epoch == 0) {
+            marks.fill(0);
+            epoch = 1;
+        }
+        stack.clear();
+        return epoch;
+    }
+};
+
+WalkScratch& walkScratch()
+{
+    thread_local WalkScratch scratch;
+    return scratch;
+}
+
+} // namespace
+
+std::shared_ptr<const ReachabilityIndex> ReachabilityIndex::build(int nodeCount, const QVector<Edge>& edges)
+{
+    auto index = std::make_shared<ReachabilityIndex>();
+    index->m_graph = CsrGraph::fromEdges(nodeCount, edges);
+    index->m_scc = Condensation::compute(index->m_graph);
+    if (index->m_scc.componentCount() <= kMaxClosureComponents)
+        index->buildClosure();
+    else
+        index->buildLabels();
+    return index;
+}
+
+void ReachabilityIndex::buildClosure()
+{
+    const int count = m_scc.componentCount();
+    if (count == 0)
+        return;
+
+    m_words = (count + 63) / 64;
+    m_closure.fill(0, qsizetype(count) * m_words);
+
+    // Components come in reverse topological order, so every successor's row
+    // is final before it is needed, and only holds bits below its own id.
+    const CsrGraph& dag = m_scc.dag();
+    for (int c = 0; c < count; c++) {
+        quint64* r = m_closure.data() + qsizetype(c) * m_words;
+        r[c / 64] |= quint64(1) << (c % 64);
+        for (const int* d = dag.outBegin(c); d != dag.outEnd(c); ++d) {
+            const quint64* s = row(*d);
+            for (int w = 0; w <= *d / 64; w++)
+                r[w] |= s[w];
+        }
+    }
+}
+
+void ReachabilityIndex::buildLabels()
+{
+    const int count = m_scc.componentCount();
+    const CsrGraph& dag = m_scc.dag();
+    m_labels.resize(qsizetype(count) * kLabelings);
+
+    QVector<quint8> visited;
+    QVector<QPair<int, int>> stack; // component, next child position
+    for (int l = 0; l < kLabelings; l++) {
+        // Alternate root and child order so the labellings differ.
+        const bool reversed = l % 2 == 1;
+        auto child = [&](int c, int i) {
+            const int degree = int(dag.outEnd(c) - dag.outBegin(c));
+            return dag.outBegin(c)[reversed ? degree - 1 - i : i];
+        };
+        visited.fill(0, count);
+        int rank = 0;
+        for (int r = 0; r < count; r++) {
+            const int root = reversed ? r : count - 1 - r;
+            if (visited[root])
+                continue;
+            visited[root] = 1;
+            stack.push_back({root, 0});
+            while (!stack.isEmpty()) {
+                const int c = stack.last().first;
+                const int i = stack.last().second;
+                if (dag.outBegin(c) + i != dag.outEnd(c)) {
+                    stack.last().second++;
+                    const int d = child(c, i);
+                    if (!visited[d]) {
+                        visited[d] = 1;
+                        stack.push_back({d, 0});
+                    }
+                    continue;
+                }
+                // Post-order: every child is labelled, visited here or before.
+                Interval& label = m_labels[qsizetype(c) * kLabelings + l];
+                label.rank = ++rank;
+                label.low = rank;
+                for (const int* d = dag.outBegin(c); d != dag.outEnd(c); ++d)
+                    label.low = std::min(label.low, m_labels[qsizetype(*d) * kLabelings + l].low);
+                stack.removeLast();
+            }
+        }
+    }
+}
+
+bool ReachabilityIndex::mayReach(int a, int b) const
+{
+    const Interval* la = m_labels.constData() + qsizetype(a) * kLabelings;
+    const Interval* lb = m_labels.constData() + qsizetype(b) * kLabelings;
+    for (int l = 0; l < kLabelings; l++) {
+        if (lb[l].low < la[l].low || lb[l].rank > la[l].rank)
+            return false;
+    }
+    return true;
+}
+
+bool ReachabilityIndex::reaches(int from, int to) const
+{
+    if (from < 0 || to < 0 || from >= nodeCount() || to >= nodeCount())
+        return false;
+
+    const int a = m_scc.componentOf(from);
+    const int b = m_scc.componentOf(to);
+    if (a == b)
+        return true;
+    // DAG edges only go to lower ids.
+    if (b > a)
+        return false;
+    if (hasClosure())
+        return row(a)[b / 64] & (quint64(1) << (b % 64));
+    if (!mayReach(a, b))
+        return false;
+
+    const CsrGraph& dag = m_scc.dag();
+    WalkScratch& scratch = walkScratch();
+    const quint32 epoch = scratch.begin(m_scc.componentCount());
+    quint32* seen = scratch.marks.data();
+    scratch.stack.push_back(a);
+    seen[a] = epoch;
+    while (!scratch.stack.isEmpty()) {
+        const int c = scratch.stack.takeLast();
+        for (const int* d = dag.outBegin(c); d != dag.outEnd(c); ++d) {
+            if (*d == b)
+                return true;
+            if (*d < b || seen[*d] == epoch || !mayReach(*d, b))
+                continue;
+            seen[*d] = epoch;
+            scratch.stack.push_back(*d);
+        }
+    }
+    return false;
+}
+
+QVector<int> ReachabilityIndex::downstream(int from) const
+{
+    QVector<int> out;
+    if (from < 0 || from >= nodeCount())
+        return out;
+
+    auto emitComponent = [&](int c) {
+        for (const int* m = m_scc.membersBegin(c); m != m_scc.membersEnd(c); ++m)
+            out.push_back(*m);
+    };
+
+    const int start = m_scc.componentOf(from);
+    if (hasClosure()) {
+        const quint64* r = row(start);
+        for (int w = 0; w <= start / 64; w++) {
+            for (quint64 bits = r[w]; bits; bits &= bits - 1)
+                emitComponent(w * 64 + qCountTrailingZeroBits(bits));
+        }
+        return out;
+    }
+
+    const CsrGraph& dag = m_scc.dag();
+    WalkScratch& scratch = walkScratch();
+    const quint32 epoch = scratch.begin(m_scc.componentCount());
+    quint32* seen = scratch.marks.data();
+    scratch.stack.push_back(start);
+    seen[start] = epoch;
+    while (!scratch.stack.isEmpty()) {
+        const int c = scratch.stack.takeLast();
+        emitComponent(c);
+        for (const int* d = dag.outBegin(c); d != dag.outEnd(c); ++d) {
+            if (seen[*d] != epoch) {
+                seen[*d] = epoch;
+                scratch.stack.push_back(*d);
+            }
+        }
+    }
+    return out;
+}
+
+QVector<int> ReachabilityIndex::upstream(int to) const
+{
+    QVector<int> out;
+    if (to < 0 || to >= nodeCount())
+        return out;
+
+    auto emitComponent = [&](int c) {
+        for (const int* m = m_scc.membersBegin(c); m != m_scc.membersEnd(c); ++m)
+            out.push_back(*m);
+    };
+
+    // Only components with a higher id can reach this one.
+    const int target = m_scc.componentOf(to);
+    if (hasClosure()) {
+        const int word = target / 64;
+        const quint64 bit = quint64(1) << (target % 64);
+        for (int c = target; c < m_scc.componentCount(); c++) {
+            if (row(c)[word] & bit)
+                emitComponent(c);
+        }
+        return out;
+    }
+
+    const CsrGraph& dag = m_scc.dag();
+    WalkScratch& scratch = walkScratch();
+    const quint32 epoch = scratch.begin(m_scc.componentCount());
+    quint32* seen = scratch.marks.data();
+    scratch.stack.push_back(target);
+    seen[target] = epoch;
+    while (!scratch.stack.isEmpty()) {
+        const int c = scratch.stack.takeLast();
+        emitComponent(c);
+        for (const int* d = dag.inBegin(c); d != dag.inEnd(c); ++d) {
+            if (seen[*d] != epoch) {
+                seen[*d] = epoch;
+                scratch.stack.push_back(*d);
+            }
+        }
+    }
+    return out;
+}
+
+qint64 ReachabilityIndex::memoryBytes() const
+{
+    return m_graph.memoryBytes() + m_scc.memoryBytes() + MemoryReport::bytesOf(m_closure) +
+           MemoryReport::bytesOf(m_labels);
+}
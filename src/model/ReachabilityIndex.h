@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include <QVector>
+
+#include <memory>
+
+#include "model/Condensation.h"
+#include "model/CsrGraph.h"
+
+// Answers "what does X (transitively) depend on" without walking the model.
+// Built once per graph, usually on the scan worker, and immutable afterwards
+// so it can be shared between threads.
+//
+// Queries work on the SCC condensation. Up to kMaxClosureComponents
+// components the full transitive closure is stored as one bitset row per
+// component. Beyond that queries walk the condensed DAG: reaches() prunes
+// the walk with interval labels (GRAIL: a component can only reach one whose
+// post-order interval nests in its own, in every labelling), and all walks
+// mark visits in a per-thread scratch array instead of allocating one.
+class ReachabilityIndex {
+public:
+    static std::shared_ptr<const ReachabilityIndex> build(int nodeCount, const QVector<Edge>& edges);
+
+    int nodeCount() const { return m_graph.nodeCount; }
+    const CsrGraph& graph() const { return m_graph; }
+    const Condensation& condensation() const { return m_scc; }
+    bool hasClosure() const { return m_words > 0; }
+
+    bool reaches(int from, int to) const;
+    // All nodes reachable from `from`, including itself. Unordered.
+    QVector<int> downstream(int from) const;
+    // All nodes that reach `to`, including itself. Unordered.
+    QVector<int> upstream(int to) const;
+
+    // Estimated heap bytes: CSR graph, condensation, and closure bitsets or
+    // interval labels.
+    qint64 memoryBytes() const;
+
+private:
+    // 8192^2 bits = 8 MiB at the limit.
+    static constexpr int kMaxClosureComponents = 8192;
+    // Depth-first labellings with different child orders; each one rules out
+    // some of the pairs the others let through.
+    static constexpr int kLabelings = 2;
+
+    struct Interval {
+        int low = 0;  // lowest post-order rank below the component
+        int rank = 0; // the component's own post-order rank
+    };
+
+    void buildClosure();
+    void buildLabels();
+    // False only if `a` certainly does not reach `b`.
+    bool mayReach(int a, int b) const;
+    const quint64* row(int c) const { return m_closure.constData() + qsizetype(c) * m_words; }
+
+    CsrGraph m_graph;
+    Condensation m_scc;
+    int m_words = 0; // 64-bit words per closure row; 0 when there is no closure
+    QVector<quint64> m_closure;
+    QVector<Interval> m_labels; // kLabelings per component; only without a closure
+};
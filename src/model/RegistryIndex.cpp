@@ -0,0 +1,512 @@
+﻿#include "RegistryIndex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <nlohmann/json.hpp>
+
+#include "model/Version.h"
+#include "util/PackageIndex.h"
+#include "util/Parallel.h"
+#include "util/PerfectHash.h"
+#include "util/Trace.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr char kMagic[8] = {'D', 'G', 'R', 'E', 'G', 'I', 'D', 'X'};
+constexpr quint32 kFormatVersion = 1;
+constexpr quint32 kByteOrder = 0x01020304;
+
+// header | seeds | slots | (pad to 8) | packages | lines | strings
+struct Header {
+    char magic[8];
+    quint32 formatVersion;
+    quint32 byteOrder;
+    quint64 sourceStamp;
+    quint32 packageCount;
+    quint32 bucketCount;
+    quint32 slotCount;
+    quint32 lineCount;
+    quint32 stringBytes;
+    quint32 pad;
+};
+
+struct PackageRecord {
+    quint64 latestHi;
+    quint64 latestLo;
+    quint32 keyOffset; // "ecosystem\x1fname" in the string pool
+    quint32 latestOffset;
+    quint32 firstLine; // highest release per major.minor, ascending
+    quint32 lineCount;
+    quint16 keyLength;
+    quint16 latestLength;
+    quint32 pad;
+};
+
+static_assert(sizeof(Header) == 48, "index layout");
+static_assert(sizeof(PackageRecord) == 40, "index layout");
+
+struct Layout {
+    qint64 seeds = 0;
+    qint64 slotKeys = 0;
+    qint64 packages = 0;
+    qint64 lines = 0;
+    qint64 strings = 0;
+    qint64 size = 0;
+};
+
+Layout layoutOf(const Header& h)
+{
+    Layout l;
+    l.seeds = sizeof(Header);
+    l.slotKeys = l.seeds + qint64(h.bucketCount) * 4;
+    l.packages = (l.slotKeys + qint64(h.slotCount) * 4 + 7) & ~qint64(7);
+    l.lines = l.packages + qint64(h.packageCount) * qint64(sizeof(PackageRecord));
+    l.strings = l.lines + qint64(h.lineCount) * 8;
+    l.size = l.strings + h.stringBytes;
+    return l;
+}
+
+QString ecosystemForDump(const std::string& ecosystem)
+{
+    const QString e = QString::fromStdString(ecosystem).toLower();
+    if (e == "npm")
+        return "npm";
+    if (e == "pypi")
+        return "pypi";
+    if (e == "maven" || e == "maven-central")
+        return "maven";
+    if (e == "gradle-plugin" || e == "gradle-plugins" || e == "gradle")
+        return "gradle-plugin";
+    return QString();
+}
+
+// Ecosystems a node kind is looked up in, in order. Gradle dependencies are
+// Maven artifacts; plugin ids are listed separately.
+QStringList ecosystemsForKind(const QString& kind)
+{
+    if (kind.endsWith(":module"))
+        return {};
+    if (kind.startsWith("npm"))
+        return {"npm"};
+    if (kind.startsWith("pypi"))
+        return {"pypi"};
+    if (kind.startsWith("maven"))
+        return {"maven"};
+    if (kind.startsWith("gradle"))
+        return {"maven", "gradle-plugin"};
+    return {};
+}
+
+struct ParsedPackage {
+    QByteArray key;
+    QByteArray latest;
+    VersionKey latestKey;
+    QVector<quint64> lines; // hi of the highest release per major.minor
+};
+
+bool parseLine(const char* begin, const char* end, ParsedPackage* out)
+{
+    json j;
+    try {
+        j = json::parse(begin, end);
+    } catch (const std::exception&) {
+        return false;
+    }
+    if (!j.is_object())
+        return false;
+    auto field = [&j](const char* key) {
+        const auto it = j.find(key);
+        return it != j.end() && it->is_string() ? it->get<std::string>() : std::string();
+    };
+
+    const QString ecosystem = ecosystemForDump(field("ecosystem"));
+    const std::string name = field("name");
+    const std::string latest = field("latest");
+    if (ecosystem.isEmpty() || name.empty() || latest.empty())
+        return false;
+    const VersionScheme scheme = Version::schemeForKind(ecosystem);
+    if (!Version::parse(QString::fromStdString(latest), scheme, &out->latestKey))
+        return false;
+    out->key = PackageIndex::packageKey(ecosystem, QString::fromStdString(name));
+    out->latest = QByteArray::fromStdString(latest);
+
+    // Highest release per major.minor line; pre-releases do not count as
+    // something to be behind on.
+    QHash<quint64, quint64> highest;
+    auto addRelease = [&highest](const VersionKey& k) {
+        if (k.isPreRelease())
+            return;
+        const quint64 line = k.hi >> 21;
+        auto it = highest.find(line);
+        if (it == highest.end())
+            highest.insert(line, k.hi);
+        else if (k.hi > it.value())
+            it.value() = k.hi;
+    };
+    addRelease(out->latestKey);
+    const auto versions = j.find("versions");
+    if (versions != j.end() && versions->is_array()) {
+        for (const json& v : *versions) {
+            VersionKey k;
+            if (v.is_string() && Version::parse(QString::fromStdString(v.get<std::string>()), scheme, &k))
+                addRelease(k);
+        }
+    }
+    out->lines.reserve(highest.size());
+    for (auto it = highest.constBegin(); it != highest.constEnd(); ++it)
+        out->lines.push_back(it.value());
+    std::sort(out->lines.begin(), out->lines.end());
+    return true;
+}
+
+} // namespace
+
+RegistryIndex::~RegistryIndex()
+{
+    close();
+}
+
+void RegistryIndex::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    m_file.close();
+}
+
+bool RegistryIndex::build(const QString& sourcePath, const QString& indexPath, QString* err)
+{
+    Trace::Span span("registry.build", sourcePath);
+    // The dump is one JSON Lines file, never a directory.
+    const quint64 stamp = QFileInfo(sourcePath).isFile() ? PackageIndex::sourceStamp(sourcePath) : 0;
+    QFile in(sourcePath);
+    if (stamp == 0 || !in.open(QIODevice::ReadOnly)) {
+        if (err) *err = QString("Cannot open %1").arg(sourcePath);
+        return false;
+    }
+    const qint64 size = in.size();
+    const uchar* bytes = size > 0 ? in.map(0, size) : nullptr;
+    if (!bytes) {
+        if (err) *err = QString("Cannot map %1").arg(sourcePath);
+        return false;
+    }
+    const char* text = reinterpret_cast<const char*>(bytes);
+
+    // Byte ranges of roughly equal size, each cut at a line end, parsed in parallel.
+    const int pieces = qMax(1, qMin<int>(QThread::idealThreadCount() * 8, int(size / (256 * 1024)) + 1));
+    QVector<qint64> cuts;
+    cuts.push_back(0);
+    for (int p = 1; p < pieces; p++) {
+        qint64 at = qMax(cuts.last(), size * p / pieces);
+        const void* nl = std::memchr(text + at, '\n', size_t(size - at));
+        at = nl ? static_cast<const char*>(nl) - text + 1 : size;
+        cuts.push_back(at);
+    }
+    cuts.push_back(size);
+
+    QVector<QVector<ParsedPackage>> parsed(pieces);
+    std::atomic<qint64> rejected{0};
+    Parallel::forChunks(pieces, 1, [&](int begin, int end) {
+        for (int p = begin; p < end; p++) {
+            const char* line = text + cuts[p];
+            const char* stop = text + cuts[p + 1];
+            while (line < stop) {
+                const void* nl = std::memchr(line, '\n', size_t(stop - line));
+                const char* lineEnd = nl ? static_cast<const char*>(nl) : stop;
+                if (lineEnd > line && !(lineEnd - line == 1 && *line == '\r')) {
+                    ParsedPackage pkg;
+                    if (parseLine(line, lineEnd, &pkg))
+                        parsed[p].push_back(std::move(pkg));
+                    else
+                        rejected.fetch_add(1, std::memory_order_relaxed);
+                }
+                line = lineEnd + 1;
+            }
+        }
+    });
+    in.unmap(const_cast<uchar*>(bytes));
+    in.close();
+    Trace::count("registry", "rejected lines", rejected.load());
+
+    // A package listed twice keeps its last line, as a later snapshot would.
+    QVector<ParsedPackage> packages;
+    QHash<QByteArray, int> byKey;
+    for (QVector<ParsedPackage>& list : parsed) {
+        for (ParsedPackage& pkg : list) {
+            auto it = byKey.find(pkg.key);
+            if (it == byKey.end()) {
+                byKey.insert(pkg.key, packages.size());
+                packages.push_back(std::move(pkg));
+            } else {
+                packages[it.value()] = std::move(pkg);
+            }
+        }
+        list.clear();
+    }
+    byKey.clear();
+    if (packages.isEmpty()) {
+        if (err) *err = QString("No package metadata found in %1.").arg(sourcePath);
+        return false;
+    }
+    Trace::count("registry", "packages", packages.size());
+
+    QVector<quint64> hashes(packages.size());
+    Parallel::forChunks(packages.size(), 4096, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            hashes[i] = PerfectHash::hashBytes(packages[i].key);
+    });
+    PerfectHash::Table table;
+    if (!PerfectHash::build(hashes, &table, err))
+        return false;
+
+    QByteArray strings;
+    QVector<PackageRecord> records;
+    QVector<quint64> lines;
+    records.reserve(packages.size());
+    for (const ParsedPackage& pkg : packages) {
+        PackageRecord r;
+        std::memset(&r, 0, sizeof(r));
+        const QByteArray key = pkg.key.left(0xffff);
+        const QByteArray latest = pkg.latest.left(0xffff);
+        r.latestHi = pkg.latestKey.hi;
+        r.latestLo = pkg.latestKey.lo;
+        r.keyOffset = quint32(strings.size());
+        r.keyLength = quint16(key.size());
+        strings += key;
+        r.latestOffset = quint32(strings.size());
+        r.latestLength = quint16(latest.size());
+        strings += latest;
+        r.firstLine = quint32(lines.size());
+        r.lineCount = quint32(pkg.lines.size());
+        lines += pkg.lines;
+        records.push_back(r);
+    }
+
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.formatVersion = kFormatVersion;
+    h.byteOrder = kByteOrder;
+    h.sourceStamp = stamp;
+    h.packageCount = quint32(records.size());
+    h.bucketCount = quint32(table.seeds.size());
+    h.slotCount = quint32(table.slotKeys.size());
+    h.lineCount = quint32(lines.size());
+    h.stringBytes = quint32(strings.size());
+    const Layout layout = layoutOf(h);
+
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+    QSaveFile f(indexPath);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (err) *err = QString("Cannot write %1").arg(indexPath);
+        return false;
+    }
+    auto writeBlock = [&f](const void* data, qint64 bytes) {
+        return bytes == 0 || f.write(static_cast<const char*>(data), bytes) == bytes;
+    };
+    const QByteArray padding(int(layout.packages - layout.slotKeys - qint64(h.slotCount) * 4), '\0');
+    const bool written = writeBlock(&h, sizeof(h)) && writeBlock(table.seeds.constData(), qint64(h.bucketCount) * 4) &&
+                         writeBlock(table.slotKeys.constData(), qint64(h.slotCount) * 4) &&
+                         writeBlock(padding.constData(), padding.size()) &&
+                         writeBlock(records.constData(), qint64(records.size()) * qint64(sizeof(PackageRecord))) &&
+                         writeBlock(lines.constData(), qint64(lines.size()) * 8) &&
+                         writeBlock(strings.constData(), strings.size());
+    if (!written) {
+        if (err) *err = QString("Failed writing %1").arg(indexPath);
+        return false;
+    }
+    if (!f.commit()) {
+        if (err) *err = QString("Failed committing %1").arg(indexPath);
+        return false;
+    }
+    return true;
+}
+
+bool RegistryIndex::open(const QString& indexPath, QString* err)
+{
+    close();
+    m_file.setFileName(indexPath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (err) *err = QString("Cannot open %1").arg(indexPath);
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < qint64(sizeof(Header))) {
+        if (err) *err = QString("%1 is not a registry index.").arg(indexPath);
+        close();
+        return false;
+    }
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        if (err) *err = QString("Cannot map %1").arg(indexPath);
+        close();
+        return false;
+    }
+
+    const Header* h = reinterpret_cast<const Header*>(m_data);
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->formatVersion != kFormatVersion ||
+        h->byteOrder != kByteOrder || layoutOf(*h).size != m_size) {
+        if (err) *err = QString("%1 is not a registry index of this version.").arg(indexPath);
+        close();
+        return false;
+    }
+    return true;
+}
+
+QString RegistryIndex::defaultIndexPath(const QString& sourcePath)
+{
+    const QByteArray path = QFileInfo(sourcePath).absoluteFilePath().toUtf8();
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+           QString("/registry-%1.idx").arg(PerfectHash::hashBytes(path), 16, 16, QChar('0'));
+}
+
+bool RegistryIndex::load(const QString& sourcePath, QString* err)
+{
+    const QString indexPath = defaultIndexPath(sourcePath);
+    const quint64 stamp = QFileInfo(sourcePath).isFile() ? PackageIndex::sourceStamp(sourcePath) : 0;
+    if (stamp == 0) {
+        if (err) *err = QString("%1 does not exist.").arg(sourcePath);
+        return false;
+    }
+    if (open(indexPath, nullptr) && reinterpret_cast<const Header*>(m_data)->sourceStamp == stamp) {
+        m_sourcePath = sourcePath;
+        return true;
+    }
+    close();
+    if (!build(sourcePath, indexPath, err) || !open(indexPath, err))
+        return false;
+    m_sourcePath = sourcePath;
+    return true;
+}
+
+int RegistryIndex::findPackage(const QByteArray& key) const
+{
+    if (!m_data)
+        return -1;
+    const Header* h = reinterpret_cast<const Header*>(m_data);
+    const Layout l = layoutOf(*h);
+    const quint32 index = PerfectHash::lookup(PerfectHash::hashBytes(key),
+                                              reinterpret_cast<const quint32*>(m_data + l.seeds), h->bucketCount,
+                                              reinterpret_cast<const quint32*>(m_data + l.slotKeys), h->slotCount);
+    if (index >= h->packageCount)
+        return -1;
+    const PackageRecord& r = reinterpret_cast<const PackageRecord*>(m_data + l.packages)[index];
+    const char* stored = reinterpret_cast<const char*>(m_data + l.strings) + r.keyOffset;
+    if (r.keyLength != key.size() || std::memcmp(stored, key.constData(), size_t(key.size())) != 0)
+        return -1;
+    return int(index);
+}
+
+RegistryIndex::Lag RegistryIndex::lag(const QString& kind, const QString& name, const QString& version) const
+{
+    Lag result;
+    int p = -1;
+    QString ecosystem;
+    for (const QString& e : ecosystemsForKind(kind)) {
+        p = findPackage(PackageIndex::packageKey(e, name));
+        if (p >= 0) {
+            ecosystem = e;
+            break;
+        }
+    }
+    if (p < 0)
+        return result;
+
+    const Header* h = reinterpret_cast<const Header*>(m_data);
+    const Layout l = layoutOf(*h);
+    const PackageRecord& r = reinterpret_cast<const PackageRecord*>(m_data + l.packages)[p];
+    const quint64* lines = reinterpret_cast<const quint64*>(m_data + l.lines) + r.firstLine;
+    VersionKey latest;
+    latest.hi = r.latestHi;
+    latest.lo = r.latestLo;
+    result.latest = QString::fromUtf8(reinterpret_cast<const char*>(m_data + l.strings) + r.latestOffset, r.latestLength);
+
+    // The version in use: as written, or what the requirement resolves to.
+    const VersionScheme scheme = Version::schemeForKind(ecosystem);
+    VersionKey v;
+    if (!Version::parse(version.trimmed(), scheme, &v)) {
+        const VersionRange range = Version::parseRange(version, scheme);
+        if (!range.valid || range.isEmpty())
+            return result;
+        if (range.contains(latest)) {
+            v = latest;
+        } else {
+            bool found = false;
+            for (quint32 i = r.lineCount; i-- > 0 && !found;) {
+                const VersionKey k = VersionKey::release(lines[i]);
+                if (range.contains(k)) {
+                    v = k;
+                    found = true;
+                }
+            }
+            // Nothing published matches; fall back to the lower bound.
+            const VersionRange::Interval& first = range.intervals.first();
+            if (!found && (range.intervals.size() != 1 || !first.hasMin))
+                return result;
+            if (!found)
+                v = first.min.releaseOfFloor();
+        }
+    }
+
+    result.known = true;
+    if (r.lineCount > 1) {
+        quint32 lastMajor = v.majorNumber();
+        for (quint32 i = 0; i < r.lineCount; i++) {
+            const VersionKey k = VersionKey::release(lines[i]);
+            if (k.majorNumber() > lastMajor) {
+                result.majorsBehind++;
+                lastMajor = k.majorNumber();
+            } else if (k.majorNumber() == v.majorNumber() && k.minorNumber() > v.minorNumber()) {
+                result.minorsBehind++;
+            }
+        }
+    } else {
+        if (latest.majorNumber() > v.majorNumber())
+            result.majorsBehind = int(latest.majorNumber() - v.majorNumber());
+        else if (latest.majorNumber() == v.majorNumber() && latest.minorNumber() > v.minorNumber())
+            result.minorsBehind = int(latest.minorNumber() - v.minorNumber());
+    }
+    return result;
+}
+
+int RegistryIndex::markOutdated(const QVector<Node>& nodes, QVector<NodeStatus>* statuses) const
+{
+    if (!m_data)
+        return 0;
+    Trace::Span span("scan.registry");
+    std::atomic<int> marked{0};
+    // Detached here, once: the workers go through the raw pointer, and each
+    // node reads and writes only its own slot.
+    NodeStatus* out = statuses->data();
+    const int count = statuses->size();
+    Parallel::forChunks(nodes.size(), 1024, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            const Node& n = nodes[i];
+            if (n.id < 0 || n.id >= count || out[n.id] != NodeStatus::Stable)
+                continue;
+            if (lag(n.kind, n.name, n.version).majorsBehind > 0) {
+                out[n.id] = NodeStatus::Outdated;
+                marked.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    return marked.load();
+}
+
+int RegistryIndex::packageCount() const
+{
+    return m_data ? int(reinterpret_cast<const Header*>(m_data)->packageCount) : 0;
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "model/Node.h"
+
+// Latest published versions from a locally mirrored registry metadata dump,
+// used to tell how far behind each dependency is.
+//
+// The dump is JSON Lines, one package per line:
+//   {"ecosystem": "npm", "name": "lodash", "latest": "4.17.21",
+//    "versions": ["4.17.20", "4.17.21", ...]}
+// Ecosystems are npm, pypi, maven and gradle-plugin; "versions" is optional.
+//
+// It is read once into an index file with a perfect hash over ecosystem and
+// name, so a lookup is one hash and two table reads in a mapped file and
+// costs nothing noticeable per scan. Per package the index keeps the latest
+// version and the highest release of every major.minor line.
+class RegistryIndex {
+public:
+    struct Lag {
+        bool known = false; // package listed and version understood
+        int majorsBehind = 0;
+        int minorsBehind = 0; // newer minor lines within the major in use
+        QString latest;
+    };
+
+    RegistryIndex() = default;
+    ~RegistryIndex();
+    RegistryIndex(const RegistryIndex&) = delete;
+    RegistryIndex& operator=(const RegistryIndex&) = delete;
+
+    static bool build(const QString& sourcePath, const QString& indexPath, QString* err);
+    bool open(const QString& indexPath, QString* err);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    // Opens the cached index for `sourcePath`, building it first when it is
+    // missing or older than the dump.
+    bool load(const QString& sourcePath, QString* err);
+    static QString defaultIndexPath(const QString& sourcePath);
+
+    // How far `version` of `name` is behind. With a "versions" list the
+    // counts are of release lines actually published; with only "latest" they
+    // are the numeric difference. A requirement is taken at the highest
+    // published release it admits, which is what an install resolves to.
+    Lag lag(const QString& kind, const QString& name, const QString& version) const;
+
+    // Sets Stable nodes at least one major version behind to Outdated, in one
+    // parallel pass. `statuses` is per node id. Returns the number marked.
+    // Minor lag alone changes no status and is not kept per node; lag()
+    // computes both counts for one node when they are shown.
+    int markOutdated(const QVector<Node>& nodes, QVector<NodeStatus>* statuses) const;
+
+    int packageCount() const;
+    QString sourcePath() const { return m_sourcePath; }
+
+private:
+    // Index into the package table, or -1.
+    int findPackage(const QByteArray& key) const;
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QString m_sourcePath;
+};
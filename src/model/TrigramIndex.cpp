@@ -0,0 +1,376 @@
+﻿#include "TrigramIndex.h"
+
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <iterator>
+
+#include "util/MemoryReport.h"
+
+// Plain-text queries also return nodes sharing at least this share of the
+// query's trigrams, so "jakson" still finds "jackson".
+static constexpr int kFuzzyMinPercent = 50;
+
+static quint64 trigramKey(QChar a, QChar b, QChar c)
+{
+    return (quint64(a.unicode()) << 32) | (quint64(b.unicode()) << 16) | quint64(c.unicode());
+}
+
+static void collectTrigrams(const QString& text, QVector<quint64>* out)
+{
+    for (int i = 0; i + 2 < text.size(); i++)
+        out->push_back(trigramKey(text[i], text[i + 1], text[i + 2]));
+}
+
+static void sortUnique(QVector<quint64>* v)
+{
+    std::sort(v->begin(), v->end());
+    v->erase(std::unique(v->begin(), v->end()), v->end());
+}
+
+static QVector<quint64> literalTrigrams(const QVector<QString>& literals)
+{
+    QVector<quint64> t;
+    for (const QString& lit : literals)
+        collectTrigrams(lit.toLower(), &t);
+    sortUnique(&t);
+    return t;
+}
+
+static int substringScore(const QString& name, const QString& version, const QString& kind, const QString& needle)
+{
+    if (name == needle)
+        return 1000;
+    if (name.startsWith(needle))
+        return 900;
+    const int pos = name.indexOf(needle);
+    if (pos >= 0)
+        return 800 - qMin(pos, 99);
+    if (version.contains(needle) || kind.contains(needle))
+        return 500;
+    return 0;
+}
+
+// Glob -> anchored regex. '*' and '?' never stop at '/', unlike
+// QRegularExpression::wildcardToRegularExpression(), since module names
+// are paths and "apps/*" should match "apps/web/package.json".
+static QString globToRegex(const QString& glob, QVector<QString>* literals)
+{
+    QString re;
+    QString run;
+    auto flush = [&]() {
+        if (!run.isEmpty())
+            literals->push_back(run);
+        run.clear();
+    };
+
+    for (int i = 0; i < glob.size(); i++) {
+        const QChar c = glob[i];
+        if (c == '*') {
+            flush();
+            re += ".*";
+        } else if (c == '?') {
+            flush();
+            re += '.';
+        } else if (c == '[') {
+            flush();
+            const int close = glob.indexOf(']', i + 1);
+            if (close < 0) {
+                re += "\\[";
+                continue;
+            }
+            QString set = glob.mid(i + 1, close - i - 1);
+            if (set.startsWith('!'))
+                set[0] = '^';
+            re += '[' + set.replace('\\', "\\\\") + ']';
+            i = close;
+        } else {
+            run += c;
+            re += QRegularExpression::escape(QString(c));
+        }
+    }
+    flush();
+    return QRegularExpression::anchoredPattern(re);
+}
+
+// Literal runs every match of `re` must contain. Conservative: anything
+// inside a group or a character class is ignored, and alternation gives up.
+static QVector<QString> regexLiterals(const QString& re)
+{
+    QVector<QString> literals;
+    if (re.contains('|'))
+        return literals;
+
+    QString run;
+    auto flush = [&]() {
+        if (!run.isEmpty())
+            literals.push_back(run);
+        run.clear();
+    };
+
+    int depth = 0;
+    for (int i = 0; i < re.size(); i++) {
+        const QChar c = re[i];
+        if (c == '\\') {
+            if (i + 1 >= re.size())
+                break;
+            const QChar next = re[++i];
+            if (next.isLetterOrNumber()) {
+                flush(); // \d, \w, \b, back-references...
+            } else if (depth == 0) {
+                run += next;
+            }
+        } else if (c == '(') {
+            flush();
+            depth++;
+        } else if (c == ')') {
+            depth = qMax(0, depth - 1);
+        } else if (depth > 0) {
+            continue;
+        } else if (c == '[') {
+            flush();
+            int j = i + 1;
+            if (j < re.size() && re[j] == ']')
+                j++;
+            while (j < re.size() && re[j] != ']')
+                j += re[j] == '\\' ? 2 : 1;
+            i = j;
+        } else if (c == '*' || c == '?' || c == '{') {
+            // The previous character is optional.
+            run.chop(1);
+            flush();
+            if (c == '{') {
+                const int close = re.indexOf('}', i + 1);
+                i = close < 0 ? re.size() : close;
+            }
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            flush();
+        } else {
+            run += c;
+        }
+    }
+    flush();
+    return literals;
+}
+
+std::shared_ptr<TrigramIndex> TrigramIndex::build(const QVector<Node>& nodes)
+{
+    auto index = std::make_shared<TrigramIndex>();
+    index->m_entries.reserve(nodes.size());
+    for (const Node& n : nodes)
+        index->addNode(n);
+    return index;
+}
+
+TrigramIndex::Entry TrigramIndex::entryFor(const Node& node)
+{
+    return {node.name.toLower(), node.version.toLower(), node.kind.toLower()};
+}
+
+QVector<quint64> TrigramIndex::entryTrigrams(const Entry& e)
+{
+    QVector<quint64> t;
+    collectTrigrams(e.name, &t);
+    collectTrigrams(e.version, &t);
+    collectTrigrams(e.kind, &t);
+    sortUnique(&t);
+    return t;
+}
+
+void TrigramIndex::addNode(const Node& node)
+{
+    if (node.id < m_entries.size()) {
+        updateNode(node);
+        return;
+    }
+    if (node.id != m_entries.size())
+        return;
+
+    m_entries.push_back(entryFor(node));
+    // Ids arrive in ascending order, so appending keeps every list sorted.
+    for (quint64 t : entryTrigrams(m_entries.back()))
+        m_postings[t].push_back(node.id);
+}
+
+void TrigramIndex::updateNode(const Node& node)
+{
+    if (node.id < 0 || node.id >= m_entries.size())
+        return;
+
+    Entry next = entryFor(node);
+    Entry& cur = m_entries[node.id];
+    if (next.name == cur.name && next.version == cur.version && next.kind == cur.kind)
+        return;
+
+    const QVector<quint64> before = entryTrigrams(cur);
+    const QVector<quint64> after = entryTrigrams(next);
+    cur = std::move(next);
+
+    QVector<quint64> gone;
+    QVector<quint64> added;
+    std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(gone));
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(added));
+
+    for (quint64 t : gone) {
+        auto it = m_postings.find(t);
+        if (it == m_postings.end())
+            continue;
+        QVector<int>& ids = it.value();
+        auto pos = std::lower_bound(ids.begin(), ids.end(), node.id);
+        if (pos != ids.end() && *pos == node.id)
+            ids.erase(pos);
+        if (ids.isEmpty())
+            m_postings.erase(it);
+    }
+    for (quint64 t : added) {
+        QVector<int>& ids = m_postings[t];
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), node.id), node.id);
+    }
+}
+
+QVector<int> TrigramIndex::candidates(const QVector<quint64>& trigrams) const
+{
+    QVector<int> out;
+    if (trigrams.isEmpty()) {
+        out.resize(m_entries.size());
+        for (int i = 0; i < out.size(); i++)
+            out[i] = i;
+        return out;
+    }
+
+    QVector<const QVector<int>*> lists;
+    lists.reserve(trigrams.size());
+    for (quint64 t : trigrams) {
+        auto it = m_postings.constFind(t);
+        if (it == m_postings.constEnd())
+            return out;
+        lists.push_back(&it.value());
+    }
+
+    // Smallest list first keeps every intermediate result small.
+    std::sort(lists.begin(), lists.end(), [](const QVector<int>* a, const QVector<int>* b) {
+        return a->size() < b->size();
+    });
+
+    out = *lists[0];
+    QVector<int> next;
+    for (int i = 1; i < lists.size() && !out.isEmpty(); i++) {
+        next.clear();
+        std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        out.swap(next);
+    }
+    return out;
+}
+
+QVector<TrigramIndex::Match> TrigramIndex::searchText(const QString& needle) const
+{
+    QVector<Match> out;
+
+    QVector<quint64> query;
+    collectTrigrams(needle, &query);
+    sortUnique(&query);
+
+    if (query.isEmpty()) {
+        // One or two characters: nothing to look up, scan the lowered fields.
+        for (int id = 0; id < m_entries.size(); id++) {
+            const Entry& e = m_entries[id];
+            const int score = substringScore(e.name, e.version, e.kind, needle);
+            if (score > 0)
+                out.push_back({id, score});
+        }
+        return out;
+    }
+
+    // Count, per node, how many query trigrams it contains. Nodes with all
+    // of them are substring candidates; the rest may still be fuzzy matches.
+    // The postings are merged and counted as runs, so the cost follows the
+    // postings touched rather than the size of the graph.
+    QVector<int> hits;
+    for (quint64 t : query) {
+        auto it = m_postings.constFind(t);
+        if (it != m_postings.constEnd())
+            hits += it.value();
+    }
+    std::sort(hits.begin(), hits.end());
+
+    const int total = query.size();
+    for (int i = 0; i < hits.size();) {
+        const int id = hits[i];
+        int shared = 0;
+        for (; i < hits.size() && hits[i] == id; i++)
+            shared++;
+
+        const Entry& e = m_entries[id];
+        int score = shared == total ? substringScore(e.name, e.version, e.kind, needle) : 0;
+        if (score == 0 && shared * 100 >= total * kFuzzyMinPercent)
+            score = 100 + 300 * shared / total;
+        if (score > 0)
+            out.push_back({id, score});
+    }
+    return out;
+}
+
+QVector<TrigramIndex::Match> TrigramIndex::searchPattern(const QString& regex, const QVector<quint64>& trigrams) const
+{
+    QVector<Match> out;
+    const QRegularExpression re(regex, QRegularExpression::CaseInsensitiveOption);
+    if (!re.isValid())
+        return out;
+
+    for (int id : candidates(trigrams)) {
+        const Entry& e = m_entries[id];
+        if (re.match(e.name).hasMatch())
+            out.push_back({id, 800});
+        else if (re.match(e.version).hasMatch() || re.match(e.kind).hasMatch())
+            out.push_back({id, 500});
+    }
+    return out;
+}
+
+QVector<TrigramIndex::Match> TrigramIndex::search(const QString& query, int limit) const
+{
+    const QString q = query.trimmed();
+    if (q.isEmpty())
+        return {};
+
+    QVector<Match> out;
+    if (q.size() >= 2 && q.startsWith('/') && q.endsWith('/')) {
+        const QString re = q.mid(1, q.size() - 2);
+        out = searchPattern(re, literalTrigrams(regexLiterals(re)));
+    } else if (q.contains('*') || q.contains('?') || q.contains('[')) {
+        QVector<QString> literals;
+        const QString re = globToRegex(q, &literals);
+        out = searchPattern(re, literalTrigrams(literals));
+    } else {
+        out = searchText(q.toLower());
+    }
+
+    // Best score first; shorter names win ties, then id for stability.
+    auto better = [this](const Match& a, const Match& b) {
+        if (a.score != b.score)
+            return a.score > b.score;
+        const int la = m_entries[a.nodeId].name.size();
+        const int lb = m_entries[b.nodeId].name.size();
+        if (la != lb)
+            return la < lb;
+        return a.nodeId < b.nodeId;
+    };
+
+    if (limit >= 0 && limit < out.size()) {
+        std::partial_sort(out.begin(), out.begin() + limit, out.end(), better);
+        out.resize(limit);
+    } else {
+        std::sort(out.begin(), out.end(), better);
+    }
+    return out;
+}
+
+qint64 TrigramIndex::memoryBytes() const
+{
+    qint64 bytes = MemoryReport::bytesOf(m_entries) + MemoryReport::bytesOf(m_postings);
+    for (const Entry& e : m_entries)
+        bytes += MemoryReport::bytesOf(e.name) + MemoryReport::bytesOf(e.version) + MemoryReport::bytesOf(e.kind);
+    for (const QVector<int>& ids : m_postings)
+        bytes += MemoryReport::bytesOf(ids);
+    return bytes;
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "model/Node.h"
+
+// Inverted index from lower-cased character trigrams of a node's name,
+// version and kind to the (sorted) ids of the nodes containing them.
+//
+// Query syntax, as typed into the filter box:
+//   /regex/     case-insensitive regular expression on any field
+//   a*b?[cd]    glob, matched against whole fields
+//   text        substring on any field, plus fuzzy (typo-tolerant) matches
+//
+// The index only narrows the candidate set: literal runs of the pattern
+// select posting lists to intersect, and the survivors are verified against
+// the pattern itself. Patterns with no trigram to anchor on fall back to a
+// scan of the pre-lowered fields.
+class TrigramIndex {
+public:
+    struct Match {
+        int nodeId = -1;
+        int score = 0; // higher is better
+    };
+
+    static std::shared_ptr<TrigramIndex> build(const QVector<Node>& nodes);
+
+    int size() const { return m_entries.size(); }
+
+    // Node ids are dense, so a new node always extends the index by one;
+    // an id already present is re-indexed instead.
+    void addNode(const Node& node);
+    // Re-index a node whose name, version or kind changed.
+    void updateNode(const Node& node);
+
+    // Ranked best first; limit < 0 returns every match.
+    QVector<Match> search(const QString& query, int limit = -1) const;
+
+    // Estimated heap bytes: lowered fields and posting lists.
+    qint64 memoryBytes() const;
+
+private:
+    struct Entry {
+        QString name;
+        QString version;
+        QString kind;
+    };
+
+    static Entry entryFor(const Node& node);
+    static QVector<quint64> entryTrigrams(const Entry& e);
+
+    // Ids present in every posting list of `trigrams`; all ids when empty.
+    QVector<int> candidates(const QVector<quint64>& trigrams) const;
+
+    QVector<Match> searchText(const QString& needle) const;
+    QVector<Match> searchPattern(const QString& regex, const QVector<quint64>& trigrams) const;
+
+    QVector<Entry> m_entries;                // node id -> lower-cased fields
+    QHash<quint64, QVector<int>> m_postings; // trigram -> ascending node ids
+};
@@ -0,0 +1,496 @@
+﻿#include "Version.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+
+namespace {
+
+enum QualifierClass : quint32 {
+    Floor = 0, // below every real version; used for exclusive upper bounds
+    Dev = 1,
+    Alpha = 2,
+    Beta = 3,
+    Milestone = 4,
+    Rc = 5,
+    Snapshot = 6,
+    OtherPre = 7,
+    Release = 8,
+    Post = 9,
+    OtherPost = 10 // Maven/PEP 440 qualifiers the scheme does not know
+};
+
+struct Parsed {
+    quint32 parts[4] = {0, 0, 0, 0};
+    int count = 0;         // numeric release components given
+    bool wildcard = false; // "1.2.x", "1.*", "1.+"
+    quint32 qualifier = Release;
+    quint32 qualifierNumber = 0;
+};
+
+// `word` is empty for a bare number after the release ("1.0-1", "1.0.0-0.3.7").
+quint32 qualifierClass(const QString& word, VersionScheme scheme)
+{
+    switch (scheme) {
+    case VersionScheme::SemVer:
+        // Every tag is a pre-release; numeric identifiers rank below
+        // alphanumeric ones.
+        if (word.isEmpty() || word == "dev")
+            return Dev;
+        if (word == "a" || word == "alpha")
+            return Alpha;
+        if (word == "b" || word == "beta")
+            return Beta;
+        if (word == "rc" || word == "pre" || word == "preview")
+            return Rc;
+        if (word == "snapshot")
+            return Snapshot;
+        return OtherPre;
+    case VersionScheme::Pep440:
+        // The spellings PEP 440 normalises; "1.0-1" is an implicit post release.
+        if (word.isEmpty() || word == "post" || word == "rev" || word == "r")
+            return Post;
+        if (word == "dev")
+            return Dev;
+        if (word == "a" || word == "alpha")
+            return Alpha;
+        if (word == "b" || word == "beta")
+            return Beta;
+        if (word == "rc" || word == "c" || word == "pre" || word == "preview")
+            return Rc;
+        return OtherPost;
+    case VersionScheme::Maven:
+        // ComparableVersion's aliases; "1.0-1" sorts after "1.0", and so do
+        // qualifiers it does not know ("32.1.2-jre", "-android").
+        if (word == "ga" || word == "final" || word == "release")
+            return Release;
+        if (word == "a" || word == "alpha")
+            return Alpha;
+        if (word == "b" || word == "beta")
+            return Beta;
+        if (word == "m" || word == "milestone")
+            return Milestone;
+        if (word == "rc" || word == "cr")
+            return Rc;
+        if (word == "snapshot")
+            return Snapshot;
+        if (word.isEmpty() || word == "sp")
+            return Post;
+        return OtherPost;
+    }
+    return OtherPost;
+}
+
+bool isSeparator(QChar c)
+{
+    return c == '.' || c == '-' || c == '_';
+}
+
+// Release components, an optional wildcard, then at most one qualifier
+// ("-beta.2", "rc1", ".post3", "-SNAPSHOT"). Build metadata is dropped.
+bool parseParsed(QString s, VersionScheme scheme, Parsed* out)
+{
+    s = s.trimmed().toLower();
+    const int plus = s.indexOf('+');
+    if (plus > 0 && s[plus - 1] != '.')
+        s.truncate(plus); // semver build metadata / PEP 440 local version ("1.+" is a Gradle wildcard)
+    const int bang = s.indexOf('!');
+    if (bang >= 0 && scheme == VersionScheme::Pep440)
+        s = s.mid(bang + 1); // epoch; epochs other than 0 are rare enough to ignore
+    if (s.startsWith('v') || s.startsWith('='))
+        s = s.mid(1);
+
+    Parsed p;
+    int i = 0;
+    const int n = s.size();
+    while (i < n && p.count < 4) {
+        if (s[i] == 'x' || s[i] == '*' || s[i] == '+') {
+            p.wildcard = true;
+            i++;
+            break;
+        }
+        if (!s[i].isDigit())
+            break;
+        quint64 v = 0;
+        while (i < n && s[i].isDigit()) {
+            v = qMin<quint64>(v * 10 + s[i].digitValue(), 0xffffffffu);
+            i++;
+        }
+        p.parts[p.count++] = quint32(v);
+        if (i < n && s[i] == '.' && i + 1 < n && (s[i + 1].isDigit() || s[i + 1] == 'x' || s[i + 1] == '*' || s[i + 1] == '+'))
+            i++;
+        else
+            break;
+    }
+    if (p.count == 0 && !p.wildcard)
+        return false;
+    // Trailing wildcard components ("1.2.x.x", Gradle "1.+") add nothing.
+    while (i < n && (s[i] == '.' || s[i] == 'x' || s[i] == '*' || s[i] == '+') && p.wildcard)
+        i++;
+
+    if (i < n) {
+        while (i < n && isSeparator(s[i]))
+            i++;
+        QString word;
+        while (i < n && s[i].isLetter())
+            word += s[i++];
+        while (i < n && isSeparator(s[i]))
+            i++;
+        quint64 num = 0;
+        bool hasNum = false;
+        while (i < n && s[i].isDigit()) {
+            num = qMin<quint64>(num * 10 + s[i].digitValue(), 0x0fffffff);
+            hasNum = true;
+            i++;
+        }
+        if (word.isEmpty() && !hasNum)
+            return false; // junk such as "1.0 garbage" or "1.2.3/4"
+        p.qualifier = qualifierClass(word, scheme);
+        p.qualifierNumber = quint32(num);
+    }
+
+    *out = p;
+    return true;
+}
+
+VersionKey pack(const quint32 parts[4], quint32 qualifier, quint32 qualifierNumber)
+{
+    const quint64 mask21 = (quint64(1) << 21) - 1;
+    VersionKey k;
+    k.hi = (qMin<quint64>(parts[0], mask21) << 42) | (qMin<quint64>(parts[1], mask21) << 21) | qMin<quint64>(parts[2], mask21);
+    k.lo = (quint64(parts[3]) << 32) | (quint64(qualifier & 0xf) << 28) | (qualifierNumber & 0x0fffffff);
+    return k;
+}
+
+VersionKey keyOf(const Parsed& p)
+{
+    return pack(p.parts, p.qualifier, p.qualifierNumber);
+}
+
+// Lowest key that starts with the given components (pre-releases included).
+VersionKey floorOf(const Parsed& p)
+{
+    quint32 parts[4] = {0, 0, 0, 0};
+    for (int i = 0; i < p.count; i++)
+        parts[i] = p.parts[i];
+    return pack(parts, Floor, 0);
+}
+
+// Floor of the version after the first `keep` components, with component
+// keep-1 incremented: bump(1.4.2, 2) = 1.5 (floor), bump(1.4.2, 1) = 2 (floor).
+VersionKey bumped(const Parsed& p, int keep)
+{
+    quint32 parts[4] = {0, 0, 0, 0};
+    keep = qBound(1, keep, 4);
+    for (int i = 0; i < keep; i++)
+        parts[i] = p.parts[i];
+    parts[keep - 1]++;
+    return pack(parts, Floor, 0);
+}
+
+VersionRange::Interval unbounded()
+{
+    return VersionRange::Interval();
+}
+
+bool intersectInterval(const VersionRange::Interval& a, const VersionRange::Interval& b, VersionRange::Interval* out)
+{
+    VersionRange::Interval r;
+    if (a.hasMin || b.hasMin) {
+        r.hasMin = true;
+        if (!b.hasMin || (a.hasMin && a.min > b.min)) {
+            r.min = a.min;
+            r.minInclusive = a.minInclusive;
+        } else if (!a.hasMin || b.min > a.min) {
+            r.min = b.min;
+            r.minInclusive = b.minInclusive;
+        } else {
+            r.min = a.min;
+            r.minInclusive = a.minInclusive && b.minInclusive;
+        }
+    }
+    if (a.hasMax || b.hasMax) {
+        r.hasMax = true;
+        if (!b.hasMax || (a.hasMax && a.max < b.max)) {
+            r.max = a.max;
+            r.maxInclusive = a.maxInclusive;
+        } else if (!a.hasMax || b.max < a.max) {
+            r.max = b.max;
+            r.maxInclusive = b.maxInclusive;
+        } else {
+            r.max = a.max;
+            r.maxInclusive = a.maxInclusive && b.maxInclusive;
+        }
+    }
+    if (r.hasMin && r.hasMax) {
+        if (r.min > r.max)
+            return false;
+        if (r.min == r.max && !(r.minInclusive && r.maxInclusive))
+            return false;
+    }
+    *out = r;
+    return true;
+}
+
+// One comparator ("^1.2", ">=3", "~=1.4.2", "1.2.x") as an interval.
+bool comparatorInterval(const QString& token, VersionScheme scheme, VersionRange::Interval* out)
+{
+    static const char* const kOps[] = {"===", "==", "~=", "!=", ">=", "<=", "^", "~", ">", "<", "="};
+    QString op;
+    for (const char* candidate : kOps) {
+        if (token.startsWith(QLatin1String(candidate))) {
+            op = QLatin1String(candidate);
+            break;
+        }
+    }
+
+    Parsed p;
+    if (!parseParsed(token.mid(op.size()), scheme, &p))
+        return false;
+
+    VersionRange::Interval r;
+    auto setMin = [&](const VersionKey& k, bool inclusive) { r.hasMin = true; r.min = k; r.minInclusive = inclusive; };
+    auto setMax = [&](const VersionKey& k, bool inclusive) { r.hasMax = true; r.max = k; r.maxInclusive = inclusive; };
+    const bool partial = p.wildcard || (scheme == VersionScheme::SemVer && p.count < 3);
+
+    if (op == "!=") {
+        // Exclusions would split the interval; they never make a set of
+        // requirements satisfiable, so ignoring them is conservative.
+        *out = unbounded();
+        return true;
+    } else if (op == "^") {
+        int keep = 1;
+        if (p.parts[0] == 0 && p.count >= 2)
+            keep = (p.parts[1] == 0 && p.count >= 3) ? 3 : 2;
+        setMin(partial ? floorOf(p) : keyOf(p), true);
+        setMax(bumped(p, keep), false);
+    } else if (op == "~") {
+        setMin(partial ? floorOf(p) : keyOf(p), true);
+        setMax(bumped(p, p.count >= 2 ? 2 : 1), false);
+    } else if (op == "~=") {
+        if (p.count < 2)
+            return false;
+        setMin(keyOf(p), true);
+        setMax(bumped(p, p.count - 1), false);
+    } else if (op == ">=") {
+        setMin(partial ? floorOf(p) : keyOf(p), true);
+    } else if (op == ">") {
+        if (partial)
+            setMin(bumped(p, qMax(1, p.count)), true);
+        else
+            setMin(keyOf(p), false);
+    } else if (op == "<=") {
+        if (partial)
+            setMax(bumped(p, qMax(1, p.count)), false);
+        else
+            setMax(keyOf(p), true);
+    } else if (op == "<") {
+        setMax(partial ? floorOf(p) : keyOf(p), false);
+    } else if (partial) {
+        // "1.2.x", "1.2" (npm), "==1.4.*", "1.+": everything with that prefix.
+        if (p.count > 0) {
+            setMin(floorOf(p), true);
+            setMax(bumped(p, p.count), false);
+        }
+    } else {
+        setMin(keyOf(p), true);
+        setMax(keyOf(p), true);
+    }
+
+    *out = r;
+    return true;
+}
+
+// Space/comma separated comparators that must all hold, or an npm hyphen range.
+bool conjunctionInterval(QString s, VersionScheme scheme, VersionRange::Interval* out)
+{
+    static const QRegularExpression hyphen(R"(^(\S+)\s+-\s+(\S+)$)");
+    static const QRegularExpression opSpace(R"((===|==|~=|!=|>=|<=|\^|~|>|<|=)\s+)");
+    static const QRegularExpression splitter(R"([\s,]+)");
+
+    s = s.trimmed();
+    const QRegularExpressionMatch m = hyphen.match(s);
+    if (m.hasMatch())
+        s = ">=" + m.captured(1) + " <=" + m.captured(2);
+
+    s.replace(opSpace, "\\1");
+    VersionRange::Interval acc = unbounded();
+    for (const QString& token : s.split(splitter, Qt::SkipEmptyParts)) {
+        VersionRange::Interval r;
+        if (!comparatorInterval(token, scheme, &r))
+            return false;
+        if (!intersectInterval(acc, r, &acc)) {
+            // Self-contradictory requirement; it matches nothing.
+            acc.hasMin = acc.hasMax = true;
+            acc.min = acc.max = VersionKey();
+            acc.minInclusive = acc.maxInclusive = false;
+        }
+    }
+    *out = acc;
+    return true;
+}
+
+// Maven ranges: "[1.0,2.0)", "[1.5]", "(,1.0],[1.2,)".
+bool parseMavenRanges(const QString& s, VersionScheme scheme, VersionRange* out)
+{
+    static const QRegularExpression group(R"(([\[\(])([^\]\)]*)([\]\)]))");
+    auto it = group.globalMatch(s);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch m = it.next();
+        const bool minInclusive = m.captured(1) == "[";
+        const bool maxInclusive = m.captured(3) == "]";
+        const QString body = m.captured(2);
+        const int comma = body.indexOf(',');
+
+        Parsed lo;
+        Parsed hi;
+        VersionRange::Interval r;
+        if (comma < 0) {
+            if (!parseParsed(body, scheme, &lo))
+                return false;
+            r.hasMin = r.hasMax = true;
+            r.min = r.max = keyOf(lo);
+            r.minInclusive = r.maxInclusive = true;
+        } else {
+            const QString a = body.left(comma).trimmed();
+            const QString b = body.mid(comma + 1).trimmed();
+            if (!a.isEmpty()) {
+                if (!parseParsed(a, scheme, &lo))
+                    return false;
+                r.hasMin = true;
+                r.min = keyOf(lo);
+                r.minInclusive = minInclusive;
+            }
+            if (!b.isEmpty()) {
+                if (!parseParsed(b, scheme, &hi))
+                    return false;
+                r.hasMax = true;
+                r.max = keyOf(hi);
+                r.maxInclusive = maxInclusive;
+            }
+        }
+        out->intervals.push_back(r);
+    }
+    out->valid = !out->intervals.isEmpty();
+    return out->valid;
+}
+
+bool containsKey(const VersionRange::Interval& r, const VersionKey& v)
+{
+    if (r.hasMin && (r.minInclusive ? v < r.min : v <= r.min))
+        return false;
+    if (r.hasMax && (r.maxInclusive ? v > r.max : v >= r.max))
+        return false;
+    return true;
+}
+
+} // namespace
+
+bool VersionKey::isPreRelease() const
+{
+    // Floor keys are synthetic range bounds, not versions anyone uses.
+    const quint64 cls = (lo >> 28) & 0xf;
+    return cls > Floor && cls < Release;
+}
+
+VersionKey VersionKey::release(quint64 hi)
+{
+    VersionKey k;
+    k.hi = hi;
+    k.lo = quint64(Release) << 28;
+    return k;
+}
+
+VersionKey VersionKey::releaseOfFloor() const
+{
+    if (((lo >> 28) & 0xf) != Floor)
+        return *this;
+    VersionKey k = *this;
+    k.lo = (lo & ~quint64(0xffffffff)) | (quint64(Release) << 28);
+    return k;
+}
+
+VersionRange VersionRange::any()
+{
+    VersionRange r;
+    r.intervals.push_back(Interval());
+    r.valid = true;
+    return r;
+}
+
+bool VersionRange::contains(const VersionKey& v) const
+{
+    for (const Interval& i : intervals) {
+        if (containsKey(i, v))
+            return true;
+    }
+    return false;
+}
+
+VersionRange VersionRange::intersected(const VersionRange& other) const
+{
+    VersionRange r;
+    r.valid = valid && other.valid;
+    for (const Interval& a : intervals) {
+        for (const Interval& b : other.intervals) {
+            Interval i;
+            if (intersectInterval(a, b, &i))
+                r.intervals.push_back(i);
+        }
+    }
+    return r;
+}
+
+VersionScheme Version::schemeForKind(const QString& kind)
+{
+    if (kind.startsWith("pypi"))
+        return VersionScheme::Pep440;
+    if (kind.startsWith("maven") || kind.startsWith("gradle"))
+        return VersionScheme::Maven;
+    return VersionScheme::SemVer;
+}
+
+bool Version::parse(const QString& text, VersionScheme scheme, VersionKey* out)
+{
+    Parsed p;
+    if (!parseParsed(text, scheme, &p) || p.wildcard)
+        return false;
+    *out = keyOf(p);
+    return true;
+}
+
+VersionRange Version::parseRange(const QString& text, VersionScheme scheme)
+{
+    const QString t = text.trimmed();
+    const QString lower = t.toLower();
+    if (t.isEmpty() || t == "*" || lower == "x" || lower == "latest" || lower.startsWith("latest."))
+        return VersionRange::any();
+
+    VersionRange r;
+    if (t.startsWith('[') || t.startsWith('(')) {
+        if (!parseMavenRanges(t, scheme, &r))
+            return VersionRange();
+        return r;
+    }
+
+    QString requirement = t;
+    if (scheme == VersionScheme::Maven) {
+        // Gradle "strictly": the one place a plain version pins.
+        if (t.endsWith("!!"))
+            requirement.chop(2);
+        // A soft requirement: nearest-wins mediation or a newer version
+        // elsewhere in the graph replaces it, so it rules nothing out.
+        Parsed p;
+        if (requirement.size() == t.size() && parseParsed(t, scheme, &p) && !p.wildcard)
+            return VersionRange::any();
+    }
+
+    for (const QString& alternative : requirement.split("||")) {
+        VersionRange::Interval i;
+        if (!conjunctionInterval(alternative, scheme, &i))
+            return VersionRange();
+        if (!(i.hasMin && i.hasMax && i.min == i.max && !(i.minInclusive && i.maxInclusive)))
+            r.intervals.push_back(i);
+    }
+    r.valid = true;
+    return r;
+}
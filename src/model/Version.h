@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include <QString>
+#include <QVector>
+
+// Version strings parsed once into fixed-size keys that compare with plain
+// integer comparisons. Three orderings are supported and share one layout:
+//   hi: major, minor, patch (21 bits each)
+//   lo: fourth release component (32 bits), qualifier class (4 bits),
+//       qualifier number (28 bits)
+// Qualifier classes are ranked per scheme, the way each ecosystem's resolver
+// does:
+//   SemVer: anything after "-" is a pre-release; numeric tags rank lowest.
+//   PEP 440: dev < a < b < rc < release < post.
+//   Maven (ComparableVersion): alpha < beta < milestone < rc < snapshot
+//   < release < sp < qualifiers it does not know ("-jre", "-android").
+enum class VersionScheme {
+    SemVer, // npm, cmake
+    Pep440, // pypi
+    Maven   // maven, gradle
+};
+
+struct VersionKey {
+    quint64 hi = 0;
+    quint64 lo = 0;
+
+    bool operator==(const VersionKey& o) const { return hi == o.hi && lo == o.lo; }
+    bool operator!=(const VersionKey& o) const { return !(*this == o); }
+    bool operator<(const VersionKey& o) const { return hi != o.hi ? hi < o.hi : lo < o.lo; }
+    bool operator<=(const VersionKey& o) const { return !(o < *this); }
+    bool operator>(const VersionKey& o) const { return o < *this; }
+    bool operator>=(const VersionKey& o) const { return !(*this < o); }
+
+    // Anything below "release": alpha, beta, rc, SNAPSHOT, .dev and so on.
+    // Maven and PEP 440 qualifiers the scheme does not know are not.
+    bool isPreRelease() const;
+    // The release with the same numbers when this is a synthetic range
+    // bound ("1.2.x" starts at the floor of 1.2); other keys unchanged.
+    VersionKey releaseOfFloor() const;
+
+    quint32 majorNumber() const { return quint32(hi >> 42); }
+    quint32 minorNumber() const { return quint32((hi >> 21) & 0x1fffff); }
+    // The plain release with the major, minor and patch of `hi`.
+    static VersionKey release(quint64 hi);
+};
+
+// A set of versions: a union of intervals. Built from a requirement string
+// ("^1.2", "~=1.4.2", ">=2, <3", "[1.0,2.0)", "1.2.x", ...).
+struct VersionRange {
+    struct Interval {
+        VersionKey min;
+        VersionKey max;
+        bool hasMin = false;
+        bool hasMax = false;
+        bool minInclusive = true;
+        bool maxInclusive = false;
+    };
+
+    QVector<Interval> intervals;
+    bool valid = false; // false when the requirement could not be understood
+
+    static VersionRange any();
+    bool contains(const VersionKey& v) const;
+    // Versions allowed by both. Empty intervals are dropped.
+    VersionRange intersected(const VersionRange& other) const;
+    bool isEmpty() const { return intervals.isEmpty(); }
+};
+
+class Version {
+public:
+    static VersionScheme schemeForKind(const QString& kind);
+
+    // Parses a concrete version. Returns false for things that are not one
+    // ("latest", "${project.version}", git URLs, ranges).
+    static bool parse(const QString& text, VersionScheme scheme, VersionKey* out);
+
+    // Parses a requirement as written in the manifest. A bare version means
+    // exactly that version (or, with fewer components, that prefix), except
+    // for Maven and Gradle, where it is only a recommendation the resolver
+    // may override and so admits any version; "1.2!!" (Gradle strictly) and
+    // "[1.2]" pin.
+    static VersionRange parseRange(const QString& text, VersionScheme scheme);
+};
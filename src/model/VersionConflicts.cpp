@@ -0,0 +1,171 @@
+﻿#include "VersionConflicts.h"
+
+#include <QHash>
+#include <QMutex>
+
+#include <algorithm>
+#include <numeric>
+
+#include "model/Version.h"
+#include "util/Parallel.h"
+
+static bool markedDeprecated(const QString& text)
+{
+    return text.contains("deprecated", Qt::CaseInsensitive);
+}
+
+static NodeStatus classify(int constrained, const VersionRange& allowed, bool deprecated, bool preRelease)
+{
+    if (constrained > 1 && allowed.isEmpty())
+        return NodeStatus::Conflict;
+    if (deprecated)
+        return NodeStatus::Deprecated;
+    if (preRelease)
+        return NodeStatus::Outdated;
+    return NodeStatus::Stable;
+}
+
+VersionConflicts::Result VersionConflicts::analyze(const QVector<Node>& nodes, const QVector<Edge>& edges)
+{
+    Result result;
+    const int n = nodes.size();
+    result.statuses.fill(NodeStatus::Stable, n);
+
+    // Distinct (scheme, text) pairs; versions repeat heavily across modules.
+    QVector<VersionScheme> nodeScheme(n);
+    for (int i = 0; i < n; i++)
+        nodeScheme[i] = Version::schemeForKind(nodes[i].kind);
+
+    QHash<QString, int> uniqueIndex;
+    QVector<QString> uniqueText;
+    QVector<VersionScheme> uniqueScheme;
+    QVector<int> edgeRange(edges.size(), -1);
+    for (int i = 0; i < edges.size(); i++) {
+        const Edge& e = edges[i];
+        if (e.to < 0 || e.to >= n || e.constraint.isEmpty())
+            continue;
+        const VersionScheme scheme = nodeScheme[e.to];
+        const QString key = QChar('0' + int(scheme)) + e.constraint;
+        auto it = uniqueIndex.constFind(key);
+        if (it == uniqueIndex.constEnd()) {
+            it = uniqueIndex.insert(key, uniqueText.size());
+            uniqueText.push_back(e.constraint);
+            uniqueScheme.push_back(scheme);
+        }
+        edgeRange[i] = it.value();
+    }
+
+    QVector<VersionRange> ranges(uniqueText.size());
+    Parallel::forChunks(uniqueText.size(), 1024, [&](int begin, int end) {
+        for (int i = begin; i < end; i++)
+            ranges[i] = Version::parseRange(uniqueText[i], uniqueScheme[i]);
+    });
+
+    // Incoming edge indices per node (CSR).
+    QVector<int> offsets(n + 1, 0);
+    for (const Edge& e : edges) {
+        if (e.to >= 0 && e.to < n)
+            offsets[e.to + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    QVector<int> incoming(offsets[n]);
+    {
+        QVector<int> fill = offsets;
+        for (int i = 0; i < edges.size(); i++) {
+            if (edges[i].to >= 0 && edges[i].to < n)
+                incoming[fill[edges[i].to]++] = i;
+        }
+    }
+
+    QMutex conflictsMutex;
+    Parallel::forChunks(n, 1024, [&](int begin, int end) {
+        QVector<Conflict> local;
+        for (int v = begin; v < end; v++) {
+            const Node& node = nodes[v];
+
+            VersionKey key;
+            bool preRelease = Version::parse(node.version, nodeScheme[v], &key) && key.isPreRelease();
+            bool deprecated = markedDeprecated(node.version);
+
+            VersionRange allowed = VersionRange::any();
+            int constrained = 0;
+            for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+                const int ei = incoming[k];
+                deprecated = deprecated || markedDeprecated(edges[ei].constraint);
+                if (edgeRange[ei] < 0 || !ranges[edgeRange[ei]].valid)
+                    continue;
+                const VersionRange& r = ranges[edgeRange[ei]];
+                for (const VersionRange::Interval& i : r.intervals)
+                    preRelease = preRelease || (i.hasMin && i.minInclusive && i.min.isPreRelease());
+                allowed = allowed.intersected(r);
+                constrained++;
+            }
+
+            const NodeStatus status = classify(constrained, allowed, deprecated, preRelease);
+            if (status == NodeStatus::Conflict) {
+                Conflict c;
+                c.nodeId = v;
+                for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+                    const Edge& e = edges[incoming[k]];
+                    if (edgeRange[incoming[k]] < 0 || !ranges[edgeRange[incoming[k]]].valid)
+                        continue;
+                    c.requirers.push_back(e.from);
+                    c.constraints.push_back(e.constraint);
+                }
+                local.push_back(c);
+            }
+            result.statuses[v] = status;
+        }
+
+        if (!local.isEmpty()) {
+            QMutexLocker lock(&conflictsMutex);
+            result.conflicts += local;
+        }
+    });
+
+    std::sort(result.conflicts.begin(), result.conflicts.end(), [](const Conflict& a, const Conflict& b) {
+        return a.nodeId < b.nodeId;
+    });
+    return result;
+}
+
+NodeStatus VersionConflicts::statusOf(const Node& node, const QStringList& constraints)
+{
+    const VersionScheme scheme = Version::schemeForKind(node.kind);
+    VersionKey key;
+    bool preRelease = Version::parse(node.version, scheme, &key) && key.isPreRelease();
+    bool deprecated = markedDeprecated(node.version);
+
+    VersionRange allowed = VersionRange::any();
+    int constrained = 0;
+    for (const QString& text : constraints) {
+        deprecated = deprecated || markedDeprecated(text);
+        if (text.isEmpty())
+            continue;
+        const VersionRange r = Version::parseRange(text, scheme);
+        if (!r.valid)
+            continue;
+        for (const VersionRange::Interval& i : r.intervals)
+            preRelease = preRelease || (i.hasMin && i.minInclusive && i.min.isPreRelease());
+        allowed = allowed.intersected(r);
+        constrained++;
+    }
+    return classify(constrained, allowed, deprecated, preRelease);
+}
+
+QVector<int> VersionConflicts::unmet(const Node& node, const QStringList& constraints)
+{
+    QVector<int> failed;
+    const VersionScheme scheme = Version::schemeForKind(node.kind);
+    VersionKey key;
+    if (!Version::parse(node.version, scheme, &key))
+        return failed;
+    for (int i = 0; i < constraints.size(); i++) {
+        if (constraints[i].isEmpty())
+            continue;
+        const VersionRange r = Version::parseRange(constraints[i], scheme);
+        if (r.valid && !r.contains(key))
+            failed.push_back(i);
+    }
+    return failed;
+}
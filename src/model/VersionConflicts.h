@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <QStringList>
+#include <QVector>
+
+#include "model/Edge.h"
+#include "model/Node.h"
+
+// Batch version analysis over a whole graph. Every edge requirement is parsed
+// once per distinct string (in parallel), then each package checks whether
+// the requirements of everything that depends on it can be met together.
+class VersionConflicts {
+public:
+    struct Conflict {
+        int nodeId = -1;
+        QVector<int> requirers; // nodes whose requirements cannot all hold
+        QStringList constraints;
+    };
+
+    struct Result {
+        QVector<NodeStatus> statuses; // per node id
+        QVector<Conflict> conflicts;
+    };
+
+    // Status rules:
+    //   Conflict   - requirements from different dependents do not intersect
+    //   Deprecated - the manifest marks the version as deprecated
+    //   Outdated   - the version in use is a pre-release (alpha, beta, rc, SNAPSHOT, dev);
+    //                RegistryIndex::markOutdated() adds those a major version behind
+    static Result analyze(const QVector<Node>& nodes, const QVector<Edge>& edges);
+    // The same rules for one node, given the requirements its dependents put
+    // on it; for re-checking a few nodes after an edit (WhatIfOverlay).
+    static NodeStatus statusOf(const Node& node, const QStringList& constraints);
+    // Indexes into `constraints` of the requirements the node's version does
+    // not satisfy. Empty unless the version is a concrete one (not a range,
+    // tag or path); a scan takes versions as found, so only WhatIfOverlay
+    // checks an edited version this way.
+    static QVector<int> unmet(const Node& node, const QStringList& constraints);
+};
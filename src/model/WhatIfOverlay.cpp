@@ -0,0 +1,259 @@
+﻿#include "WhatIfOverlay.h"
+
+#include <QStringList>
+
+#include <algorithm>
+
+#include "model/AdvisoryDb.h"
+#include "model/ReachabilityIndex.h"
+#include "model/RegistryIndex.h"
+#include "model/VersionConflicts.h"
+
+WhatIfOverlay::WhatIfOverlay(const GraphModel& model)
+    : m_base(model.toData())
+    , m_reach(model.reachability())
+    , m_edgeIndex(model.edgeIndex())
+{
+}
+
+WhatIfOverlay::WhatIfOverlay(GraphModel::Data base, std::shared_ptr<const GraphModel::EdgeIndex> edgeIndex)
+    : m_base(std::move(base))
+    , m_reach(m_base.reachability ? m_base.reachability : ReachabilityIndex::build(m_base.nodes.size(), m_base.edges))
+    , m_edgeIndex(std::move(edgeIndex))
+{
+}
+
+void WhatIfOverlay::setLocalMetadata(std::shared_ptr<const RegistryIndex> registry,
+                                     std::shared_ptr<const AdvisoryDb> advisories)
+{
+    m_registry = std::move(registry);
+    m_advisories = std::move(advisories);
+}
+
+bool WhatIfOverlay::setVersion(int id, const QString& version)
+{
+    if (id < 0 || id >= m_base.nodes.size())
+        return false;
+    const QString v = version.trimmed();
+    if (v == m_base.nodes[id].version)
+        m_edits.versions.remove(id);
+    else
+        m_edits.versions.insert(id, v);
+    recheckStatus(id);
+    return true;
+}
+
+bool WhatIfOverlay::removeEdge(int fromId, int toId)
+{
+    if (!takeEdge(fromId, toId))
+        return false;
+    recheckReachability(toId);
+    recheckStatus(toId);
+    return true;
+}
+
+int WhatIfOverlay::dropNode(int id)
+{
+    if (id < 0 || id >= m_base.nodes.size())
+        return 0;
+    // One re-check for all of them.
+    const CsrGraph& g = m_reach->graph();
+    int removed = 0;
+    for (const int* u = g.inBegin(id); u != g.inEnd(id); ++u)
+        removed += takeEdge(*u, id) ? 1 : 0;
+    if (removed > 0) {
+        recheckReachability(id);
+        recheckStatus(id);
+    }
+    return removed;
+}
+
+QString WhatIfOverlay::version(int id) const
+{
+    auto it = m_edits.versions.constFind(id);
+    if (it != m_edits.versions.constEnd())
+        return it.value();
+    return id >= 0 && id < m_base.nodes.size() ? m_base.nodes[id].version : QString();
+}
+
+NodeStatus WhatIfOverlay::status(int id) const
+{
+    auto it = m_edits.statuses.constFind(id);
+    if (it != m_edits.statuses.constEnd())
+        return it.value();
+    return id >= 0 && id < m_base.nodes.size() ? m_base.nodes[id].status : NodeStatus::Stable;
+}
+
+bool WhatIfOverlay::hasEdge(int fromId, int toId) const
+{
+    const quint64 key = GraphModel::edgeKey(fromId, toId);
+    return m_edgeIndex->contains(key) && !m_edits.removedEdges.contains(key);
+}
+
+QVector<int> WhatIfOverlay::unreachable() const
+{
+    QVector<int> ids = m_unreachable;
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+QVector<WhatIfOverlay::StatusChange> WhatIfOverlay::statusChanges() const
+{
+    QVector<StatusChange> changes;
+    changes.reserve(m_edits.statuses.size());
+    for (auto it = m_edits.statuses.cbegin(); it != m_edits.statuses.cend(); ++it)
+        changes.push_back({it.key(), m_base.nodes[it.key()].status, it.value()});
+    std::sort(changes.begin(), changes.end(), [](const StatusChange& a, const StatusChange& b) {
+        return a.nodeId < b.nodeId;
+    });
+    return changes;
+}
+
+QVector<WhatIfOverlay::Violation> WhatIfOverlay::violations() const
+{
+    QVector<Violation> all;
+    for (const QVector<Violation>& v : m_violations)
+        all += v;
+    std::sort(all.begin(), all.end(), [](const Violation& a, const Violation& b) {
+        return a.nodeId != b.nodeId ? a.nodeId < b.nodeId : a.requirerId < b.requirerId;
+    });
+    return all;
+}
+
+WhatIfOverlay::Edits WhatIfOverlay::release()
+{
+    Edits edits = std::move(m_edits);
+    m_edits = Edits();
+    m_violations.clear();
+    m_base = GraphModel::Data();
+    m_reach.reset();
+    m_edgeIndex.reset();
+    m_reached.clear();
+    m_unreachable.clear();
+    return edits;
+}
+
+bool WhatIfOverlay::takeEdge(int fromId, int toId)
+{
+    const quint64 key = GraphModel::edgeKey(fromId, toId);
+    if (!m_edgeIndex->contains(key) || m_edits.removedEdges.contains(key))
+        return false;
+    // Reachability before this removal is the baseline for re-checking it.
+    computeReached();
+    m_edits.removedEdges.insert(key);
+    return true;
+}
+
+void WhatIfOverlay::computeReached()
+{
+    const CsrGraph& g = m_reach->graph();
+    if (m_reached.size() == g.nodeCount)
+        return;
+    m_reached.fill(false, g.nodeCount);
+    QVector<int> queue;
+    for (int v = 0; v < g.nodeCount; v++) {
+        if (g.inDegree(v) == 0) {
+            m_reached[v] = true;
+            queue.push_back(v);
+        }
+    }
+    for (int head = 0; head < queue.size(); head++) {
+        const int v = queue[head];
+        for (const int* w = g.outBegin(v); w != g.outEnd(v); ++w) {
+            if (!m_reached[*w]) {
+                m_reached[*w] = true;
+                queue.push_back(*w);
+            }
+        }
+    }
+}
+
+void WhatIfOverlay::recheckReachability(int toId)
+{
+    if (!m_reached[toId])
+        return;
+    const CsrGraph& g = m_reach->graph();
+
+    // Only nodes the base graph reaches through toId can have lost their
+    // last path; any path to the others avoids the removed edges.
+    QSet<int> candidates;
+    for (int v : m_reach->downstream(toId)) {
+        if (m_reached[v])
+            candidates.insert(v);
+    }
+
+    // Re-reach them from what is still reached outside the candidate set.
+    QSet<int> again;
+    QVector<int> queue;
+    for (int v : candidates) {
+        for (const int* u = g.inBegin(v); u != g.inEnd(v); ++u) {
+            if (m_reached[*u] && !candidates.contains(*u) &&
+                !m_edits.removedEdges.contains(GraphModel::edgeKey(*u, v))) {
+                again.insert(v);
+                queue.push_back(v);
+                break;
+            }
+        }
+    }
+    for (int head = 0; head < queue.size(); head++) {
+        const int v = queue[head];
+        for (const int* w = g.outBegin(v); w != g.outEnd(v); ++w) {
+            if (candidates.contains(*w) && !again.contains(*w) &&
+                !m_edits.removedEdges.contains(GraphModel::edgeKey(v, *w))) {
+                again.insert(*w);
+                queue.push_back(*w);
+            }
+        }
+    }
+
+    for (int v : candidates) {
+        if (!again.contains(v)) {
+            m_reached[v] = false;
+            m_unreachable.push_back(v);
+        }
+    }
+}
+
+void WhatIfOverlay::recheckStatus(int id)
+{
+    Node node = m_base.nodes[id];
+    node.version = version(id);
+
+    QStringList constraints;
+    QVector<int> requirers;
+    const CsrGraph& g = m_reach->graph();
+    for (const int* u = g.inBegin(id); u != g.inEnd(id); ++u) {
+        const quint64 key = GraphModel::edgeKey(*u, id);
+        if (m_edits.removedEdges.contains(key))
+            continue;
+        auto it = m_edgeIndex->constFind(key);
+        if (it != m_edgeIndex->constEnd()) {
+            constraints.push_back(m_base.edges[it.value()].constraint);
+            requirers.push_back(*u);
+        }
+    }
+
+    // An edited version must still meet what its dependents ask for; the base
+    // version is taken as the scan found it.
+    QVector<Violation> broken;
+    if (m_edits.versions.contains(id)) {
+        for (int i : VersionConflicts::unmet(node, constraints))
+            broken.push_back({id, requirers[i], constraints[i]});
+    }
+    if (broken.isEmpty())
+        m_violations.remove(id);
+    else
+        m_violations.insert(id, broken);
+
+    // Same order as a scan: version rules, then registry lag, then advisories.
+    NodeStatus status = broken.isEmpty() ? VersionConflicts::statusOf(node, constraints) : NodeStatus::Conflict;
+    if (m_registry && status == NodeStatus::Stable && m_registry->lag(node.kind, node.name, node.version).majorsBehind > 0)
+        status = NodeStatus::Outdated;
+    if (m_advisories && !m_advisories->match(node.kind, node.name, node.version).isEmpty())
+        status = NodeStatus::Vulnerable;
+
+    if (status == m_base.nodes[id].status)
+        m_edits.statuses.remove(id);
+    else
+        m_edits.statuses.insert(id, status);
+}
@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <memory>
+
+#include "model/GraphModel.h"
+
+class AdvisoryDb;
+class RegistryIndex;
+
+// "What breaks if we drop X or bump Y": edits recorded over a snapshot of a
+// model without touching it, so nothing is rebuilt while trying them out.
+//
+// The snapshot is the model's data plus its reachability and edge indexes,
+// all shared with the model rather than copied. Each edit updates the impact
+// incrementally: a removed edge re-checks only the nodes below its target
+// (from the base closure), and only nodes whose version or incoming
+// requirements changed get a new status. Discarding is dropping the overlay;
+// GraphModel::applyOverlay() commits it in time proportional to the edits.
+class WhatIfOverlay {
+public:
+    struct StatusChange {
+        int nodeId = -1;
+        NodeStatus before = NodeStatus::Stable;
+        NodeStatus after = NodeStatus::Stable;
+    };
+
+    // A dependent whose requirement an edited version does not satisfy.
+    struct Violation {
+        int nodeId = -1;
+        int requirerId = -1;
+        QString constraint;
+    };
+
+    // What applyOverlay() writes into the model.
+    struct Edits {
+        QHash<int, QString> versions;
+        QSet<quint64> removedEdges;        // GraphModel::edgeKey()
+        QHash<int, NodeStatus> statuses;   // only where they differ from the base
+    };
+
+    // Builds the model's reachability and edge indexes if it has none yet.
+    explicit WhatIfOverlay(const GraphModel& model);
+    // Over a snapshot held elsewhere (QueryServer); its reachability index is
+    // built here if it has none.
+    WhatIfOverlay(GraphModel::Data base, std::shared_ptr<const GraphModel::EdgeIndex> edgeIndex);
+
+    // Registry lag and advisories to re-check edited nodes against, as a scan
+    // would (see MainWindow's overlayLocalMetadata()).
+    void setLocalMetadata(std::shared_ptr<const RegistryIndex> registry, std::shared_ptr<const AdvisoryDb> advisories);
+
+    const GraphModel::Data& base() const { return m_base; }
+    bool isEmpty() const { return m_edits.versions.isEmpty() && m_edits.removedEdges.isEmpty(); }
+    int editCount() const { return m_edits.versions.size() + m_edits.removedEdges.size(); }
+
+    // Setting a node back to its base version drops the edit. False for an
+    // unknown node.
+    bool setVersion(int id, const QString& version);
+    // False if the edge does not exist (or is already removed).
+    bool removeEdge(int fromId, int toId);
+    // Removes every edge into `id`, as if nothing required it any more.
+    // Returns the number of edges removed.
+    int dropNode(int id);
+
+    // The graph with the edits applied.
+    QString version(int id) const;
+    NodeStatus status(int id) const;
+    bool hasEdge(int fromId, int toId) const;
+
+    // Nodes reachable from a root (a node nothing depends on) in the base but
+    // not after the edits. Sorted.
+    QVector<int> unreachable() const;
+    // Sorted by node id.
+    QVector<StatusChange> statusChanges() const;
+    // Requirements broken by the version edits, sorted by node id and then
+    // requirer. A node with any of them is in conflict.
+    QVector<Violation> violations() const;
+
+    // Moves the edits out and drops the references to the model's data.
+    Edits release();
+
+private:
+    bool takeEdge(int fromId, int toId);
+    void computeReached();
+    void recheckReachability(int toId);
+    void recheckStatus(int id);
+
+    GraphModel::Data m_base;
+    std::shared_ptr<const ReachabilityIndex> m_reach;
+    std::shared_ptr<const GraphModel::EdgeIndex> m_edgeIndex;
+    std::shared_ptr<const RegistryIndex> m_registry;
+    std::shared_ptr<const AdvisoryDb> m_advisories;
+
+    Edits m_edits;
+    QHash<int, QVector<Violation>> m_violations; // by edited node id
+    // Reachable from a root after the edits so far; filled on the first
+    // removal (one walk of the base graph), then only ever cleared.
+    QVector<bool> m_reached;
+    QVector<int> m_unreachable;
+};
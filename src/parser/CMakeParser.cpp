@@ -1,18 +1,8 @@
 ﻿#include "CMakeParser.h"
 
-#include <QFile>
 #include <QRegularExpression>
 
-static bool readText(const QString& path, QString* out, QString* err)
-{
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        if (err) *err = QString("Cannot open %1").arg(path);
-        return false;
-    }
-    *out = QString::fromUtf8(f.readAll());
-    return true;
-}
+#include "util/Trace.h"
 
 static QString stripComments(const QString& s)
 {
@@ -26,15 +16,12 @@ static QString stripComments(const QString& s)
     return lines.join("\n");
 }
 
-bool CMakeParser::parseCMakeLists(const QString& filePath, ParsedDeps* out, QString* err)
+bool CMakeParser::parse(const ParseContext& ctx, ParsedDeps* out, QString*)
 {
+    Trace::Span span("parse.cmake");
     out->deps.clear();
 
-    QString txt;
-    if (!readText(filePath, &txt, err))
-        return false;
-
-    txt = stripComments(txt);
+    const QString txt = stripComments(ctx.text());
 
     // find_package(Foo ...)
     {
@@ -1,8 +1,9 @@
 ﻿#pragma once
 
-#include "parser/DependencyScanner.h"
+#include "parser/ParseContext.h"
 
 class CMakeParser {
 public:
-    static bool parseCMakeLists(const QString& filePath, ParsedDeps* out, QString* err);
+    static constexpr ManifestFormat kFormat{"cmake", {"cmakelists.txt"}};
+    static bool parse(const ParseContext& ctx, ParsedDeps* out, QString* err);
 };
@@ -2,91 +2,106 @@
 
 #include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
-#include <QRegularExpression>
+#include <QDateTime>
 #include <QDirIterator>
+#include <QtConcurrent/QtConcurrentMap>
 
-#include "parser/JSONParser.h"
-#include "parser/XMLParser.h"
-#include "parser/GradleParser.h"
-#include "parser/CMakeParser.h"
+#include "parser/ParserRegistry.h"
+#include "model/VersionConflicts.h"
+#include "util/Trace.h"
 
-static bool readTextFile(const QString& path, QString* out, QString* err)
+static bool readAllBytes(const QString& path, QByteArray* out, QString* err)
 {
     QFile f(path);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!f.open(QIODevice::ReadOnly)) {
         if (err) *err = QString("Cannot open %1").arg(path);
         return false;
     }
-    *out = QString::fromUtf8(f.readAll());
+    *out = f.readAll();
     return true;
 }
 
-static bool parseRequirementsTxt(const QString& filePath, ParsedDeps* out, QString* err)
+QHash<QString, ManifestCache::Entry> ManifestCache::snapshot() const
 {
-    out->deps.clear();
-    QString txt;
-    if (!readTextFile(filePath, &txt, err))
-        return false;
-
-    QTextStream ts(&txt);
-    while (!ts.atEnd()) {
-        QString line = ts.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith('#'))
-            continue;
-        // Skip editable installs / includes; still show as unknown dependency
-        if (line.startsWith("-r ") || line.startsWith("--requirement"))
-            continue;
+    QMutexLocker lock(&m_mutex);
+    return m_entries;
+}
 
-        // Basic: name==version, name>=version, name
-        QRegularExpression re(R"(^([A-Za-z0-9_.-]+)\s*(==|>=|<=|~=|>|<)?\s*([^;\s]+)?)");
-        auto m = re.match(line);
-        if (!m.hasMatch())
-            continue;
-        const QString name = m.captured(1);
-        const QString op = m.captured(2);
-        const QString ver = m.captured(3);
-        QString version = ver;
-        if (!op.isEmpty() && !ver.isEmpty())
-            version = op + ver;
-        out->deps.push_back({name, version});
-    }
+void ManifestCache::replace(QHash<QString, Entry> entries)
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries = std::move(entries);
+}
 
-    return true;
+int ManifestCache::size() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_entries.size();
 }
 
-static QVector<QString> findCandidateFiles(const QDir& repoDir)
+QVector<QString> DependencyScanner::findCandidateFiles(const QDir& repoDir)
 {
+    Trace::Span span("scan.walk");
     QVector<QString> files;
     QDirIterator it(repoDir.absolutePath(), QDir::Files, QDirIterator::Subdirectories);
     while (it.hasNext()) {
         const QString path = it.next();
-        const QString fn = QFileInfo(path).fileName();
-
-        if (fn.compare("package.json", Qt::CaseInsensitive) == 0 ||
-            fn.compare("requirements.txt", Qt::CaseInsensitive) == 0 ||
-            fn.compare("pom.xml", Qt::CaseInsensitive) == 0 ||
-            fn.compare("build.gradle", Qt::CaseInsensitive) == 0 ||
-            fn.compare("build.gradle.kts", Qt::CaseInsensitive) == 0 ||
-            fn.compare("CMakeLists.txt", Qt::CaseInsensitive) == 0) {
-
-            // Ignore vendored/build directories to keep scans responsive.
-            const QString lower = path.toLower();
-            if (lower.contains("/node_modules/") || lower.contains("\\node_modules\\") ||
-                lower.contains("/build/") || lower.contains("\\build\\") ||
-                lower.contains("/.git/") || lower.contains("\\.git\\") ||
-                lower.contains("/dist/") || lower.contains("\\dist\\") ||
-                lower.contains("/out/") || lower.contains("\\out\\")) {
-                continue;
-            }
-
-            files.push_back(path);
-        }
+        if (!ParserRegistry::forFileName(it.fileName()))
+            continue;
+
+        // Ignore vendored/build directories to keep scans responsive.
+        if (isIgnoredPath(path))
+            continue;
+
+        files.push_back(path);
     }
     return files;
 }
 
-bool DependencyScanner::scanRepositoryToGraph(const QDir& repoDir, GraphModel* graph, QString* err)
+QString DependencyScanner::manifestKind(const QString& fileName)
+{
+    const ParserEntry* parser = ParserRegistry::forFileName(fileName);
+    return parser ? QString::fromLatin1(parser->format.kind) : QString();
+}
+
+bool DependencyScanner::isIgnoredPath(const QString& path)
+{
+    // Relative paths (git trees) get a leading separator so top-level
+    // directories match too.
+    const QString lower = "/" + QDir::fromNativeSeparators(path).toLower();
+    return lower.contains("/node_modules/") ||
+           lower.contains("/build/") ||
+           lower.contains("/.git/") ||
+           lower.contains("/dist/") ||
+           lower.contains("/out/");
+}
+
+bool DependencyScanner::parseManifest(const QString& kind, const QByteArray& content, ParsedDeps* out, QString* err)
+{
+    const ParserEntry* parser = ParserRegistry::forKind(kind);
+    if (!parser) {
+        if (err) *err = QString("Unsupported manifest kind %1").arg(kind);
+        return false;
+    }
+    return parser->parse(ParseContext(QString(), content), out, err);
+}
+
+void DependencyScanner::addManifest(GraphModel* graph, int rootId, const QString& relPath, const QString& kind, const ParsedDeps& parsed)
+{
+    Trace::Span span("scan.merge");
+    // Pseudo module node for each file to keep mixes readable
+    int moduleId = graph->upsertNode(relPath, "", kind + ":module");
+    graph->addEdge(rootId, moduleId);
+
+    for (const auto& dep : parsed.deps) {
+        const QString name = dep.first;
+        const QString version = dep.second;
+        int depId = graph->upsertNode(name, version, kind);
+        graph->addEdge(moduleId, depId, version);
+    }
+}
+
+bool DependencyScanner::scanRepositoryToGraph(const QDir& repoDir, GraphModel* graph, QString* err, ManifestCache* cache)
 {
     if (err) *err = QString();
     if (!repoDir.exists()) {
@@ -94,6 +109,7 @@ bool DependencyScanner::scanRepositoryToGraph(const QDir& repoDir, GraphModel* g
         return false;
     }
 
+    Trace::Span span("scan", Trace::isEnabled() ? repoDir.absolutePath() : QString());
     graph->clear();
 
     const QString repoName = QFileInfo(repoDir.absolutePath()).fileName();
@@ -101,49 +117,73 @@ bool DependencyScanner::scanRepositoryToGraph(const QDir& repoDir, GraphModel* g
 
     const QVector<QString> candidates = findCandidateFiles(repoDir);
 
-    // Aggregate: connect root -> each dependency; and connect file-specific pseudo nodes for cross-language mixes.
-    for (const QString& filePath : candidates) {
-        ParsedDeps parsed;
-        QString perr;
-        QString fn = QFileInfo(filePath).fileName().toLower();
+    // Read and parse every manifest in parallel into its own slot. Read,
+    // then parse from memory: the same parsers serve git blobs, and a trace
+    // can tell file I/O from parsing.
+    struct Slot {
+        const ParserEntry* parser = nullptr;
+        ManifestCache::Entry result;
+    };
+    const QHash<QString, ManifestCache::Entry> previous = cache ? cache->snapshot() : QHash<QString, ManifestCache::Entry>();
+    QVector<Slot> results(candidates.size());
+    QVector<int> order(candidates.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    QtConcurrent::blockingMap(order, [&](int i) {
+        const QString& filePath = candidates[i];
+        const QFileInfo info(filePath);
+        Slot& slot = results[i];
+        slot.parser = ParserRegistry::forFileName(info.fileName());
+        slot.result.size = info.size();
+        slot.result.modified = info.lastModified().toMSecsSinceEpoch();
+        const QString kind = QString::fromLatin1(slot.parser->format.kind);
+
+        auto hit = previous.constFind(filePath);
+        if (hit != previous.constEnd() && hit->size == slot.result.size && hit->modified == slot.result.modified) {
+            slot.result = hit.value();
+            Trace::count("cache", "hits", 1);
+            return;
+        }
+        if (cache)
+            Trace::count("cache", "misses", 1);
 
-        QString kind;
+        QByteArray bytes;
+        QString perr;
         bool ok = false;
-
-        if (fn == "package.json") {
-            kind = "npm";
-            ok = JSONParser::parsePackageJson(filePath, &parsed, &perr);
-        } else if (fn == "requirements.txt") {
-            kind = "pypi";
-            ok = parseRequirementsTxt(filePath, &parsed, &perr);
-        } else if (fn == "pom.xml") {
-            kind = "maven";
-            ok = XMLParser::parsePomXml(filePath, &parsed, &perr);
-        } else if (fn == "build.gradle" || fn == "build.gradle.kts") {
-            kind = "gradle";
-            ok = GradleParser::parseBuildGradle(filePath, &parsed, &perr);
-        } else if (fn == "cmakelists.txt") {
-            kind = "cmake";
-            ok = CMakeParser::parseCMakeLists(filePath, &parsed, &perr);
+        {
+            Trace::Span readSpan("scan.read", filePath);
+            ok = readAllBytes(filePath, &bytes, &perr);
         }
+        ok = ok && slot.parser->parse(ParseContext(repoDir.relativeFilePath(filePath), bytes), &slot.result.parsed, &perr);
+        slot.result.ok = ok;
 
+        Trace::count(kind, "files", 1);
+        Trace::count(kind, "bytes", bytes.size());
         if (!ok) {
             // Non-fatal: skip file but keep scanning.
-            continue;
-        }
-
-        // Pseudo module node for each file to keep mixes readable
-        QString rel = repoDir.relativeFilePath(filePath);
-        int moduleId = graph->upsertNode(rel, "", kind + ":module");
-        graph->addEdge(rootId, moduleId);
-
-        for (const auto& dep : parsed.deps) {
-            const QString name = dep.first;
-            const QString version = dep.second;
-            int depId = graph->upsertNode(name, version, kind);
-            graph->addEdge(moduleId, depId);
+            Trace::count(kind, "failed", 1);
+            return;
         }
+        Trace::count(kind, "deps", slot.result.parsed.deps.size());
+    });
+
+    // Aggregate in walk order: connect root -> each file's pseudo node -> its dependencies.
+    QHash<QString, ManifestCache::Entry> seen;
+    for (int i = 0; i < candidates.size(); i++) {
+        const Slot& slot = results[i];
+        if (slot.result.ok)
+            addManifest(graph, rootId, repoDir.relativeFilePath(candidates[i]), QString::fromLatin1(slot.parser->format.kind),
+                        slot.result.parsed);
+        if (cache)
+            seen.insert(candidates[i], slot.result);
     }
+    if (cache)
+        cache->replace(std::move(seen));
+
+    // Statuses come from all requirements at once, not from whichever
+    // manifest happened to be parsed last.
+    Trace::Span versionsSpan("scan.versions");
+    graph->setStatuses(VersionConflicts::analyze(graph->nodes(), graph->edges()).statuses);
 
     return true;
 }
@@ -4,6 +4,8 @@
 #include <QVector>
 #include <QPair>
 #include <QDir>
+#include <QHash>
+#include <QMutex>
 
 #include "model/GraphModel.h"
 
@@ -12,9 +14,50 @@ struct ParsedDeps {
     QVector<QPair<QString, QString>> deps;
 };
 
+// Parse results by absolute manifest path, reused while the file's size and
+// modification time are unchanged, so a rescan only reads and parses the
+// manifests that changed. Each scan replaces the contents with what it saw,
+// so deleted files drop out. Thread-safe; one instance serves consecutive
+// scans.
+class ManifestCache {
+public:
+    struct Entry {
+        qint64 size = -1;
+        qint64 modified = 0; // ms since epoch
+        bool ok = false;
+        ParsedDeps parsed;
+    };
+
+    QHash<QString, Entry> snapshot() const;
+    void replace(QHash<QString, Entry> entries);
+    int size() const;
+
+private:
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+};
+
 class DependencyScanner {
 public:
     // Scans repo tree for supported files and merges results into the graph.
-    // Adds a synthetic root node for the repo.
-    static bool scanRepositoryToGraph(const QDir& repoDir, GraphModel* graph, QString* err);
+    // Adds a synthetic root node for the repo. Manifests are read and parsed
+    // in parallel and merged in walk order, so node ids do not depend on
+    // scheduling. With a cache, unchanged manifests are not read again.
+    static bool scanRepositoryToGraph(const QDir& repoDir, GraphModel* graph, QString* err,
+                                      ManifestCache* cache = nullptr);
+    // Absolute paths of the supported manifests under repoDir, skipping
+    // isIgnoredPath() directories.
+    static QVector<QString> findCandidateFiles(const QDir& repoDir);
+
+    // Building blocks shared with scans that do not read a working tree
+    // (HistoryScanner reads manifests straight from git objects).
+
+    // "npm", "pypi", "maven", "gradle", "cmake", or empty if the file name is
+    // not a supported manifest (see ParserRegistry).
+    static QString manifestKind(const QString& fileName);
+    // Vendored and build output directories (node_modules, build, dist...).
+    static bool isIgnoredPath(const QString& path);
+    static bool parseManifest(const QString& kind, const QByteArray& content, ParsedDeps* out, QString* err);
+    // Adds a manifest's pseudo module node under the root plus its dependencies.
+    static void addManifest(GraphModel* graph, int rootId, const QString& relPath, const QString& kind, const ParsedDeps& parsed);
 };
@@ -1,27 +1,14 @@
 ﻿#include "GradleParser.h"
 
-#include <QFile>
-#include <QTextStream>
 #include <QRegularExpression>
 
-static bool readText(const QString& path, QString* out, QString* err)
-{
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        if (err) *err = QString("Cannot open %1").arg(path);
-        return false;
-    }
-    *out = QString::fromUtf8(f.readAll());
-    return true;
-}
+#include "util/Trace.h"
 
-bool GradleParser::parseBuildGradle(const QString& filePath, ParsedDeps* out, QString* err)
+bool GradleParser::parse(const ParseContext& ctx, ParsedDeps* out, QString*)
 {
+    Trace::Span span("parse.gradle");
     out->deps.clear();
-
-    QString txt;
-    if (!readText(filePath, &txt, err))
-        return false;
+    const QString txt = ctx.text();
 
     // Extremely pragmatic parsing: capture strings like "group:artifact:version" in dependencies blocks.
     // Works for most common Gradle declarations.
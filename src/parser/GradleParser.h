@@ -1,8 +1,9 @@
 ﻿#pragma once
 
-#include "parser/DependencyScanner.h"
+#include "parser/ParseContext.h"
 
 class GradleParser {
 public:
-    static bool parseBuildGradle(const QString& filePath, ParsedDeps* out, QString* err);
+    static constexpr ManifestFormat kFormat{"gradle", {"build.gradle", "build.gradle.kts"}};
+    static bool parse(const ParseContext& ctx, ParsedDeps* out, QString* err);
 };
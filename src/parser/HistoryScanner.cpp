@@ -0,0 +1,148 @@
+﻿#include "HistoryScanner.h"
+
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+
+#include "github/GitBlobReader.h"
+#include "model/GraphDiff.h"
+#include "model/VersionConflicts.h"
+#include "parser/DependencyScanner.h"
+#include "util/Trace.h"
+
+namespace {
+
+struct Manifest {
+    QString path;
+    QString blobId;
+    QString kind;
+};
+
+struct ParsedBlob {
+    bool ok = false;
+    ParsedDeps parsed;
+};
+
+} // namespace
+
+bool HistoryScanner::scan(const QString& repoPath, const QVector<GitHandler::Commit>& commits,
+                          DependencyHistory* out, QString* err)
+{
+    if (err) *err = QString();
+
+    GitBlobReader reader;
+    if (!reader.open(repoPath, err))
+        return false;
+
+    const QString repoName = QFileInfo(repoPath).fileName();
+    QHash<QString, ParsedBlob> cache; // kind + ":" + blob id
+    QString previousSignature;
+
+    DependencyHistory history;
+    history.entries.reserve(commits.size());
+
+    for (const GitHandler::Commit& commit : commits) {
+        Trace::Span span("history.commit", commit.id);
+        QString lsErr;
+        const QVector<GitHandler::TreeEntry> blobs = GitHandler::listBlobs(repoPath, commit.id, &lsErr);
+        if (!lsErr.isEmpty()) {
+            if (err) *err = lsErr;
+            return false;
+        }
+
+        // Manifests in path order, so node ids do not depend on tree order.
+        QVector<Manifest> manifests;
+        for (const GitHandler::TreeEntry& b : blobs) {
+            const QString kind = DependencyScanner::manifestKind(b.path.section('/', -1));
+            if (kind.isEmpty() || DependencyScanner::isIgnoredPath(b.path))
+                continue;
+            manifests.push_back({b.path, b.blobId, kind});
+        }
+        std::sort(manifests.begin(), manifests.end(), [](const Manifest& a, const Manifest& b) {
+            return a.path < b.path;
+        });
+
+        QString signature;
+        for (const Manifest& m : manifests)
+            signature += m.path + ' ' + m.blobId + '\n';
+
+        DependencyHistory::Entry entry;
+        entry.commit = commit;
+
+        // No manifest changed since the previous commit: same graph.
+        if (!history.entries.isEmpty() && signature == previousSignature) {
+            entry.graph = history.entries.last().graph;
+            history.blobsReused += manifests.size();
+            Trace::count("cache", "hits", manifests.size());
+            history.entries.push_back(entry);
+            continue;
+        }
+        previousSignature = signature;
+
+        GraphModel graph;
+        const int rootId = graph.upsertNode(repoName.isEmpty() ? "repo" : repoName, "", "repo");
+        for (const Manifest& m : manifests) {
+            const QString key = m.kind + ":" + m.blobId;
+            auto it = cache.constFind(key);
+            if (it == cache.constEnd()) {
+                ParsedBlob blob;
+                QByteArray bytes;
+                QString readErr;
+                if (reader.read(m.blobId, &bytes, &readErr)) {
+                    // Non-fatal: a manifest that does not parse is skipped,
+                    // as in a working-tree scan.
+                    QString parseErr;
+                    blob.ok = DependencyScanner::parseManifest(m.kind, bytes, &blob.parsed, &parseErr);
+                } else if (!reader.isOpen()) {
+                    if (err) *err = readErr;
+                    return false;
+                }
+                it = cache.insert(key, blob);
+                history.blobsParsed++;
+                Trace::count(m.kind, "files", 1);
+                Trace::count(m.kind, "bytes", bytes.size());
+                Trace::count("cache", "misses", 1);
+            } else {
+                history.blobsReused++;
+                Trace::count("cache", "hits", 1);
+            }
+
+            if (it.value().ok)
+                DependencyScanner::addManifest(&graph, rootId, m.path, m.kind, it.value().parsed);
+        }
+        graph.setStatuses(VersionConflicts::analyze(graph.nodes(), graph.edges()).statuses);
+
+        entry.graph = graph.takeData();
+        history.entries.push_back(entry);
+    }
+
+    *out = std::move(history);
+    return true;
+}
+
+QByteArray DependencyHistory::toJson() const
+{
+    QJsonArray commits;
+    const GraphModel::Data empty;
+    for (int i = 0; i < entries.size(); i++) {
+        const Entry& e = entries[i];
+        const GraphModel::Data& before = i > 0 ? entries[i - 1].graph : empty;
+
+        QJsonObject o;
+        o["commit"] = e.commit.id;
+        o["time"] = e.commit.time;
+        o["subject"] = e.commit.subject;
+        o["nodes"] = e.graph.nodes.size();
+        o["edges"] = e.graph.edges.size();
+        o["delta"] = GraphDiff::compute(before, e.graph).toJsonObject();
+        commits.push_back(o);
+    }
+
+    QJsonObject root;
+    root["commits"] = commits;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include "github/GitHandler.h"
+#include "model/GraphModel.h"
+
+// Dependency graphs of a series of commits.
+struct DependencyHistory {
+    struct Entry {
+        GitHandler::Commit commit;
+        GraphModel::Data graph;
+    };
+
+    QVector<Entry> entries; // oldest first
+    int blobsParsed = 0;
+    int blobsReused = 0; // manifests whose blob had already been parsed
+    QString error; // set by callers that hand the result across threads
+
+    // {"commits":[{"commit","time","subject","nodes","edges","delta"}]}, where
+    // delta is the GraphDiff against the previous entry (the first entry's
+    // delta lists its whole graph as added).
+    QByteArray toJson() const;
+};
+
+// Scans commits without checking them out: `git ls-tree` lists each commit's
+// manifests, and their blobs are streamed through one GitBlobReader into the
+// DependencyScanner parsers. Parse results are cached by blob id, so a
+// manifest that did not change between commits is read and parsed once.
+class HistoryScanner {
+public:
+    static bool scan(const QString& repoPath, const QVector<GitHandler::Commit>& commits,
+                     DependencyHistory* out, QString* err);
+};
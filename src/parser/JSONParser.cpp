@@ -1,22 +1,12 @@
 ﻿#include "JSONParser.h"
 
-#include <QFile>
 #include <QString>
 
 #include <nlohmann/json.hpp>
 
-using json = nlohmann::json;
+#include "util/Trace.h"
 
-static bool readAllBytes(const QString& path, QByteArray* out, QString* err)
-{
-    QFile f(path);
-    if (!f.open(QIODevice::ReadOnly)) {
-        if (err) *err = QString("Cannot open %1").arg(path);
-        return false;
-    }
-    *out = f.readAll();
-    return true;
-}
+using json = nlohmann::json;
 
 static void collectDeps(const json& obj, QVector<QPair<QString, QString>>* out)
 {
@@ -32,13 +22,12 @@ static void collectDeps(const json& obj, QVector<QPair<QString, QString>>* out)
     }
 }
 
-bool JSONParser::parsePackageJson(const QString& filePath, ParsedDeps* out, QString* err)
+bool JSONParser::parse(const ParseContext& ctx, ParsedDeps* out, QString* err)
 {
+    Trace::Span span("parse.npm");
     out->deps.clear();
 
-    QByteArray bytes;
-    if (!readAllBytes(filePath, &bytes, err))
-        return false;
+    const QByteArray& bytes = ctx.bytes();
 
     json j;
     try {
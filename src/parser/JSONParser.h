@@ -1,8 +1,9 @@
 ﻿#pragma once
 
-#include "parser/DependencyScanner.h"
+#include "parser/ParseContext.h"
 
 class JSONParser {
 public:
-    static bool parsePackageJson(const QString& filePath, ParsedDeps* out, QString* err);
+    static constexpr ManifestFormat kFormat{"npm", {"package.json"}};
+    static bool parse(const ParseContext& ctx, ParsedDeps* out, QString* err);
 };
@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include "parser/DependencyScanner.h"
+
+// One manifest as every parser receives it: the bytes, from a working tree
+// or a git blob, and the path they came from (for messages only).
+class ParseContext {
+public:
+    ParseContext(const QString& path, const QByteArray& bytes)
+        : m_path(path)
+        , m_bytes(bytes)
+    {
+    }
+
+    const QString& path() const { return m_path; }
+    const QByteArray& bytes() const { return m_bytes; }
+    // The bytes decoded as UTF-8, for text-based parsers.
+    QString text() const { return QString::fromUtf8(m_bytes); }
+
+private:
+    QString m_path;
+    QByteArray m_bytes;
+};
+
+using ParseFn = bool (*)(const ParseContext& ctx, ParsedDeps* out, QString* err);
+
+// What a parser declares about the files it handles. ParserRegistry builds
+// its file name dispatch table from these at compile time.
+struct ManifestFormat {
+    static constexpr int kMaxFileNames = 3;
+
+    const char* kind;                     // node kind of its dependencies ("npm", ...)
+    const char* fileNames[kMaxFileNames]; // lower case; unused entries stay null
+};
@@ -0,0 +1,142 @@
+﻿#include "ParserRegistry.h"
+
+#include <cstring>
+
+#include "parser/CMakeParser.h"
+#include "parser/GradleParser.h"
+#include "parser/JSONParser.h"
+#include "parser/RequirementsParser.h"
+#include "parser/XMLParser.h"
+
+namespace {
+
+template <typename Parser>
+constexpr ParserEntry entry()
+{
+    return {Parser::kFormat, &Parser::parse};
+}
+
+// Adding a format: a parser class with kFormat and parse(), listed here.
+constexpr ParserEntry kParsers[] = {
+    entry<JSONParser>(),
+    entry<RequirementsParser>(),
+    entry<XMLParser>(),
+    entry<GradleParser>(),
+    entry<CMakeParser>(),
+};
+constexpr int kParserCount = int(sizeof(kParsers) / sizeof(kParsers[0]));
+
+constexpr int kSlots = 32; // power of two, a few times the number of names
+constexpr int kMaxNameLength = 64;
+
+constexpr int nameLength(const char* s)
+{
+    int n = 0;
+    while (s[n])
+        n++;
+    return n;
+}
+
+constexpr quint32 hashName(const char* s, int n, quint32 seed)
+{
+    quint32 h = 2166136261u ^ seed;
+    for (int i = 0; i < n; i++) {
+        h ^= quint8(s[i]);
+        h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+}
+
+struct FileSlot {
+    const char* name = nullptr;
+    int length = 0;
+    int parser = -1;
+};
+
+struct FileTable {
+    quint32 seed = 0; // 0: no seed found
+    FileSlot entries[kSlots] = {};
+};
+
+constexpr bool isLowerAscii(const char* s)
+{
+    for (int i = 0; s[i]; i++) {
+        if (quint8(s[i]) >= 0x80 || (s[i] >= 'A' && s[i] <= 'Z'))
+            return false;
+    }
+    return true;
+}
+
+// Tries seeds until every declared name has a slot of its own.
+constexpr FileTable buildFileTable()
+{
+    for (quint32 seed = 1; seed < 100000; seed++) {
+        FileTable t;
+        t.seed = seed;
+        bool ok = true;
+        for (int p = 0; p < kParserCount && ok; p++) {
+            for (int f = 0; f < ManifestFormat::kMaxFileNames && ok; f++) {
+                const char* name = kParsers[p].format.fileNames[f];
+                if (!name)
+                    break;
+                const int n = nameLength(name);
+                if (n > kMaxNameLength || !isLowerAscii(name))
+                    return FileTable();
+                FileSlot& slot = t.entries[hashName(name, n, seed) & (kSlots - 1)];
+                if (slot.name) {
+                    ok = false;
+                    break;
+                }
+                slot.name = name;
+                slot.length = n;
+                slot.parser = p;
+            }
+        }
+        if (ok)
+            return t;
+    }
+    return FileTable();
+}
+
+constexpr FileTable kFileTable = buildFileTable();
+static_assert(kFileTable.seed != 0,
+              "manifest file names must be lower-case ASCII, at most kMaxNameLength long and fit kSlots");
+
+} // namespace
+
+const ParserEntry* ParserRegistry::forFileName(QStringView fileName)
+{
+    const int n = int(fileName.size());
+    if (n == 0 || n > kMaxNameLength)
+        return nullptr;
+    char lower[kMaxNameLength];
+    for (int i = 0; i < n; i++) {
+        const char16_t c = fileName[i].unicode();
+        if (c >= 0x80)
+            return nullptr;
+        lower[i] = (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : char(c);
+    }
+    const FileSlot& slot = kFileTable.entries[hashName(lower, n, kFileTable.seed) & (kSlots - 1)];
+    if (!slot.name || slot.length != n || std::memcmp(slot.name, lower, size_t(n)) != 0)
+        return nullptr;
+    return &kParsers[slot.parser];
+}
+
+const ParserEntry* ParserRegistry::forKind(QStringView kind)
+{
+    for (const ParserEntry& p : kParsers) {
+        if (kind == QLatin1String(p.format.kind))
+            return &p;
+    }
+    return nullptr;
+}
+
+int ParserRegistry::count()
+{
+    return kParserCount;
+}
+
+const ParserEntry& ParserRegistry::at(int index)
+{
+    return kParsers[index];
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+
+#include <QString>
+#include <QStringView>
+
+#include "parser/ParseContext.h"
+
+struct ParserEntry {
+    ManifestFormat format;
+    ParseFn parse;
+};
+
+// The manifest parsers, in one compile-time table.
+//
+// Each parser class declares `static constexpr ManifestFormat kFormat` and
+// `static bool parse(const ParseContext&, ParsedDeps*, QString*)`, and is
+// listed once in ParserRegistry.cpp. File names are dispatched through a
+// perfect hash over all declared names, built by the compiler: a lookup is
+// one hash of the lower-cased name and one compare, whatever the number of
+// formats. The walker, parallel parsing and the manifest cache go through
+// here, so they need nothing per format.
+class ParserRegistry {
+public:
+    // Parser for a file name (no directories), compared case-insensitively;
+    // nullptr if no parser handles it.
+    static const ParserEntry* forFileName(QStringView fileName);
+    static const ParserEntry* forKind(QStringView kind);
+
+    static int count();
+    static const ParserEntry& at(int index);
+};
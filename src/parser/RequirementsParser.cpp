@@ -0,0 +1,39 @@
+﻿#include "RequirementsParser.h"
+
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include "util/Trace.h"
+
+bool RequirementsParser::parse(const ParseContext& ctx, ParsedDeps* out, QString*)
+{
+    Trace::Span span("parse.pypi");
+    out->deps.clear();
+
+    // Basic: name==version, name>=version, name
+    static const QRegularExpression re(R"(^([A-Za-z0-9_.-]+)\s*(==|>=|<=|~=|>|<)?\s*([^;\s]+)?)");
+
+    QString txt = ctx.text();
+    QTextStream ts(&txt);
+    while (!ts.atEnd()) {
+        QString line = ts.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        // Skip editable installs / includes; still show as unknown dependency
+        if (line.startsWith("-r ") || line.startsWith("--requirement"))
+            continue;
+
+        auto m = re.match(line);
+        if (!m.hasMatch())
+            continue;
+        const QString name = m.captured(1);
+        const QString op = m.captured(2);
+        const QString ver = m.captured(3);
+        QString version = ver;
+        if (!op.isEmpty() && !ver.isEmpty())
+            version = op + ver;
+        out->deps.push_back({name, version});
+    }
+
+    return true;
+}
@@ -0,0 +1,9 @@
+﻿#pragma once
+
+#include "parser/ParseContext.h"
+
+class RequirementsParser {
+public:
+    static constexpr ManifestFormat kFormat{"pypi", {"requirements.txt"}};
+    static bool parse(const ParseContext& ctx, ParsedDeps* out, QString* err);
+};
@@ -2,6 +2,8 @@
 
 #include <tinyxml2.h>
 
+#include "util/Trace.h"
+
 using namespace tinyxml2;
 
 static QString txtOrEmpty(const XMLElement* el)
@@ -11,17 +13,8 @@ static QString txtOrEmpty(const XMLElement* el)
     return QString::fromUtf8(el->GetText()).trimmed();
 }
 
-bool XMLParser::parsePomXml(const QString& filePath, ParsedDeps* out, QString* err)
+static bool collectPomDeps(const XMLDocument& doc, ParsedDeps* out, QString* err)
 {
-    out->deps.clear();
-
-    XMLDocument doc;
-    XMLError rc = doc.LoadFile(filePath.toUtf8().constData());
-    if (rc != XML_SUCCESS) {
-        if (err) *err = QString("XML load error (%1)").arg(int(rc));
-        return false;
-    }
-
     const XMLElement* project = doc.FirstChildElement("project");
     if (!project) {
         if (err) *err = "Not a pom.xml (no <project>)";
@@ -50,3 +43,17 @@ bool XMLParser::parsePomXml(const QString& filePath, ParsedDeps* out, QString* e
 
     return true;
 }
+
+bool XMLParser::parse(const ParseContext& ctx, ParsedDeps* out, QString* err)
+{
+    Trace::Span span("parse.maven");
+    out->deps.clear();
+
+    XMLDocument doc;
+    XMLError rc = doc.Parse(ctx.bytes().constData(), size_t(ctx.bytes().size()));
+    if (rc != XML_SUCCESS) {
+        if (err) *err = QString("XML parse error (%1)").arg(int(rc));
+        return false;
+    }
+    return collectPomDeps(doc, out, err);
+}
@@ -1,8 +1,9 @@
 ﻿#pragma once
 
-#include "parser/DependencyScanner.h"
+#include "parser/ParseContext.h"
 
 class XMLParser {
 public:
-    static bool parsePomXml(const QString& filePath, ParsedDeps* out, QString* err);
+    static constexpr ManifestFormat kFormat{"maven", {"pom.xml"}};
+    static bool parse(const ParseContext& ctx, ParsedDeps* out, QString* err);
 };
@@ -0,0 +1,556 @@
+﻿#include "QueryServer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QStringList>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <utility>
+
+#include "model/AdvisoryDb.h"
+#include "model/GraphDiff.h"
+#include "model/PathQuery.h"
+#include "model/ReachabilityIndex.h"
+#include "model/RegistryIndex.h"
+#include "model/TrigramIndex.h"
+#include "model/WhatIfOverlay.h"
+#include "parser/DependencyScanner.h"
+
+namespace {
+
+constexpr int kDefaultLimit = 200;
+constexpr int kMaxPaths = 32;
+constexpr int kMaxCachedAnswers = 4096;
+
+using Snapshot = QueryServer::Snapshot;
+
+struct Answer {
+    bool ok = false;
+    bool cacheable = true;
+    QByteArray result; // compact JSON object
+    QString error;
+};
+
+QString nodeKey(const Node& n)
+{
+    return n.kind + ":" + n.name;
+}
+
+QJsonObject nodeJson(const Node& n)
+{
+    QJsonObject o;
+    o["id"] = n.id;
+    o["key"] = nodeKey(n);
+    o["name"] = n.name;
+    o["version"] = n.version;
+    o["kind"] = n.kind;
+    o["status"] = nodeStatusToString(n.status);
+    return o;
+}
+
+QByteArray compact(const QJsonObject& o)
+{
+    return QJsonDocument(o).toJson(QJsonDocument::Compact);
+}
+
+// Spliced around an already serialized result, so cached answers are
+// written without parsing or serializing them again.
+QByteArray okLine(const QJsonValue& id, const QByteArray& result)
+{
+    // QJsonDocument only serializes arrays and objects.
+    const QByteArray wrapped = QJsonDocument(QJsonArray{id}).toJson(QJsonDocument::Compact);
+    return "{\"id\":" + wrapped.mid(1, wrapped.size() - 2) + ",\"ok\":true,\"result\":" + result + "}\n";
+}
+
+QByteArray errorLine(const QJsonValue& id, const QString& error)
+{
+    QJsonObject o;
+    o["id"] = id;
+    o["ok"] = false;
+    o["error"] = error;
+    return compact(o) + '\n';
+}
+
+bool sameGraph(const GraphModel::Data& a, const QVector<Node>& nodes, const QVector<Edge>& edges)
+{
+    if (a.nodes.size() != nodes.size() || a.edges.size() != edges.size())
+        return false;
+    for (int i = 0; i < nodes.size(); i++) {
+        const Node& x = a.nodes[i];
+        const Node& y = nodes[i];
+        if (x.status != y.status || x.name != y.name || x.version != y.version || x.kind != y.kind)
+            return false;
+    }
+    for (int i = 0; i < edges.size(); i++) {
+        const Edge& x = a.edges[i];
+        const Edge& y = edges[i];
+        if (x.from != y.from || x.to != y.to || x.constraint != y.constraint)
+            return false;
+    }
+    return true;
+}
+
+// A "kind:name" key, or a plain name if only one node has it.
+int findNode(const Snapshot& s, const QJsonValue& value, const char* field, QString* err)
+{
+    const QString name = value.toString();
+    if (name.isEmpty()) {
+        *err = QString("Missing \"%1\"").arg(field);
+        return -1;
+    }
+    auto key = s.data.keyToId.constFind(name);
+    if (key != s.data.keyToId.constEnd())
+        return key.value();
+
+    const QVector<int> ids = s.byName.value(name);
+    if (ids.size() == 1)
+        return ids[0];
+    if (ids.isEmpty()) {
+        *err = QString("No node named %1").arg(name);
+    } else {
+        QStringList keys;
+        for (int id : ids)
+            keys.push_back(nodeKey(s.data.nodes[id]));
+        *err = QString("%1 is ambiguous: %2").arg(name, keys.join(", "));
+    }
+    return -1;
+}
+
+// Everything that transitively depends on `id`. The modules are the
+// manifests (services) that pull it in.
+QJsonObject dependents(const Snapshot& s, int id, int limit)
+{
+    QVector<int> ids = s.data.reachability->upstream(id);
+    ids.removeOne(id);
+    std::sort(ids.begin(), ids.end());
+
+    QJsonArray modules;
+    QJsonArray nodes;
+    for (int v : ids) {
+        const Node& n = s.data.nodes[v];
+        if (n.kind.endsWith(":module"))
+            modules.append(n.name);
+        if (nodes.size() < limit)
+            nodes.append(nodeJson(n));
+    }
+
+    QJsonObject o;
+    o["node"] = nodeJson(s.data.nodes[id]);
+    o["count"] = ids.size();
+    o["modules"] = modules;
+    o["nodes"] = nodes;
+    o["truncated"] = ids.size() > nodes.size();
+    return o;
+}
+
+// Runs on the thread pool; reads nothing but the snapshot.
+Answer answer(const Snapshot& s, const QJsonObject& request)
+{
+    Answer a;
+    const QString op = request["op"].toString();
+    const int limit = request["limit"].toInt(kDefaultLimit) > 0 ? request["limit"].toInt(kDefaultLimit) : kDefaultLimit;
+    QJsonObject result;
+
+    if (op == "dependents") {
+        const int id = findNode(s, request["node"], "node", &a.error);
+        if (id < 0)
+            return a;
+        result = dependents(s, id, limit);
+    } else if (op == "impact") {
+        const int id = findNode(s, request["node"], "node", &a.error);
+        if (id < 0)
+            return a;
+        result = dependents(s, id, limit);
+
+        WhatIfOverlay overlay(s.data, s.edgeIndex);
+        overlay.setLocalMetadata(s.registry, s.advisories);
+        if (request.contains("version"))
+            overlay.setVersion(id, request["version"].toString());
+        if (request["drop"].toBool())
+            overlay.dropNode(id);
+
+        QJsonArray changes;
+        for (const WhatIfOverlay::StatusChange& c : overlay.statusChanges()) {
+            QJsonObject o;
+            o["node"] = nodeKey(s.data.nodes[c.nodeId]);
+            o["before"] = nodeStatusToString(c.before);
+            o["after"] = nodeStatusToString(c.after);
+            changes.append(o);
+        }
+        const QVector<int> lost = overlay.unreachable();
+        QJsonArray unreachable;
+        for (int i = 0; i < lost.size() && i < limit; i++)
+            unreachable.append(nodeKey(s.data.nodes[lost[i]]));
+        QJsonArray violations;
+        for (const WhatIfOverlay::Violation& v : overlay.violations()) {
+            QJsonObject o;
+            o["node"] = nodeKey(s.data.nodes[v.nodeId]);
+            o["requiredBy"] = nodeKey(s.data.nodes[v.requirerId]);
+            o["constraint"] = v.constraint;
+            violations.append(o);
+        }
+        result["statusChanges"] = changes;
+        result["violations"] = violations;
+        result["unreachable"] = unreachable;
+        result["unreachableCount"] = lost.size();
+    } else if (op == "path") {
+        const int to = findNode(s, request["to"], "to", &a.error);
+        if (to < 0)
+            return a;
+        const int from = request.contains("from") ? findNode(s, request["from"], "from", &a.error) : s.rootId;
+        if (from < 0) {
+            if (a.error.isEmpty())
+                a.error = "The graph has no repo root; pass \"from\"";
+            return a;
+        }
+        const int k = qBound(1, request["k"].toInt(1), kMaxPaths);
+        PathQuery query(s.data.reachability);
+        const QVector<QVector<int>> found =
+            k == 1 ? QVector<QVector<int>>{query.shortestPath(from, to)} : query.kShortestPaths(from, to, k);
+
+        QJsonArray paths;
+        for (const QVector<int>& path : found) {
+            if (path.isEmpty())
+                continue;
+            QJsonArray keys;
+            for (int v : path)
+                keys.append(nodeKey(s.data.nodes[v]));
+            paths.append(keys);
+        }
+        result["from"] = nodeKey(s.data.nodes[from]);
+        result["to"] = nodeKey(s.data.nodes[to]);
+        result["paths"] = paths;
+    } else if (op == "search") {
+        const QString query = request["query"].toString();
+        if (query.isEmpty()) {
+            a.error = "Missing \"query\"";
+            return a;
+        }
+        QJsonArray nodes;
+        for (const TrigramIndex::Match& m : s.data.search->search(query, limit))
+            nodes.append(nodeJson(s.data.nodes[m.nodeId]));
+        result["nodes"] = nodes;
+    } else if (op == "diff") {
+        GraphModel::Data before;
+        const QString against = request["against"].toString();
+        if (!against.isEmpty()) {
+            // The export may be rewritten between requests.
+            a.cacheable = false;
+            QFile f(against);
+            if (!f.open(QIODevice::ReadOnly)) {
+                a.error = QString("Cannot open %1").arg(against);
+                return a;
+            }
+            if (!GraphModel::fromJson(f.readAll(), &before, &a.error))
+                return a;
+        } else if (s.hasPrevious) {
+            before = s.previous;
+        } else {
+            a.error = "No previous scan yet; pass \"against\" with a JSON export";
+            return a;
+        }
+        result = GraphDiff::compute(before, s.data).toJsonObject();
+    } else {
+        a.error = QString("Unknown op \"%1\"").arg(op);
+        return a;
+    }
+
+    a.ok = true;
+    a.result = compact(result);
+    return a;
+}
+
+} // namespace
+
+QueryServer::QueryServer(QObject* parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &QueryServer::onNewConnection);
+    connect(&m_refreshTimer, &QTimer::timeout, this, [this]() {
+        for (int i = 0; i < m_repos.size(); i++)
+            rescan(i);
+    });
+}
+
+QueryServer::~QueryServer() = default;
+
+void QueryServer::addRepository(const QDir& dir)
+{
+    Repository repo;
+    repo.dir = dir;
+    repo.name = QFileInfo(dir.absolutePath()).fileName();
+    for (const Repository& other : m_repos) {
+        if (other.name == repo.name)
+            repo.name = dir.absolutePath();
+    }
+    repo.cache = std::make_shared<ManifestCache>();
+    m_repos.push_back(repo);
+}
+
+void QueryServer::setRefreshInterval(int seconds)
+{
+    m_refreshTimer.setInterval(qMax(0, seconds) * 1000);
+}
+
+void QueryServer::setLocalMetadata(std::shared_ptr<const RegistryIndex> registry,
+                                   std::shared_ptr<const AdvisoryDb> advisories)
+{
+    m_registry = std::move(registry);
+    m_advisories = std::move(advisories);
+}
+
+bool QueryServer::start(const QString& name, QString* err)
+{
+    if (m_repos.isEmpty()) {
+        if (err) *err = "No repository to serve.";
+        return false;
+    }
+    // A server that was killed leaves its socket file behind.
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        if (err) *err = QString("Cannot listen on %1: %2").arg(name, m_server->errorString());
+        return false;
+    }
+    for (int i = 0; i < m_repos.size(); i++)
+        rescan(i);
+    if (m_refreshTimer.interval() > 0)
+        m_refreshTimer.start();
+    return true;
+}
+
+QString QueryServer::serverPath() const
+{
+    return m_server->fullServerName();
+}
+
+void QueryServer::onNewConnection()
+{
+    while (QLocalSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { serveNext(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            m_busy.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void QueryServer::serveNext(QLocalSocket* socket)
+{
+    while (!m_busy.contains(socket) && socket->canReadLine()) {
+        const QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+        if (!doc.isObject()) {
+            socket->write(errorLine(QJsonValue(), doc.isNull() ? parseError.errorString() : QString("Not a JSON object")));
+            continue;
+        }
+        dispatch(socket, doc.object());
+    }
+}
+
+void QueryServer::dispatch(QLocalSocket* socket, const QJsonObject& request)
+{
+    const QJsonValue id = request["id"];
+    const QString op = request["op"].toString();
+
+    if (op == "repos") {
+        QJsonArray repos;
+        for (const Repository& r : m_repos) {
+            QJsonObject o;
+            o["name"] = r.name;
+            o["path"] = r.dir.absolutePath();
+            o["scanning"] = r.scanning;
+            if (r.snapshot) {
+                o["nodes"] = r.snapshot->data.nodes.size();
+                o["edges"] = r.snapshot->data.edges.size();
+                o["generation"] = r.snapshot->generation;
+                o["scannedAt"] = r.snapshot->scannedAt.toString(Qt::ISODate);
+            }
+            repos.append(o);
+        }
+        QJsonObject result;
+        result["repos"] = repos;
+        socket->write(okLine(id, compact(result)));
+        return;
+    }
+
+    QString err;
+    const int index = findRepository(request["repo"], &err);
+    if (index < 0) {
+        socket->write(errorLine(id, err));
+        return;
+    }
+    Repository& repo = m_repos[index];
+
+    // Later requests on this connection wait until these are answered.
+    if (op == "refresh") {
+        m_busy.insert(socket);
+        if (repo.scanning) {
+            repo.afterScan.push_back({socket, request});
+        } else {
+            repo.waiting.push_back({socket, request});
+            rescan(index);
+        }
+        return;
+    }
+    if (!repo.snapshot) {
+        m_busy.insert(socket);
+        repo.waiting.push_back({socket, request});
+        return;
+    }
+
+    QJsonObject query = request;
+    query.remove("id");
+    query.remove("repo");
+    // Keys are sorted, so the same question always gives the same key.
+    const QByteArray key = repo.name.toUtf8() + '\n' + compact(query);
+    auto cached = m_cache.constFind(key);
+    if (cached != m_cache.constEnd()) {
+        socket->write(okLine(id, cached.value()));
+        return;
+    }
+
+    m_busy.insert(socket);
+    const std::shared_ptr<const Snapshot> snapshot = repo.snapshot;
+    QPointer<QLocalSocket> guard(socket);
+    QtConcurrent::run([snapshot, request]() { return answer(*snapshot, request); })
+        .then(this, [this, guard, id, key, snapshot, index](const Answer& a) {
+            // Not cached when a newer scan was published meanwhile.
+            if (a.ok && a.cacheable && m_repos[index].snapshot == snapshot) {
+                if (m_cache.size() >= kMaxCachedAnswers)
+                    m_cache.clear();
+                m_cache.insert(key, a.result);
+            }
+            if (guard)
+                finish(guard, a.ok ? okLine(id, a.result) : errorLine(id, a.error));
+        });
+}
+
+void QueryServer::finish(QLocalSocket* socket, const QByteArray& line)
+{
+    m_busy.remove(socket);
+    socket->write(line);
+    serveNext(socket);
+}
+
+void QueryServer::rescan(int index)
+{
+    Repository& repo = m_repos[index];
+    if (repo.scanning)
+        return;
+    repo.scanning = true;
+
+    // Unchanged manifests come from the repository's ManifestCache, and an
+    // unchanged graph keeps the published snapshot and its cached answers.
+    const QDir dir = repo.dir;
+    const std::shared_ptr<const Snapshot> old = repo.snapshot;
+    QtConcurrent::run([dir, cache = repo.cache, old, registry = m_registry,
+                       advisories = m_advisories]() -> std::pair<std::shared_ptr<const Snapshot>, bool> {
+        GraphModel tmp;
+        QString err;
+        // Best-effort, as in the window: a partial graph is still served.
+        (void)DependencyScanner::scanRepositoryToGraph(dir, &tmp, &err, cache.get());
+        if (registry || advisories) {
+            QVector<NodeStatus> statuses;
+            statuses.reserve(tmp.nodes().size());
+            for (const Node& n : tmp.nodes())
+                statuses.push_back(n.status);
+            if (registry)
+                registry->markOutdated(tmp.nodes(), &statuses);
+            if (advisories)
+                advisories->markVulnerable(tmp.nodes(), &statuses);
+            tmp.setStatuses(statuses);
+        }
+        if (old && sameGraph(old->data, tmp.nodes(), tmp.edges()))
+            return {old, false};
+
+        auto s = std::make_shared<Snapshot>();
+        s->edgeIndex = tmp.edgeIndex();
+        s->registry = registry;
+        s->advisories = advisories;
+        s->data = tmp.takeData();
+        s->data.reachability = ReachabilityIndex::build(s->data.nodes.size(), s->data.edges);
+        s->data.search = TrigramIndex::build(s->data.nodes);
+        if (old) {
+            s->previous = old->data;
+            s->previous.reachability.reset();
+            s->previous.search.reset();
+            s->hasPrevious = true;
+        }
+        for (const Node& n : s->data.nodes) {
+            s->byName[n.name].push_back(n.id);
+            if (s->rootId < 0 && n.kind == "repo")
+                s->rootId = n.id;
+        }
+        s->generation = old ? old->generation + 1 : 1;
+        s->scannedAt = QDateTime::currentDateTimeUtc();
+        return {std::move(s), true};
+    }).then(this, [this, index](const std::pair<std::shared_ptr<const Snapshot>, bool>& scanned) {
+        publish(index, scanned.first, scanned.second);
+    });
+}
+
+void QueryServer::publish(int index, std::shared_ptr<const Snapshot> snapshot, bool changed)
+{
+    Repository& repo = m_repos[index];
+    repo.scanning = false;
+    if (changed) {
+        repo.snapshot = std::move(snapshot);
+        // Only this repository's answers are stale; keys start with its name.
+        const QByteArray prefix = repo.name.toUtf8() + '\n';
+        for (auto it = m_cache.begin(); it != m_cache.end();) {
+            if (it.key().startsWith(prefix))
+                it = m_cache.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    QVector<Waiting> waiting;
+    waiting.swap(repo.waiting);
+    repo.waiting.swap(repo.afterScan);
+    if (!repo.waiting.isEmpty())
+        rescan(index);
+
+    for (const Waiting& w : waiting) {
+        if (!w.socket)
+            continue;
+        if (w.request["op"].toString() == "refresh") {
+            QJsonObject result;
+            result["generation"] = repo.snapshot->generation;
+            result["changed"] = changed;
+            result["nodes"] = repo.snapshot->data.nodes.size();
+            result["edges"] = repo.snapshot->data.edges.size();
+            finish(w.socket, okLine(w.request["id"], compact(result)));
+        } else {
+            m_busy.remove(w.socket);
+            dispatch(w.socket, w.request);
+            serveNext(w.socket);
+        }
+    }
+}
+
+int QueryServer::findRepository(const QJsonValue& name, QString* err) const
+{
+    const QString wanted = name.toString();
+    if (wanted.isEmpty()) {
+        if (m_repos.size() == 1)
+            return 0;
+        *err = "Several repositories are served; pass \"repo\"";
+        return -1;
+    }
+    for (int i = 0; i < m_repos.size(); i++) {
+        if (m_repos[i].name == wanted)
+            return i;
+    }
+    *err = QString("Unknown repo \"%1\"").arg(wanted);
+    return -1;
+}
@@ -0,0 +1,118 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalSocket>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+
+#include "model/GraphModel.h"
+
+class AdvisoryDb;
+class QLocalServer;
+class ManifestCache;
+class RegistryIndex;
+
+// Headless DepGraph for scripts and CI (`DepGraph --serve <repo>`): keeps the
+// graphs of one or more repositories in memory, rescans them incrementally
+// and answers queries over a local socket.
+//
+// One JSON object per line each way. A request has "op", "repo" when more
+// than one repository is served, an optional "id" that is echoed back, and
+// the op's fields:
+//   repos                               served repositories and their sizes
+//   dependents {node, limit?}           everything that transitively depends on node
+//   impact     {node, version?, drop?}  dependents, plus what bumping or dropping
+//                                       node changes (WhatIfOverlay) and which
+//                                       requirements a bump breaks
+//   path       {to, from?, k?}          shortest chains, from the repo root by default
+//   search     {query, limit?}          filter-box syntax (TrigramIndex)
+//   diff       {against?}               against the previous scan or a JSON export
+//   refresh                             rescan now; answered once published
+// Replies are {"id", "ok": true, "result": {...}} or {"id", "ok": false,
+// "error": "..."}. Nodes are named by "kind:name" key or by plain name.
+//
+// Every scan publishes an immutable Snapshot. Queries run on the thread pool
+// against the snapshot current when they arrived, so readers never lock and
+// never see a graph mid-update. Answers are cached per snapshot, so asking
+// again is one hash lookup on the server thread. Each connection is answered
+// in order; separate connections are served concurrently.
+class QueryServer : public QObject {
+    Q_OBJECT
+public:
+    explicit QueryServer(QObject* parent = nullptr);
+    ~QueryServer() override;
+
+    // Served under its directory name. Call before start().
+    void addRepository(const QDir& dir);
+    // Seconds between rescans; 0 rescans only on "refresh".
+    void setRefreshInterval(int seconds);
+    // Registry lag and advisories applied to every scan and to "impact", as
+    // the window does; without them statuses come from version rules alone.
+    // Call before start().
+    void setLocalMetadata(std::shared_ptr<const RegistryIndex> registry, std::shared_ptr<const AdvisoryDb> advisories);
+
+    // Starts the first scans and listens on `name`: a socket path, or a name
+    // placed in the temp directory (a named pipe on Windows).
+    bool start(const QString& name, QString* err);
+    QString serverPath() const;
+
+    // What one scan produced. Published whole and never modified, so
+    // queries on other threads read it without locks.
+    struct Snapshot {
+        GraphModel::Data data; // with reachability and search indexes
+        std::shared_ptr<const GraphModel::EdgeIndex> edgeIndex;
+        std::shared_ptr<const RegistryIndex> registry; // may be null
+        std::shared_ptr<const AdvisoryDb> advisories;  // may be null
+        GraphModel::Data previous; // the scan before, for "diff"; no indexes
+        bool hasPrevious = false;
+        QHash<QString, QVector<int>> byName;
+        int rootId = -1;
+        int generation = 0;
+        QDateTime scannedAt;
+    };
+
+private:
+    struct Waiting {
+        QPointer<QLocalSocket> socket;
+        QJsonObject request;
+    };
+
+    struct Repository {
+        QString name;
+        QDir dir;
+        std::shared_ptr<ManifestCache> cache;
+        std::shared_ptr<const Snapshot> snapshot; // replaced, never modified
+        bool scanning = false;
+        // Requests held until the scan in progress is published: "refresh",
+        // and anything asked before the first scan finished.
+        QVector<Waiting> waiting;
+        // "refresh" asked during a scan, which may have read the files
+        // before they changed: answered by the scan after it.
+        QVector<Waiting> afterScan;
+    };
+
+    void onNewConnection();
+    void serveNext(QLocalSocket* socket);
+    void dispatch(QLocalSocket* socket, const QJsonObject& request);
+    void finish(QLocalSocket* socket, const QByteArray& line);
+    void rescan(int repo);
+    void publish(int repo, std::shared_ptr<const Snapshot> snapshot, bool changed);
+    int findRepository(const QJsonValue& name, QString* err) const;
+
+    QLocalServer* m_server = nullptr;
+    QTimer m_refreshTimer;
+    std::shared_ptr<const RegistryIndex> m_registry;
+    std::shared_ptr<const AdvisoryDb> m_advisories;
+    QVector<Repository> m_repos;
+    QSet<QLocalSocket*> m_busy; // waiting for an answer; later lines stay queued
+    QHash<QByteArray, QByteArray> m_cache; // repo name + request -> result JSON
+};
@@ -0,0 +1,136 @@
+﻿#include "MemoryReport.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QStringList>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+static QString formatBytes(qint64 bytes)
+{
+    return QLocale().formattedDataSize(bytes);
+}
+
+void MemoryReport::add(const QString& component, const QString& part, qint64 bytes, qint64 count)
+{
+    m_entries.push_back({component, part, bytes, count});
+}
+
+qint64 MemoryReport::total() const
+{
+    qint64 sum = 0;
+    for (const Entry& e : m_entries)
+        sum += e.bytes;
+    return sum;
+}
+
+qint64 MemoryReport::total(const QString& component) const
+{
+    qint64 sum = 0;
+    for (const Entry& e : m_entries) {
+        if (e.component == component)
+            sum += e.bytes;
+    }
+    return sum;
+}
+
+qint64 MemoryReport::processResidentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return qint64(pmc.WorkingSetSize);
+    return -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, task_info_t(&info), &count) == KERN_SUCCESS)
+        return qint64(info.resident_size);
+    return -1;
+#elif defined(Q_OS_UNIX)
+    // statm: size resident shared ... in pages
+    QFile f("/proc/self/statm");
+    if (!f.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = f.readAll().split(' ');
+    bool ok = false;
+    const qint64 pages = fields.value(1).toLongLong(&ok);
+    return ok ? pages * sysconf(_SC_PAGESIZE) : -1;
+#else
+    return -1;
+#endif
+}
+
+QString MemoryReport::toText() const
+{
+    QStringList lines;
+    QStringList components;
+    for (const Entry& e : m_entries) {
+        if (!components.contains(e.component))
+            components << e.component;
+    }
+
+    for (const QString& c : components) {
+        lines << QString("%1  %2").arg(c, -28).arg(formatBytes(total(c)), 12);
+        for (const Entry& e : m_entries) {
+            if (e.component != c)
+                continue;
+            const QString count = e.count >= 0 ? QString("  (%1)").arg(e.count) : QString();
+            lines << QString("  %1%2").arg(e.part, -26).arg(formatBytes(e.bytes), 12) + count;
+        }
+    }
+    lines << QString("%1  %2").arg("estimated total", -28).arg(formatBytes(total()), 12);
+
+    const qint64 rss = processResidentBytes();
+    if (rss >= 0)
+        lines << QString("%1  %2").arg("process resident", -28).arg(formatBytes(rss), 12);
+    return lines.join('\n');
+}
+
+QByteArray MemoryReport::toJson() const
+{
+    QJsonArray entries;
+    for (const Entry& e : m_entries) {
+        QJsonObject o;
+        o["component"] = e.component;
+        o["part"] = e.part;
+        o["bytes"] = e.bytes;
+        if (e.count >= 0)
+            o["count"] = e.count;
+        entries.push_back(o);
+    }
+
+    QJsonObject root;
+    root["entries"] = entries;
+    root["estimatedTotal"] = total();
+    root["processResident"] = processResidentBytes();
+    return QJsonDocument(root).toJson(QJsonDocument::Indented);
+}
+
+QString MemoryReport::summaryLine() const
+{
+    QStringList parts;
+    QStringList seen;
+    for (const Entry& e : m_entries) {
+        if (seen.contains(e.component))
+            continue;
+        seen << e.component;
+        parts << QString("%1 %2").arg(e.component, formatBytes(total(e.component)));
+    }
+
+    QString line = parts.join(", ");
+    const qint64 rss = processResidentBytes();
+    if (rss >= 0)
+        line += QString(" (resident %1)").arg(formatBytes(rss));
+    return line;
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+// Estimated heap usage broken down by component ("model", "view", ...) and
+// part ("nodes", "key index", ...). Components fill it through their
+// reportMemory() methods.
+//
+// Figures are estimates from container capacities and element sizes, not
+// allocator measurements: they are meant to show which part dominates and
+// whether a change moved it, and are compared against the process resident
+// size, which is measured.
+class MemoryReport {
+public:
+    struct Entry {
+        QString component;
+        QString part;
+        qint64 bytes = 0;
+        qint64 count = -1; // elements, items...; -1 when not meaningful
+    };
+
+    void add(const QString& component, const QString& part, qint64 bytes, qint64 count = -1);
+
+    const QVector<Entry>& entries() const { return m_entries; }
+    qint64 total() const;
+    qint64 total(const QString& component) const;
+
+    // Resident set size of this process; -1 where the OS does not tell.
+    static qint64 processResidentBytes();
+
+    // One line per part, grouped by component, with totals.
+    QString toText() const;
+    QByteArray toJson() const;
+    // "model 12.3 MiB, view 4.5 MiB, ... (resident 80 MiB)"
+    QString summaryLine() const;
+
+    // Estimation helpers.
+    static qint64 bytesOf(const QString& s)
+    {
+        // Header plus UTF-16 storage; the shared empty string costs nothing.
+        return s.capacity() > 0 ? kArrayHeader + (qint64(s.capacity()) + 1) * 2 : 0;
+    }
+
+    template <typename T>
+    static qint64 bytesOf(const QVector<T>& v)
+    {
+        return v.capacity() > 0 ? kArrayHeader + qint64(v.capacity()) * qint64(sizeof(T)) : 0;
+    }
+
+    // Qt 6 hashes: one offset byte per bucket, spans of 128 buckets and the
+    // entries themselves. Keys and values that own heap memory (strings,
+    // nested containers) are not followed; callers add those.
+    template <typename K, typename V>
+    static qint64 bytesOf(const QHash<K, V>& h)
+    {
+        if (h.capacity() == 0)
+            return 0;
+        const qint64 spans = (qint64(h.capacity()) + 127) / 128;
+        return kHashHeader + spans * kSpanOverhead + qint64(h.capacity()) + qint64(h.size()) * qint64(sizeof(K) + sizeof(V));
+    }
+
+    template <typename T>
+    static qint64 bytesOf(const QSet<T>& s)
+    {
+        if (s.capacity() == 0)
+            return 0;
+        const qint64 spans = (qint64(s.capacity()) + 127) / 128;
+        return kHashHeader + spans * kSpanOverhead + qint64(s.capacity()) + qint64(s.size()) * qint64(sizeof(T));
+    }
+
+    static constexpr qint64 kArrayHeader = 16; // QArrayData: ref, flags, capacity
+    static constexpr qint64 kHashHeader = 32;
+    static constexpr qint64 kSpanOverhead = 136; // offsets[128] + entries pointer
+
+private:
+    QVector<Entry> m_entries;
+};
@@ -0,0 +1,40 @@
+﻿#include "PackageIndex.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+
+#include "util/PerfectHash.h"
+
+namespace PackageIndex {
+
+quint64 sourceStamp(const QString& sourcePath)
+{
+    const QFileInfo fi(sourcePath);
+    if (!fi.exists())
+        return 0;
+    QByteArray s = fi.absoluteFilePath().toUtf8();
+    s += '|' + QByteArray::number(fi.lastModified().toMSecsSinceEpoch());
+    if (fi.isDir()) {
+        const QFileInfoList subdirs =
+            QDir(sourcePath).entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+        for (const QFileInfo& d : subdirs)
+            s += '|' + d.fileName().toUtf8() + ':' + QByteArray::number(d.lastModified().toMSecsSinceEpoch());
+    } else {
+        s += '|' + QByteArray::number(fi.size());
+    }
+    return PerfectHash::hashBytes(s) | 1; // never 0, which means "no source"
+}
+
+QByteArray packageKey(const QString& ecosystem, const QString& name)
+{
+    QString n = name.trimmed();
+    if (ecosystem == "pypi") {
+        static const QRegularExpression separators("[-_.]+");
+        n = n.toLower().replace(separators, "-");
+    }
+    return ecosystem.toUtf8() + '\x1f' + n.toUtf8();
+}
+
+} // namespace PackageIndex
@@ -0,0 +1,19 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Shared by the on-disk package indexes (AdvisoryDb, RegistryIndex).
+namespace PackageIndex {
+
+// Identifies a source dump's state without reading it: path, modification
+// time and size for a file; for a directory its own and its immediate
+// subdirectories' modification times, which files coming and going touch.
+// Files edited in place need a forced rebuild. 0 when the source is missing.
+quint64 sourceStamp(const QString& sourcePath);
+
+// Lookup key of a package within an ecosystem ("npm", "pypi", ...). PyPI
+// names are PEP 503 normalised: "Foo_Bar.baz" and "foo-bar-baz" are one.
+QByteArray packageKey(const QString& ecosystem, const QString& name);
+
+} // namespace PackageIndex
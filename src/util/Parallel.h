@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace Parallel {
+
+// Runs fn(begin, end) over [0, count) in chunks of at least `minChunk` on the
+// global thread pool, about four per thread, and returns when all are done.
+template <typename Fn>
+void forChunks(int count, int minChunk, Fn fn)
+{
+    const int chunk = qMax(qMax(1, minChunk), count / (QThread::idealThreadCount() * 4));
+    QVector<int> starts;
+    for (int s = 0; s < count; s += chunk)
+        starts.push_back(s);
+    QtConcurrent::blockingMap(starts, [&](int s) { fn(s, qMin(count, s + chunk)); });
+}
+
+} // namespace Parallel
@@ -0,0 +1,88 @@
+﻿#include "PerfectHash.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace PerfectHash {
+
+quint64 hashBytes(const char* data, qsizetype size)
+{
+    quint64 h = 14695981039346656037ull;
+    for (qsizetype i = 0; i < size; i++) {
+        h ^= quint8(data[i]);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool build(const QVector<quint64>& hashes, Table* out, QString* err)
+{
+    const quint32 n = quint32(hashes.size());
+    out->seeds.clear();
+    out->slotKeys.clear();
+    if (n == 0)
+        return true;
+
+    {
+        QVector<quint64> sorted = hashes;
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            if (err) *err = "Two keys have the same hash.";
+            return false;
+        }
+    }
+
+    // About four keys per bucket and 80% of slots used: seeds are found in a
+    // few tries even for the last, fullest stretch of the table.
+    const quint32 bucketCount = qMax<quint32>(1, (n + 3) / 4);
+    const quint32 slotCount = n + n / 4 + 1;
+
+    // Keys grouped by bucket (counting sort).
+    QVector<quint32> bucketStart(bucketCount + 1, 0);
+    for (quint64 h : hashes)
+        bucketStart[bucketOf(h, bucketCount) + 1]++;
+    for (quint32 b = 0; b < bucketCount; b++)
+        bucketStart[b + 1] += bucketStart[b];
+    QVector<quint32> keys(n);
+    {
+        QVector<quint32> fill = bucketStart;
+        for (quint32 i = 0; i < n; i++)
+            keys[fill[bucketOf(hashes[i], bucketCount)]++] = i;
+    }
+
+    // Largest buckets first, while the table is still empty.
+    QVector<quint32> order(bucketCount);
+    for (quint32 b = 0; b < bucketCount; b++)
+        order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&](quint32 a, quint32 b) {
+        return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+    });
+
+    out->seeds.fill(0, int(bucketCount));
+    out->slotKeys.fill(kEmpty, int(slotCount));
+    std::vector<quint32> positions;
+    for (quint32 b : order) {
+        const quint32 begin = bucketStart[b];
+        const quint32 end = bucketStart[b + 1];
+        if (begin == end)
+            break; // the rest are empty too
+        for (quint32 seed = 0;; seed++) {
+            positions.clear();
+            bool ok = true;
+            for (quint32 k = begin; k < end && ok; k++) {
+                const quint32 pos = slotOf(hashes[keys[k]], seed, slotCount);
+                ok = out->slotKeys[pos] == kEmpty && std::find(positions.begin(), positions.end(), pos) == positions.end();
+                positions.push_back(pos);
+            }
+            if (!ok)
+                continue;
+            for (quint32 k = begin; k < end; k++)
+                out->slotKeys[positions[k - begin]] = keys[k];
+            out->seeds[b] = seed;
+            break;
+        }
+    }
+    return true;
+}
+
+} // namespace PerfectHash
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Perfect hashing for static key sets stored in index files ("hash and
+// displace"): keys are spread over buckets of about four, and each bucket
+// gets a seed under which all of its keys land in free slots. A lookup is
+// one string hash, one seed read and one slot read, with no probing.
+//
+// Unknown keys also land on some slot, so callers compare the stored key.
+// Hashes are stable across runs and platforms, so tables can be written to
+// disk and mapped back.
+namespace PerfectHash {
+
+constexpr quint32 kEmpty = 0xffffffffu;
+
+// 64-bit FNV-1a.
+quint64 hashBytes(const char* data, qsizetype size);
+
+inline quint64 hashBytes(const QByteArray& bytes)
+{
+    return hashBytes(bytes.constData(), bytes.size());
+}
+
+// splitmix64 finaliser; spreads a key hash under a seed.
+inline quint64 mix(quint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+inline quint32 bucketOf(quint64 hash, quint32 bucketCount)
+{
+    return quint32(hash % bucketCount);
+}
+
+inline quint32 slotOf(quint64 hash, quint32 seed, quint32 slotCount)
+{
+    return quint32(mix(hash ^ (quint64(seed) * 0x9e3779b97f4a7c15ull)) % slotCount);
+}
+
+struct Table {
+    QVector<quint32> seeds; // per bucket
+    QVector<quint32> slotKeys; // key index per slot, or kEmpty
+};
+
+// Finds seeds for keys with the given (distinct) hashes. Fails only when two
+// keys share a 64-bit hash.
+bool build(const QVector<quint64>& hashes, Table* out, QString* err);
+
+// Index of the key that would have `hash`, or kEmpty.
+inline quint32 lookup(quint64 hash, const quint32* seeds, quint32 bucketCount, const quint32* slotKeys, quint32 slotCount)
+{
+    if (bucketCount == 0 || slotCount == 0)
+        return kEmpty;
+    return slotKeys[slotOf(hash, seeds[bucketOf(hash, bucketCount)], slotCount)];
+}
+
+} // namespace PerfectHash
@@ -0,0 +1,249 @@
+﻿#include "PngStreamWriter.h"
+
+#include <QImage>
+#include <QtEndian>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "util/Trace.h"
+
+// Compressed bytes per IDAT chunk.
+static constexpr int kIdatBytes = 256 * 1024;
+// RGB, 8 bits per channel.
+static constexpr int kBytesPerPixel = 3;
+
+static void appendBigEndian(QByteArray* out, quint32 v)
+{
+    const quint32 be = qToBigEndian(v);
+    out->append(reinterpret_cast<const char*>(&be), 4);
+}
+
+static int paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+// Writes filter `type` of `raw` (previous row `prev`) into `out`, which starts
+// with the filter byte. Returns the sum of absolute byte values, the usual
+// estimate of how well the row will compress.
+static quint64 filterRow(int type, const quint8* raw, const quint8* prev, int len, quint8* out)
+{
+    out[0] = quint8(type);
+    quint64 cost = 0;
+    for (int i = 0; i < len; i++) {
+        const int a = i >= kBytesPerPixel ? raw[i - kBytesPerPixel] : 0;
+        const int b = prev[i];
+        const int c = i >= kBytesPerPixel ? prev[i - kBytesPerPixel] : 0;
+        int v = raw[i];
+        switch (type) {
+        case 1: v -= a; break;
+        case 2: v -= b; break;
+        case 3: v -= (a + b) / 2; break;
+        case 4: v -= paeth(a, b, c); break;
+        default: break;
+        }
+        out[i + 1] = quint8(v);
+        cost += std::abs(int(qint8(quint8(v))));
+    }
+    return cost;
+}
+
+PngStreamWriter::PngStreamWriter() = default;
+
+PngStreamWriter::~PngStreamWriter()
+{
+    abort();
+}
+
+bool PngStreamWriter::fail(const QString& message, QString* err)
+{
+    if (err)
+        *err = message;
+    abort();
+    return false;
+}
+
+bool PngStreamWriter::open(const QString& path, int width, int height, int dpi, QString* err)
+{
+    abort();
+    if (width <= 0 || height <= 0)
+        return fail("Nothing to export: the image is empty.", err);
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly))
+        return fail(QString("Cannot write %1: %2").arg(path, m_file.errorString()), err);
+
+    m_zs = std::make_unique<z_stream_s>();
+    std::memset(m_zs.get(), 0, sizeof(z_stream_s));
+    if (deflateInit(m_zs.get(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        m_zs.reset();
+        return fail("Cannot initialise the PNG compressor.", err);
+    }
+    m_open = true;
+    m_width = width;
+    m_height = height;
+    m_rowsWritten = 0;
+
+    const int rowBytes = width * kBytesPerPixel;
+    m_prev.fill('\0', rowBytes);
+    m_raw.resize(rowBytes);
+    m_filtered.resize(5 * (rowBytes + 1));
+    m_out.resize(kIdatBytes);
+    m_zs->next_out = reinterpret_cast<Bytef*>(m_out.data());
+    m_zs->avail_out = uInt(m_out.size());
+
+    static const char kSignature[8] = {char(137), 'P', 'N', 'G', '\r', '\n', char(26), '\n'};
+    if (m_file.write(kSignature, 8) != 8)
+        return fail(m_file.errorString(), err);
+
+    QByteArray ihdr;
+    appendBigEndian(&ihdr, quint32(width));
+    appendBigEndian(&ihdr, quint32(height));
+    ihdr.append(char(8)); // bit depth
+    ihdr.append(char(2)); // colour type: RGB
+    ihdr.append(char(0)); // deflate
+    ihdr.append(char(0)); // adaptive filtering
+    ihdr.append(char(0)); // no interlace
+    if (!writeChunk("IHDR", ihdr, err))
+        return false;
+
+    if (dpi > 0) {
+        const quint32 ppm = quint32(dpi / 0.0254 + 0.5);
+        QByteArray phys;
+        appendBigEndian(&phys, ppm);
+        appendBigEndian(&phys, ppm);
+        phys.append(char(1)); // unit: metre
+        if (!writeChunk("pHYs", phys, err))
+            return false;
+    }
+    return true;
+}
+
+bool PngStreamWriter::writeChunk(const char* type, const QByteArray& data, QString* err)
+{
+    QByteArray chunk;
+    chunk.reserve(data.size() + 12);
+    appendBigEndian(&chunk, quint32(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+    const uLong crc = crc32(0, reinterpret_cast<const Bytef*>(chunk.constData() + 4), uInt(data.size() + 4));
+    appendBigEndian(&chunk, quint32(crc));
+    if (m_file.write(chunk) != chunk.size())
+        return fail(QString("Cannot write %1: %2").arg(m_file.fileName(), m_file.errorString()), err);
+    return true;
+}
+
+bool PngStreamWriter::deflateRow(const quint8* row, int flush, QString* err)
+{
+    const int len = m_width * kBytesPerPixel + 1;
+    m_zs->next_in = const_cast<Bytef*>(row);
+    m_zs->avail_in = row ? uInt(len) : 0;
+
+    int ret = Z_OK;
+    do {
+        ret = deflate(m_zs.get(), flush);
+        if (ret == Z_STREAM_ERROR)
+            return fail("PNG compression failed.", err);
+        if (m_zs->avail_out == 0) {
+            if (!writeChunk("IDAT", m_out, err))
+                return false;
+            m_zs->next_out = reinterpret_cast<Bytef*>(m_out.data());
+            m_zs->avail_out = uInt(m_out.size());
+        }
+    } while (m_zs->avail_in > 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    return true;
+}
+
+bool PngStreamWriter::writeRows(const QImage& rows, QString* err)
+{
+    if (!m_open)
+        return fail("The PNG file is not open.", err);
+    if (rows.width() != m_width || m_rowsWritten + rows.height() > m_height)
+        return fail("Rows do not fit the PNG image size.", err);
+
+    Trace::Span span("export.encode");
+    QImage img = rows;
+    if (img.format() != QImage::Format_RGB32 && img.format() != QImage::Format_ARGB32 &&
+        img.format() != QImage::Format_ARGB32_Premultiplied)
+        img = img.convertToFormat(QImage::Format_RGB32);
+
+    const int rowBytes = m_width * kBytesPerPixel;
+    auto* raw = reinterpret_cast<quint8*>(m_raw.data());
+    auto* prev = reinterpret_cast<const quint8*>(m_prev.constData());
+    auto* filtered = reinterpret_cast<quint8*>(m_filtered.data());
+
+    for (int y = 0; y < img.height(); y++) {
+        const auto* line = reinterpret_cast<const QRgb*>(img.constScanLine(y));
+        for (int x = 0; x < m_width; x++) {
+            raw[x * 3] = quint8(qRed(line[x]));
+            raw[x * 3 + 1] = quint8(qGreen(line[x]));
+            raw[x * 3 + 2] = quint8(qBlue(line[x]));
+        }
+
+        int best = 0;
+        quint64 bestCost = ~quint64(0);
+        for (int type = 0; type < 5; type++) {
+            const quint64 cost = filterRow(type, raw, prev, rowBytes, filtered + type * (rowBytes + 1));
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = type;
+            }
+        }
+        if (!deflateRow(filtered + best * (rowBytes + 1), Z_NO_FLUSH, err))
+            return false;
+
+        std::memcpy(m_prev.data(), raw, size_t(rowBytes));
+        m_rowsWritten++;
+    }
+    return true;
+}
+
+bool PngStreamWriter::finish(QString* err)
+{
+    if (!m_open)
+        return fail("The PNG file is not open.", err);
+    if (m_rowsWritten != m_height)
+        return fail(QString("Only %1 of %2 rows were written.").arg(m_rowsWritten).arg(m_height), err);
+
+    if (!deflateRow(nullptr, Z_FINISH, err))
+        return false;
+    const int pending = m_out.size() - int(m_zs->avail_out);
+    if (pending > 0 && !writeChunk("IDAT", m_out.left(pending), err))
+        return false;
+    if (!writeChunk("IEND", QByteArray(), err))
+        return false;
+
+    deflateEnd(m_zs.get());
+    m_zs.reset();
+    m_open = false;
+    if (!m_file.commit())
+        return fail(QString("Cannot write %1: %2").arg(m_file.fileName(), m_file.errorString()), err);
+    return true;
+}
+
+void PngStreamWriter::abort()
+{
+    if (m_zs) {
+        deflateEnd(m_zs.get());
+        m_zs.reset();
+    }
+    if (m_file.isOpen()) {
+        // Committing a cancelled save closes it and removes the temporary file.
+        m_file.cancelWriting();
+        m_file.commit();
+    }
+    m_open = false;
+    m_prev.clear();
+    m_raw.clear();
+    m_filtered.clear();
+    m_out.clear();
+}
@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QSaveFile>
+#include <QString>
+
+#include <memory>
+
+class QImage;
+struct z_stream_s;
+
+// Writes an 8-bit RGB PNG a band of rows at a time, so an image never has to
+// exist in memory as a whole. Rows are filtered per row (the usual
+// minimum-sum-of-differences choice) and deflated into IDAT chunks as the
+// compressed output fills up.
+//
+// Not thread-safe, but it may be driven from any one thread at a time. The
+// file is written through QSaveFile: nothing replaces `path` unless finish()
+// succeeds.
+class PngStreamWriter {
+public:
+    PngStreamWriter();
+    ~PngStreamWriter();
+    PngStreamWriter(const PngStreamWriter&) = delete;
+    PngStreamWriter& operator=(const PngStreamWriter&) = delete;
+
+    // `dpi` > 0 adds a pHYs chunk so viewers and printers know the intended size.
+    bool open(const QString& path, int width, int height, int dpi, QString* err);
+
+    // Appends rows top to bottom. `rows` must be as wide as the image; alpha
+    // is dropped, so it should be opaque.
+    bool writeRows(const QImage& rows, QString* err);
+
+    // Writes the last chunks once every row has been written, and commits.
+    bool finish(QString* err);
+    // Discards the partial file.
+    void abort();
+
+    int rowsWritten() const { return m_rowsWritten; }
+
+private:
+    bool deflateRow(const quint8* row, int flush, QString* err);
+    bool writeChunk(const char* type, const QByteArray& data, QString* err);
+    bool fail(const QString& message, QString* err);
+
+    QSaveFile m_file;
+    std::unique_ptr<z_stream_s> m_zs;
+    bool m_open = false;
+    int m_width = 0;
+    int m_height = 0;
+    int m_rowsWritten = 0;
+    QByteArray m_prev;     // previous raw row, for the Up/Average/Paeth filters
+    QByteArray m_raw;      // current raw row
+    QByteArray m_filtered; // filter byte + filtered row, per candidate filter
+    QByteArray m_out;      // deflate output, flushed as one IDAT when full
+};
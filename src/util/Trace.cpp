@@ -0,0 +1,246 @@
+﻿#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocale>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QThread>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+std::atomic<bool> Trace::s_enabled{false};
+
+namespace {
+
+struct Event {
+    const char* name;
+    qint64 start;
+    qint64 end;
+    QString detail;
+};
+
+// One per thread that ever recorded something. Only its own thread appends;
+// the mutex is taken by that thread and, rarely, by a reader merging buffers,
+// so it is practically never contended.
+struct ThreadBuffer {
+    int tid = 0;
+    QString threadName;
+    QMutex mutex;
+    QVector<Event> events;
+    QHash<QString, qint64> counts; // group + '\x1f' + counter
+};
+
+struct Registry {
+    QMutex mutex;
+    // Kept alive past thread exit so a finished worker's spans still export.
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::atomic<qint64> epoch{Trace::now()};
+};
+
+Registry& registry()
+{
+    static Registry r;
+    return r;
+}
+
+ThreadBuffer& localBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer) {
+        buffer = std::make_shared<ThreadBuffer>();
+        QThread* thread = QThread::currentThread();
+        Registry& r = registry();
+        QMutexLocker lock(&r.mutex);
+        buffer->tid = int(r.buffers.size()) + 1;
+        if (!thread->objectName().isEmpty())
+            buffer->threadName = thread->objectName();
+        else if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+            buffer->threadName = "main";
+        else
+            buffer->threadName = QString("worker %1").arg(buffer->tid);
+        r.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+std::vector<std::shared_ptr<ThreadBuffer>> allBuffers()
+{
+    Registry& r = registry();
+    QMutexLocker lock(&r.mutex);
+    return r.buffers;
+}
+
+QString formatCounter(const QString& name, qint64 value)
+{
+    if (name == "bytes")
+        return QLocale().formattedDataSize(value);
+    return QString("%1 %2").arg(value).arg(name);
+}
+
+} // namespace
+
+qint64 Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void Trace::setEnabled(bool on)
+{
+    s_enabled.store(on, std::memory_order_relaxed);
+}
+
+void Trace::reset()
+{
+    registry().epoch.store(now());
+    for (const auto& b : allBuffers()) {
+        QMutexLocker lock(&b->mutex);
+        b->events.clear();
+        b->counts.clear();
+    }
+}
+
+void Trace::record(const char* name, qint64 start, qint64 end, const QString& detail)
+{
+    ThreadBuffer& b = localBuffer();
+    QMutexLocker lock(&b.mutex);
+    b.events.push_back({name, start, end, detail});
+}
+
+void Trace::addCount(const QString& group, const char* name, qint64 delta)
+{
+    ThreadBuffer& b = localBuffer();
+    QMutexLocker lock(&b.mutex);
+    b.counts[group + QChar(0x1f) + QLatin1String(name)] += delta;
+}
+
+QVector<Trace::SpanTotal> Trace::spanTotals()
+{
+    // Names are literals, so the pointer identifies the span.
+    QHash<const char*, SpanTotal> byName;
+    for (const auto& b : allBuffers()) {
+        QMutexLocker lock(&b->mutex);
+        for (const Event& e : b->events) {
+            SpanTotal& t = byName[e.name];
+            t.count++;
+            t.totalNs += e.end - e.start;
+        }
+    }
+
+    // The same literal may live at several addresses across translation units.
+    QHash<QString, SpanTotal> merged;
+    for (auto it = byName.constBegin(); it != byName.constEnd(); ++it) {
+        SpanTotal& t = merged[QLatin1String(it.key())];
+        t.name = QLatin1String(it.key());
+        t.count += it.value().count;
+        t.totalNs += it.value().totalNs;
+    }
+
+    QVector<SpanTotal> out(merged.cbegin(), merged.cend());
+    std::sort(out.begin(), out.end(), [](const SpanTotal& a, const SpanTotal& b) {
+        return a.totalNs != b.totalNs ? a.totalNs > b.totalNs : a.name < b.name;
+    });
+    return out;
+}
+
+QMap<QString, QMap<QString, qint64>> Trace::counters()
+{
+    QMap<QString, QMap<QString, qint64>> out;
+    for (const auto& b : allBuffers()) {
+        QMutexLocker lock(&b->mutex);
+        for (auto it = b->counts.constBegin(); it != b->counts.constEnd(); ++it)
+            out[it.key().section(QChar(0x1f), 0, 0)][it.key().section(QChar(0x1f), 1)] += it.value();
+    }
+    return out;
+}
+
+QString Trace::summaryText()
+{
+    static constexpr int kMaxSpans = 8;
+
+    QStringList lines;
+    const QVector<SpanTotal> spans = spanTotals();
+    QStringList spanParts;
+    for (int i = 0; i < spans.size() && i < kMaxSpans; i++) {
+        spanParts << QString("%1 %2 ms (%3)")
+                         .arg(spans[i].name)
+                         .arg(spans[i].totalNs / 1e6, 0, 'f', 1)
+                         .arg(spans[i].count);
+    }
+    if (!spanParts.isEmpty())
+        lines << spanParts.join(", ");
+
+    const auto groups = counters();
+    for (auto g = groups.constBegin(); g != groups.constEnd(); ++g) {
+        QStringList parts;
+        for (auto c = g.value().constBegin(); c != g.value().constEnd(); ++c)
+            parts << formatCounter(c.key(), c.value());
+        lines << QString("%1: %2").arg(g.key(), parts.join(", "));
+    }
+    return lines.join('\n');
+}
+
+QByteArray Trace::toChromeJson()
+{
+    const qint64 epoch = registry().epoch.load();
+    const auto buffers = allBuffers();
+
+    QJsonArray events;
+    qint64 last = epoch;
+    for (const auto& b : buffers) {
+        QMutexLocker lock(&b->mutex);
+
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = 1;
+        meta["tid"] = b->tid;
+        meta["args"] = QJsonObject{{"name", b->threadName}};
+        events.push_back(meta);
+
+        for (const Event& e : b->events) {
+            QJsonObject o;
+            o["name"] = QLatin1String(e.name);
+            o["cat"] = QString(QLatin1String(e.name)).section('.', 0, 0);
+            o["ph"] = "X";
+            o["pid"] = 1;
+            o["tid"] = b->tid;
+            // Microseconds, as the format expects.
+            o["ts"] = (e.start - epoch) / 1000.0;
+            o["dur"] = (e.end - e.start) / 1000.0;
+            if (!e.detail.isEmpty())
+                o["args"] = QJsonObject{{"detail", e.detail}};
+            events.push_back(o);
+            last = qMax(last, e.end);
+        }
+    }
+
+    // Counter totals as one sample per group at the end of the trace.
+    const auto groups = counters();
+    for (auto g = groups.constBegin(); g != groups.constEnd(); ++g) {
+        QJsonObject args;
+        for (auto c = g.value().constBegin(); c != g.value().constEnd(); ++c)
+            args[c.key()] = c.value();
+        QJsonObject o;
+        o["name"] = g.key();
+        o["ph"] = "C";
+        o["pid"] = 1;
+        o["ts"] = (last - epoch) / 1000.0;
+        o["args"] = args;
+        events.push_back(o);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// Scoped spans and counters for profiling scans.
+//
+// Off by default. While disabled a Span costs one relaxed atomic load and
+// count() returns straight away. While enabled every thread appends to its
+// own buffer, so worker threads never contend with each other; the buffers
+// are only merged when a summary or a trace is requested.
+//
+//   Trace::Span span("scan.read", path);
+//   Trace::count("npm", "bytes", bytes.size());
+//
+// Span names must be string literals (they are stored as pointers). Details
+// that have to be built first should only be built while tracing is on:
+//
+//   Trace::Span span("git", Trace::isEnabled() ? args.join(' ') : QString());
+class Trace {
+public:
+    static void setEnabled(bool on);
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+    // Drops recorded spans and counters (e.g. before a new scan).
+    static void reset();
+
+    class Span {
+    public:
+        explicit Span(const char* name)
+            : m_name(isEnabled() ? name : nullptr)
+        {
+            if (m_name)
+                m_start = now();
+        }
+        Span(const char* name, const QString& detail)
+            : Span(name)
+        {
+            if (m_name)
+                m_detail = detail;
+        }
+        ~Span()
+        {
+            if (m_name)
+                record(m_name, m_start, now(), m_detail);
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* m_name;
+        qint64 m_start = 0;
+        QString m_detail;
+    };
+
+    // Adds delta to counter `name` of `group` (an ecosystem, "cache", ...).
+    static void count(const QString& group, const char* name, qint64 delta)
+    {
+        if (isEnabled())
+            addCount(group, name, delta);
+    }
+    // Literal groups ("cache") only become a QString while tracing is on.
+    static void count(const char* group, const char* name, qint64 delta)
+    {
+        if (isEnabled())
+            addCount(QString::fromLatin1(group), name, delta);
+    }
+
+    struct SpanTotal {
+        QString name;
+        int count = 0;
+        qint64 totalNs = 0;
+    };
+    // Per span name, largest total first. Nested spans are counted in both.
+    static QVector<SpanTotal> spanTotals();
+    // group -> counter -> value
+    static QMap<QString, QMap<QString, qint64>> counters();
+    // A few lines for the status panel; empty if nothing was recorded.
+    static QString summaryText();
+
+    // Chrome trace event format; loads in chrome://tracing and Perfetto.
+    static QByteArray toChromeJson();
+
+    // Nanoseconds on a monotonic clock.
+    static qint64 now();
+
+private:
+    static void record(const char* name, qint64 start, qint64 end, const QString& detail);
+    static void addCount(const QString& group, const char* name, qint64 delta);
+
+    static std::atomic<bool> s_enabled;
+};
@@ -0,0 +1,195 @@
+﻿#include "ZipReader.h"
+
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+
+#include <zlib.h>
+
+static constexpr quint32 kEndOfCentralDir = 0x06054b50;
+static constexpr quint32 kZip64EndLocator = 0x07064b50;
+static constexpr quint32 kZip64End = 0x06064b50;
+static constexpr quint32 kCentralHeader = 0x02014b50;
+static constexpr quint32 kLocalHeader = 0x04034b50;
+
+static quint16 u16(const uchar* p)
+{
+    return qFromLittleEndian<quint16>(p);
+}
+
+static quint32 u32(const uchar* p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+static quint64 u64(const uchar* p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+ZipReader::~ZipReader()
+{
+    close();
+}
+
+void ZipReader::close()
+{
+    if (m_data)
+        m_file.unmap(const_cast<uchar*>(m_data));
+    m_data = nullptr;
+    m_size = 0;
+    m_file.close();
+    m_entries.clear();
+}
+
+bool ZipReader::open(const QString& path, QString* err)
+{
+    close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (err) *err = QString("Cannot open %1: %2").arg(path, m_file.errorString());
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        if (err) *err = QString("Cannot map %1.").arg(path);
+        close();
+        return false;
+    }
+    if (!readCentralDirectory(err)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ZipReader::readCentralDirectory(QString* err)
+{
+    // The end record sits in the last 22 bytes plus a comment of up to 64 KiB.
+    qint64 eocd = -1;
+    for (qint64 p = m_size - 22; p >= 0 && p >= m_size - 22 - 65535; p--) {
+        if (u32(m_data + p) == kEndOfCentralDir) {
+            eocd = p;
+            break;
+        }
+    }
+    if (eocd < 0) {
+        if (err) *err = "Not a zip archive.";
+        return false;
+    }
+
+    quint64 count = u16(m_data + eocd + 10);
+    quint64 dirSize = u32(m_data + eocd + 12);
+    quint64 dirOffset = u32(m_data + eocd + 16);
+
+    // Zip64: the real values live in a second end record found via the locator.
+    if (eocd >= 20 && u32(m_data + eocd - 20) == kZip64EndLocator) {
+        const quint64 end64 = u64(m_data + eocd - 20 + 8);
+        if (end64 + 56 > quint64(m_size) || u32(m_data + end64) != kZip64End) {
+            if (err) *err = "Corrupt Zip64 end record.";
+            return false;
+        }
+        count = u64(m_data + end64 + 32);
+        dirSize = u64(m_data + end64 + 40);
+        dirOffset = u64(m_data + end64 + 48);
+    }
+    if (dirOffset + dirSize > quint64(m_size)) {
+        if (err) *err = "Corrupt zip central directory.";
+        return false;
+    }
+
+    m_entries.reserve(int(qMin<quint64>(count, 1u << 24)));
+    quint64 p = dirOffset;
+    for (quint64 i = 0; i < count; i++) {
+        if (p + 46 > dirOffset + dirSize || u32(m_data + p) != kCentralHeader) {
+            if (err) *err = "Corrupt zip central directory entry.";
+            return false;
+        }
+        const quint16 flags = u16(m_data + p + 8);
+        const quint16 nameLen = u16(m_data + p + 28);
+        const quint16 extraLen = u16(m_data + p + 30);
+        const quint16 commentLen = u16(m_data + p + 32);
+        if (p + 46 + nameLen + extraLen + commentLen > dirOffset + dirSize) {
+            if (err) *err = "Corrupt zip central directory entry.";
+            return false;
+        }
+
+        Entry e;
+        e.method = u16(m_data + p + 10);
+        e.compressedSize = u32(m_data + p + 20);
+        e.size = u32(m_data + p + 24);
+        e.localHeaderOffset = u32(m_data + p + 42);
+        const char* name = reinterpret_cast<const char*>(m_data + p + 46);
+        // Bit 11: UTF-8 names; otherwise CP437, which is ASCII for our purposes.
+        e.name = (flags & 0x800) ? QString::fromUtf8(name, nameLen) : QString::fromLatin1(name, nameLen);
+
+        // Zip64 extra field: only the values saturated in the header are present, in this order.
+        const uchar* x = m_data + p + 46 + nameLen;
+        const uchar* xEnd = x + extraLen;
+        while (x + 4 <= xEnd) {
+            const quint16 id = u16(x);
+            const quint16 len = u16(x + 2);
+            const uchar* v = x + 4;
+            if (id == 0x0001 && v + len <= xEnd) {
+                const uchar* vEnd = v + len;
+                if (e.size == 0xffffffffu && v + 8 <= vEnd) { e.size = u64(v); v += 8; }
+                if (e.compressedSize == 0xffffffffu && v + 8 <= vEnd) { e.compressedSize = u64(v); v += 8; }
+                if (e.localHeaderOffset == 0xffffffffu && v + 8 <= vEnd) { e.localHeaderOffset = u64(v); }
+            }
+            x += 4 + len;
+        }
+
+        if (!e.name.endsWith('/'))
+            m_entries.push_back(e);
+        p += 46 + nameLen + extraLen + commentLen;
+    }
+    return true;
+}
+
+bool ZipReader::read(const Entry& entry, QByteArray* out, QString* err) const
+{
+    const quint64 h = entry.localHeaderOffset;
+    if (!m_data || h + 30 > quint64(m_size) || u32(m_data + h) != kLocalHeader) {
+        if (err) *err = QString("Corrupt zip entry %1.").arg(entry.name);
+        return false;
+    }
+    // The local header has its own name and extra lengths.
+    const quint64 start = h + 30 + u16(m_data + h + 26) + u16(m_data + h + 28);
+    if (start + entry.compressedSize > quint64(m_size) || entry.size > quint64(INT_MAX)) {
+        if (err) *err = QString("Corrupt or oversized zip entry %1.").arg(entry.name);
+        return false;
+    }
+
+    const uchar* src = m_data + start;
+    if (entry.method == 0) {
+        *out = QByteArray(reinterpret_cast<const char*>(src), int(entry.compressedSize));
+        return true;
+    }
+    if (entry.method != 8) {
+        if (err) *err = QString("Unsupported compression in zip entry %1.").arg(entry.name);
+        return false;
+    }
+
+    out->resize(int(entry.size));
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    // Negative window bits: raw deflate, no zlib header.
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        if (err) *err = "Cannot initialise the zip decompressor.";
+        return false;
+    }
+    // Entries are well below 4 GiB each, which is what z_stream counts in.
+    zs.next_in = const_cast<Bytef*>(src);
+    zs.avail_in = uInt(entry.compressedSize);
+    zs.next_out = reinterpret_cast<Bytef*>(out->data());
+    zs.avail_out = uInt(entry.size);
+    const int ret = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+    if (ret != Z_STREAM_END || zs.total_out != entry.size) {
+        if (err) *err = QString("Cannot decompress zip entry %1.").arg(entry.name);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+// Read-only access to the entries of a zip archive (stored or deflated,
+// Zip64 included), enough to read advisory dumps without unpacking them.
+//
+// The archive is memory-mapped. After open() the reader is immutable, so
+// read() may be called from several threads at once.
+class ZipReader {
+public:
+    struct Entry {
+        QString name;
+        quint16 method = 0; // 0 stored, 8 deflated
+        quint64 compressedSize = 0;
+        quint64 size = 0;
+        quint64 localHeaderOffset = 0;
+    };
+
+    ZipReader() = default;
+    ~ZipReader();
+    ZipReader(const ZipReader&) = delete;
+    ZipReader& operator=(const ZipReader&) = delete;
+
+    bool open(const QString& path, QString* err);
+    void close();
+
+    // Files only; directory entries are skipped.
+    const QVector<Entry>& entries() const { return m_entries; }
+
+    bool read(const Entry& entry, QByteArray* out, QString* err) const;
+
+private:
+    bool readCentralDirectory(QString* err);
+
+    QFile m_file;
+    const uchar* m_data = nullptr;
+    qint64 m_size = 0;
+    QVector<Entry> m_entries;
+};